@@ -0,0 +1,205 @@
+#include "damage.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    long long area(const Rect& r)
+    {
+        return (long long)(r.right - r.left) * (r.bottom - r.top);
+    }
+
+    bool isEmpty(const Rect& r)
+    {
+        return r.right <= r.left || r.bottom <= r.top;
+    }
+
+    bool intersects(const Rect& a, const Rect& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    }
+
+    Rect unite(const Rect& a, const Rect& b)
+    {
+        return Rect{ std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+    }
+
+    void removeAt(std::vector<Rect>& rects, size_t index)
+    {
+        rects[index] = rects.back();
+        rects.pop_back();
+    }
+
+    // Collapse many rectangles into at most cells x cells by the cell holding their center
+    void bucketRects(std::vector<Rect>& rects, int cells)
+    {
+        Rect all = rects[0];
+        for (const Rect& r : rects) all = unite(all, r);
+        int cellWidth = std::max(1, (all.right - all.left + cells - 1) / cells);
+        int cellHeight = std::max(1, (all.bottom - all.top + cells - 1) / cells);
+
+        std::vector<Rect> buckets(cells * cells, Rect{ 0, 0, 0, 0 });
+        for (const Rect& r : rects)
+        {
+            int cx = std::min(((r.left + r.right) / 2 - all.left) / cellWidth, cells - 1);
+            int cy = std::min(((r.top + r.bottom) / 2 - all.top) / cellHeight, cells - 1);
+            Rect& bucket = buckets[cy * cells + cx];
+            bucket = isEmpty(bucket) ? r : unite(bucket, r);
+        }
+
+        rects.clear();
+        for (const Rect& b : buckets)
+        {
+            if (!isEmpty(b)) rects.push_back(b);
+        }
+    }
+}
+
+Rect shapeBounds(const Shape& shape)
+{
+    const float* c = shape.coords;
+    float margin = std::max(shape.pen.width, 1.0f) * 0.5f + 1.0f;
+    float left = std::min(c[0], c[2]) - margin;
+    float right = std::max(c[0], c[2]) + margin;
+    float top = std::min(c[1], c[3]) - margin;
+    float bottom = std::max(c[1], c[3]) + margin;
+    return Rect{ (int)std::floor(left), (int)std::floor(top), (int)std::ceil(right), (int)std::ceil(bottom) };
+}
+
+void drawShape(Canvas& canvas, const Shape& shape)
+{
+    const float* c = shape.coords;
+    canvas.pen = shape.pen;
+    canvas.brush = shape.brush;
+    switch (shape.type)
+    {
+    case ShapeType::Line:
+        moveTo(canvas, c[0], c[1]);
+        lineTo(canvas, c[2], c[3]);
+        break;
+    case ShapeType::Rectangle:
+        drawRectangle(canvas, c[0], c[1], c[2], c[3]);
+        break;
+    case ShapeType::Ellipse:
+        drawEllipse(canvas, c[0], c[1], c[2], c[3]);
+        break;
+    case ShapeType::RoundRect:
+        drawRoundRect(canvas, c[0], c[1], c[2], c[3], c[4], c[5]);
+        break;
+    case ShapeType::Pie:
+        drawPie(canvas, c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7]);
+        break;
+    }
+}
+
+int addShape(DrawList& list, const Shape& shape)
+{
+    list.shapes.push_back(shape);
+    list.bounds.push_back(shapeBounds(shape));
+    damageRect(list, list.bounds.back());
+    return (int)list.shapes.size() - 1;
+}
+
+void updateShape(DrawList& list, int index, const Shape& shape)
+{
+    // The old area has to be uncovered and the new one drawn
+    damageRect(list, list.bounds[index]);
+    list.shapes[index] = shape;
+    list.bounds[index] = shapeBounds(shape);
+    damageRect(list, list.bounds[index]);
+}
+
+void damageRect(DrawList& list, const Rect& rect)
+{
+    if (!isEmpty(rect)) list.damage.push_back(rect);
+}
+
+void mergeDamage(std::vector<Rect>& rects, int maxRects, int rectOverhead)
+{
+    rects.erase(std::remove_if(rects.begin(), rects.end(), isEmpty), rects.end());
+    if (rects.empty()) return;
+
+    // Pairwise merging is quadratic, so very long lists are first reduced on a coarse grid
+    if ((int)rects.size() > maxRects * 4)
+    {
+        bucketRects(rects, std::max(1, (int)std::sqrt((double)maxRects * 4)));
+    }
+
+    // Merge pairs while the union is cheaper than drawing both separately
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            for (size_t j = i + 1; j < rects.size(); j++)
+            {
+                Rect u = unite(rects[i], rects[j]);
+                if (area(u) <= area(rects[i]) + area(rects[j]) + rectOverhead)
+                {
+                    rects[i] = u;
+                    removeAt(rects, j);
+                    merged = true;
+                    j = i;
+                }
+            }
+        }
+    }
+
+    // Over the limit merge the pairs that grow the least
+    while ((int)rects.size() > maxRects)
+    {
+        size_t bestI = 0, bestJ = 1;
+        long long bestGrowth = -1;
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            for (size_t j = i + 1; j < rects.size(); j++)
+            {
+                long long growth = area(unite(rects[i], rects[j])) - area(rects[i]) - area(rects[j]);
+                if (bestGrowth < 0 || growth < bestGrowth)
+                {
+                    bestGrowth = growth;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        rects[bestI] = unite(rects[bestI], rects[bestJ]);
+        removeAt(rects, bestJ);
+    }
+}
+
+std::vector<Rect> repaint(DrawList& list, Canvas& canvas)
+{
+    std::vector<Rect> rects;
+    rects.swap(list.damage);
+    for (Rect& r : rects)
+    {
+        r.left = std::max(r.left, 0);
+        r.top = std::max(r.top, 0);
+        r.right = std::min(r.right, canvas.width);
+        r.bottom = std::min(r.bottom, canvas.height);
+    }
+    mergeDamage(rects, list.maxDamageRects, list.rectOverhead);
+
+    // Many overlapping rectangles cost more than one pass over everything
+    long long damaged = 0;
+    for (const Rect& r : rects) damaged += area(r);
+    if (damaged > list.fullRepaintRatio * canvas.width * canvas.height)
+    {
+        rects.assign(1, Rect{ 0, 0, canvas.width, canvas.height });
+    }
+
+    // Rectangles may still overlap, repainting a pixel twice gives the same result
+    for (const Rect& r : rects)
+    {
+        setClip(canvas, r);
+        fillRect(canvas, r, list.background);
+        for (size_t i = 0; i < list.shapes.size(); i++)
+        {
+            if (intersects(list.bounds[i], r)) drawShape(canvas, list.shapes[i]);
+        }
+    }
+    resetClip(canvas);
+    return rects;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include "raster.h"
+
+// Retained list of figures with damage tracking: every change marks the pixels it touches,
+// repaint merges those marks into a few rectangles and re-rasterizes only them.
+
+enum class ShapeType
+{
+    Line,      // x1, y1, x2, y2
+    Rectangle, // left, top, right, bottom
+    Ellipse,   // left, top, right, bottom
+    RoundRect, // left, top, right, bottom, corner width, corner height
+    Pie        // left, top, right, bottom, xr1, yr1, xr2, yr2
+};
+
+struct Shape
+{
+    ShapeType type;
+    float coords[8];
+    Pen pen;
+    Brush brush;
+};
+
+struct DrawList
+{
+    std::vector<Shape> shapes;       // Drawn in order, later shapes on top
+    std::vector<Rect> bounds;        // Pixels touched by each shape
+    std::vector<Rect> damage;        // Damaged since the last repaint
+    Color background = { 0, 0, 0, 255 };
+    int maxDamageRects = 32;         // Rectangles left after merging
+    int rectOverhead = 4096;         // Cost of one more rectangle, in pixels
+    float fullRepaintRatio = 0.5f;   // Damaged share of the canvas above which it is repainted whole
+};
+
+// Pixels touched by a shape, including the pen and anti-aliasing
+Rect shapeBounds(const Shape& shape);
+
+// Rasterize one shape with its own pen and brush
+void drawShape(Canvas& canvas, const Shape& shape);
+
+// Editing, each call damages the area that changes
+int addShape(DrawList& list, const Shape& shape);
+void updateShape(DrawList& list, int index, const Shape& shape);
+void damageRect(DrawList& list, const Rect& rect);
+
+// Merge rectangles until merging would cost more pixels than it saves, then down to maxRects
+void mergeDamage(std::vector<Rect>& rects, int maxRects, int rectOverhead);
+
+// Re-rasterize the damaged area into the canvas, returns the rectangles that have to be presented
+std::vector<Rect> repaint(DrawList& list, Canvas& canvas);
@@ -0,0 +1,99 @@
+// Incremental repaint benchmark, does not need Windows:
+// g++ -O2 -std=c++14 raster.cpp damage.cpp damage_benchmark.cpp -o damage_benchmark
+#include "damage.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+const int kWidth = 1920;
+const int kHeight = 1080;
+const int kColumns = 48;
+const int kRows = 27;
+
+// Gauge widget: frame, pie showing the value and a needle line
+void makeWidget(DrawList& list, int column, int row, float value, bool add, int first)
+{
+    float cell = (float)kWidth / kColumns;
+    float x = column * cell + 2.0f, y = row * cell + 2.0f, size = cell - 4.0f;
+    float cx = x + size * 0.5f, cy = y + size * 0.5f;
+    float angle = value * 6.2831853f;
+    float ex = cx + std::cos(angle) * size * 0.4f, ey = cy - std::sin(angle) * size * 0.4f;
+
+    Shape shapes[3] = {
+        { ShapeType::RoundRect, { x, y, x + size, y + size, 8.0f, 8.0f }, { rgb(90, 90, 90), 1.0f }, { rgb(30, 30, 30) } },
+        { ShapeType::Pie, { x + 4, y + 4, x + size - 4, y + size - 4, cx + 10.0f, cy, ex, ey }, { rgb(255, 0, 255), 2.0f }, { rgb(255, 255, 0) } },
+        { ShapeType::Line, { cx, cy, ex, ey }, { rgb(255, 255, 255), 2.0f }, { rgb(0, 0, 0) } },
+    };
+    for (int i = 0; i < 3; i++)
+    {
+        if (add) addShape(list, shapes[i]);
+        else updateShape(list, first + i, shapes[i]);
+    }
+}
+
+double seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    DrawList list;
+    Canvas canvas;
+    createCanvas(canvas, kWidth, kHeight);
+    std::mt19937 rng(7);
+    for (int row = 0; row < kRows; row++)
+    {
+        for (int column = 0; column < kColumns; column++)
+        {
+            makeWidget(list, column, row, (rng() % 1000) / 1000.0f, true, 0);
+        }
+    }
+    repaint(list, canvas);
+
+    // Full redraw of the whole dashboard as the reference cost
+    const int frames = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++)
+    {
+        damageRect(list, Rect{ 0, 0, kWidth, kHeight });
+        repaint(list, canvas);
+    }
+    double fullMs = seconds(start) * 1000.0 / frames;
+    std::cout << "full redraw: " << fullMs << " ms/frame" << std::endl;
+
+    const int widgets = kColumns * kRows;
+    const double fractions[] = { 0.001, 0.01, 0.05, 0.1, 0.25, 0.5, 1.0 };
+    for (double fraction : fractions)
+    {
+        int changed = std::max(1, (int)(widgets * fraction));
+        long long pixels = 0;
+        size_t rects = 0;
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++)
+        {
+            for (int i = 0; i < changed; i++)
+            {
+                int w = (int)(rng() % widgets);
+                makeWidget(list, w % kColumns, w / kColumns, (rng() % 1000) / 1000.0f, false, w * 3);
+            }
+            std::vector<Rect> presented = repaint(list, canvas);
+            rects += presented.size();
+            for (const Rect& r : presented) pixels += (long long)(r.right - r.left) * (r.bottom - r.top);
+        }
+        double ms = seconds(start) * 1000.0 / frames;
+        std::cout << "changed " << fraction * 100.0 << "% widgets: " << ms << " ms/frame ("
+            << fullMs / ms << "x vs full), repainted " << 100.0 * pixels / frames / ((double)kWidth * kHeight)
+            << "% of screen in " << rects / frames << " rects" << std::endl;
+    }
+
+    // Incremental result has to match drawing everything from scratch
+    Canvas reference;
+    createCanvas(reference, kWidth, kHeight);
+    list.damage.clear();
+    damageRect(list, Rect{ 0, 0, kWidth, kHeight });
+    repaint(list, reference);
+    std::cout << (reference.pixels == canvas.pixels ? "incremental result matches full redraw" : "MISMATCH against full redraw") << std::endl;
+    return 0;
+}
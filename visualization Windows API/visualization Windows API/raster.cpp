@@ -0,0 +1,357 @@
+#include "raster.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    uint32_t packColor(Color color)
+    {
+        return uint32_t(color.r) | uint32_t(color.g) << 8 | uint32_t(color.b) << 16 | uint32_t(color.a) << 24;
+    }
+
+    // Store an opaque color into n pixels
+    void fillSpan(uint32_t* dst, uint32_t color, int n)
+    {
+        int i = 0;
+#ifdef RASTER_SSE2
+        const __m128i c = _mm_set1_epi32((int)color);
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm_storeu_si128((__m128i*)(dst + i), c);
+        }
+#endif
+        for (; i < n; i++)
+        {
+            dst[i] = color;
+        }
+    }
+
+    // Blend a color over n pixels weighted by per-pixel coverage (nullptr means full coverage)
+    void blendSpan(uint32_t* dst, Color color, const float* coverage, int n)
+    {
+        const float alphaScale = color.a * (256.0f / 255.0f);
+        int i = 0;
+#ifdef RASTER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)packColor(color)), zero);
+        const __m128i full = _mm_set1_epi16(256);
+        const __m128 scale = _mm_set1_ps(alphaScale);
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i + 4 <= n; i += 4)
+        {
+            // Weights 0..256 for four pixels, spread over the four channels of each pixel
+            __m128 cov = coverage ? _mm_loadu_ps(coverage + i) : one;
+            __m128i a32 = _mm_cvtps_epi32(_mm_mul_ps(cov, scale));
+            __m128i a16 = _mm_packs_epi32(a32, a32);
+            __m128i a2 = _mm_unpacklo_epi16(a16, a16);
+            __m128i aLo = _mm_unpacklo_epi32(a2, a2);
+            __m128i aHi = _mm_unpackhi_epi32(a2, a2);
+
+            // dst * (256 - a) + src * a never exceeds 255 * 256, so unsigned 16 bit lanes are enough
+            __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+            __m128i dLo = _mm_unpacklo_epi8(d, zero);
+            __m128i dHi = _mm_unpackhi_epi8(d, zero);
+            dLo = _mm_add_epi16(_mm_mullo_epi16(dLo, _mm_sub_epi16(full, aLo)), _mm_mullo_epi16(src, aLo));
+            dHi = _mm_add_epi16(_mm_mullo_epi16(dHi, _mm_sub_epi16(full, aHi)), _mm_mullo_epi16(src, aHi));
+            _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_srli_epi16(dLo, 8), _mm_srli_epi16(dHi, 8)));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            uint32_t a = (uint32_t)((coverage ? coverage[i] : 1.0f) * alphaScale + 0.5f);
+            uint32_t d = dst[i];
+            uint32_t r = ((d & 0xFF) * (256 - a) + color.r * a) >> 8;
+            uint32_t g = ((d >> 8 & 0xFF) * (256 - a) + color.g * a) >> 8;
+            uint32_t b = ((d >> 16 & 0xFF) * (256 - a) + color.b * a) >> 8;
+            uint32_t al = ((d >> 24) * (256 - a) + color.a * a) >> 8;
+            dst[i] = r | g << 8 | b << 16 | al << 24;
+        }
+    }
+
+    float clamp01(float v)
+    {
+        return std::min(std::max(v, 0.0f), 1.0f);
+    }
+
+    // Signed distance estimate to an axis-aligned ellipse centered at the origin.
+    // The estimate is accurate near the edge, bound is never larger in magnitude than the true distance.
+    float ellipseDistance(float x, float y, float rx, float ry, float& bound)
+    {
+        float k0 = std::sqrt((x / rx) * (x / rx) + (y / ry) * (y / ry));
+        float k1 = std::sqrt((x / (rx * rx)) * (x / (rx * rx)) + (y / (ry * ry)) * (y / (ry * ry)));
+        bound = (k0 - 1.0f) * std::min(rx, ry);
+        if (k1 == 0.0f)
+        {
+            return -std::min(rx, ry);
+        }
+        return k0 * (k0 - 1.0f) / k1;
+    }
+
+    // Shapes evaluated as signed distance in pixels, negative inside. Next to the distance used
+    // for coverage they return a bound that changes by at most one per pixel, used to skip spans.
+    struct SegmentShape
+    {
+        float ax, ay, bx, by, radius;
+
+        float operator()(float x, float y, float& bound) const
+        {
+            float px = x - ax, py = y - ay;
+            float dx = bx - ax, dy = by - ay;
+            float len2 = dx * dx + dy * dy;
+            float t = len2 > 0.0f ? clamp01((px * dx + py * dy) / len2) : 0.0f;
+            float ex = px - dx * t, ey = py - dy * t;
+            bound = std::sqrt(ex * ex + ey * ey) - radius;
+            return bound;
+        }
+    };
+
+    struct BoxShape
+    {
+        float cx, cy, hx, hy;
+
+        float operator()(float x, float y, float& bound) const
+        {
+            float qx = std::fabs(x - cx) - hx;
+            float qy = std::fabs(y - cy) - hy;
+            float ox = std::max(qx, 0.0f), oy = std::max(qy, 0.0f);
+            bound = std::sqrt(ox * ox + oy * oy) + std::min(std::max(qx, qy), 0.0f);
+            return bound;
+        }
+    };
+
+    struct EllipseShape
+    {
+        float cx, cy, rx, ry;
+
+        float operator()(float x, float y, float& bound) const
+        {
+            return ellipseDistance(x - cx, y - cy, rx, ry, bound);
+        }
+    };
+
+    // Box with elliptical corners, as drawn by RoundRect
+    struct RoundBoxShape
+    {
+        float cx, cy, hx, hy, rx, ry;
+
+        float operator()(float x, float y, float& bound) const
+        {
+            float ax = std::fabs(x - cx), ay = std::fabs(y - cy);
+            float kx = hx - rx, ky = hy - ry; // Corner ellipse center
+            if (ax > kx && ay > ky)
+            {
+                return ellipseDistance(ax - kx, ay - ky, rx, ry, bound);
+            }
+            // Inside the straight part the corner arcs may be closer than the sides
+            float d = std::max(ax - hx, ay - hy);
+            float qx = std::max(kx - ax, 0.0f), qy = std::max(ky - ay, 0.0f);
+            bound = d < 0.0f ? std::max(d, -std::sqrt(qx * qx + qy * qy)) : d;
+            return d;
+        }
+    };
+
+    // Ellipse cut to the counterclockwise wedge between two radials, as drawn by Pie
+    struct PieShape
+    {
+        EllipseShape ellipse;
+        float u1x, u1y, u2x, u2y; // Radial directions with y pointing up
+        bool wide;                // Wedge wider than half a turn
+
+        float operator()(float x, float y, float& bound) const
+        {
+            float px = x - ellipse.cx, py = ellipse.cy - y;
+            float d1 = u1y * px - u1x * py; // Negative on the counterclockwise side of the first radial
+            float d2 = u2x * py - u2y * px; // Negative on the clockwise side of the second radial
+            float wedge = wide ? std::min(d1, d2) : std::max(d1, d2);
+            float d = std::max(ellipse(x, y, bound), wedge);
+            bound = std::max(bound, wedge);
+            return d;
+        }
+    };
+
+    // Rasterize a shape inside its bounds: interior spans are skipped or filled whole,
+    // only pixels near the edge get coverage from the distance and are blended as spans
+    template <typename Shape>
+    void rasterizeShape(Canvas& canvas, const Shape& shape, float left, float top, float right, float bottom,
+        const Color* fill, const Color* stroke, float halfWidth)
+    {
+        if (fill && fill->a == 0) fill = nullptr;
+        if (stroke && stroke->a == 0) stroke = nullptr;
+        if (!fill && !stroke) return;
+
+        float margin = (stroke ? halfWidth : 0.0f) + 1.0f;
+        int x0 = std::max(canvas.clip.left, (int)std::floor(std::min(left, right) - margin));
+        int x1 = std::min(canvas.clip.right, (int)std::ceil(std::max(left, right) + margin));
+        int y0 = std::max(canvas.clip.top, (int)std::floor(std::min(top, bottom) - margin));
+        int y1 = std::min(canvas.clip.bottom, (int)std::ceil(std::max(top, bottom) + margin));
+        if (x0 >= x1 || y0 >= y1) return;
+
+        // Distances past which a pixel is fully inside (fill only) or fully outside
+        float inner = stroke ? halfWidth + 0.5f : 0.5f;
+        float outer = stroke ? halfWidth + 0.5f : 0.5f;
+        uint32_t fillPacked = fill ? packColor(*fill) : 0;
+        bool opaqueFill = fill && fill->a == 255;
+
+        static thread_local std::vector<float> fillCoverage;
+        static thread_local std::vector<float> strokeCoverage;
+        fillCoverage.resize(canvas.width);
+        strokeCoverage.resize(canvas.width);
+
+        for (int y = y0; y < y1; y++)
+        {
+            uint32_t* row = canvas.pixels.data() + (size_t)y * canvas.width;
+            float py = y + 0.5f;
+            int runStart = x0;
+            int runLength = 0;
+
+            auto flushRun = [&]()
+            {
+                if (runLength == 0) return;
+                if (fill) blendSpan(row + runStart, *fill, fillCoverage.data(), runLength);
+                if (stroke) blendSpan(row + runStart, *stroke, strokeCoverage.data(), runLength);
+                runLength = 0;
+            };
+
+            int x = x0;
+            while (x < x1)
+            {
+                float bound;
+                float d = shape(x + 0.5f, py, bound);
+                if (bound <= -inner)
+                {
+                    flushRun();
+                    int n = std::min(x1 - x, (int)(-inner - bound) + 1);
+                    if (fill)
+                    {
+                        if (opaqueFill) fillSpan(row + x, fillPacked, n);
+                        else blendSpan(row + x, *fill, nullptr, n);
+                    }
+                    x += n;
+                }
+                else if (bound >= outer)
+                {
+                    flushRun();
+                    x += (int)(bound - outer) + 1;
+                }
+                else
+                {
+                    if (runLength == 0) runStart = x;
+                    fillCoverage[runLength] = clamp01(0.5f - d);
+                    strokeCoverage[runLength] = clamp01(halfWidth + 0.5f - std::fabs(d));
+                    runLength++;
+                    x++;
+                }
+            }
+            flushRun();
+        }
+    }
+
+    float penHalfWidth(const Pen& pen)
+    {
+        return std::max(pen.width, 1.0f) * 0.5f;
+    }
+}
+
+void createCanvas(Canvas& canvas, int width, int height)
+{
+    canvas.width = width;
+    canvas.height = height;
+    canvas.pixels.assign((size_t)width * height, 0);
+    resetClip(canvas);
+}
+
+void clearCanvas(Canvas& canvas, Color color)
+{
+    fillSpan(canvas.pixels.data(), packColor(color), (int)canvas.pixels.size());
+}
+
+void setClip(Canvas& canvas, const Rect& rect)
+{
+    canvas.clip.left = std::max(rect.left, 0);
+    canvas.clip.top = std::max(rect.top, 0);
+    canvas.clip.right = std::max(std::min(rect.right, canvas.width), canvas.clip.left);
+    canvas.clip.bottom = std::max(std::min(rect.bottom, canvas.height), canvas.clip.top);
+}
+
+void resetClip(Canvas& canvas)
+{
+    canvas.clip = { 0, 0, canvas.width, canvas.height };
+}
+
+void fillRect(Canvas& canvas, const Rect& rect, Color color)
+{
+    int x0 = std::max(rect.left, canvas.clip.left);
+    int x1 = std::min(rect.right, canvas.clip.right);
+    int y0 = std::max(rect.top, canvas.clip.top);
+    int y1 = std::min(rect.bottom, canvas.clip.bottom);
+    uint32_t packed = packColor(color);
+    for (int y = y0; y < y1 && x0 < x1; y++)
+    {
+        fillSpan(canvas.pixels.data() + (size_t)y * canvas.width + x0, packed, x1 - x0);
+    }
+}
+
+void moveTo(Canvas& canvas, float x, float y)
+{
+    canvas.currentX = x;
+    canvas.currentY = y;
+}
+
+void lineTo(Canvas& canvas, float x, float y)
+{
+    float radius = penHalfWidth(canvas.pen);
+    SegmentShape segment = { canvas.currentX, canvas.currentY, x, y, radius };
+    rasterizeShape(canvas, segment,
+        std::min(canvas.currentX, x) - radius, std::min(canvas.currentY, y) - radius,
+        std::max(canvas.currentX, x) + radius, std::max(canvas.currentY, y) + radius,
+        &canvas.pen.color, nullptr, 0.0f);
+    moveTo(canvas, x, y);
+}
+
+void drawRectangle(Canvas& canvas, float left, float top, float right, float bottom)
+{
+    BoxShape box = { (left + right) * 0.5f, (top + bottom) * 0.5f, std::fabs(right - left) * 0.5f, std::fabs(bottom - top) * 0.5f };
+    rasterizeShape(canvas, box, left, top, right, bottom, &canvas.brush.color, &canvas.pen.color, penHalfWidth(canvas.pen));
+}
+
+void drawEllipse(Canvas& canvas, float left, float top, float right, float bottom)
+{
+    EllipseShape ellipse = { (left + right) * 0.5f, (top + bottom) * 0.5f,
+        std::max(std::fabs(right - left) * 0.5f, 0.5f), std::max(std::fabs(bottom - top) * 0.5f, 0.5f) };
+    rasterizeShape(canvas, ellipse, left, top, right, bottom, &canvas.brush.color, &canvas.pen.color, penHalfWidth(canvas.pen));
+}
+
+void drawRoundRect(Canvas& canvas, float left, float top, float right, float bottom, float cornerWidth, float cornerHeight)
+{
+    float hx = std::fabs(right - left) * 0.5f;
+    float hy = std::fabs(bottom - top) * 0.5f;
+    RoundBoxShape box = { (left + right) * 0.5f, (top + bottom) * 0.5f, hx, hy,
+        std::min(std::max(cornerWidth * 0.5f, 0.5f), hx), std::min(std::max(cornerHeight * 0.5f, 0.5f), hy) };
+    rasterizeShape(canvas, box, left, top, right, bottom, &canvas.brush.color, &canvas.pen.color, penHalfWidth(canvas.pen));
+}
+
+void drawPie(Canvas& canvas, float left, float top, float right, float bottom, float xr1, float yr1, float xr2, float yr2)
+{
+    PieShape pie;
+    pie.ellipse = { (left + right) * 0.5f, (top + bottom) * 0.5f,
+        std::max(std::fabs(right - left) * 0.5f, 0.5f), std::max(std::fabs(bottom - top) * 0.5f, 0.5f) };
+
+    // Radial angles measured counterclockwise on screen, so y is flipped
+    float a1 = std::atan2(pie.ellipse.cy - yr1, xr1 - pie.ellipse.cx);
+    float a2 = std::atan2(pie.ellipse.cy - yr2, xr2 - pie.ellipse.cx);
+    float sweep = a2 - a1;
+    const float twoPi = 6.28318531f;
+    while (sweep <= 0.0f) sweep += twoPi;
+    pie.u1x = std::cos(a1);
+    pie.u1y = std::sin(a1);
+    pie.u2x = std::cos(a2);
+    pie.u2y = std::sin(a2);
+    pie.wide = sweep > twoPi * 0.5f;
+
+    rasterizeShape(canvas, pie, left, top, right, bottom, &canvas.brush.color, &canvas.pen.color, penHalfWidth(canvas.pen));
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Portable 2D rasterizer drawing the GDI primitives of the demo into an in-memory RGBA framebuffer.
+// Edges are anti-aliased from a signed distance to the shape, interior spans are filled with SIMD.
+
+// Color in framebuffer byte order (R, G, B, A)
+struct Color
+{
+    uint8_t r, g, b, a;
+};
+
+inline Color rgb(uint8_t r, uint8_t g, uint8_t b)
+{
+    return Color{ r, g, b, 255 };
+}
+
+// Solid pen, same as CreatePen(PS_SOLID, width, color); width <= 1 draws a one pixel line
+struct Pen
+{
+    Color color;
+    float width;
+};
+
+// Solid brush, same as CreateSolidBrush(color); alpha 0 disables filling
+struct Brush
+{
+    Color color;
+};
+
+// Pixel rectangle, right and bottom are exclusive
+struct Rect
+{
+    int left, top, right, bottom;
+};
+
+// Drawing surface with its selected pen and brush, the counterpart of a memory DC
+struct Canvas
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> pixels; // Row-major, top-down, one RGBA pixel per element
+    Rect clip = { 0, 0, 0, 0 };   // Drawing is limited to this rectangle
+    Pen pen = { rgb(0, 0, 0), 1.0f };
+    Brush brush = { rgb(255, 255, 255) };
+    float currentX = 0.0f; // Current position for lineTo
+    float currentY = 0.0f;
+};
+
+// Canvas setup
+void createCanvas(Canvas& canvas, int width, int height);
+void clearCanvas(Canvas& canvas, Color color);
+void setClip(Canvas& canvas, const Rect& rect);
+void resetClip(Canvas& canvas);
+void fillRect(Canvas& canvas, const Rect& rect, Color color); // Opaque fill, limited by the clip
+
+// Lines, same as MoveToEx/LineTo
+void moveTo(Canvas& canvas, float x, float y);
+void lineTo(Canvas& canvas, float x, float y);
+
+// Closed figures outlined with the pen and filled with the brush, same arguments as the GDI calls
+void drawRectangle(Canvas& canvas, float left, float top, float right, float bottom);
+void drawEllipse(Canvas& canvas, float left, float top, float right, float bottom);
+void drawRoundRect(Canvas& canvas, float left, float top, float right, float bottom, float cornerWidth, float cornerHeight);
+void drawPie(Canvas& canvas, float left, float top, float right, float bottom, float xr1, float yr1, float xr2, float yr2);
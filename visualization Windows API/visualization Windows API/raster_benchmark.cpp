@@ -0,0 +1,61 @@
+// Rasterizer benchmark, does not need Windows:
+// g++ -O2 -std=c++14 raster.cpp raster_benchmark.cpp -o raster_benchmark
+#include "raster.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Draw random primitives of one kind for a fixed time and report primitives per second
+double measurePrimitives(Canvas& canvas, int kind, double seconds)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> posX(0.0f, (float)canvas.width);
+    std::uniform_real_distribution<float> posY(0.0f, (float)canvas.height);
+    std::uniform_real_distribution<float> size(canvas.width * 0.02f, canvas.width * 0.15f);
+
+    auto start = std::chrono::steady_clock::now();
+    long long count = 0;
+    double elapsed = 0.0;
+    while (elapsed < seconds)
+    {
+        for (int i = 0; i < 256; i++, count++)
+        {
+            float x = posX(rng), y = posY(rng);
+            float w = size(rng), h = size(rng);
+            canvas.pen.color = rgb((uint8_t)rng(), (uint8_t)rng(), (uint8_t)rng());
+            canvas.brush.color = rgb((uint8_t)rng(), (uint8_t)rng(), (uint8_t)rng());
+            switch (kind)
+            {
+            case 0: moveTo(canvas, x, y); lineTo(canvas, x + w, y + h); break;
+            case 1: drawRectangle(canvas, x, y, x + w, y + h); break;
+            case 2: drawEllipse(canvas, x, y, x + w, y + h); break;
+            case 3: drawRoundRect(canvas, x, y, x + w, y + h, w * 0.5f, h * 0.5f); break;
+            case 4: drawPie(canvas, x, y, x + w, y + h, x + w, y, x, y + h); break;
+            }
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return count / elapsed;
+}
+
+int main()
+{
+    const char* names[] = { "line", "rectangle", "ellipse", "round rect", "pie" };
+    const int resolutions[][2] = { { 640, 480 }, { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+
+    for (const auto& resolution : resolutions)
+    {
+        Canvas canvas;
+        createCanvas(canvas, resolution[0], resolution[1]);
+        clearCanvas(canvas, rgb(255, 255, 255));
+        canvas.pen.width = 2.0f;
+
+        std::cout << resolution[0] << "x" << resolution[1] << std::endl;
+        for (int kind = 0; kind < 5; kind++)
+        {
+            double rate = measurePrimitives(canvas, kind, 0.5);
+            std::cout << "  " << names[kind] << ": " << (long long)rate << " primitives/s" << std::endl;
+        }
+    }
+    return 0;
+}
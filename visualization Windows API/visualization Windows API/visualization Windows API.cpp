@@ -1,9 +1,40 @@
 #include <windows.h>
+#include "damage.h"
 
 // Windows API Application
 static TCHAR lpszAppName[] = TEXT("API Windows");
+Canvas canvas;       // Portable framebuffer the figures are drawn into
+DrawList drawList;   // Figures of the demo, repainted only where they change
+int movableEllipse;  // Figure moved with the arrow keys
 HBITMAP bitmapBuffer;
 HDC memoryContext;
+uint32_t* bitmapBits; // Pixels of bitmapBuffer, BGRA
+
+// Copy a canvas rectangle into the DIB section in the layout expected by GDI
+void updatePresentBuffer(const Rect& rect)
+{
+    for (int y = rect.top; y < rect.bottom; y++)
+    {
+        const uint32_t* src = canvas.pixels.data() + (size_t)y * canvas.width;
+        uint32_t* dst = bitmapBits + (size_t)y * canvas.width;
+        for (int x = rect.left; x < rect.right; x++)
+        {
+            uint32_t p = src[x];
+            dst[x] = (p & 0xFF00FF00) | (p & 0xFF) << 16 | (p >> 16 & 0xFF);
+        }
+    }
+}
+
+// Re-rasterize what changed and invalidate only those parts of the window
+void repaintDamage(HWND hWnd)
+{
+    for (const Rect& r : repaint(drawList, canvas))
+    {
+        updatePresentBuffer(r);
+        RECT rect = { r.left, r.top, r.right, r.bottom };
+        InvalidateRect(hWnd, &rect, FALSE);
+    }
+}
 
 // Window procedure for handling messages
 LRESULT CALLBACK MainWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
@@ -13,35 +44,34 @@ LRESULT CALLBACK MainWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_CREATE:
     {
         // Create drawings when the window is created
-        HGDIOBJ oldPen = SelectObject(memoryContext, CreatePen(PS_SOLID, 2, RGB(255, 0, 255)));
-        HGDIOBJ oldBrush = SelectObject(memoryContext, CreateSolidBrush(RGB(255, 255, 0)));
+        Pen pen = { rgb(255, 0, 255), 2.0f };
+        Brush brush = { rgb(255, 255, 0) };
 
-        // Line
-        MoveToEx(memoryContext, 50, 50, NULL); // Start point
-        LineTo(memoryContext, 200, 200);       // End point
+        // Line from (50, 50) to (200, 200)
+        addShape(drawList, Shape{ ShapeType::Line, { 50, 50, 200, 200 }, pen, brush });
 
         // Rectangle, vertices in (100, 100), (300, 200)
-        Rectangle(memoryContext, 100, 100, 300, 200);
+        addShape(drawList, Shape{ ShapeType::Rectangle, { 100, 100, 300, 200 }, pen, brush });
 
         // Ellipse inscribed in a rectangle with vertices (150, 150) and (350, 250)
-        Ellipse(memoryContext, 150, 200, 350, 250);
+        movableEllipse = addShape(drawList, Shape{ ShapeType::Ellipse, { 150, 200, 350, 250 }, pen, brush });
 
         // Rectangle with rounded corners (300, 300) to (500, 400), corner radius 100x100
-        RoundRect(memoryContext, 300, 300, 500, 400, 100, 100);
+        addShape(drawList, Shape{ ShapeType::RoundRect, { 300, 300, 500, 400, 100, 100 }, pen, brush });
 
         // A segment of a circle (a fragment of an ellipse)
-        Pie(memoryContext, 200, 300, 400, 400, 300, 200, 300, 400);
+        addShape(drawList, Shape{ ShapeType::Pie, { 200, 300, 400, 400, 300, 200, 300, 400 }, pen, brush });
 
-        DeleteObject(SelectObject(memoryContext, oldPen));
-        DeleteObject(SelectObject(memoryContext, oldBrush));
+        repaintDamage(hWnd);
     } break;
 
     case WM_PAINT:
     {
-        // Handle drawing when the window is refreshed
+        // Handle drawing when the window is refreshed, only the invalidated part is copied
         PAINTSTRUCT ps;
         HDC hDC = BeginPaint(hWnd, &ps);
-        BitBlt(hDC, 0, 0, 640, 480, memoryContext, 0, 0, SRCCOPY);
+        BitBlt(hDC, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left, ps.rcPaint.bottom - ps.rcPaint.top,
+            memoryContext, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
         EndPaint(hWnd, &ps);
     }
     break;
@@ -53,6 +83,20 @@ LRESULT CALLBACK MainWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         {
             PostQuitMessage(0);
         }
+
+        // Arrow keys move the ellipse, only the area it leaves and enters is repainted
+        float dx = wParam == VK_LEFT ? -10.0f : wParam == VK_RIGHT ? 10.0f : 0.0f;
+        float dy = wParam == VK_UP ? -10.0f : wParam == VK_DOWN ? 10.0f : 0.0f;
+        if (dx != 0.0f || dy != 0.0f)
+        {
+            Shape ellipse = drawList.shapes[movableEllipse];
+            ellipse.coords[0] += dx;
+            ellipse.coords[1] += dy;
+            ellipse.coords[2] += dx;
+            ellipse.coords[3] += dy;
+            updateShape(drawList, movableEllipse, ellipse);
+            repaintDamage(hWnd);
+        }
     }
     break;
 
@@ -72,10 +116,23 @@ LRESULT CALLBACK MainWndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 // Main application function
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
-    // Initialize memory context and bitmap buffer
+    // Initialize the framebuffer, black like a fresh compatible bitmap
+    createCanvas(canvas, 640, 480);
+    clearCanvas(canvas, rgb(0, 0, 0));
+    drawList.background = rgb(0, 0, 0);
+
+    // Memory context with a top-down 32 bit DIB section the canvas is copied into
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = canvas.width;
+    info.bmiHeader.biHeight = -canvas.height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
     memoryContext = CreateCompatibleDC(NULL);
-    bitmapBuffer = CreateCompatibleBitmap(GetDC(NULL), 640, 480);
+    bitmapBuffer = CreateDIBSection(memoryContext, &info, DIB_RGB_COLORS, (void**)&bitmapBits, NULL, 0);
     HGDIOBJ bmp = SelectObject(memoryContext, bitmapBuffer);
+    updatePresentBuffer(Rect{ 0, 0, canvas.width, canvas.height });
 
     // Register window class
     WNDCLASS wndclass = {};
@@ -0,0 +1,370 @@
+#include "batch2d.h"
+#include "gl_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <SFML/Window.hpp>
+
+namespace
+{
+    // Kada instancja to prostokt z czterech wierzchokw wyznaczonych z gl_VertexID,
+    // poszerzony o p obrysu i piksel na wygadzanie. Linie dostaj prostokt obrcony wzdu odcinka.
+    const GLchar* batchVertexSource = R"glsl(
+        #version 330 core
+        in vec4 bounds;
+        in vec4 params;
+        in vec4 fillColor;
+        in vec4 strokeColor;
+        in vec2 style;
+
+        uniform vec2 viewport;
+
+        out vec2 pixel;
+        flat out vec4 shapeBounds;
+        flat out vec4 shapeParams;
+        flat out vec4 shapeFill;
+        flat out vec4 shapeStroke;
+        flat out vec2 shapeStyle;
+
+        void main()
+        {
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            float margin = style.x * 0.5 + 1.0;
+
+            if (style.y < 0.5)
+            {
+                vec2 a = bounds.xy;
+                vec2 b = bounds.zw;
+                vec2 dir = b - a;
+                float len = length(dir);
+                dir = len > 0.0 ? dir / len : vec2(1.0, 0.0);
+                vec2 side = vec2(-dir.y, dir.x);
+                pixel = mix(a - dir * margin, b + dir * margin, corner.x) + side * mix(-margin, margin, corner.y);
+            }
+            else
+            {
+                vec2 lo = min(bounds.xy, bounds.zw) - margin;
+                vec2 hi = max(bounds.xy, bounds.zw) + margin;
+                pixel = mix(lo, hi, corner);
+            }
+
+            shapeBounds = bounds;
+            shapeParams = params;
+            shapeFill = fillColor;
+            shapeStroke = strokeColor;
+            shapeStyle = style;
+            gl_Position = vec4(pixel.x / viewport.x * 2.0 - 1.0, 1.0 - pixel.y / viewport.y * 2.0, 0.0, 1.0);
+        }
+    )glsl";
+
+    // Odlegoci jak w rasteryzatorze dema GDI, ujemne wewntrz ksztatu
+    const GLchar* batchFragmentSource = R"glsl(
+        #version 330 core
+        in vec2 pixel;
+        flat in vec4 shapeBounds;
+        flat in vec4 shapeParams;
+        flat in vec4 shapeFill;
+        flat in vec4 shapeStroke;
+        flat in vec2 shapeStyle;
+
+        out vec4 outColor;
+
+        float ellipseDistance(vec2 p, vec2 r)
+        {
+            float k0 = length(p / r);
+            float k1 = length(p / (r * r));
+            return k1 == 0.0 ? -min(r.x, r.y) : k0 * (k0 - 1.0) / k1;
+        }
+
+        float segmentDistance(vec2 p, vec2 a, vec2 b)
+        {
+            vec2 pa = p - a;
+            vec2 ba = b - a;
+            float len2 = dot(ba, ba);
+            float t = len2 > 0.0 ? clamp(dot(pa, ba) / len2, 0.0, 1.0) : 0.0;
+            return length(pa - ba * t);
+        }
+
+        void main()
+        {
+            int type = int(shapeStyle.y + 0.5);
+            float halfWidth = max(shapeStyle.x, 1.0) * 0.5;
+            vec2 center = (shapeBounds.xy + shapeBounds.zw) * 0.5;
+            vec2 halfSize = abs(shapeBounds.zw - shapeBounds.xy) * 0.5;
+            vec2 p = pixel - center;
+            float d;
+
+            if (type == 0)
+            {
+                // Linia ma tylko obrys
+                float coverage = clamp(halfWidth + 0.5 - segmentDistance(pixel, shapeBounds.xy, shapeBounds.zw), 0.0, 1.0);
+                float alpha = shapeStroke.a * coverage;
+                outColor = vec4(shapeStroke.rgb * alpha, alpha);
+                return;
+            }
+            else if (type == 1)
+            {
+                vec2 q = abs(p) - halfSize;
+                d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);
+            }
+            else if (type == 3)
+            {
+                vec2 r = shapeParams.xy;
+                vec2 a = abs(p);
+                vec2 k = halfSize - r;
+                d = (a.x > k.x && a.y > k.y) ? ellipseDistance(a - k, r) : max(a.x - halfSize.x, a.y - halfSize.y);
+            }
+            else
+            {
+                d = ellipseDistance(p, max(halfSize, vec2(0.5)));
+                if (type >= 4)
+                {
+                    // Wycinek midzy dwoma promieniami przeciwnie do wskazwek zegara, o y w gr
+                    vec2 q = vec2(p.x, -p.y);
+                    float d1 = shapeParams.y * q.x - shapeParams.x * q.y;
+                    float d2 = shapeParams.z * q.y - shapeParams.w * q.x;
+                    float wedge = type == 5 ? min(d1, d2) : max(d1, d2);
+                    d = max(d, wedge);
+                }
+            }
+
+            // Obrys nakadany na wypenienie, wynik z kanaem alfa przemnoonym
+            float fillCoverage = clamp(0.5 - d, 0.0, 1.0);
+            float strokeCoverage = clamp(halfWidth + 0.5 - abs(d), 0.0, 1.0);
+            float fillAlpha = shapeFill.a * fillCoverage;
+            float strokeAlpha = shapeStroke.a * strokeCoverage;
+            vec3 color = shapeFill.rgb * fillAlpha * (1.0 - strokeAlpha) + shapeStroke.rgb * strokeAlpha;
+            float alpha = fillAlpha * (1.0 - strokeAlpha) + strokeAlpha;
+            if (alpha <= 0.0) discard;
+            outColor = vec4(color, alpha);
+        }
+    )glsl";
+
+    void packColor(GLubyte* out, const glm::vec4& color)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            out[i] = (GLubyte)(std::min(std::max(color[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    ShapeInstance& addInstance(Batch2D& batch, ShapeKind kind, float left, float top, float right, float bottom,
+        const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth)
+    {
+        batch.shapes.emplace_back();
+        ShapeInstance& shape = batch.shapes.back();
+        shape.bounds[0] = left;
+        shape.bounds[1] = top;
+        shape.bounds[2] = right;
+        shape.bounds[3] = bottom;
+        shape.params[0] = shape.params[1] = shape.params[2] = shape.params[3] = 0.0f;
+        packColor(shape.fill, fill);
+        packColor(shape.stroke, stroke);
+        shape.strokeWidth = strokeWidth;
+        shape.type = (float)kind;
+        return shape;
+    }
+}
+
+bool createBatch2D(Batch2D& batch)
+{
+    batch.program = createProgram(batchVertexSource, batchFragmentSource,
+        { "bounds", "params", "fillColor", "strokeColor", "style" }, "2D batch");
+    if (!batch.program) return false;
+    batch.uniViewport = glGetUniformLocation(batch.program, "viewport");
+
+    glGenVertexArrays(1, &batch.vao);
+    glGenBuffers(1, &batch.instanceBuffer);
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instanceBuffer);
+
+    // Wszystkie atrybuty zmieniaj si co instancj, wierzchoki nie maj wasnych danych
+    GLsizei stride = sizeof(ShapeInstance);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(ShapeInstance, bounds));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(ShapeInstance, params));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(ShapeInstance, fill));
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(ShapeInstance, stroke));
+    glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(ShapeInstance, strokeWidth));
+    for (GLuint i = 0; i < 5; i++)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    glBindVertexArray(0);
+    checkGLErrors("After creating 2D batch");
+    return true;
+}
+
+void destroyBatch2D(Batch2D& batch)
+{
+    glDeleteProgram(batch.program);
+    glDeleteVertexArrays(1, &batch.vao);
+    glDeleteBuffers(1, &batch.instanceBuffer);
+    batch.program = 0;
+    batch.vao = 0;
+    batch.instanceBuffer = 0;
+    batch.capacity = 0;
+    batch.shapes.clear();
+}
+
+void batchLine(Batch2D& batch, float x1, float y1, float x2, float y2, float width, const glm::vec4& color)
+{
+    addInstance(batch, SHAPE_LINE, x1, y1, x2, y2, glm::vec4(0.0f), color, width);
+}
+
+void batchRectangle(Batch2D& batch, float left, float top, float right, float bottom, const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth)
+{
+    addInstance(batch, SHAPE_RECTANGLE, left, top, right, bottom, fill, stroke, strokeWidth);
+}
+
+void batchEllipse(Batch2D& batch, float left, float top, float right, float bottom, const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth)
+{
+    addInstance(batch, SHAPE_ELLIPSE, left, top, right, bottom, fill, stroke, strokeWidth);
+}
+
+void batchRoundRect(Batch2D& batch, float left, float top, float right, float bottom, float cornerWidth, float cornerHeight,
+    const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth)
+{
+    ShapeInstance& shape = addInstance(batch, SHAPE_ROUND_RECT, left, top, right, bottom, fill, stroke, strokeWidth);
+    float hx = std::fabs(right - left) * 0.5f;
+    float hy = std::fabs(bottom - top) * 0.5f;
+    shape.params[0] = std::min(std::max(cornerWidth * 0.5f, 0.5f), hx);
+    shape.params[1] = std::min(std::max(cornerHeight * 0.5f, 0.5f), hy);
+}
+
+void batchPie(Batch2D& batch, float left, float top, float right, float bottom, float xr1, float yr1, float xr2, float yr2,
+    const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth)
+{
+    // Kty promieni liczone przeciwnie do wskazwek zegara na ekranie, wic o y jest odwrcona
+    float cx = (left + right) * 0.5f, cy = (top + bottom) * 0.5f;
+    float a1 = std::atan2(cy - yr1, xr1 - cx);
+    float a2 = std::atan2(cy - yr2, xr2 - cx);
+    float sweep = a2 - a1;
+    const float twoPi = 6.28318531f;
+    while (sweep <= 0.0f) sweep += twoPi;
+
+    ShapeInstance& shape = addInstance(batch, sweep > twoPi * 0.5f ? SHAPE_PIE_WIDE : SHAPE_PIE,
+        left, top, right, bottom, fill, stroke, strokeWidth);
+    shape.params[0] = std::cos(a1);
+    shape.params[1] = std::sin(a1);
+    shape.params[2] = std::cos(a2);
+    shape.params[3] = std::sin(a2);
+}
+
+void flushBatch2D(Batch2D& batch, int viewportWidth, int viewportHeight)
+{
+    if (batch.shapes.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, batch.instanceBuffer);
+    size_t bytes = batch.shapes.size() * sizeof(ShapeInstance);
+    if (batch.shapes.size() > batch.capacity)
+    {
+        batch.capacity = std::max(batch.shapes.size(), batch.capacity * 2);
+    }
+    // Osierocenie starego bufora, sterownik nie czeka a GPU skoczy poprzedni klatk
+    glBufferData(GL_ARRAY_BUFFER, batch.capacity * sizeof(ShapeInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.shapes.data());
+
+    // Ksztaty rysowane w kolejnoci dodania, bez z-bufora
+    GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(batch.program);
+    glUniform2f(batch.uniViewport, (float)viewportWidth, (float)viewportHeight);
+    glBindVertexArray(batch.vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)batch.shapes.size());
+    glBindVertexArray(0);
+    batch.drawCalls++;
+
+    if (depthTest) glEnable(GL_DEPTH_TEST);
+    if (!blend) glDisable(GL_BLEND);
+    batch.shapes.clear();
+}
+
+void batchDemoShapes(Batch2D& batch)
+{
+    glm::vec4 pen(1.0f, 0.0f, 1.0f, 1.0f);
+    glm::vec4 brush(1.0f, 1.0f, 0.0f, 1.0f);
+    batchLine(batch, 50, 50, 200, 200, 2.0f, pen);
+    batchRectangle(batch, 100, 100, 300, 200, brush, pen, 2.0f);
+    batchEllipse(batch, 150, 200, 350, 250, brush, pen, 2.0f);
+    batchRoundRect(batch, 300, 300, 500, 400, 100, 100, brush, pen, 2.0f);
+    batchPie(batch, 200, 300, 400, 400, 300, 200, 300, 400, brush, pen, 2.0f);
+}
+
+int runBatch2DBenchmark(sf::Window& window, int count)
+{
+    Batch2D batch;
+    if (!createBatch2D(batch)) return 1;
+
+    // Bez synchronizacji pionowej, inaczej mierzylibymy odwieanie monitora
+    window.setVerticalSyncEnabled(false);
+    window.setFramerateLimit(0);
+    int width = (int)window.getSize().x;
+    int height = (int)window.getSize().y;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> posX(0.0f, (float)width);
+    std::uniform_real_distribution<float> posY(0.0f, (float)height);
+    std::uniform_real_distribution<float> size(4.0f, 40.0f);
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+    const int frames = 200;
+    const int warmup = 20;
+    double submitSeconds = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames + warmup; frame++)
+    {
+        if (frame == warmup)
+        {
+            glFinish();
+            submitSeconds = 0.0;
+            start = std::chrono::steady_clock::now();
+        }
+
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent)) {}
+
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        auto submitStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+        {
+            float x = posX(rng), y = posY(rng);
+            float w = size(rng), h = size(rng);
+            glm::vec4 fill(channel(rng), channel(rng), channel(rng), 1.0f);
+            glm::vec4 stroke(channel(rng), channel(rng), channel(rng), 1.0f);
+            switch (i % 5)
+            {
+            case 0: batchLine(batch, x, y, x + w, y + h, 2.0f, stroke); break;
+            case 1: batchRectangle(batch, x, y, x + w, y + h, fill, stroke, 2.0f); break;
+            case 2: batchEllipse(batch, x, y, x + w, y + h, fill, stroke, 2.0f); break;
+            case 3: batchRoundRect(batch, x, y, x + w, y + h, w * 0.5f, h * 0.5f, fill, stroke, 2.0f); break;
+            case 4: batchPie(batch, x, y, x + w, y + h, x + w, y, x, y + h, fill, stroke, 2.0f); break;
+            }
+        }
+        flushBatch2D(batch, width, height);
+        submitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+
+        window.display();
+    }
+    glFinish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "2D batch: " << count << " shapes, " << width << "x" << height << std::endl;
+    std::cout << "  submit: " << submitSeconds / frames * 1000.0 << " ms/frame" << std::endl;
+    std::cout << "  frame: " << seconds / frames * 1000.0 << " ms (" << frames / seconds << " FPS)" << std::endl;
+    std::cout << "  " << (long long)(count * (double)frames / seconds) << " shapes/s" << std::endl;
+
+    destroyBatch2D(batch);
+    checkGLErrors("After 2D batch benchmark");
+    return 0;
+}
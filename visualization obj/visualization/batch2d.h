@@ -0,0 +1,66 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Prymitywy 2D z dema GDI (linia, prostokt, elipsa, zaokrglony prostokt, wycinek) zbierane
+// w jednym dynamicznym buforze i rysowane jednym wywoaniem. Ksztat liczony jest w shaderze
+// fragmentw z odlegoci od krawdzi (SDF), wic nie ma teselacji. Wsprzdne w pikselach okna.
+
+// Dane jednego ksztatu, jedna instancja na ksztat
+struct ShapeInstance
+{
+    float bounds[4];   // left, top, right, bottom; dla linii koce odcinka
+    float params[4];   // promienie naronikw lub kierunki ramion wycinka
+    GLubyte fill[4];   // Kolor wypenienia RGBA
+    GLubyte stroke[4]; // Kolor obrysu RGBA
+    float strokeWidth;
+    float type;        // ShapeKind
+};
+
+enum ShapeKind
+{
+    SHAPE_LINE = 0,
+    SHAPE_RECTANGLE = 1,
+    SHAPE_ELLIPSE = 2,
+    SHAPE_ROUND_RECT = 3,
+    SHAPE_PIE = 4,      // Wycinek mniejszy ni p obrotu
+    SHAPE_PIE_WIDE = 5  // Wycinek wikszy ni p obrotu
+};
+
+struct Batch2D
+{
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint instanceBuffer = 0;
+    GLint uniViewport = -1;
+    size_t capacity = 0;                // Pojemno bufora w ksztatach
+    std::vector<ShapeInstance> shapes;  // Ksztaty biecej klatki
+    unsigned drawCalls = 0;             // Wywoania rysowania od ostatniego resetu
+};
+
+bool createBatch2D(Batch2D& batch);
+void destroyBatch2D(Batch2D& batch);
+
+// Dodawanie ksztatw, argumenty jak w wywoaniach GDI
+void batchLine(Batch2D& batch, float x1, float y1, float x2, float y2, float width, const glm::vec4& color);
+void batchRectangle(Batch2D& batch, float left, float top, float right, float bottom, const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth);
+void batchEllipse(Batch2D& batch, float left, float top, float right, float bottom, const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth);
+void batchRoundRect(Batch2D& batch, float left, float top, float right, float bottom, float cornerWidth, float cornerHeight,
+    const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth);
+void batchPie(Batch2D& batch, float left, float top, float right, float bottom, float xr1, float yr1, float xr2, float yr2,
+    const glm::vec4& fill, const glm::vec4& stroke, float strokeWidth);
+
+// Wysanie zebranych ksztatw jednym wywoaniem i wyczyszczenie listy
+void flushBatch2D(Batch2D& batch, int viewportWidth, int viewportHeight);
+
+// Ksztaty rysowane przez demo GDI, z tym samym pirem i pdzlem
+void batchDemoShapes(Batch2D& batch);
+
+// Pomiar: count losowych ksztatw na klatk, wypisuje czas przygotowania, czas klatki i ksztaty na sekund
+int runBatch2DBenchmark(sf::Window& window, int count);
@@ -0,0 +1,414 @@
+#include "chunk_file.h"
+#include "mapped_file.h"
+#include "mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    const uint32_t noIndex = 0xFFFFFFFFu;
+
+    // Naronik trjkta jako indeksy do tablic v, vt i vn pliku obj
+    struct Corner
+    {
+        uint32_t position;
+        uint32_t texCoord;
+        uint32_t normal;
+    };
+
+    struct CornerHash
+    {
+        size_t operator()(const Corner& c) const
+        {
+            size_t h = 2166136261u;
+            h = (h ^ c.position) * 16777619u;
+            h = (h ^ c.texCoord) * 16777619u;
+            h = (h ^ c.normal) * 16777619u;
+            return h;
+        }
+    };
+
+    struct CornerEqual
+    {
+        bool operator()(const Corner& a, const Corner& b) const
+        {
+            return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+        }
+    };
+
+    // Indeks obj: od 1, ujemny liczony od koca, brak oznaczony noIndex
+    uint32_t resolveIndex(long value, uint64_t count)
+    {
+        if (value > 0 && (uint64_t)value <= count) return (uint32_t)(value - 1);
+        if (value < 0 && (uint64_t)(-value) <= count) return (uint32_t)(count + value);
+        return noIndex;
+    }
+
+    // Naronik ciany w formacie v, v/vt, v//vn lub v/vt/vn
+    bool parseCorner(const char*& p, uint64_t positions, uint64_t texCoords, uint64_t normals, Corner& corner)
+    {
+        char* end;
+        long value = std::strtol(p, &end, 10);
+        if (end == p) return false;
+        corner.position = resolveIndex(value, positions);
+        corner.texCoord = noIndex;
+        corner.normal = noIndex;
+        p = end;
+
+        if (*p == '/')
+        {
+            p++;
+            if (*p != '/')
+            {
+                value = std::strtol(p, &end, 10);
+                if (end != p) corner.texCoord = resolveIndex(value, texCoords);
+                p = end;
+            }
+            if (*p == '/')
+            {
+                p++;
+                value = std::strtol(p, &end, 10);
+                if (end != p) corner.normal = resolveIndex(value, normals);
+                p = end;
+            }
+        }
+        return corner.position != noIndex;
+    }
+
+    template <typename T>
+    void writeValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void padToPage(std::ofstream& out)
+    {
+        static const char zeros[chunkPageSize] = {};
+        uint64_t position = (uint64_t)out.tellp();
+        uint64_t padding = (chunkPageSize - position % chunkPageSize) % chunkPageSize;
+        out.write(zeros, (std::streamsize)padding);
+    }
+
+    // Siatka komrek o zblionej liczbie trjktw przy rwnomiernym rozkadzie,
+    // paskie osie (np. teren) dostaj jedn warstw
+    glm::ivec3 gridDimensions(const glm::vec3& extent, uint64_t targetCells)
+    {
+        const uint64_t maxCells = 1u << 21;
+        targetCells = std::max<uint64_t>(1, std::min(targetCells, maxCells));
+
+        float largest = std::max(extent.x, std::max(extent.y, extent.z));
+        double volume = 1.0;
+        int axes = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            if (extent[i] > largest * 1e-3f)
+            {
+                volume *= extent[i];
+                axes++;
+            }
+        }
+        if (axes == 0) return glm::ivec3(1);
+
+        double cell = std::pow(volume / (double)targetCells, 1.0 / axes);
+        glm::ivec3 dims;
+        for (int i = 0; i < 3; i++)
+        {
+            dims[i] = extent[i] > largest * 1e-3f ? std::max(1, (int)std::lround(extent[i] / cell)) : 1;
+        }
+        return dims;
+    }
+}
+
+bool buildChunkFile(const std::string& objPath, const std::string& chunkPath, uint32_t chunkTriangles)
+{
+    std::ifstream file(objPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Cannot open file: " << objPath << std::endl;
+        return false;
+    }
+    chunkTriangles = std::max(chunkTriangles, 64u);
+
+    // Przebieg 1: atrybuty i trjkty do plikw tymczasowych, w pamici tylko liczniki
+    const std::string positionPath = chunkPath + ".v.tmp";
+    const std::string texCoordPath = chunkPath + ".vt.tmp";
+    const std::string normalPath = chunkPath + ".vn.tmp";
+    const std::string cornerPath = chunkPath + ".f.tmp";
+    const std::string orderPath = chunkPath + ".order.tmp";
+    auto removeTemporary = [&]()
+    {
+        std::remove(positionPath.c_str());
+        std::remove(texCoordPath.c_str());
+        std::remove(normalPath.c_str());
+        std::remove(cornerPath.c_str());
+        std::remove(orderPath.c_str());
+    };
+
+    uint64_t positionCount = 0, texCoordCount = 0, normalCount = 0, triangleCount = 0;
+    glm::vec3 boundsMin(INFINITY), boundsMax(-INFINITY);
+    {
+        std::ofstream positions(positionPath, std::ios::binary);
+        std::ofstream texCoords(texCoordPath, std::ios::binary);
+        std::ofstream normals(normalPath, std::ios::binary);
+        std::ofstream corners(cornerPath, std::ios::binary);
+        if (!positions || !texCoords || !normals || !corners)
+        {
+            std::cerr << "Cannot create temporary files next to: " << chunkPath << std::endl;
+            removeTemporary();
+            return false;
+        }
+
+        std::string line;
+        std::vector<Corner> face;
+        while (std::getline(file, line))
+        {
+            const char* p = line.c_str();
+            char* end;
+            if (p[0] == 'v' && p[1] == ' ')
+            {
+                glm::vec3 v;
+                v.x = std::strtof(p + 2, &end);
+                v.y = std::strtof(end, &end);
+                v.z = std::strtof(end, &end);
+                writeValue(positions, v);
+                boundsMin = glm::min(boundsMin, v);
+                boundsMax = glm::max(boundsMax, v);
+                positionCount++;
+            }
+            else if (p[0] == 'v' && p[1] == 't' && p[2] == ' ')
+            {
+                glm::vec2 t;
+                t.x = std::strtof(p + 3, &end);
+                t.y = std::strtof(end, &end);
+                writeValue(texCoords, t);
+                texCoordCount++;
+            }
+            else if (p[0] == 'v' && p[1] == 'n' && p[2] == ' ')
+            {
+                glm::vec3 n;
+                n.x = std::strtof(p + 3, &end);
+                n.y = std::strtof(end, &end);
+                n.z = std::strtof(end, &end);
+                writeValue(normals, n);
+                normalCount++;
+            }
+            else if (p[0] == 'f' && p[1] == ' ')
+            {
+                face.clear();
+                p += 2;
+                Corner corner;
+                while (true)
+                {
+                    while (*p == ' ' || *p == '\t') p++;
+                    if (*p == '\0' || *p == '\r') break;
+                    if (!parseCorner(p, positionCount, texCoordCount, normalCount, corner))
+                    {
+                        std::cerr << "Error: Invalid face: " << line << std::endl;
+                        removeTemporary();
+                        return false;
+                    }
+                    face.push_back(corner);
+                }
+
+                // Wielokty dzielone wachlarzem
+                for (size_t i = 2; i < face.size(); i++)
+                {
+                    writeValue(corners, face[0]);
+                    writeValue(corners, face[i - 1]);
+                    writeValue(corners, face[i]);
+                    triangleCount++;
+                }
+            }
+        }
+    }
+
+    if (triangleCount == 0)
+    {
+        std::cerr << "Error: No triangles in " << objPath << std::endl;
+        removeTemporary();
+        return false;
+    }
+    std::cout << "Chunking " << objPath << ": " << positionCount << " positions, " << triangleCount << " triangles" << std::endl;
+
+    MappedFile positionFile, texCoordFile, normalFile, cornerFile, orderFile;
+    auto closeAll = [&]()
+    {
+        unmapFile(positionFile);
+        unmapFile(texCoordFile);
+        unmapFile(normalFile);
+        unmapFile(cornerFile);
+        unmapFile(orderFile);
+        removeTemporary();
+    };
+    if (!mapFile(positionFile, positionPath) || !mapFile(texCoordFile, texCoordPath) ||
+        !mapFile(normalFile, normalPath) || !mapFile(cornerFile, cornerPath) ||
+        !createMappedFile(orderFile, orderPath, triangleCount * sizeof(uint64_t)))
+    {
+        closeAll();
+        return false;
+    }
+    const glm::vec3* positions = reinterpret_cast<const glm::vec3*>(positionFile.data);
+    const glm::vec2* texCoords = reinterpret_cast<const glm::vec2*>(texCoordFile.data);
+    const glm::vec3* normals = reinterpret_cast<const glm::vec3*>(normalFile.data);
+    const Corner* corners = reinterpret_cast<const Corner*>(cornerFile.data);
+    uint64_t* order = reinterpret_cast<uint64_t*>(orderFile.data);
+
+    auto centroid = [&](uint64_t triangle)
+    {
+        const Corner* c = corners + triangle * 3;
+        return (positions[c[0].position] + positions[c[1].position] + positions[c[2].position]) / 3.0f;
+    };
+
+    // Przebieg 2: trjkty do komrek siatki wedug rodka, kolejno zapisana w pliku
+    glm::vec3 extent = boundsMax - boundsMin;
+    glm::ivec3 dims = gridDimensions(extent, (triangleCount + chunkTriangles - 1) / chunkTriangles);
+    glm::vec3 cellScale = glm::vec3(dims) / glm::max(extent, glm::vec3(1e-20f));
+    auto cellOf = [&](uint64_t triangle)
+    {
+        glm::ivec3 cell = glm::ivec3((centroid(triangle) - boundsMin) * cellScale);
+        cell = glm::clamp(cell, glm::ivec3(0), dims - 1);
+        return (size_t)((cell.z * dims.y + cell.y) * dims.x + cell.x);
+    };
+
+    std::vector<uint64_t> cellStart((size_t)dims.x * dims.y * dims.z + 1, 0);
+    for (uint64_t t = 0; t < triangleCount; t++) cellStart[cellOf(t) + 1]++;
+
+    uint64_t chunkCount = 0;
+    for (size_t c = 1; c < cellStart.size(); c++)
+    {
+        chunkCount += (cellStart[c] + chunkTriangles - 1) / chunkTriangles;
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    std::vector<uint64_t> cursor(cellStart.begin(), cellStart.end() - 1);
+    for (uint64_t t = 0; t < triangleCount; t++) order[cursor[cellOf(t)]++] = t;
+
+    // Przebieg 3: kawaki po kolei, nagwek i tablica uzupeniane na kocu
+    std::ofstream out(chunkPath, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot create file: " << chunkPath << std::endl;
+        closeAll();
+        return false;
+    }
+
+    ChunkFileHeader header = {};
+    std::memcpy(header.magic, "OBJC", 4);
+    header.version = chunkFileVersion;
+    header.chunkCount = (uint32_t)chunkCount;
+    header.boundsMin = boundsMin;
+    header.boundsMax = boundsMax;
+
+    std::vector<ChunkInfo> chunks((size_t)chunkCount);
+    writeValue(out, header);
+    out.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(ChunkInfo));
+    chunks.clear();
+
+    std::vector<uint64_t> cellTriangles;
+    std::unordered_map<Corner, uint32_t, CornerHash, CornerEqual> remap;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (size_t c = 0; c + 1 < cellStart.size(); c++)
+    {
+        uint64_t count = cellStart[c + 1] - cellStart[c];
+        if (count == 0) continue;
+        cellTriangles.assign(order + cellStart[c], order + cellStart[c + 1]);
+        releasePages(orderFile, cellStart[c] * sizeof(uint64_t), count * sizeof(uint64_t));
+
+        // Przepeniona komrka dzielona wzdu najduszej osi rodkw trjktw
+        uint64_t pieces = (count + chunkTriangles - 1) / chunkTriangles;
+        if (pieces > 1)
+        {
+            glm::vec3 low(INFINITY), high(-INFINITY);
+            for (uint64_t t : cellTriangles)
+            {
+                low = glm::min(low, centroid(t));
+                high = glm::max(high, centroid(t));
+            }
+            glm::vec3 size = high - low;
+            int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+            std::sort(cellTriangles.begin(), cellTriangles.end(), [&](uint64_t a, uint64_t b)
+                {
+                    return centroid(a)[axis] < centroid(b)[axis];
+                });
+        }
+
+        for (uint64_t piece = 0; piece < pieces; piece++)
+        {
+            uint64_t first = count * piece / pieces, last = count * (piece + 1) / pieces;
+
+            remap.clear();
+            vertices.clear();
+            indices.clear();
+            for (uint64_t i = first; i < last; i++)
+            {
+                const Corner* c3 = corners + cellTriangles[i] * 3;
+                glm::vec3 faceNormal = glm::cross(positions[c3[1].position] - positions[c3[0].position],
+                    positions[c3[2].position] - positions[c3[0].position]);
+                for (int k = 0; k < 3; k++)
+                {
+                    auto inserted = remap.emplace(c3[k], (uint32_t)vertices.size());
+                    if (inserted.second)
+                    {
+                        Vertex vertex;
+                        vertex.position = positions[c3[k].position];
+                        vertex.normal = c3[k].normal != noIndex ? normals[c3[k].normal] : glm::vec3(0.0f);
+                        vertex.texCoord = c3[k].texCoord != noIndex ? texCoords[c3[k].texCoord] : glm::vec2(0.0f);
+                        vertices.push_back(vertex);
+                    }
+                    // Bez vn normalna wygadzana z ssiednich cian kawaka
+                    if (c3[k].normal == noIndex) vertices[inserted.first->second].normal += faceNormal;
+                    indices.push_back(inserted.first->second);
+                }
+            }
+
+            ChunkInfo info = {};
+            info.boundsMin = glm::vec3(INFINITY);
+            info.boundsMax = glm::vec3(-INFINITY);
+            for (Vertex& v : vertices)
+            {
+                if (glm::dot(v.normal, v.normal) > 0.0f) v.normal = glm::normalize(v.normal);
+                info.boundsMin = glm::min(info.boundsMin, v.position);
+                info.boundsMax = glm::max(info.boundsMax, v.position);
+            }
+            info.center = (info.boundsMin + info.boundsMax) * 0.5f;
+            info.radius = 0.0f;
+            for (const Vertex& v : vertices) info.radius = std::max(info.radius, glm::length(v.position - info.center));
+
+            padToPage(out);
+            info.offset = (uint64_t)out.tellp();
+            info.vertexCount = (uint32_t)vertices.size();
+            info.indexCount = (uint32_t)indices.size();
+            out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(Vertex));
+            out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+            chunks.push_back(info);
+
+            header.maxVertices = std::max(header.maxVertices, info.vertexCount);
+            header.maxIndices = std::max(header.maxIndices, info.indexCount);
+        }
+    }
+    padToPage(out);
+
+    out.seekp(0);
+    writeValue(out, header);
+    out.write(reinterpret_cast<const char*>(chunks.data()), chunks.size() * sizeof(ChunkInfo));
+    bool ok = out.good();
+    out.close();
+    closeAll();
+
+    if (!ok)
+    {
+        std::cerr << "Error writing " << chunkPath << std::endl;
+        return false;
+    }
+    std::cout << "Chunk file " << chunkPath << ": " << chunkCount << " chunks in a " << dims.x << "x" << dims.y << "x" << dims.z
+        << " grid, at most " << header.maxVertices << " vertices and " << header.maxIndices / 3 << " triangles per chunk" << std::endl;
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+
+// Plik kawakw siatki do strumieniowania. Siatka jest dzielona na przestrzenne kawaki
+// o ograniczonej liczbie trjktw, kady z wasnymi wierzchokami (Vertex) i lokalnymi
+// indeksami 32-bitowymi, zaczynajcy si na granicy strony. Na pocztku pliku nagwek
+// i tablica kawakw z ich granicami.
+
+const uint32_t chunkFileVersion = 1;
+const uint32_t chunkPageSize = 4096;
+
+struct ChunkFileHeader
+{
+    char magic[4];         // "OBJC"
+    uint32_t version;
+    uint32_t chunkCount;
+    uint32_t maxVertices;  // Najwikszy kawaek, wyznacza rozmiar miejsca w puli GPU
+    uint32_t maxIndices;
+    uint32_t reserved;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+struct ChunkInfo
+{
+    glm::vec3 center;      // Sfera otaczajca
+    float radius;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    uint64_t offset;       // Pooenie wierzchokw w pliku, po nich indeksy
+    uint32_t vertexCount;
+    uint32_t indexCount;
+};
+
+// Przetworzenie dowolnie duego pliku obj na plik kawakw. Dane porednie trafiaj do plikw
+// tymczasowych obok wyniku, w pamici s tylko liczniki komrek i jeden kawaek naraz.
+bool buildChunkFile(const std::string& objPath, const std::string& chunkPath, uint32_t chunkTriangles = 16384);
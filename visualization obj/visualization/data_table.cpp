@@ -0,0 +1,673 @@
+#include "data_table.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include "memory.h"
+#include "text.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+    const uint32_t columnCacheVersion = 1;
+    const size_t typeSampleRows = 1000;
+    const uint64_t pointLabelLimit = 20000; // Do tylu punktw kady dostaje etykiet z wartoci y
+
+    struct ColumnCacheHeader
+    {
+        char magic[4];         // "COLS"
+        uint32_t version;
+        uint32_t columnCount;
+        uint32_t reserved;
+        uint64_t rowCount;
+    };
+
+    struct ColumnCacheEntry
+    {
+        uint32_t type;
+        uint32_t nameLength;
+        uint64_t offset;       // Pooenie wartoci w pliku, wyrwnane do 64 bajtw
+    };
+
+    // Jedno pole od begin, koniec pola w fieldEnd, zwraca pocztek nastpnego pola (za separatorem)
+    const char* nextField(const char* begin, const char* lineEnd, char delimiter, const char*& fieldBegin, const char*& fieldEnd)
+    {
+        while (begin < lineEnd && *begin == ' ') begin++;
+        if (begin < lineEnd && *begin == '"')
+        {
+            // Cudzysw w polu zapisany jako dwa cudzysowy
+            const char* quote = begin + 1;
+            while (true)
+            {
+                quote = static_cast<const char*>(std::memchr(quote, '"', lineEnd - quote));
+                if (!quote || quote + 1 >= lineEnd || quote[1] != '"') break;
+                quote += 2;
+            }
+            fieldBegin = begin + 1;
+            fieldEnd = quote ? quote : lineEnd;
+            const char* delimiterPos = quote ? static_cast<const char*>(std::memchr(quote, delimiter, lineEnd - quote)) : nullptr;
+            return delimiterPos ? delimiterPos + 1 : lineEnd + 1;
+        }
+        const char* delimiterPos = static_cast<const char*>(std::memchr(begin, delimiter, lineEnd - begin));
+        fieldBegin = begin;
+        fieldEnd = delimiterPos ? delimiterPos : lineEnd;
+        return fieldEnd + 1;
+    }
+
+    void trim(const char*& begin, const char*& end)
+    {
+        while (begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        if (begin < end && *begin == '+') begin++;
+    }
+
+    // Liczba z caego pola, puste pole to NaN; false, gdy pole nie jest liczb
+    template <typename T>
+    bool parseNumber(const char* begin, const char* end, T& value)
+    {
+        trim(begin, end);
+        if (begin == end)
+        {
+            value = std::numeric_limits<T>::quiet_NaN();
+            return true;
+        }
+        std::from_chars_result result = std::from_chars(begin, end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    // Cyfry znaczce mantysy, bez zer wiodcych
+    int significantDigits(const char* begin, const char* end)
+    {
+        int digits = 0;
+        bool leading = true;
+        for (const char* c = begin; c < end && *c != 'e' && *c != 'E'; c++)
+        {
+            if (*c < '0' || *c > '9') continue;
+            if (*c == '0' && leading) continue;
+            leading = false;
+            digits++;
+        }
+        return digits;
+    }
+
+    // Koniec wiersza bez '\r', pusty wiersz to taki bez adnego znaku
+    const char* lineEndOf(const char* begin, const char* newline)
+    {
+        return newline > begin && newline[-1] == '\r' ? newline - 1 : newline;
+    }
+
+    uint64_t countRows(const char* begin, const char* end)
+    {
+        uint64_t rows = 0;
+        while (begin < end)
+        {
+            const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+            if (!newline) newline = end;
+            if (lineEndOf(begin, newline) > begin) rows++;
+            begin = newline + 1;
+        }
+        return rows;
+    }
+
+    template <typename T>
+    void writeValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+bool loadCsv(const std::string& path, DataTable& table, unsigned threads)
+{
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!mapFile(file, path)) return false;
+    const char* data = reinterpret_cast<const char*>(file.data);
+    const char* end = data + file.size;
+    if (file.size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) data += 3;
+
+    // Nagwek, separator to najczstszy z przecinka, rednika i tabulatora
+    const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+    if (!newline) newline = end;
+    const char* headerEnd = lineEndOf(data, newline);
+    table = DataTable();
+    size_t best = 0;
+    for (char candidate : { ',', ';', '\t' })
+    {
+        size_t count = (size_t)std::count(data, headerEnd, candidate);
+        if (count > best)
+        {
+            best = count;
+            table.delimiter = candidate;
+        }
+    }
+    for (const char* field = data; field <= headerEnd;)
+    {
+        const char* nameBegin;
+        const char* nameEnd;
+        field = nextField(field, headerEnd, table.delimiter, nameBegin, nameEnd);
+        trim(nameBegin, nameEnd);
+        DataColumn column;
+        column.name.assign(nameBegin, nameEnd);
+        table.columns.push_back(column);
+    }
+    const char* body = std::min(newline + 1, end);
+
+    // Typy z pocztkowych wierszy: liczba, gdy kade niepuste pole jest liczb
+    std::vector<int> digits(table.columns.size(), 0);
+    std::vector<bool> numeric(table.columns.size(), true);
+    const char* line = body;
+    for (size_t row = 0; row < typeSampleRows && line < end;)
+    {
+        const char* lineNewline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!lineNewline) lineNewline = end;
+        const char* lineEnd = lineEndOf(line, lineNewline);
+        if (lineEnd > line)
+        {
+            const char* field = line;
+            for (size_t c = 0; c < table.columns.size() && field <= lineEnd; c++)
+            {
+                const char* fieldBegin;
+                const char* fieldEnd;
+                field = nextField(field, lineEnd, table.delimiter, fieldBegin, fieldEnd);
+                double value;
+                if (!parseNumber(fieldBegin, fieldEnd, value)) numeric[c] = false;
+                else digits[c] = std::max(digits[c], significantDigits(fieldBegin, fieldEnd));
+            }
+            row++;
+        }
+        line = lineNewline + 1;
+    }
+    for (size_t c = 0; c < table.columns.size(); c++)
+    {
+        table.columns[c].type = !numeric[c] ? ColumnType::Text : digits[c] > 7 ? ColumnType::Double : ColumnType::Float;
+    }
+
+    // Zakresy penych wierszy dla wtkw i liczba wierszy w kadym
+    if (threads == 0) threads = jobThreadCount();
+    uint64_t bodySize = (uint64_t)(end - body);
+    unsigned parts = (unsigned)std::max<uint64_t>(1, std::min<uint64_t>(threads * 4, bodySize / (1 << 20)));
+    std::vector<const char*> bounds(parts + 1, end);
+    bounds[0] = body;
+    for (unsigned i = 1; i < parts; i++)
+    {
+        const char* split = body + bodySize * i / parts;
+        const char* splitNewline = static_cast<const char*>(std::memchr(split, '\n', end - split));
+        bounds[i] = std::max(bounds[i - 1], splitNewline ? splitNewline + 1 : end);
+    }
+    std::vector<uint64_t> firstRow(parts + 1, 0);
+    parallelFor(parts, [&](unsigned begin, unsigned finish)
+    {
+        for (unsigned part = begin; part < finish; part++) firstRow[part + 1] = countRows(bounds[part], bounds[part + 1]);
+    }, threads);
+    for (unsigned part = 0; part < parts; part++) firstRow[part + 1] += firstRow[part];
+    table.rowCount = firstRow[parts];
+
+    for (DataColumn& column : table.columns)
+    {
+        if (column.type == ColumnType::Float) column.floats.resize((size_t)table.rowCount);
+        if (column.type == ColumnType::Double) column.doubles.resize((size_t)table.rowCount);
+    }
+
+    // Parsowanie: kady zakres pisze do swoich wierszy w tablicach kolumn
+    std::vector<uint64_t> badFields(parts, 0);
+    parallelFor(parts, [&](unsigned begin, unsigned finish)
+    {
+        for (unsigned part = begin; part < finish; part++)
+        {
+            uint64_t row = firstRow[part];
+            for (const char* line = bounds[part]; line < bounds[part + 1];)
+            {
+                const char* lineNewline = static_cast<const char*>(std::memchr(line, '\n', bounds[part + 1] - line));
+                if (!lineNewline) lineNewline = bounds[part + 1];
+                const char* lineEnd = lineEndOf(line, lineNewline);
+                if (lineEnd > line)
+                {
+                    const char* field = line;
+                    for (DataColumn& column : table.columns)
+                    {
+                        const char* fieldBegin = lineEnd;
+                        const char* fieldEnd = lineEnd;
+                        if (field <= lineEnd) field = nextField(field, lineEnd, table.delimiter, fieldBegin, fieldEnd);
+                        if (column.type == ColumnType::Float && !parseNumber(fieldBegin, fieldEnd, column.floats[row]))
+                        {
+                            column.floats[row] = std::numeric_limits<float>::quiet_NaN();
+                            badFields[part]++;
+                        }
+                        if (column.type == ColumnType::Double && !parseNumber(fieldBegin, fieldEnd, column.doubles[row]))
+                        {
+                            column.doubles[row] = std::numeric_limits<double>::quiet_NaN();
+                            badFields[part]++;
+                        }
+                    }
+                    row++;
+                }
+                line = lineNewline + 1;
+            }
+        }
+    }, threads);
+    unmapFile(file);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t bad = 0;
+    for (uint64_t count : badFields) bad += count;
+    std::cout << "Loaded " << path << ": " << table.rowCount << " rows, " << table.columns.size() << " columns in "
+        << seconds * 1000.0 << " ms (" << bodySize / seconds / (1024 * 1024) << " MB/s, " << table.rowCount / seconds / 1e6
+        << " M rows/s, " << threads << " threads)";
+    if (bad) std::cout << ", " << bad << " non-numeric fields stored as NaN";
+    std::cout << std::endl;
+    return true;
+}
+
+bool saveColumnCache(const std::string& path, const DataTable& table)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot create file: " << path << std::endl;
+        return false;
+    }
+
+    ColumnCacheHeader header = {};
+    std::memcpy(header.magic, "COLS", 4);
+    header.version = columnCacheVersion;
+    header.columnCount = (uint32_t)table.columns.size();
+    header.rowCount = table.rowCount;
+
+    // Nagwek, wpisy kolumn, nazwy, a za nimi wartoci kolumn po kolei
+    std::vector<ColumnCacheEntry> entries(table.columns.size());
+    uint64_t offset = sizeof(header) + entries.size() * sizeof(ColumnCacheEntry);
+    for (const DataColumn& column : table.columns) offset += column.name.size();
+    for (size_t c = 0; c < table.columns.size(); c++)
+    {
+        const DataColumn& column = table.columns[c];
+        offset = (offset + 63) / 64 * 64;
+        entries[c].type = (uint32_t)column.type;
+        entries[c].nameLength = (uint32_t)column.name.size();
+        entries[c].offset = offset;
+        offset += column.floats.size() * sizeof(float) + column.doubles.size() * sizeof(double);
+    }
+
+    writeValue(out, header);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ColumnCacheEntry));
+    for (const DataColumn& column : table.columns) out.write(column.name.data(), column.name.size());
+    static const char zeros[64] = {};
+    for (size_t c = 0; c < table.columns.size(); c++)
+    {
+        const DataColumn& column = table.columns[c];
+        out.write(zeros, (std::streamsize)(entries[c].offset - (uint64_t)out.tellp()));
+        out.write(reinterpret_cast<const char*>(column.floats.data()), column.floats.size() * sizeof(float));
+        out.write(reinterpret_cast<const char*>(column.doubles.data()), column.doubles.size() * sizeof(double));
+    }
+    if (!out.good())
+    {
+        std::cerr << "Error writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadColumnCache(const std::string& path, DataTable& table)
+{
+    MappedFile file;
+    if (!mapFile(file, path)) return false;
+
+    const ColumnCacheHeader* header = reinterpret_cast<const ColumnCacheHeader*>(file.data);
+    if (file.size < sizeof(ColumnCacheHeader) || std::memcmp(header->magic, "COLS", 4) != 0 || header->version != columnCacheVersion ||
+        file.size < sizeof(ColumnCacheHeader) + (uint64_t)header->columnCount * sizeof(ColumnCacheEntry))
+    {
+        std::cerr << "Not a column cache file: " << path << std::endl;
+        unmapFile(file);
+        return false;
+    }
+
+    const ColumnCacheEntry* entries = reinterpret_cast<const ColumnCacheEntry*>(file.data + sizeof(ColumnCacheHeader));
+    const char* name = reinterpret_cast<const char*>(entries + header->columnCount);
+    table = DataTable();
+    table.rowCount = header->rowCount;
+    for (uint32_t c = 0; c < header->columnCount; c++)
+    {
+        DataColumn column;
+        column.name.assign(name, entries[c].nameLength);
+        name += entries[c].nameLength;
+        column.type = (ColumnType)entries[c].type;
+
+        uint64_t valueSize = column.type == ColumnType::Float ? sizeof(float) : column.type == ColumnType::Double ? sizeof(double) : 0;
+        if (entries[c].offset + valueSize * table.rowCount > file.size)
+        {
+            std::cerr << "Truncated column cache file: " << path << std::endl;
+            unmapFile(file);
+            return false;
+        }
+        const unsigned char* values = file.data + entries[c].offset;
+        if (column.type == ColumnType::Float)
+        {
+            column.floats.assign(reinterpret_cast<const float*>(values), reinterpret_cast<const float*>(values) + table.rowCount);
+        }
+        if (column.type == ColumnType::Double)
+        {
+            column.doubles.assign(reinterpret_cast<const double*>(values), reinterpret_cast<const double*>(values) + table.rowCount);
+        }
+        table.columns.push_back(std::move(column));
+    }
+    unmapFile(file);
+    return true;
+}
+
+bool loadTable(const std::string& path, DataTable& table)
+{
+    const std::string cachePath = path + ".cols";
+    std::error_code error;
+    auto csvTime = std::filesystem::last_write_time(path, error);
+    if (error)
+    {
+        std::cerr << "Cannot open file: " << path << std::endl;
+        return false;
+    }
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (!error && cacheTime >= csvTime)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (loadColumnCache(cachePath, table))
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Loaded " << cachePath << ": " << table.rowCount << " rows, " << table.columns.size() << " columns in "
+                << seconds * 1000.0 << " ms" << std::endl;
+            return true;
+        }
+    }
+
+    if (!loadCsv(path, table)) return false;
+    saveColumnCache(cachePath, table);
+    return true;
+}
+
+int findColumn(const DataTable& table, const std::string& nameOrIndex)
+{
+    for (size_t c = 0; c < table.columns.size(); c++)
+    {
+        if (table.columns[c].name == nameOrIndex) return (int)c;
+    }
+    int index = -1;
+    std::from_chars_result result = std::from_chars(nameOrIndex.data(), nameOrIndex.data() + nameOrIndex.size(), index);
+    if (result.ec != std::errc() || result.ptr != nameOrIndex.data() + nameOrIndex.size()) return -1;
+    return index >= 0 && index < (int)table.columns.size() ? index : -1;
+}
+
+GLuint createColumnBuffer(const DataColumn& column, double offset)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (column.type == ColumnType::Float)
+    {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(column.floats.size() * sizeof(float)), column.floats.data(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        // Zamiana na float w porcjach, bez kopii caej kolumny
+        const size_t batch = 1 << 16;
+        std::vector<float> converted(batch);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(column.doubles.size() * sizeof(float)), nullptr, GL_STATIC_DRAW);
+        for (size_t first = 0; first < column.doubles.size(); first += batch)
+        {
+            size_t count = std::min(batch, column.doubles.size() - first);
+            for (size_t i = 0; i < count; i++) converted[i] = (float)(column.doubles[first + i] - offset);
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(first * sizeof(float)), (GLsizeiptr)(count * sizeof(float)), converted.data());
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return buffer;
+}
+
+namespace
+{
+    const GLchar* scatterVertexSource = R"glsl(
+        #version 330 core
+        in float x;
+        in float y;
+
+        uniform vec4 range; // Minimum x, y i odwrotnoci zakresw
+
+        void main()
+        {
+            gl_Position = vec4((vec2(x, y) - range.xy) * range.zw * 1.9 - 0.95, 0.0, 1.0);
+        }
+    )glsl";
+
+    const GLchar* scatterFragmentSource = R"glsl(
+        #version 330 core
+        out vec4 outColor;
+
+        void main()
+        {
+            outColor = vec4(0.4, 0.8, 0.95, 0.5);
+        }
+    )glsl";
+
+    // Zakres wartoci kolumny bez NaN, kolumny Double po odjciu offset
+    void columnRange(const DataColumn& column, double offset, float& minimum, float& maximum)
+    {
+        minimum = std::numeric_limits<float>::max();
+        maximum = -std::numeric_limits<float>::max();
+        for (float value : column.floats)
+        {
+            if (value < minimum) minimum = value;
+            if (value > maximum) maximum = value;
+        }
+        for (double value : column.doubles)
+        {
+            float shifted = (float)(value - offset);
+            if (shifted < minimum) minimum = shifted;
+            if (shifted > maximum) maximum = shifted;
+        }
+        if (minimum > maximum) minimum = maximum = 0.0f;
+    }
+
+    double columnValue(const DataColumn& column, uint64_t row)
+    {
+        return column.floats.empty() ? column.doubles[(size_t)row] : (double)column.floats[(size_t)row];
+    }
+
+    // Podziaka osi od minimum do minimum + span (wartoci z przesuniciem kolumny), pooenie w pikselach od 0 do length
+    template <typename Place>
+    void addAxisLabels(FrameAllocator& frameMemory, double minimum, double span, float length, const Place& place)
+    {
+        if (!(span > 0.0)) return;
+        double step = niceTickStep(span, std::max((int)(length / 100.0f), 2));
+        for (double value = std::ceil(minimum / step) * step; value <= minimum + span; value += step)
+        {
+            place(frameFormat(frameMemory, "%g", std::abs(value) < step * 1e-6 ? 0.0 : value), (float)((value - minimum) / span) * length);
+        }
+    }
+}
+
+int runScatterViewer(sf::Window& window, const char* path, const char* xColumn, const char* yColumn)
+{
+    DataTable table;
+    if (!loadTable(path, table)) return 1;
+    int xIndex = findColumn(table, xColumn), yIndex = findColumn(table, yColumn);
+    if (xIndex < 0 || yIndex < 0 || table.columns[xIndex].type == ColumnType::Text || table.columns[yIndex].type == ColumnType::Text)
+    {
+        std::cerr << "No numeric columns " << xColumn << " and " << yColumn << " in " << path << std::endl;
+        return 1;
+    }
+
+    // Kolumny Double przesunite o pierwsz warto, eby float nie traci precyzji
+    const DataColumn& xData = table.columns[xIndex];
+    const DataColumn& yData = table.columns[yIndex];
+    double xOffset = xData.doubles.empty() ? 0.0 : xData.doubles[0];
+    double yOffset = yData.doubles.empty() ? 0.0 : yData.doubles[0];
+    float xMin, xMax, yMin, yMax;
+    columnRange(xData, xOffset, xMin, xMax);
+    columnRange(yData, yOffset, yMin, yMax);
+
+    GLuint program = createProgram(scatterVertexSource, scatterFragmentSource, { "x", "y" }, "Scatter");
+    if (!program) return 1;
+    GLuint buffers[2] = { createColumnBuffer(xData, xOffset), createColumnBuffer(yData, yOffset) };
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    for (GLuint attribute = 0; attribute < 2; attribute++)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[attribute]);
+        glVertexAttribPointer(attribute, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
+        glEnableVertexAttribArray(attribute);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "range"), xMin, yMin, 1.0f / std::max(xMax - xMin, 1e-30f), 1.0f / std::max(yMax - yMin, 1e-30f));
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Punkty zajmuj rodkowe 95% okna, tak jak w shaderze
+    TextBatch text;
+    bool labels = createTextRenderer(text, defaultFontPath());
+    FrameAllocator frameMemory;
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    const glm::vec4 axisColor(0.7f, 0.7f, 0.75f, 1.0f), pointColor(0.9f, 0.9f, 0.6f, 0.9f);
+
+    bool running = true;
+    sf::Clock fpsClock;
+    int frameCount = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            if (windowEvent.type == sf::Event::Closed ||
+                (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Escape))
+            {
+                running = false;
+            }
+            // T wcza i wycza podziaki i etykiety punktw
+            if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::T && text.program) labels = !labels;
+        }
+
+        glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glUseProgram(program);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)table.rowCount);
+        glBindVertexArray(0);
+
+        // Etykiety ukadane od nowa co klatk w pamici klatki
+        text.drawnGlyphs = 0;
+        if (labels)
+        {
+            beginFrameMemory(frameMemory);
+            beginText(text, frameMemory);
+            float left = width * 0.025f, bottom = height * 0.025f, plotWidth = width * 0.95f, plotHeight = height * 0.95f;
+            addAxisLabels(frameMemory, xMin + xOffset, (double)xMax - xMin, plotWidth, [&](const char* label, float position)
+            {
+                addText(text, label, glm::vec2(left + position, 3.0f), 12.0f, axisColor, TextAlign::Center);
+            });
+            addAxisLabels(frameMemory, yMin + yOffset, (double)yMax - yMin, plotHeight, [&](const char* label, float position)
+            {
+                addText(text, label, glm::vec2(2.0f, bottom + position - 4.0f), 12.0f, axisColor);
+            });
+            if (table.rowCount <= pointLabelLimit)
+            {
+                // Napis punktu w buforze na stosie, eby tablica znakw pozostaa ostatnim przydziaem klatki i rosa w miejscu
+                float xScale = plotWidth / std::max(xMax - xMin, 1e-30f), yScale = plotHeight / std::max(yMax - yMin, 1e-30f);
+                char label[32];
+                for (uint64_t row = 0; row < table.rowCount; row++)
+                {
+                    double x = columnValue(xData, row), y = columnValue(yData, row);
+                    glm::vec2 position(left + (float)(x - (xData.floats.empty() ? xOffset : 0.0) - xMin) * xScale,
+                        bottom + (float)(y - (yData.floats.empty() ? yOffset : 0.0) - yMin) * yScale + 4.0f);
+                    std::snprintf(label, sizeof(label), "%.3g", y);
+                    addText(text, label, position, 10.0f, pointColor, TextAlign::Center);
+                }
+            }
+            drawText(text, width, height);
+        }
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            window.setTitle("Scatter - FPS: " + std::to_string(frameCount) + " - " + xData.name + " x " + yData.name + ", " +
+                std::to_string(table.rowCount) + " points, glyphs: " + std::to_string(text.drawnGlyphs));
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    releaseFrameAllocator(frameMemory);
+    if (text.program) destroyTextRenderer(text);
+    glDisable(GL_BLEND);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(2, buffers);
+    glDeleteProgram(program);
+    checkGLErrors("After scatter viewer");
+    return 0;
+}
+
+int runCsvBenchmark(uint64_t rows)
+{
+    // Syntetyczny plik: znacznik czasu, dwie wsprzdne, warto i etykieta tekstowa
+    const std::string path = "benchmark.csv";
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+        {
+            std::cerr << "Cannot create file: " << path << std::endl;
+            return 1;
+        }
+        out << "time,x,y,value,label\n";
+        uint32_t state = 1;
+        char line[128];
+        for (uint64_t row = 0; row < rows; row++)
+        {
+            state = state * 1664525u + 1013904223u;
+            float x = (float)(state >> 8) / 16777216.0f * 100.0f;
+            state = state * 1664525u + 1013904223u;
+            float y = (float)(state >> 8) / 16777216.0f * 100.0f;
+            int length = std::snprintf(line, sizeof(line), "%.3f,%.4f,%.4f,%.5g,sensor%u\n",
+                1700000000.0 + row * 0.001, x, y, std::sin(x * 0.1f) * y, (unsigned)(row % 16));
+            out.write(line, length);
+        }
+    }
+    uint64_t bytes = (uint64_t)std::filesystem::file_size(path);
+    std::cout << "CSV ingestion: " << rows << " rows, " << bytes / (1024 * 1024) << " MB" << std::endl;
+
+    DataTable table;
+    unsigned cores = jobThreadCount();
+    for (unsigned threads : { 1u, cores })
+    {
+        if (!loadCsv(path, table, threads)) return 1;
+    }
+    for (const DataColumn& column : table.columns)
+    {
+        std::cout << "  " << column.name << ": " << (column.type == ColumnType::Float ? "float" : column.type == ColumnType::Double ? "double" : "text") << std::endl;
+    }
+
+    const std::string cachePath = path + ".cols";
+    auto start = std::chrono::steady_clock::now();
+    saveColumnCache(cachePath, table);
+    double saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    DataTable cached;
+    if (!loadColumnCache(cachePath, cached)) return 1;
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t cacheBytes = (uint64_t)std::filesystem::file_size(cachePath);
+    std::cout << "  column cache: " << cacheBytes / (1024 * 1024) << " MB, saved in " << saveSeconds * 1000.0 << " ms, loaded in "
+        << loadSeconds * 1000.0 << " ms (" << cacheBytes / loadSeconds / (1024 * 1024) << " MB/s, " << cached.rowCount / loadSeconds / 1e6
+        << " M rows/s)" << std::endl;
+
+    std::remove(path.c_str());
+    std::remove(cachePath.c_str());
+    return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Wczytywanie tabel CSV prosto do kolumn. Plik jest odwzorowany w pami i dzielony na zakresy
+// penych wierszy, kady wtek liczy najpierw swoje wiersze, a potem parsuje liczby (from_chars)
+// bezporednio na ich miejsca w tablicach kolumn, bez obiektw wierszy. Typy kolumn wynikaj
+// z pocztkowych wierszy. Gotow tabel mona zapisa jako binarn pami podrczn kolumn,
+// ktrej wczytanie to tylko kopiowanie tablic.
+
+enum class ColumnType
+{
+    Float,  // Liczby mieszczce si w precyzji float
+    Double, // Liczby z wicej ni 7 cyframi znaczcymi, np. znaczniki czasu
+    Text    // Kolumna nie jest wczytywana
+};
+
+struct DataColumn
+{
+    std::string name;
+    ColumnType type = ColumnType::Float;
+    std::vector<float> floats;   // Wartoci kolumny Float, NaN dla pustych pl
+    std::vector<double> doubles; // Wartoci kolumny Double
+};
+
+struct DataTable
+{
+    std::vector<DataColumn> columns;
+    uint64_t rowCount = 0;
+    char delimiter = ',';
+};
+
+// Wczytanie pliku CSV z nagwkiem, threads = 0 oznacza wszystkie rdzenie.
+// Pola w cudzysowach nie mog zawiera znakw nowej linii.
+bool loadCsv(const std::string& path, DataTable& table, unsigned threads = 0);
+
+// Binarna pami podrczna kolumn
+bool saveColumnCache(const std::string& path, const DataTable& table);
+bool loadColumnCache(const std::string& path, DataTable& table);
+
+// CSV przez pami podrczn path + ".cols", odtwarzan, gdy jest starsza ni plik CSV
+bool loadTable(const std::string& path, DataTable& table);
+
+// Indeks kolumny o podanej nazwie albo numerze, -1 gdy jej brak
+int findColumn(const DataTable& table, const std::string& nameOrIndex);
+
+// Bufor wierzchokw z jednej kolumny (float), kolumny Double s przesuwane o offset przed zamian na float
+GLuint createColumnBuffer(const DataColumn& column, double offset = 0.0);
+
+// Wykres punktowy dwch kolumn, kada we wasnym buforze jako osobny atrybut
+int runScatterViewer(sf::Window& window, const char* path, const char* xColumn, const char* yColumn);
+
+// Pomiar: przepustowo wczytywania syntetycznego CSV na jednym i wszystkich rdzeniach oraz pamici podrcznej,
+// nie potrzebuje okna
+int runCsvBenchmark(uint64_t rows);
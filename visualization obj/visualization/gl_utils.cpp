@@ -0,0 +1,80 @@
+#include "gl_utils.h"
+#include <iostream>
+
+// Sprawdzanie bdw shaderw
+bool checkShaders(GLuint shader, const std::string& type)
+{
+    GLint status;
+    GLchar log[512];
+
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status); // GL_COMPILE_STATUS - to chcemy pobra
+
+    if (!status) // 0 - bd
+    {
+        glGetShaderInfoLog(shader, 512, nullptr, log);
+        std::cerr << "Error: Compilation of " << type << " failed\n" << log << std::endl;
+        return false;
+    }
+    else
+    {
+        std::cout << "Compilation of " << type << " OK" << std::endl;
+        return true;
+    }
+}
+
+// Sprawdzanie bdw OpenGL
+void checkGLErrors(const char* context) 
+{
+    GLenum err;
+    while ((err = glGetError()) != GL_NO_ERROR)
+    {
+        std::cerr << "OpenGL error in " << context << ": " << err << std::endl;
+    }
+}
+
+// Kompilacja i linkowanie programu, 0 w przypadku bdu
+GLuint createProgram(const GLchar* vertexCode, const GLchar* fragmentCode, const std::vector<std::string>& attributes, const std::string& name)
+{
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexCode, NULL);
+    glCompileShader(vertexShader);
+
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentCode, NULL);
+    glCompileShader(fragmentShader);
+
+    if (!checkShaders(vertexShader, name + " vertex shader") || !checkShaders(fragmentShader, name + " fragment shader"))
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+
+    // Przypisanie lokalizacji atrybutw przed linkowaniem
+    for (size_t i = 0; i < attributes.size(); i++)
+    {
+        glBindAttribLocation(program, (GLuint)i, attributes[i].c_str());
+    }
+    glBindFragDataLocation(program, 0, "outColor");
+    glLinkProgram(program);
+
+    // Shadery nie s ju potrzebne po linkowaniu
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
+    GLint programStatus;
+    glGetProgramiv(program, GL_LINK_STATUS, &programStatus);
+    if (!programStatus)
+    {
+        GLchar log[512];
+        glGetProgramInfoLog(program, 512, nullptr, log);
+        std::cerr << "Error: Linking " << name << " program failed\n" << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+
+// Sprawdzanie bdw shaderw
+bool checkShaders(GLuint shader, const std::string& type);
+
+// Sprawdzanie bdw OpenGL
+void checkGLErrors(const char* context);
+
+// Kompilacja i linkowanie programu, atrybuty dostaj lokalizacje wedug kolejnoci na licie
+GLuint createProgram(const GLchar* vertexCode, const GLchar* fragmentCode, const std::vector<std::string>& attributes, const std::string& name);
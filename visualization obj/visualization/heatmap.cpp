@@ -0,0 +1,651 @@
+#include "heatmap.h"
+#include "data_table.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "streaming_texture.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+
+namespace
+{
+    const size_t binBlock = 4096;             // Punkty liczone naraz: najpierw indeksy komrek, potem zliczanie
+    const uint64_t pointsPerThread = 65536;   // Mniej punktw na wtek nie opaca si dzieli
+
+    unsigned threadCount(unsigned threads)
+    {
+        return threads ? threads : jobThreadCount();
+    }
+
+    // Prostokt pikseli [x0, x1) x [y0, y1) do zliczenia
+    struct PixelRect
+    {
+        int x0, y0, x1, y1;
+    };
+
+    // Cigy zakres punktw indeksu, z ktrego liczone s tylko punkty w prostokcie rect
+    struct PointRange
+    {
+        uint64_t begin, end;
+        int rect;
+    };
+
+    int bucketColumn(const ScatterIndex& index, double x)
+    {
+        double scale = index.bucketsX / std::max((double)index.xMax - index.xMin, 1e-30);
+        return (int)std::min(std::max(std::floor((x - index.xMin) * scale), 0.0), (double)index.bucketsX - 1);
+    }
+
+    int bucketRow(const ScatterIndex& index, double y)
+    {
+        double scale = index.bucketsY / std::max((double)index.yMax - index.yMin, 1e-30);
+        return (int)std::min(std::max(std::floor((y - index.yMin) * scale), 0.0), (double)index.bucketsY - 1);
+    }
+
+    // Zliczenie punktw [begin, end) lecych w prostokcie do histogramu szerokoci width
+    void binPoints(const Heatmap& heatmap, const ScatterIndex& index, const PixelRect& rect, uint64_t begin, uint64_t end, uint32_t* histogram)
+    {
+        int32_t bins[binBlock];
+        double invWidth = 1.0 / heatmap.pixelWidth, invHeight = 1.0 / heatmap.pixelHeight;
+        for (uint64_t block = begin; block < end; block += binBlock)
+        {
+            size_t count = (size_t)std::min<uint64_t>(binBlock, end - block);
+            const float* xs = index.xs.data() + block;
+            const float* ys = index.ys.data() + block;
+            for (size_t i = 0; i < count; i++)
+            {
+                // Piksel w siatce zakotwiczonej w anchor, wic przesunity widok trafia w te same granice
+                double x = std::floor((xs[i] - heatmap.anchorX) * invWidth) - heatmap.originX;
+                double y = std::floor((ys[i] - heatmap.anchorY) * invHeight) - heatmap.originY;
+                bool inside = x >= rect.x0 && x < rect.x1 && y >= rect.y0 && y < rect.y1;
+                bins[i] = inside ? (int32_t)y * heatmap.width + (int32_t)x : -1;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                if (bins[i] >= 0) histogram[bins[i]]++;
+            }
+        }
+    }
+
+    // Zliczenie prostoktw: kubeki przecinajce kady prostokt to po jednym zakresie punktw na wiersz kubekw
+    void binRects(Heatmap& heatmap, const ScatterIndex& index, const std::vector<PixelRect>& rects)
+    {
+        std::vector<PointRange> ranges;
+        uint64_t total = 0;
+        for (int r = 0; r < (int)rects.size(); r++)
+        {
+            const PixelRect& rect = rects[r];
+            if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1) continue;
+            double x0 = heatmap.anchorX + (heatmap.originX + rect.x0) * heatmap.pixelWidth;
+            double x1 = heatmap.anchorX + (heatmap.originX + rect.x1) * heatmap.pixelWidth;
+            double y0 = heatmap.anchorY + (heatmap.originY + rect.y0) * heatmap.pixelHeight;
+            double y1 = heatmap.anchorY + (heatmap.originY + rect.y1) * heatmap.pixelHeight;
+            if (x1 < index.xMin || x0 > index.xMax || y1 < index.yMin || y0 > index.yMax) continue;
+
+            // Kubeek zapasu z kadej strony na zaokrglenia floatw, punkty i tak s sprawdzane
+            int c0 = std::max(bucketColumn(index, x0) - 1, 0), c1 = std::min(bucketColumn(index, x1) + 1, index.bucketsX - 1);
+            int r0 = std::max(bucketRow(index, y0) - 1, 0), r1 = std::min(bucketRow(index, y1) + 1, index.bucketsY - 1);
+            for (int row = r0; row <= r1; row++)
+            {
+                uint64_t begin = index.bucketStart[(size_t)row * index.bucketsX + c0];
+                uint64_t end = index.bucketStart[(size_t)row * index.bucketsX + c1 + 1];
+                if (begin == end) continue;
+                if (!ranges.empty() && ranges.back().end == begin && ranges.back().rect == r) ranges.back().end = end;
+                else ranges.push_back(PointRange{ begin, end, r });
+                total += end - begin;
+            }
+        }
+        heatmap.binnedPoints = total;
+        if (total == 0) return;
+
+        // Wtek 0 liczy od razu do counts, pozostae do wasnych histogramw
+        unsigned threads = (unsigned)std::min<uint64_t>(threadCount(heatmap.threads), std::max<uint64_t>(total / pointsPerThread, 1));
+        size_t cells = (size_t)heatmap.width * heatmap.height;
+        if (heatmap.local.size() < threads - 1) heatmap.local.resize(threads - 1);
+        for (unsigned t = 0; t + 1 < threads; t++)
+        {
+            if (heatmap.local[t].size() != cells) heatmap.local[t].assign(cells, 0);
+        }
+
+        // Kady wtek dostaje rwn cz poczonych zakresw
+        parallelFor(threads, [&](unsigned first, unsigned last)
+        {
+            for (unsigned t = first; t < last; t++)
+            {
+                uint32_t* histogram = t == 0 ? heatmap.counts.data() : heatmap.local[t - 1].data();
+                uint64_t partBegin = total * t / threads, partEnd = total * (t + 1) / threads;
+                uint64_t position = 0;
+                for (const PointRange& range : ranges)
+                {
+                    uint64_t length = range.end - range.begin;
+                    uint64_t begin = std::max(partBegin, position), end = std::min(partEnd, position + length);
+                    if (begin < end) binPoints(heatmap, index, rects[range.rect], range.begin + begin - position, range.begin + end - position, histogram);
+                    position += length;
+                    if (position >= partEnd) break;
+                }
+            }
+        }, threads);
+
+        // Sumowanie histogramw wierszami, histogramy wtkw wracaj do zera
+        if (threads < 2) return;
+        for (const PixelRect& rect : rects)
+        {
+            if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1) continue;
+            parallelFor((unsigned)(rect.y1 - rect.y0), [&](unsigned begin, unsigned end)
+            {
+                for (unsigned row = begin; row < end; row++)
+                {
+                    size_t offset = (size_t)(rect.y0 + row) * heatmap.width;
+                    uint32_t* counts = heatmap.counts.data() + offset;
+                    for (unsigned t = 0; t + 1 < threads; t++)
+                    {
+                        uint32_t* local = heatmap.local[t].data() + offset;
+                        for (int x = rect.x0; x < rect.x1; x++) counts[x] += local[x];
+                        std::memset(local + rect.x0, 0, (rect.x1 - rect.x0) * sizeof(uint32_t));
+                    }
+                }
+            }, threads);
+        }
+    }
+
+    // Przesunicie licznikw o (shiftX, shiftY) pikseli: nowy piksel (x, y) to stary (x + shiftX, y + shiftY)
+    void shiftCounts(Heatmap& heatmap, int shiftX, int shiftY)
+    {
+        int width = heatmap.width, height = heatmap.height;
+        uint32_t* counts = heatmap.counts.data();
+        int sourceX = std::max(shiftX, 0), targetX = std::max(-shiftX, 0);
+        size_t length = (size_t)(width - std::abs(shiftX)) * sizeof(uint32_t);
+        auto moveRow = [&](int y)
+        {
+            uint32_t* row = counts + (size_t)y * width;
+            int source = y + shiftY;
+            if (source >= 0 && source < height) std::memmove(row + targetX, counts + (size_t)source * width + sourceX, length);
+        };
+        // Kolejno wierszy taka, eby rdo nie byo ju nadpisane
+        if (shiftY >= 0) for (int y = 0; y < height; y++) moveRow(y);
+        else for (int y = height - 1; y >= 0; y--) moveRow(y);
+    }
+
+    // Mapa kolorw od ciemnego fioletu przez czerwie do jasnej ci
+    struct Colormap
+    {
+        unsigned char colors[256][4];
+
+        Colormap()
+        {
+            const float stops[5][3] = { { 0, 0, 4 }, { 87, 16, 110 }, { 188, 55, 84 }, { 249, 142, 9 }, { 252, 255, 164 } };
+            for (int i = 0; i < 256; i++)
+            {
+                float position = i / 255.0f * 4.0f;
+                int stop = std::min((int)position, 3);
+                float t = position - stop;
+                for (int c = 0; c < 3; c++) colors[i][c] = (unsigned char)(stops[stop][c] + (stops[stop + 1][c] - stops[stop][c]) * t + 0.5f);
+                colors[i][3] = 255;
+            }
+        }
+    };
+
+    // Siatka zakotwiczona od nowa w lewym dolnym rogu widoku
+    void resetAnchor(Heatmap& heatmap, double left, double bottom, double pixelWidth, double pixelHeight)
+    {
+        heatmap.anchorX = left;
+        heatmap.anchorY = bottom;
+        heatmap.originX = heatmap.originY = 0;
+        heatmap.pixelWidth = pixelWidth;
+        heatmap.pixelHeight = pixelHeight;
+    }
+}
+
+void buildScatterIndex(const float* xs, const float* ys, size_t count, ScatterIndex& index, unsigned threads)
+{
+    threads = threadCount(threads);
+    unsigned parts = (unsigned)std::min<uint64_t>(threads, std::max<uint64_t>(count / pointsPerThread, 1));
+    auto partBegin = [&](unsigned part) { return (size_t)((uint64_t)count * part / parts); };
+
+    // Zakres danych z pominiciem NaN i nieskoczonoci
+    std::vector<float> ranges((size_t)parts * 4);
+    parallelFor(parts, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned part = begin; part < end; part++)
+        {
+            float xMin = std::numeric_limits<float>::max(), xMax = -xMin, yMin = xMin, yMax = -xMin;
+            for (size_t i = partBegin(part); i < partBegin(part + 1); i++)
+            {
+                if (!std::isfinite(xs[i]) || !std::isfinite(ys[i])) continue;
+                xMin = std::min(xMin, xs[i]);
+                xMax = std::max(xMax, xs[i]);
+                yMin = std::min(yMin, ys[i]);
+                yMax = std::max(yMax, ys[i]);
+            }
+            float* range = &ranges[(size_t)part * 4];
+            range[0] = xMin, range[1] = xMax, range[2] = yMin, range[3] = yMax;
+        }
+    }, threads);
+    index.xMin = index.yMin = std::numeric_limits<float>::max();
+    index.xMax = index.yMax = -std::numeric_limits<float>::max();
+    for (unsigned part = 0; part < parts; part++)
+    {
+        const float* range = &ranges[(size_t)part * 4];
+        index.xMin = std::min(index.xMin, range[0]);
+        index.xMax = std::max(index.xMax, range[1]);
+        index.yMin = std::min(index.yMin, range[2]);
+        index.yMax = std::max(index.yMax, range[3]);
+    }
+    if (index.xMin > index.xMax) index.xMin = index.xMax = index.yMin = index.yMax = 0.0f;
+
+    // Sortowanie przez zliczanie: liczniki kubekw kadej czci, potem rozoenie punktw
+    size_t buckets = (size_t)index.bucketsX * index.bucketsY;
+    auto bucketOf = [&](float x, float y) { return (size_t)bucketRow(index, y) * index.bucketsX + bucketColumn(index, x); };
+    std::vector<uint64_t> partCounts((size_t)parts * buckets, 0);
+    parallelFor(parts, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned part = begin; part < end; part++)
+        {
+            uint64_t* counts = &partCounts[(size_t)part * buckets];
+            for (size_t i = partBegin(part); i < partBegin(part + 1); i++)
+            {
+                if (std::isfinite(xs[i]) && std::isfinite(ys[i])) counts[bucketOf(xs[i], ys[i])]++;
+            }
+        }
+    }, threads);
+    index.bucketStart.assign(buckets + 1, 0);
+    uint64_t position = 0;
+    for (size_t bucket = 0; bucket < buckets; bucket++)
+    {
+        index.bucketStart[bucket] = position;
+        for (unsigned part = 0; part < parts; part++)
+        {
+            uint64_t partCount = partCounts[(size_t)part * buckets + bucket];
+            partCounts[(size_t)part * buckets + bucket] = position;
+            position += partCount;
+        }
+    }
+    index.bucketStart[buckets] = position;
+
+    index.xs.resize((size_t)position);
+    index.ys.resize((size_t)position);
+    parallelFor(parts, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned part = begin; part < end; part++)
+        {
+            uint64_t* next = &partCounts[(size_t)part * buckets];
+            for (size_t i = partBegin(part); i < partBegin(part + 1); i++)
+            {
+                if (!std::isfinite(xs[i]) || !std::isfinite(ys[i])) continue;
+                uint64_t target = next[bucketOf(xs[i], ys[i])]++;
+                index.xs[(size_t)target] = xs[i];
+                index.ys[(size_t)target] = ys[i];
+            }
+        }
+    }, threads);
+}
+
+void createHeatmap(Heatmap& heatmap, int width, int height)
+{
+    heatmap.width = std::max(width, 1);
+    heatmap.height = std::max(height, 1);
+    heatmap.counts.assign((size_t)heatmap.width * heatmap.height, 0);
+    heatmap.pixels.assign(heatmap.counts.size() * 4, 0);
+    heatmap.local.clear();
+    heatmap.valid = false;
+
+    // Jeden teksel na piksel ekranu
+    if (!heatmap.texture) glGenTextures(1, &heatmap.texture);
+    glBindTexture(GL_TEXTURE_2D, heatmap.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, heatmap.width, heatmap.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void destroyHeatmap(Heatmap& heatmap)
+{
+    if (heatmap.texture) glDeleteTextures(1, &heatmap.texture);
+    heatmap.texture = 0;
+    heatmap.counts.clear();
+    heatmap.local.clear();
+    heatmap.pixels.clear();
+    heatmap.valid = false;
+}
+
+void aggregateHeatmap(Heatmap& heatmap, const ScatterIndex& index, double left, double bottom, double pixelWidth, double pixelHeight)
+{
+    auto start = std::chrono::steady_clock::now();
+    int width = heatmap.width, height = heatmap.height;
+    std::vector<PixelRect> rects;
+
+    // Ta sama skala i przesunicie o cae piksele: stare liczniki przesuwane, liczone tylko odsonite pasy
+    heatmap.incremental = false;
+    if (heatmap.valid && pixelWidth == heatmap.pixelWidth && pixelHeight == heatmap.pixelHeight)
+    {
+        double originX = (left - heatmap.anchorX) / pixelWidth, originY = (bottom - heatmap.anchorY) / pixelHeight;
+        int64_t newX = (int64_t)std::llround(originX), newY = (int64_t)std::llround(originY);
+        int64_t shiftX = newX - heatmap.originX, shiftY = newY - heatmap.originY;
+        if (std::abs(originX - newX) < 1e-3 && std::abs(originY - newY) < 1e-3 && std::abs(shiftX) < width && std::abs(shiftY) < height)
+        {
+            heatmap.incremental = true;
+            if (shiftX == 0 && shiftY == 0)
+            {
+                heatmap.binnedPoints = 0;
+                heatmap.aggregateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                return;
+            }
+            shiftCounts(heatmap, (int)shiftX, (int)shiftY);
+            heatmap.originX = newX;
+            heatmap.originY = newY;
+
+            // Odsonite kolumny na ca wysoko, odsonite wiersze bez tych kolumn
+            int columnsBegin = shiftX > 0 ? width - (int)shiftX : 0, columnsEnd = shiftX > 0 ? width : (int)-shiftX;
+            int rowsBegin = shiftY > 0 ? height - (int)shiftY : 0, rowsEnd = shiftY > 0 ? height : (int)-shiftY;
+            int restBegin = shiftX < 0 ? columnsEnd : 0, restEnd = shiftX > 0 ? columnsBegin : width;
+            rects.push_back(PixelRect{ columnsBegin, 0, columnsEnd, height });
+            rects.push_back(PixelRect{ restBegin, rowsBegin, restEnd, rowsEnd });
+            for (const PixelRect& rect : rects)
+            {
+                for (int y = rect.y0; y < rect.y1; y++)
+                {
+                    std::fill(heatmap.counts.begin() + (size_t)y * width + rect.x0, heatmap.counts.begin() + (size_t)y * width + rect.x1, 0u);
+                }
+            }
+        }
+    }
+    if (!heatmap.incremental)
+    {
+        resetAnchor(heatmap, left, bottom, pixelWidth, pixelHeight);
+        std::fill(heatmap.counts.begin(), heatmap.counts.end(), 0u);
+        rects.push_back(PixelRect{ 0, 0, width, height });
+    }
+
+    binRects(heatmap, index, rects);
+    heatmap.left = heatmap.anchorX + heatmap.originX * pixelWidth;
+    heatmap.bottom = heatmap.anchorY + heatmap.originY * pixelHeight;
+    heatmap.valid = true;
+    heatmap.aggregateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void updateHeatmapTexture(Heatmap& heatmap)
+{
+    static const Colormap colormap;
+    auto start = std::chrono::steady_clock::now();
+    unsigned threads = threadCount(heatmap.threads);
+    unsigned rows = (unsigned)heatmap.height;
+
+    uint32_t maximum = 0;
+    for (uint32_t count : heatmap.counts) maximum = std::max(maximum, count);
+
+    // Skala logarytmiczna pokazuje zarwno pojedyncze punkty, jak i gste skupiska
+    double scale = heatmap.logScale ? 255.0 / std::log1p((double)std::max(maximum, 1u)) : 255.0 / std::max(maximum, 1u);
+    parallelFor(rows, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned row = begin; row < end; row++)
+        {
+            const uint32_t* counts = heatmap.counts.data() + (size_t)row * heatmap.width;
+            unsigned char* pixels = heatmap.pixels.data() + (size_t)row * heatmap.width * 4;
+            for (int x = 0; x < heatmap.width; x++)
+            {
+                uint32_t count = counts[x];
+                if (count == 0)
+                {
+                    // To odrnione od najmniejszej gstoci
+                    pixels[x * 4 + 0] = 20, pixels[x * 4 + 1] = 20, pixels[x * 4 + 2] = 26, pixels[x * 4 + 3] = 255;
+                    continue;
+                }
+                double value = heatmap.logScale ? std::log1p((double)count) * scale : count * scale;
+                std::memcpy(pixels + x * 4, colormap.colors[std::min((int)value, 255)], 4);
+            }
+        }
+    }, threads);
+
+    glBindTexture(GL_TEXTURE_2D, heatmap.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, heatmap.width, heatmap.height, GL_RGBA, GL_UNSIGNED_BYTE, heatmap.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    heatmap.colorSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runHeatmapViewer(sf::Window& window, const char* path, const char* xColumn, const char* yColumn)
+{
+    DataTable table;
+    if (!loadTable(path, table)) return 1;
+    int xIndex = findColumn(table, xColumn), yIndex = findColumn(table, yColumn);
+    if (xIndex < 0 || yIndex < 0 || table.columns[xIndex].type == ColumnType::Text || table.columns[yIndex].type == ColumnType::Text)
+    {
+        std::cerr << "No numeric columns " << xColumn << " and " << yColumn << " in " << path << std::endl;
+        return 1;
+    }
+
+    // Kolumny Double przesunite o pierwsz warto, eby float nie traci precyzji
+    std::vector<float> converted[2];
+    const float* values[2];
+    for (int axis = 0; axis < 2; axis++)
+    {
+        const DataColumn& column = table.columns[axis == 0 ? xIndex : yIndex];
+        if (column.type == ColumnType::Double)
+        {
+            double offset = column.doubles.empty() ? 0.0 : column.doubles[0];
+            converted[axis].resize(column.doubles.size());
+            for (size_t i = 0; i < column.doubles.size(); i++) converted[axis][i] = (float)(column.doubles[i] - offset);
+            values[axis] = converted[axis].data();
+        }
+        else values[axis] = column.floats.data();
+    }
+
+    ScatterIndex index;
+    auto start = std::chrono::steady_clock::now();
+    buildScatterIndex(values[0], values[1], (size_t)table.rowCount, index);
+    std::cout << "Heatmap index: " << index.xs.size() << " points in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0
+        << " ms" << std::endl;
+    converted[0].clear();
+    converted[1].clear();
+    std::string names = table.columns[xIndex].name + " x " + table.columns[yIndex].name;
+    table.columns.clear();
+
+    GLuint program = createProgram(screenQuadVertexSource, screenQuadFragmentSource, {}, "Heatmap");
+    if (!program) return 1;
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "frame"), 0);
+    glDisable(GL_DEPTH_TEST);
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    Heatmap heatmap;
+    createHeatmap(heatmap, width, height);
+
+    // Cay zakres danych z marginesem 5%
+    double pixelWidth = std::max((double)index.xMax - index.xMin, 1e-6) * 1.1 / width;
+    double pixelHeight = std::max((double)index.yMax - index.yMin, 1e-6) * 1.1 / height;
+    double left = index.xMin - width * pixelWidth * 0.05 / 1.1, bottom = index.yMin - height * pixelHeight * 0.05 / 1.1;
+    bool dirty = true, dragging = false;
+    int dragX = 0, dragY = 0;
+    double worstPan = 0.0;
+
+    bool running = true;
+    sf::Clock fpsClock;
+    int frameCount = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            switch (windowEvent.type)
+            {
+            case sf::Event::Closed:
+                running = false;
+                break;
+            case sf::Event::Resized:
+                width = std::max((int)windowEvent.size.width, 1);
+                height = std::max((int)windowEvent.size.height, 1);
+                glViewport(0, 0, width, height);
+                createHeatmap(heatmap, width, height);
+                dirty = true;
+                break;
+            case sf::Event::KeyPressed:
+                if (windowEvent.key.code == sf::Keyboard::Escape) running = false;
+                if (windowEvent.key.code == sf::Keyboard::L)
+                {
+                    heatmap.logScale = !heatmap.logScale;
+                    dirty = true;
+                }
+                break;
+            case sf::Event::MouseWheelScrolled:
+            {
+                // Przyblianie wok punktu pod kursorem, zmiana skali liczy widok od nowa
+                double scale = std::pow(0.8, windowEvent.mouseWheelScroll.delta);
+                double anchorX = left + windowEvent.mouseWheelScroll.x * pixelWidth;
+                double anchorY = bottom + (height - windowEvent.mouseWheelScroll.y) * pixelHeight;
+                pixelWidth *= scale;
+                pixelHeight *= scale;
+                left = anchorX - windowEvent.mouseWheelScroll.x * pixelWidth;
+                bottom = anchorY - (height - windowEvent.mouseWheelScroll.y) * pixelHeight;
+                dirty = true;
+                break;
+            }
+            case sf::Event::MouseButtonPressed:
+                dragging = windowEvent.mouseButton.button == sf::Mouse::Left;
+                dragX = windowEvent.mouseButton.x;
+                dragY = windowEvent.mouseButton.y;
+                break;
+            case sf::Event::MouseButtonReleased:
+                dragging = false;
+                break;
+            case sf::Event::MouseMoved:
+                if (dragging)
+                {
+                    // Przesuwanie o cae piksele, wic agregacja jest przyrostowa
+                    left -= (windowEvent.mouseMove.x - dragX) * pixelWidth;
+                    bottom += (windowEvent.mouseMove.y - dragY) * pixelHeight;
+                    dragX = windowEvent.mouseMove.x;
+                    dragY = windowEvent.mouseMove.y;
+                    dirty = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (dirty)
+        {
+            aggregateHeatmap(heatmap, index, left, bottom, pixelWidth, pixelHeight);
+            updateHeatmapTexture(heatmap);
+            if (heatmap.incremental) worstPan = std::max(worstPan, heatmap.aggregateSeconds + heatmap.colorSeconds);
+            dirty = false;
+        }
+
+        glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, heatmap.texture);
+        glBindVertexArray(vao);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            window.setTitle("Heatmap - FPS: " + std::to_string(frameCount) + " - " + names + ", " + std::to_string(index.xs.size()) + " points, " +
+                (heatmap.incremental ? "pan " : "full ") + std::to_string(heatmap.aggregateSeconds * 1000.0) + " ms (" +
+                std::to_string(heatmap.binnedPoints) + " binned), colormap " + std::to_string(heatmap.colorSeconds * 1000.0) + " ms, worst pan " +
+                std::to_string(worstPan * 1000.0) + " ms, " + (heatmap.logScale ? "log" : "linear") + " [L]");
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    destroyHeatmap(heatmap);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+    checkGLErrors("After heatmap viewer");
+    return 0;
+}
+
+int runHeatmapBenchmark(sf::Window& window, uint64_t points)
+{
+    // Kilka skupisk gaussowskich o rnej gstoci na jednostajnym tle
+    std::vector<float> xs((size_t)points), ys((size_t)points);
+    std::mt19937 random(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_real_distribution<float> uniform(0.0f, 100.0f);
+    const float clusters[4][3] = { { 30.0f, 40.0f, 2.0f }, { 70.0f, 60.0f, 8.0f }, { 50.0f, 20.0f, 0.5f }, { 20.0f, 80.0f, 4.0f } };
+    for (size_t i = 0; i < xs.size(); i++)
+    {
+        unsigned cluster = (unsigned)(i % 5);
+        if (cluster == 4)
+        {
+            xs[i] = uniform(random);
+            ys[i] = uniform(random);
+            continue;
+        }
+        xs[i] = clusters[cluster][0] + normal(random) * clusters[cluster][2];
+        ys[i] = clusters[cluster][1] + normal(random) * clusters[cluster][2];
+    }
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    unsigned cores = jobThreadCount();
+    std::cout << "Heatmap: " << points << " points, " << width << "x" << height << " pixels" << std::endl;
+
+    ScatterIndex index;
+    for (unsigned threads : { 1u, cores })
+    {
+        auto start = std::chrono::steady_clock::now();
+        buildScatterIndex(xs.data(), ys.data(), xs.size(), index, threads);
+        std::cout << "  index, " << threads << " threads: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0
+            << " ms" << std::endl;
+    }
+    xs = std::vector<float>();
+    ys = std::vector<float>();
+
+    Heatmap heatmap;
+    createHeatmap(heatmap, width, height);
+    const int repeats = 5;
+    for (unsigned threads : { 1u, cores })
+    {
+        heatmap.threads = threads;
+        // Pena agregacja przy coraz wikszym przyblieniu na gste skupisko
+        for (double zoom : { 1.0, 8.0, 64.0 })
+        {
+            double pixelWidth = 100.0 / zoom / width, pixelHeight = 100.0 / zoom / height;
+            double left = 30.0 - width * pixelWidth * 0.5, bottom = 40.0 - height * pixelHeight * 0.5;
+            double best = std::numeric_limits<double>::max();
+            for (int repeat = 0; repeat < repeats; repeat++)
+            {
+                heatmap.valid = false;
+                aggregateHeatmap(heatmap, index, left, bottom, pixelWidth, pixelHeight);
+                best = std::min(best, heatmap.aggregateSeconds);
+            }
+            updateHeatmapTexture(heatmap);
+            std::cout << "  full, " << threads << " threads, zoom " << zoom << "x: " << best * 1000.0 << " ms, " << heatmap.binnedPoints
+                << " points binned, colormap and upload " << heatmap.colorSeconds * 1000.0 << " ms" << std::endl;
+        }
+
+        // Przesuwanie o kilka pikseli na klatk przy penym widoku, jak przy przeciganiu mysz
+        double pixelWidth = 100.0 / width, pixelHeight = 100.0 / height;
+        heatmap.valid = false;
+        aggregateHeatmap(heatmap, index, 0.0, 0.0, pixelWidth, pixelHeight);
+        double total = 0.0, worst = 0.0;
+        uint64_t binned = 0;
+        const int steps = 60;
+        for (int step = 1; step <= steps; step++)
+        {
+            aggregateHeatmap(heatmap, index, step * 4 * pixelWidth, step * 3 * pixelHeight, pixelWidth, pixelHeight);
+            total += heatmap.aggregateSeconds;
+            worst = std::max(worst, heatmap.aggregateSeconds);
+            binned += heatmap.binnedPoints;
+        }
+        std::cout << "  pan, " << threads << " threads: " << total / steps * 1000.0 << " ms average, " << worst * 1000.0 << " ms worst, "
+            << binned / steps << " points binned per step" << std::endl;
+    }
+
+    destroyHeatmap(heatmap);
+    checkGLErrors("After heatmap benchmark");
+    return 0;
+}
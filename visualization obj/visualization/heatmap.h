@@ -0,0 +1,70 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Mapa gstoci dla wykresw punktowych ze zbyt wieloma punktami, eby rysowa je osobno.
+// Punkty s raz ukadane wedug kubekw siatki 256x256 w przestrzeni danych, wic widok
+// przeglda tylko kubeki, ktre przecina. Kady wtek zlicza swoje punkty do wasnego
+// histogramu w rozdzielczoci ekranu (blokami: najpierw indeksy komrek, potem zliczanie),
+// histogramy s sumowane na kocu, a liczniki przechodz przez map kolorw liniow lub
+// logarytmiczn do jednej tekstury. Przesunicie widoku o cae piksele przesuwa siatk
+// i zlicza tylko odsonite pasy.
+
+struct ScatterIndex
+{
+    int bucketsX = 256;
+    int bucketsY = 256;
+    float xMin = 0.0f, xMax = 0.0f, yMin = 0.0f, yMax = 0.0f;
+    std::vector<float> xs;               // Punkty uporzdkowane wedug kubekw, wierszami
+    std::vector<float> ys;
+    std::vector<uint64_t> bucketStart;   // Pierwszy punkt kadego kubeka, na kocu liczba punktw
+};
+
+// Uoenie punktw wedug kubekw, punkty z NaN s pomijane
+void buildScatterIndex(const float* xs, const float* ys, size_t count, ScatterIndex& index, unsigned threads = 0);
+
+struct Heatmap
+{
+    int width = 0;
+    int height = 0;
+    double left = 0.0, bottom = 0.0;          // Widok obecnych licznikw: lewy dolny rg i rozmiar piksela w jednostkach danych
+    double pixelWidth = 0.0, pixelHeight = 0.0;
+    double anchorX = 0.0, anchorY = 0.0;      // Pocztek siatki pikseli, ustalany przy zmianie skali
+    int64_t originX = 0, originY = 0;         // Pooenie widoku w pikselach od pocztku siatki
+    bool valid = false;                        // Liczniki odpowiadaj widokowi, mona je przesuwa
+    bool logScale = true;
+    unsigned threads = 0;                      // 0 oznacza wszystkie rdzenie
+
+    std::vector<uint32_t> counts;
+    std::vector<std::vector<uint32_t>> local;  // Histogram kadego wtku
+    std::vector<unsigned char> pixels;         // RGBA8 po mapie kolorw
+    GLuint texture = 0;
+
+    // Ostatnia agregacja
+    bool incremental = false;
+    uint64_t binnedPoints = 0;
+    double aggregateSeconds = 0.0;
+    double colorSeconds = 0.0;                 // Mapa kolorw i wysanie tekstury
+};
+
+void createHeatmap(Heatmap& heatmap, int width, int height);
+void destroyHeatmap(Heatmap& heatmap);
+
+// Liczniki dla widoku od (left, bottom) z podanym rozmiarem piksela, przyrostowo gdy to moliwe
+void aggregateHeatmap(Heatmap& heatmap, const ScatterIndex& index, double left, double bottom, double pixelWidth, double pixelHeight);
+
+// Mapa kolorw i wysanie do tekstury
+void updateHeatmapTexture(Heatmap& heatmap);
+
+// Mapa gstoci dwch kolumn CSV: przeciganie przesuwa, kko myszy przyblia, L przecza skal
+int runHeatmapViewer(sf::Window& window, const char* path, const char* xColumn, const char* yColumn);
+
+// Pomiar: budowa indeksu, pena agregacja przy kilku powikszeniach i przesunicie, jeden i wszystkie rdzenie
+int runHeatmapBenchmark(sf::Window& window, uint64_t points);
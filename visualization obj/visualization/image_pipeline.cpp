@@ -0,0 +1,362 @@
+#include "image_pipeline.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "stb_image.h"
+#include <GL/glew.h>
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_SIMD_SSE 1
+#endif
+
+namespace
+{
+    // Tablice przejcia sRGB <-> liniowe, odwrotna z krokiem 1/4096
+    const int linearSteps = 4096;
+
+    struct SrgbTables
+    {
+        float toLinear[256];
+        unsigned char fromLinear[linearSteps + 1];
+
+        SrgbTables()
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i <= linearSteps; i++)
+            {
+                float l = (float)i / linearSteps;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                fromLinear[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+            }
+        }
+    };
+
+    const SrgbTables& srgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    // Poziom poredni: RGBA float w wietle liniowym, alfa bez zmian
+    struct LinearLevel
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<float> pixels;
+    };
+
+    // Indeks rda z przyciciem dla nieparzystych wymiarw
+    inline int sourceIndex(int x, int size) { return std::min(x, size - 1); }
+
+    // Pierwszy poziom ze rda 8-bitowego: zamiana przez tablic i rednia 2x2
+    void downsampleBytes(const TextureImage& source, LinearLevel& target, unsigned rowBegin, unsigned rowEnd, bool simd)
+    {
+        const SrgbTables& tables = srgbTables();
+        const float alphaScale = 1.0f / 255.0f;
+        for (unsigned y = rowBegin; y < rowEnd; y++)
+        {
+            const unsigned char* row0 = &source.pixels[(size_t)sourceIndex(2 * y, source.height) * source.width * 4];
+            const unsigned char* row1 = &source.pixels[(size_t)sourceIndex(2 * y + 1, source.height) * source.width * 4];
+            float* out = &target.pixels[(size_t)y * target.width * 4];
+            for (int x = 0; x < target.width; x++)
+            {
+                const unsigned char* p[4] = {
+                    row0 + sourceIndex(2 * x, source.width) * 4, row0 + sourceIndex(2 * x + 1, source.width) * 4,
+                    row1 + sourceIndex(2 * x, source.width) * 4, row1 + sourceIndex(2 * x + 1, source.width) * 4 };
+#ifdef IMAGE_SIMD_SSE
+                if (simd)
+                {
+                    __m128 sum = _mm_setzero_ps();
+                    for (int k = 0; k < 4; k++)
+                    {
+                        sum = _mm_add_ps(sum, _mm_set_ps(p[k][3] * alphaScale, tables.toLinear[p[k][2]], tables.toLinear[p[k][1]], tables.toLinear[p[k][0]]));
+                    }
+                    _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+                    continue;
+                }
+#endif
+                for (int c = 0; c < 3; c++)
+                {
+                    out[x * 4 + c] = 0.25f * (tables.toLinear[p[0][c]] + tables.toLinear[p[1][c]] + tables.toLinear[p[2][c]] + tables.toLinear[p[3][c]]);
+                }
+                out[x * 4 + 3] = 0.25f * alphaScale * (p[0][3] + p[1][3] + p[2][3] + p[3][3]);
+            }
+        }
+    }
+
+    // Kolejne poziomy z poprzedniego poziomu liniowego
+    void downsampleLinear(const LinearLevel& source, LinearLevel& target, unsigned rowBegin, unsigned rowEnd, bool simd)
+    {
+        for (unsigned y = rowBegin; y < rowEnd; y++)
+        {
+            const float* row0 = &source.pixels[(size_t)sourceIndex(2 * y, source.height) * source.width * 4];
+            const float* row1 = &source.pixels[(size_t)sourceIndex(2 * y + 1, source.height) * source.width * 4];
+            float* out = &target.pixels[(size_t)y * target.width * 4];
+            for (int x = 0; x < target.width; x++)
+            {
+                const float* p00 = row0 + sourceIndex(2 * x, source.width) * 4;
+                const float* p10 = row0 + sourceIndex(2 * x + 1, source.width) * 4;
+                const float* p01 = row1 + sourceIndex(2 * x, source.width) * 4;
+                const float* p11 = row1 + sourceIndex(2 * x + 1, source.width) * 4;
+#ifdef IMAGE_SIMD_SSE
+                if (simd)
+                {
+                    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(p00), _mm_loadu_ps(p10)), _mm_add_ps(_mm_loadu_ps(p01), _mm_loadu_ps(p11)));
+                    _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+                    continue;
+                }
+#endif
+                for (int c = 0; c < 4; c++) out[x * 4 + c] = 0.25f * (p00[c] + p10[c] + p01[c] + p11[c]);
+            }
+        }
+    }
+
+    // Powrt do 8 bitw: kolor przez tablic sRGB, alfa liniowo
+    void encodeLevel(const LinearLevel& source, TextureImage& target, unsigned rowBegin, unsigned rowEnd, bool simd)
+    {
+        const SrgbTables& tables = srgbTables();
+        for (unsigned y = rowBegin; y < rowEnd; y++)
+        {
+            const float* in = &source.pixels[(size_t)y * source.width * 4];
+            unsigned char* out = &target.pixels[(size_t)y * target.width * 4];
+            for (int x = 0; x < source.width; x++)
+            {
+                int index[4];
+#ifdef IMAGE_SIMD_SSE
+                if (simd)
+                {
+                    // Skale kanaw: kolor na indeks tablicy, alfa od razu na 0..255
+                    const __m128 scale = _mm_set_ps(255.0f, (float)linearSteps, (float)linearSteps, (float)linearSteps);
+                    __m128i rounded = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + x * 4), scale));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(index), rounded);
+                }
+                else
+#endif
+                {
+                    for (int c = 0; c < 3; c++) index[c] = (int)(in[x * 4 + c] * linearSteps + 0.5f);
+                    index[3] = (int)(in[x * 4 + 3] * 255.0f + 0.5f);
+                }
+                for (int c = 0; c < 3; c++) out[x * 4 + c] = tables.fromLinear[std::min(std::max(index[c], 0), linearSteps)];
+                out[x * 4 + 3] = (unsigned char)std::min(std::max(index[3], 0), 255);
+            }
+        }
+    }
+}
+
+bool loadTextureImage(const std::string& path, TextureImage& image)
+{
+    // Dekodowanie bez odwracania w stb_image i bez rozszerzania kanaw,
+    // oba kroki robi jedno przejcie kopiujce do bufora obrazu
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (!data)
+    {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return false;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char* in = data + (size_t)(height - 1 - y) * width * channels;
+        unsigned char* out = &image.pixels[(size_t)y * width * 4];
+        switch (channels)
+        {
+        case 4:
+            std::memcpy(out, in, (size_t)width * 4);
+            break;
+        case 3:
+            for (int x = 0; x < width; x++, in += 3, out += 4)
+            {
+                out[0] = in[0]; out[1] = in[1]; out[2] = in[2]; out[3] = 255;
+            }
+            break;
+        case 2:
+            for (int x = 0; x < width; x++, in += 2, out += 4)
+            {
+                out[0] = out[1] = out[2] = in[0]; out[3] = in[1];
+            }
+            break;
+        default:
+            for (int x = 0; x < width; x++, in += 1, out += 4)
+            {
+                out[0] = out[1] = out[2] = in[0]; out[3] = 255;
+            }
+            break;
+        }
+    }
+    stbi_image_free(data);
+    return true;
+}
+
+void resampleImage(const TextureImage& source, int width, int height, TextureImage& result)
+{
+    result.width = width;
+    result.height = height;
+    result.pixels.resize((size_t)width * height * 4);
+
+    for (int y = 0; y < height; y++)
+    {
+        // rodek piksela wyniku w pikselach rda
+        float sy = std::max((y + 0.5f) * source.height / height - 0.5f, 0.0f);
+        int y0 = std::min((int)sy, source.height - 1), y1 = std::min(y0 + 1, source.height - 1);
+        float fy = sy - y0;
+        for (int x = 0; x < width; x++)
+        {
+            float sx = std::max((x + 0.5f) * source.width / width - 0.5f, 0.0f);
+            int x0 = std::min((int)sx, source.width - 1), x1 = std::min(x0 + 1, source.width - 1);
+            float fx = sx - x0;
+
+            const unsigned char* p00 = &source.pixels[((size_t)y0 * source.width + x0) * 4];
+            const unsigned char* p10 = &source.pixels[((size_t)y0 * source.width + x1) * 4];
+            const unsigned char* p01 = &source.pixels[((size_t)y1 * source.width + x0) * 4];
+            const unsigned char* p11 = &source.pixels[((size_t)y1 * source.width + x1) * 4];
+            unsigned char* out = &result.pixels[((size_t)y * width + x) * 4];
+            for (int c = 0; c < 4; c++)
+            {
+                float top = p00[c] + (p10[c] - p00[c]) * fx;
+                float bottom = p01[c] + (p11[c] - p01[c]) * fx;
+                out[c] = (unsigned char)(top + (bottom - top) * fy + 0.5f);
+            }
+        }
+    }
+}
+
+int mipLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+void generateMipChain(const TextureImage& base, std::vector<TextureImage>& levels, MipPath path)
+{
+    bool simd = path != MipPath::Scalar;
+    unsigned threads = path == MipPath::Parallel ? jobThreadCount() : 1u;
+    levels.resize(mipLevelCount(base.width, base.height) - 1);
+
+    LinearLevel previous, current;
+    int width = base.width, height = base.height;
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        current.width = width;
+        current.height = height;
+        current.pixels.resize((size_t)width * height * 4);
+
+        // Mae poziomy nie s warte uruchamiania wtkw
+        unsigned levelThreads = (size_t)width * height >= 64 * 1024 ? threads : 1u;
+        parallelFor((unsigned)height, [&](unsigned begin, unsigned end)
+        {
+            if (level == 0) downsampleBytes(base, current, begin, end, simd);
+            else downsampleLinear(previous, current, begin, end, simd);
+        }, levelThreads);
+
+        TextureImage& target = levels[level];
+        target.width = width;
+        target.height = height;
+        target.pixels.resize((size_t)width * height * 4);
+        parallelFor((unsigned)height, [&](unsigned begin, unsigned end)
+        {
+            encodeLevel(current, target, begin, end, simd);
+        }, levelThreads);
+
+        std::swap(previous, current);
+    }
+}
+
+int runMipmapBenchmark(sf::Window& window, int size)
+{
+    (void)window;
+    size = std::max(2, size);
+
+    // Obraz testowy z drobnym wzorem, eby rednie w sRGB i liniowo wyranie si rniy
+    TextureImage base;
+    base.width = base.height = size;
+    base.pixels.resize((size_t)size * size * 4);
+    for (int y = 0; y < size; y++)
+    {
+        for (int x = 0; x < size; x++)
+        {
+            unsigned char* p = &base.pixels[((size_t)y * size + x) * 4];
+            bool on = ((x ^ y) & 1) != 0;
+            p[0] = on ? 255 : 0;
+            p[1] = (unsigned char)(x * 255 / size);
+            p[2] = (unsigned char)(y * 255 / size);
+            p[3] = 255;
+        }
+    }
+    double megapixels = (double)size * size / 1e6;
+    std::cout << "Mipmaps: " << size << "x" << size << ", " << mipLevelCount(size, size) << " levels" << std::endl;
+
+    const int runs = 5;
+    std::vector<TextureImage> levels;
+    const char* names[3] = { "CPU scalar", "CPU SIMD", "CPU SIMD, all cores" };
+    for (int path = 0; path < 3; path++)
+    {
+        generateMipChain(base, levels, (MipPath)path);
+        auto start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; run++) generateMipChain(base, levels, (MipPath)path);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / runs;
+        std::cout << "  " << names[path] << ": " << seconds * 1000.0 << " ms, " << megapixels / seconds << " MPixel/s" << std::endl;
+    }
+    // Szachownica 0/255 uredniona liniowo daje 188 w sRGB, naiwnie 128
+    std::cout << "  level 1 red channel: " << (int)levels[0].pixels[0] << " (sRGB-correct 188)" << std::endl;
+
+    // Ten sam obraz w sterowniku: wysanie poziomu 0 i glGenerateMipmap, mierzone do glFinish
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, base.pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glFinish();
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, base.pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    glFinish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / runs;
+    std::cout << "  glGenerateMipmap (" << glGetString(GL_RENDERER) << "): " << seconds * 1000.0 << " ms including upload, "
+        << megapixels / seconds << " MPixel/s" << std::endl;
+
+    // Wysanie poziomw policzonych na CPU
+    start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, base.pixels.data());
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint)level + 1, 0, 0, levels[level].width, levels[level].height, GL_RGBA, GL_UNSIGNED_BYTE, levels[level].pixels.data());
+        }
+    }
+    glFinish();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / runs;
+    std::cout << "  uploading CPU levels: " << seconds * 1000.0 << " ms" << std::endl;
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+    checkGLErrors("After mipmap benchmark");
+    return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Przygotowanie obrazw na CPU: odwrcenie wierszy i rozszerzenie do RGBA w jednym przejciu
+// po dekodowaniu oraz acuch mipmap liczony w przestrzeni liniowej (rednia kolorw sRGB
+// po zamianie na wiato liniowe), z SSE i na kilku wtkach. Poziomy s gotowe do
+// wysania bez glGenerateMipmap.
+
+// Obraz RGBA8, pierwszy wiersz na dole jak w OpenGL
+struct TextureImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+enum class MipPath
+{
+    Scalar,   // Bez SIMD, jeden wtek
+    Simd,     // SSE, jeden wtek
+    Parallel  // SSE na wszystkich rdzeniach
+};
+
+// Dekodowanie pliku do image, bufor obrazu jest uywany ponownie, jeli wystarcza
+bool loadTextureImage(const std::string& path, TextureImage& image);
+
+// Skalowanie dwuliniowe do podanego rozmiaru
+void resampleImage(const TextureImage& source, int width, int height, TextureImage& result);
+
+// Liczba poziomw mipmap a do 1x1
+int mipLevelCount(int width, int height);
+
+// Poziomy 1..n-1 obrazu base w levels[0..n-2]
+void generateMipChain(const TextureImage& base, std::vector<TextureImage>& levels, MipPath path = MipPath::Parallel);
+
+// Pomiar: MPiksele/s acucha mipmap na CPU w kadej ciece i glGenerateMipmap sterownika
+int runMipmapBenchmark(sf::Window& window, int size);
@@ -0,0 +1,433 @@
+#include "indirect_draw.h"
+#include "gl_utils.h"
+#include "lod.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const int texelsPerDraw = 6;
+
+    // Najwiksza skala macierzy modelu, promie sfery otaczajcej ronie o tyle
+    float maxScale(const glm::mat4& model)
+    {
+        return std::sqrt(std::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+            std::max(glm::dot(glm::vec3(model[1]), glm::vec3(model[1])), glm::dot(glm::vec3(model[2]), glm::vec3(model[2])))));
+    }
+}
+
+uint32_t addPooledMesh(IndirectRenderer& renderer, const Mesh& mesh)
+{
+    PooledMesh pooled;
+    pooled.baseVertex = (GLint)renderer.vertices.size();
+    pooled.center = mesh.center;
+    pooled.radius = mesh.radius;
+
+    unsigned firstIndex = (unsigned)renderer.indices.size();
+    for (MeshLod lod : mesh.lods)
+    {
+        lod.indexOffset += firstIndex;
+        pooled.lods.push_back(lod);
+    }
+    renderer.vertices.insert(renderer.vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+    renderer.indices.insert(renderer.indices.end(), mesh.indices.begin(), mesh.indices.end());
+
+    renderer.meshes.push_back(pooled);
+    return (uint32_t)renderer.meshes.size() - 1;
+}
+
+void createIndirectRenderer(IndirectRenderer& renderer)
+{
+    renderer.multiDraw = GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+    if (!renderer.multiDraw)
+    {
+        std::cerr << "GL_ARB_multi_draw_indirect not supported, indirect commands are issued one by one." << std::endl;
+    }
+
+    glGenVertexArrays(1, &renderer.vao);
+    glGenBuffers(1, &renderer.vbo);
+    glGenBuffers(1, &renderer.ebo);
+    glGenBuffers(1, &renderer.drawIdBuffer);
+    glGenBuffers(1, &renderer.commandBuffer);
+    glGenBuffers(1, &renderer.drawDataBuffer);
+    glGenTextures(1, &renderer.drawDataTexture);
+
+    glBindVertexArray(renderer.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
+    glBufferData(GL_ARRAY_BUFFER, renderer.vertices.size() * sizeof(Vertex), renderer.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, renderer.indices.size() * sizeof(unsigned int), renderer.indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(2);
+
+    // Numery rysowa 0..n-1, polecenie i czyta element baseInstance = i
+    std::vector<GLuint> drawIds(std::max<size_t>(renderer.objects.size(), 1));
+    for (size_t i = 0; i < drawIds.size(); i++) drawIds[i] = (GLuint)i;
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.drawIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, drawIds.size() * sizeof(GLuint), drawIds.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+    glVertexAttribDivisor(3, 1);
+    if (renderer.multiDraw) glEnableVertexAttribArray(3);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, std::max<size_t>(renderer.objects.size(), 1) * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, renderer.drawDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(renderer.objects.size(), 1) * texelsPerDraw * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer.drawDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, renderer.drawDataBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    renderer.materialStart.assign(renderer.materialCount + 1, 0);
+    checkGLErrors("After creating indirect renderer");
+}
+
+void destroyIndirectRenderer(IndirectRenderer& renderer)
+{
+    glDeleteVertexArrays(1, &renderer.vao);
+    glDeleteBuffers(1, &renderer.vbo);
+    glDeleteBuffers(1, &renderer.ebo);
+    glDeleteBuffers(1, &renderer.drawIdBuffer);
+    glDeleteBuffers(1, &renderer.commandBuffer);
+    glDeleteBuffers(1, &renderer.drawDataBuffer);
+    glDeleteTextures(1, &renderer.drawDataTexture);
+    renderer.vao = renderer.vbo = renderer.ebo = 0;
+    renderer.drawIdBuffer = renderer.commandBuffer = renderer.drawDataBuffer = renderer.drawDataTexture = 0;
+}
+
+void cullIndirect(IndirectRenderer& renderer, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale, float maxPixelError)
+{
+    // Liczenie widocznych na materia, potem wpisanie polece od razu w kolejnoci materiaw
+    std::vector<uint32_t>& start = renderer.materialStart;
+    start.assign(renderer.materialCount + 1, 0);
+
+    std::vector<std::pair<uint32_t, int>>& visible = renderer.visible;
+    visible.clear();
+    glm::vec4 planes[6];
+    frustumPlanes(viewProj, planes);
+    for (uint32_t i = 0; i < renderer.objects.size(); i++)
+    {
+        const DrawObject& object = renderer.objects[i];
+        const PooledMesh& mesh = renderer.meshes[object.mesh];
+        glm::vec3 center = glm::vec3(object.model * glm::vec4(mesh.center, 1.0f));
+        float radius = mesh.radius * maxScale(object.model);
+        if (!sphereInPlanes(planes, center, radius)) continue;
+
+        int lod = selectLod(mesh.lods, radius, center, cameraPos, pixelScale, maxPixelError);
+        visible.push_back(std::make_pair(i, lod));
+        start[object.material + 1]++;
+    }
+    for (uint32_t m = 0; m < renderer.materialCount; m++) start[m + 1] += start[m];
+
+    renderer.commands.resize(visible.size());
+    renderer.drawData.resize(visible.size() * texelsPerDraw);
+    renderer.commandObjects.resize(visible.size());
+    std::vector<uint32_t>& cursor = renderer.materialCursor;
+    cursor.assign(start.begin(), start.end() - 1);
+    for (const auto& entry : visible)
+    {
+        const DrawObject& object = renderer.objects[entry.first];
+        const PooledMesh& mesh = renderer.meshes[object.mesh];
+        const MeshLod& lod = mesh.lods[entry.second];
+        uint32_t slot = cursor[object.material]++;
+
+        DrawElementsIndirectCommand& command = renderer.commands[slot];
+        command.count = lod.indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = lod.indexOffset;
+        command.baseVertex = mesh.baseVertex;
+        command.baseInstance = slot; // Numer rysowania w shaderze
+        renderer.commandObjects[slot] = entry.first;
+
+        glm::vec4* data = &renderer.drawData[slot * texelsPerDraw];
+        data[0] = object.model[0];
+        data[1] = object.model[1];
+        data[2] = object.model[2];
+        data[3] = object.model[3];
+        data[4] = object.color;
+        data[5] = glm::vec4((float)object.layer, 0.0f, 0.0f, 0.0f);
+    }
+
+    if (!renderer.commands.empty())
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commandBuffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, renderer.commands.size() * sizeof(DrawElementsIndirectCommand), renderer.commands.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, renderer.drawDataBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, renderer.drawData.size() * sizeof(glm::vec4), renderer.drawData.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    renderer.drawCalls = 0;
+}
+
+void drawIndirect(IndirectRenderer& renderer, uint32_t material)
+{
+    uint32_t first = renderer.materialStart[material];
+    uint32_t count = renderer.materialStart[material + 1] - first;
+    if (count == 0) return;
+
+    glBindVertexArray(renderer.vao);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, renderer.drawDataTexture);
+
+    if (renderer.multiDraw)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, renderer.commandBuffer);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(first * sizeof(DrawElementsIndirectCommand)), (GLsizei)count, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        renderer.drawCalls++;
+    }
+    else
+    {
+        // Te same polecenia z CPU, numer rysowania jako staa warto wyczonego atrybutu
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            const DrawElementsIndirectCommand& command = renderer.commands[i];
+            glVertexAttribI1ui(3, command.baseInstance);
+            glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)command.count, GL_UNSIGNED_INT,
+                (void*)(command.firstIndex * sizeof(unsigned int)), command.baseVertex);
+            renderer.drawCalls++;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+const GLchar* indirectVertexSource = R"glsl(
+    #version 330 core
+    in vec3 position;
+    in vec3 normal;
+    in vec2 texCoord;
+    in uint drawId;
+
+    uniform samplerBuffer drawData;
+    uniform mat4 viewProj;
+
+    out vec3 Normal;
+    out vec2 TexCoord;
+    out vec4 Color;
+    flat out float Layer;
+
+    void main()
+    {
+        int base = int(drawId) * 6;
+        mat4 model = mat4(texelFetch(drawData, base), texelFetch(drawData, base + 1),
+                          texelFetch(drawData, base + 2), texelFetch(drawData, base + 3));
+        Color = texelFetch(drawData, base + 4);
+        Layer = texelFetch(drawData, base + 5).x;
+        Normal = mat3(model) * normal;
+        TexCoord = texCoord;
+        gl_Position = viewProj * model * vec4(position, 1.0);
+    }
+)glsl";
+
+namespace
+{
+    // Ten sam wynik dla ptli po obiektach, dane obiektu w uniformach
+    const GLchar* uniformVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        in vec3 normal;
+        in vec2 texCoord;
+
+        uniform mat4 model;
+        uniform vec4 color;
+        uniform mat4 viewProj;
+
+        out vec3 Normal;
+        out vec2 TexCoord;
+        out vec4 Color;
+
+        void main()
+        {
+            Color = color;
+            Normal = mat3(model) * normal;
+            TexCoord = texCoord;
+            gl_Position = viewProj * model * vec4(position, 1.0);
+        }
+    )glsl";
+
+    // Materia 0: matowy
+    const GLchar* matteFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        in vec4 Color;
+        out vec4 outColor;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            outColor = vec4(Color.rgb * light, Color.a);
+        }
+    )glsl";
+
+    // Materia 1: szachownica z UV
+    const GLchar* checkerFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        in vec4 Color;
+        out vec4 outColor;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            vec2 cell = floor(TexCoord * 8.0);
+            float checker = mod(cell.x + cell.y, 2.0) * 0.5 + 0.5;
+            outColor = vec4(Color.rgb * light * checker, Color.a);
+        }
+    )glsl";
+}
+
+int runIndirectBenchmark(sf::Window& window, int objectCount)
+{
+    Mesh meshes[2];
+    if (!loadMesh("chair.obj", meshes[0]) || !loadMesh("table.obj", meshes[1])) return 1;
+
+    IndirectRenderer renderer;
+    renderer.materialCount = 2;
+    for (Mesh& mesh : meshes)
+    {
+        addPooledMesh(renderer, mesh);
+        uploadMesh(mesh); // Osobne VAO dla ptli po obiektach
+    }
+
+    // Kwadratowa siatka obiektw, siatka i materia na przemian
+    int side = std::max(1, (int)std::ceil(std::sqrt((double)objectCount)));
+    float spacing = std::max(meshes[0].radius, meshes[1].radius) * 2.5f;
+    for (int i = 0; i < objectCount; i++)
+    {
+        DrawObject object;
+        object.mesh = (uint32_t)(i % 2);
+        object.material = (uint32_t)((i / 2) % 2);
+        object.model = glm::translate(glm::mat4(1.0f), glm::vec3((i % side) * spacing, 0.0f, (i / side) * spacing));
+        object.model = glm::rotate(object.model, (float)(i % 16) * 0.4f, glm::vec3(0.0f, 1.0f, 0.0f));
+        object.color = glm::vec4(0.5f + 0.5f * ((i * 37) % 11) / 10.0f, 0.5f + 0.5f * ((i * 53) % 7) / 6.0f, 0.7f, 1.0f);
+        object.layer = 0;
+        renderer.objects.push_back(object);
+    }
+    createIndirectRenderer(renderer);
+
+    GLuint indirectPrograms[2] = {
+        createProgram(indirectVertexSource, matteFragmentSource, { "position", "normal", "texCoord", "drawId" }, "Indirect matte"),
+        createProgram(indirectVertexSource, checkerFragmentSource, { "position", "normal", "texCoord", "drawId" }, "Indirect checker") };
+    GLuint uniformPrograms[2] = {
+        createProgram(uniformVertexSource, matteFragmentSource, { "position", "normal", "texCoord" }, "Per-object matte"),
+        createProgram(uniformVertexSource, checkerFragmentSource, { "position", "normal", "texCoord" }, "Per-object checker") };
+    for (GLuint program : { indirectPrograms[0], indirectPrograms[1], uniformPrograms[0], uniformPrograms[1] })
+    {
+        if (!program) return 1;
+    }
+    for (GLuint program : indirectPrograms)
+    {
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "drawData"), 0);
+    }
+
+    float extent = side * spacing;
+    glm::vec3 cameraPos(-spacing, spacing * 3.0f, -spacing);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    float fov = glm::radians(45.0f);
+    glm::mat4 proj = glm::perspective(fov, (float)width / height, spacing * 0.05f, extent * 2.0f);
+    glm::mat4 viewProj = proj * view;
+    float pixelScale = pixelsPerUnit(fov, height);
+
+    window.setVerticalSyncEnabled(false);
+    glEnable(GL_DEPTH_TEST);
+    std::cout << "Indirect: " << objectCount << " objects, " << renderer.meshes.size() << " meshes, "
+        << renderer.materialCount << " materials" << (renderer.multiDraw ? "" : " (no multi-draw)") << std::endl;
+
+    const int frames = 100;
+    for (int indirect = 0; indirect < 2; indirect++)
+    {
+        double submitSeconds = 0.0;
+        unsigned drawCalls = 0;
+        size_t visibleCount = 0;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Czas CPU od odrzucania do ostatniego wywoania, oba warianty z tym samym odrzucaniem i LOD
+            auto submitStart = std::chrono::steady_clock::now();
+            cullIndirect(renderer, viewProj, cameraPos, pixelScale, 1.0f);
+            if (indirect)
+            {
+                for (uint32_t material = 0; material < renderer.materialCount; material++)
+                {
+                    glUseProgram(indirectPrograms[material]);
+                    glUniformMatrix4fv(glGetUniformLocation(indirectPrograms[material], "viewProj"), 1, GL_FALSE, glm::value_ptr(viewProj));
+                    drawIndirect(renderer, material);
+                }
+            }
+            else
+            {
+                for (uint32_t material = 0; material < renderer.materialCount; material++)
+                {
+                    GLuint program = uniformPrograms[material];
+                    glUseProgram(program);
+                    glUniformMatrix4fv(glGetUniformLocation(program, "viewProj"), 1, GL_FALSE, glm::value_ptr(viewProj));
+                    GLint uniModel = glGetUniformLocation(program, "model");
+                    GLint uniColor = glGetUniformLocation(program, "color");
+                    for (uint32_t i = renderer.materialStart[material]; i < renderer.materialStart[material + 1]; i++)
+                    {
+                        // Poziom LOD z polecenia, przesunity do wasnego bufora indeksw siatki
+                        const DrawElementsIndirectCommand& command = renderer.commands[i];
+                        const DrawObject& object = renderer.objects[renderer.commandObjects[i]];
+                        unsigned firstIndex = command.firstIndex - renderer.meshes[object.mesh].lods[0].indexOffset;
+
+                        glBindVertexArray(meshes[object.mesh].vao);
+                        glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(object.model));
+                        glUniform4fv(uniColor, 1, glm::value_ptr(object.color));
+                        glDrawElements(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(unsigned int)));
+                        renderer.drawCalls++;
+                    }
+                }
+                glBindVertexArray(0);
+            }
+            submitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+            drawCalls = renderer.drawCalls;
+            visibleCount = renderer.commands.size();
+
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (indirect ? "  multi-draw indirect: " : "  per-object loop: ") << visibleCount << " visible, "
+            << drawCalls << " draw calls, CPU submit " << submitSeconds / frames * 1000.0 << " ms, frame "
+            << seconds / frames * 1000.0 << " ms" << std::endl;
+    }
+
+    for (GLuint program : { indirectPrograms[0], indirectPrograms[1], uniformPrograms[0], uniformPrograms[1] }) glDeleteProgram(program);
+    destroyIndirectRenderer(renderer);
+    for (Mesh& mesh : meshes) destroyMesh(mesh);
+    checkGLErrors("After indirect benchmark");
+    return 0;
+}
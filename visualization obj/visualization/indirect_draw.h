@@ -0,0 +1,88 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "mesh.h"
+
+namespace sf
+{
+    class Window;
+}
+
+// Rysowanie sterowane danymi: wszystkie statyczne siatki w jednej parze VBO/EBO ze wsplnym VAO,
+// dane obiektw (macierz modelu i kolor) w buforze tekstury indeksowanym numerem rysowania.
+// Przebieg odrzucania na CPU zapisuje polecenia do bufora poredniego, a cay widoczny zbir
+// idzie jednym glMultiDrawElementsIndirect na materia. Numer rysowania dociera do shadera przez
+// atrybut instancji z dzielnikiem 1, bo baseInstance polecenia przesuwa jego odczyt.
+
+// Ukad z GL_ARB_multi_draw_indirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// Siatka we wsplnym buforze, lods[].indexOffset liczone od pocztku bufora indeksw
+struct PooledMesh
+{
+    GLint baseVertex = 0;
+    std::vector<MeshLod> lods;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+struct DrawObject
+{
+    uint32_t mesh;
+    uint32_t material;
+    glm::mat4 model;
+    glm::vec4 color;
+    int layer = 0; // Warstwa tablicy tekstur
+};
+
+struct IndirectRenderer
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<PooledMesh> meshes;
+    std::vector<DrawObject> objects;
+    uint32_t materialCount = 1;
+
+    bool multiDraw = false; // Bez rozszerzenia polecenia s wykonywane pojedynczo
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    GLuint drawIdBuffer = 0;
+    GLuint commandBuffer = 0;
+    GLuint drawDataBuffer = 0, drawDataTexture = 0;
+
+    // Wynik ostatniego odrzucania: polecenia i dane posortowane wedug materiau
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<glm::vec4> drawData;       // 6 tekseli na rysowanie: 4 kolumny macierzy, kolor, warstwa tekstury
+    std::vector<uint32_t> commandObjects;  // Obiekt kadego polecenia
+    std::vector<std::pair<uint32_t, int>> visible; // Bufor roboczy: obiekt i jego poziom LOD
+    std::vector<uint32_t> materialStart;   // Pierwsze polecenie kadego materiau, na kocu liczba polece
+    std::vector<uint32_t> materialCursor;  // Bufor roboczy: nastpne wolne polecenie kadego materiau
+    unsigned drawCalls = 0;                // Wywoania rysowania od ostatniego odrzucania
+};
+
+// Shader wierzchokw czytajcy dane rysowania, wyjcia: Normal, TexCoord, Color i Layer
+extern const GLchar* indirectVertexSource;
+
+// Dopisanie siatki z jej poziomami LOD do wsplnego bufora, zwraca numer siatki
+uint32_t addPooledMesh(IndirectRenderer& renderer, const Mesh& mesh);
+
+// Wysanie wsplnych buforw po dodaniu wszystkich siatek i obiektw
+void createIndirectRenderer(IndirectRenderer& renderer);
+void destroyIndirectRenderer(IndirectRenderer& renderer);
+
+// Odrzucenie obiektw poza ostrosupem, wybr LOD i zapis polece do bufora poredniego
+void cullIndirect(IndirectRenderer& renderer, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale, float maxPixelError);
+
+// Rysowanie widocznych obiektw jednego materiau, program musi mie samplerBuffer drawData na jednostce 0
+void drawIndirect(IndirectRenderer& renderer, uint32_t material);
+
+// Pomiar: liczba wywoa i czas wysyania na CPU dla ptli po obiektach i dla rysowania poredniego
+int runIndirectBenchmark(sf::Window& window, int objectCount);
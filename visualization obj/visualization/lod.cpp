@@ -0,0 +1,451 @@
+#include "lod.h"
+#include "gl_utils.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+    // Symetryczna macierz 4x4 kwadryki: suma kwadratw odlegoci od paszczyzn waona polem trjktw
+    struct Quadric
+    {
+        double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+        double weight;
+    };
+
+    void addPlane(Quadric& q, double x, double y, double z, double d, double w)
+    {
+        q.a00 += w * x * x; q.a01 += w * x * y; q.a02 += w * x * z; q.a03 += w * x * d;
+        q.a11 += w * y * y; q.a12 += w * y * z; q.a13 += w * y * d;
+        q.a22 += w * z * z; q.a23 += w * z * d;
+        q.a33 += w * d * d;
+        q.weight += w;
+    }
+
+    void addQuadric(Quadric& q, const Quadric& o)
+    {
+        q.a00 += o.a00; q.a01 += o.a01; q.a02 += o.a02; q.a03 += o.a03;
+        q.a11 += o.a11; q.a12 += o.a12; q.a13 += o.a13;
+        q.a22 += o.a22; q.a23 += o.a23;
+        q.a33 += o.a33;
+        q.weight += o.weight;
+    }
+
+    // redni kwadrat odlegoci, wic pierwiastek jest w jednostkach obiektu niezalenie od liczby paszczyzn
+    double evaluate(const Quadric& q, const glm::vec3& p)
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x
+            + q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y
+            + q.a22 * z * z + 2.0 * q.a23 * z
+            + q.a33;
+        return q.weight > 0.0 ? std::max(e, 0.0) / q.weight : 0.0;
+    }
+
+    struct Collapse
+    {
+        double cost;
+        unsigned from, to;
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3& p) const
+        {
+            unsigned words[3];
+            std::memcpy(words, &p.x, sizeof(words));
+            return (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual
+    {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    glm::vec3 triangleNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+    {
+        return glm::cross(b - a, c - a);
+    }
+
+    // Czy przesunicie from na to nie odwraca adnego z pozostaych trjktw wok from
+    bool keepsOrientation(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+        const unsigned* triangles, unsigned triangleCount, unsigned from, unsigned to)
+    {
+        for (unsigned i = 0; i < triangleCount; i++)
+        {
+            const unsigned int* tri = &indices[triangles[i] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) continue; // Ten trjkt znika
+
+            glm::vec3 p[3], moved[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = vertices[tri[k]].position;
+                moved[k] = tri[k] == from ? vertices[to].position : p[k];
+            }
+            glm::vec3 before = triangleNormal(p[0], p[1], p[2]);
+            glm::vec3 after = triangleNormal(moved[0], moved[1], moved[2]);
+            float d = glm::dot(before, after);
+            if (d <= 0.0f || d * d < 0.0625f * glm::dot(before, before) * glm::dot(after, after)) return false;
+        }
+        return true;
+    }
+}
+
+float simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+    size_t targetIndexCount, std::vector<unsigned int>& result)
+{
+    size_t vertexCount = vertices.size();
+
+    // Wierzchoki o tym samym pooeniu, ale innych UV lub normalnych, le na szwie
+    std::unordered_map<glm::vec3, unsigned, PositionHash, PositionEqual> positions;
+    std::vector<unsigned> positionId(vertexCount);
+    std::vector<unsigned> groupSize;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        auto inserted = positions.emplace(vertices[i].position, (unsigned)groupSize.size());
+        if (inserted.second) groupSize.push_back(0);
+        positionId[i] = inserted.first->second;
+        groupSize[positionId[i]]++;
+    }
+
+    // Kwadryki z paszczyzn trjktw, wsplne dla caej grupy pooenia
+    std::vector<Quadric> groupQuadrics(groupSize.size(), Quadric{});
+    std::unordered_map<uint64_t, unsigned> edgeUse;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const glm::vec3& a = vertices[indices[t]].position;
+        glm::vec3 n = triangleNormal(a, vertices[indices[t + 1]].position, vertices[indices[t + 2]].position);
+        float length = glm::length(n);
+        if (length > 0.0f)
+        {
+            n = n / length;
+            for (int k = 0; k < 3; k++)
+            {
+                addPlane(groupQuadrics[positionId[indices[t + k]]], n.x, n.y, n.z, -glm::dot(n, a), length * 0.5f);
+            }
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t p0 = positionId[indices[t + k]], p1 = positionId[indices[t + (k + 1) % 3]];
+            edgeUse[std::min(p0, p1) << 32 | std::max(p0, p1)]++;
+        }
+    }
+
+    // Brzegi i krawdzie nierozmaitociowe s zablokowane tak jak szwy
+    std::vector<char> lockedGroup(groupSize.size(), 0);
+    for (size_t g = 0; g < groupSize.size(); g++) lockedGroup[g] = groupSize[g] > 1;
+    for (const auto& edge : edgeUse)
+    {
+        if (edge.second != 2)
+        {
+            lockedGroup[edge.first >> 32] = 1;
+            lockedGroup[edge.first & 0xFFFFFFFFu] = 1;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<char> locked(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        quadrics[i] = groupQuadrics[positionId[i]];
+        locked[i] = lockedGroup[positionId[i]];
+    }
+
+    result = indices;
+    double maxCost = 0.0;
+    std::vector<unsigned> remap(vertexCount);
+    std::vector<char> touched(vertexCount);
+    std::vector<unsigned> triangleOffsets(vertexCount + 1);
+    std::vector<unsigned> vertexTriangles;
+    std::vector<Collapse> collapses;
+
+    // Przebiegi: w kadym najtasze rozczne zwinicia, potem przebudowa indeksw
+    while (result.size() > targetIndexCount)
+    {
+        size_t triangleCount = result.size() / 3;
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (unsigned int index : result) triangleOffsets[index + 1]++;
+        for (size_t i = 0; i < vertexCount; i++) triangleOffsets[i + 1] += triangleOffsets[i];
+        vertexTriangles.resize(result.size());
+        std::vector<unsigned> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < result.size(); i++) vertexTriangles[cursor[result[i]]++] = (unsigned)(i / 3);
+
+        collapses.clear();
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned a = result[t * 3 + k], b = result[t * 3 + (k + 1) % 3];
+                for (int dir = 0; dir < 2; dir++)
+                {
+                    unsigned from = dir ? b : a, to = dir ? a : b;
+                    if (locked[from]) continue;
+                    Quadric q = quadrics[from];
+                    addQuadric(q, quadrics[to]);
+                    collapses.push_back(Collapse{ evaluate(q, vertices[to].position), from, to });
+                }
+            }
+        }
+        if (collapses.empty()) break;
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        for (size_t i = 0; i < vertexCount; i++) remap[i] = (unsigned)i;
+        std::fill(touched.begin(), touched.end(), 0);
+
+        for (const Collapse& c : collapses)
+        {
+            if (removed >= trianglesToRemove) break;
+            if (touched[c.from] || touched[c.to]) continue;
+
+            const unsigned* around = &vertexTriangles[triangleOffsets[c.from]];
+            unsigned aroundCount = triangleOffsets[c.from + 1] - triangleOffsets[c.from];
+            if (!keepsOrientation(vertices, result, around, aroundCount, c.from, c.to)) continue;
+
+            // Ssiedztwo from jest zamroone do koca przebiegu, eby testy orientacji byy aktualne
+            remap[c.from] = c.to;
+            addQuadric(quadrics[c.to], quadrics[c.from]);
+            for (unsigned i = 0; i < aroundCount; i++)
+            {
+                const unsigned int* tri = &result[around[i] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) removed++;
+            }
+            maxCost = std::max(maxCost, c.cost);
+        }
+        if (removed == 0) break;
+
+        // Trjkty zdegenerowane po zwiniciu znikaj
+        size_t write = 0;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            unsigned a = remap[result[t * 3]], b = remap[result[t * 3 + 1]], c = remap[result[t * 3 + 2]];
+            if (positionId[a] == positionId[b] || positionId[b] == positionId[c] || positionId[a] == positionId[c]) continue;
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    return (float)std::sqrt(maxCost);
+}
+
+void buildLods(Mesh& mesh, const std::vector<unsigned int>& indices, int maxLevels)
+{
+    mesh.indices = indices;
+    mesh.lods.assign(1, MeshLod{ 0, (unsigned)indices.size(), 0.0f });
+
+    // Kady poziom liczony z penej siatki, wic bd odnosi si do oryginau
+    std::vector<unsigned int> lod;
+    size_t previousCount = indices.size();
+    for (int level = 1; level < maxLevels; level++)
+    {
+        size_t target = (indices.size() >> level) / 3 * 3;
+        if (target < 3 * 64) break;
+        float error = simplifyMesh(mesh.vertices, indices, target, lod);
+        if (lod.size() > previousCount * 9 / 10) break; // Dalej blokuj ju tylko szwy i brzegi
+
+        mesh.lods.push_back(MeshLod{ (unsigned)mesh.indices.size(), (unsigned)lod.size(), std::max(error, mesh.lods.back().error) });
+        mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+        previousCount = lod.size();
+    }
+}
+
+float pixelsPerUnit(float fovRadians, int viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(fovRadians * 0.5f));
+}
+
+int selectLod(const std::vector<MeshLod>& lods, float radius, const glm::vec3& objectCenter, const glm::vec3& cameraPos, float pixelScale, float maxPixelError)
+{
+    float distance = glm::length(objectCenter - cameraPos) - radius;
+    if (distance <= 0.0f) return 0;
+
+    int lod = 0;
+    for (size_t i = 1; i < lods.size(); i++)
+    {
+        if (lods[i].error * pixelScale / distance > maxPixelError) break;
+        lod = (int)i;
+    }
+    return lod;
+}
+
+int selectLod(const Mesh& mesh, const glm::vec3& objectCenter, const glm::vec3& cameraPos, float pixelScale, float maxPixelError)
+{
+    return selectLod(mesh.lods, mesh.radius, objectCenter, cameraPos, pixelScale, maxPixelError);
+}
+
+void frustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6])
+{
+    // Paszczyzny to suma i rnica czwartego wiersza z wierszami 0-2
+    for (int i = 0; i < 6; i++)
+    {
+        int row = i / 2;
+        float sign = (i % 2) ? -1.0f : 1.0f;
+        glm::vec4 plane(viewProj[0][3] + sign * viewProj[0][row], viewProj[1][3] + sign * viewProj[1][row],
+            viewProj[2][3] + sign * viewProj[2][row], viewProj[3][3] + sign * viewProj[3][row]);
+        planes[i] = plane / glm::length(glm::vec3(plane));
+    }
+}
+
+bool sphereInPlanes(const glm::vec4 planes[6], const glm::vec3& center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) return false;
+    }
+    return true;
+}
+
+namespace
+{
+    const GLchar* lodVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        in vec3 normal;
+        in vec2 texCoord;
+        in vec3 offset; // Przesunicie instancji
+
+        uniform mat4 viewProj;
+
+        out vec3 Normal;
+
+        void main()
+        {
+            Normal = normal;
+            gl_Position = viewProj * vec4(position + offset, 1.0);
+        }
+    )glsl";
+
+    const GLchar* lodFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        out vec4 outColor;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            outColor = vec4(vec3(light), 1.0);
+        }
+    )glsl";
+}
+
+int runLodBenchmark(sf::Window& window, const char* objPath, int gridSize)
+{
+    Mesh mesh;
+    if (!loadMesh(objPath, mesh)) return 1;
+    uploadMesh(mesh);
+
+    GLuint program = createProgram(lodVertexSource, lodFragmentSource, { "position", "normal", "texCoord", "offset" }, "LOD benchmark");
+    if (!program) return 1;
+    GLint uniViewProj = glGetUniformLocation(program, "viewProj");
+
+    // Przesunicia instancji w buforze doczonym do VAO siatki
+    GLuint instanceBuffer;
+    glGenBuffers(1, &instanceBuffer);
+    glBindVertexArray(mesh.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
+
+    // Siatka obiektw ogldana z rogu, bliskie s due, dalekie zajmuj kilka pikseli
+    float spacing = mesh.radius * 2.5f;
+    std::vector<glm::vec3> positions;
+    for (int z = 0; z < gridSize; z++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            positions.push_back(glm::vec3(x * spacing, 0.0f, z * spacing));
+        }
+    }
+    float extent = gridSize * spacing;
+    glm::vec3 cameraPos(-spacing, mesh.radius * 4.0f, -spacing);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    float fov = glm::radians(45.0f);
+    glm::mat4 proj = glm::perspective(fov, (float)width / height, mesh.radius * 0.1f, extent * 2.0f);
+    float pixelScale = pixelsPerUnit(fov, height);
+
+    window.setVerticalSyncEnabled(false);
+    glEnable(GL_DEPTH_TEST);
+    glUseProgram(program);
+    glUniformMatrix4fv(uniViewProj, 1, GL_FALSE, glm::value_ptr(proj * view));
+
+    std::cout << "LOD: " << positions.size() << " instances, levels:";
+    for (const MeshLod& lod : mesh.lods) std::cout << " " << lod.indexCount / 3 << " (" << lod.error << ")";
+    std::cout << std::endl;
+
+    std::vector<std::vector<glm::vec3>> buckets(mesh.lods.size());
+    std::vector<glm::vec3> instances;
+    const int frames = 100;
+    for (int useLods = 0; useLods < 2; useLods++)
+    {
+        double selectSeconds = 0.0;
+        long long triangles = 0;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            // Wybr poziomu dla kadej instancji, potem jedno wywoanie na poziom
+            auto selectStart = std::chrono::steady_clock::now();
+            for (auto& bucket : buckets) bucket.clear();
+            for (const glm::vec3& p : positions)
+            {
+                int lod = useLods ? selectLod(mesh, p + mesh.center, cameraPos, pixelScale, 1.0f) : 0;
+                buckets[lod].push_back(p);
+            }
+            instances.clear();
+            for (const auto& bucket : buckets) instances.insert(instances.end(), bucket.begin(), bucket.end());
+            selectSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - selectStart).count();
+
+            glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::vec3), instances.data(), GL_STREAM_DRAW);
+
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glBindVertexArray(mesh.vao);
+            size_t first = 0;
+            triangles = 0;
+            for (size_t lod = 0; lod < buckets.size(); lod++)
+            {
+                if (buckets[lod].empty()) continue;
+                // Bez baseInstance z GL 4.2 pocztek instancji wybiera przesunicie atrybutu
+                glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)(first * sizeof(glm::vec3)));
+                glDrawElementsInstanced(GL_TRIANGLES, mesh.lods[lod].indexCount, GL_UNSIGNED_INT,
+                    (void*)(mesh.lods[lod].indexOffset * sizeof(unsigned int)), (GLsizei)buckets[lod].size());
+                triangles += (long long)buckets[lod].size() * mesh.lods[lod].indexCount / 3;
+                first += buckets[lod].size();
+            }
+            glBindVertexArray(0);
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (useLods ? "  with LOD: " : "  full detail: ") << triangles << " triangles, frame "
+            << seconds / frames * 1000.0 << " ms, selection " << selectSeconds / frames * 1000.0 << " ms" << std::endl;
+    }
+
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteProgram(program);
+    destroyMesh(mesh);
+    checkGLErrors("After LOD benchmark");
+    return 0;
+}
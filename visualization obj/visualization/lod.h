@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "mesh.h"
+
+namespace sf
+{
+    class Window;
+}
+
+// Upraszczanie siatki przez zwijanie krawdzi z metryk kwadryk (QEM). Wierzchoek zawsze
+// przesuwa si na ssiedni istniejcy wierzchoek, wic kady poziom to tylko nowe indeksy
+// do tego samego VBO. Wierzchoki na szwach UV/normalnych i na brzegach siatki nie s ruszane.
+
+// Uproszczenie do okoo targetIndexCount indeksw, zwraca osignity bd w jednostkach obiektu
+float simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+    size_t targetIndexCount, std::vector<unsigned int>& result);
+
+// acuch poziomw: kady ma okoo poow trjktw poprzedniego, dopisywany do mesh.indices
+void buildLods(Mesh& mesh, const std::vector<unsigned int>& indices, int maxLevels = 8);
+
+// Liczba pikseli ekranu na jednostk wiata w odlegoci 1 dla danego pionowego pola widzenia
+float pixelsPerUnit(float fovRadians, int viewportHeight);
+
+// Najmniej szczegowy poziom, ktrego bd po rzutowaniu nie przekracza maxPixelError
+int selectLod(const Mesh& mesh, const glm::vec3& objectCenter, const glm::vec3& cameraPos, float pixelScale, float maxPixelError);
+int selectLod(const std::vector<MeshLod>& lods, float radius, const glm::vec3& objectCenter, const glm::vec3& cameraPos, float pixelScale, float maxPixelError);
+
+// Sze znormalizowanych paszczyzn ostrosupa wycignitych z macierzy viewProj, do testw wielu kul
+void frustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+bool sphereInPlanes(const glm::vec4 planes[6], const glm::vec3& center, float radius);
+
+// Pomiar: dua scena z instancjami siatki rysowana z pen szczegowoci i z LOD
+int runLodBenchmark(sf::Window& window, const char* objPath, int gridSize);
@@ -0,0 +1,131 @@
+#include "mapped_file.h"
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    bool mapHandle(MappedFile& mapped, HANDLE file, uint64_t size, bool writable, const std::string& path)
+    {
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            std::cerr << "Cannot open file: " << path << std::endl;
+            return false;
+        }
+        mapped.file = file;
+        mapped.size = size;
+        if (size == 0) return true;
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+            (DWORD)(size >> 32), (DWORD)size, nullptr);
+        if (!mapping)
+        {
+            std::cerr << "Cannot map file: " << path << std::endl;
+            unmapFile(mapped);
+            return false;
+        }
+        mapped.mapping = mapping;
+        mapped.data = (unsigned char*)MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+        if (!mapped.data)
+        {
+            std::cerr << "Cannot map view of file: " << path << std::endl;
+            unmapFile(mapped);
+            return false;
+        }
+        return true;
+    }
+#else
+    bool mapDescriptor(MappedFile& mapped, int descriptor, uint64_t size, bool writable, const std::string& path)
+    {
+        if (descriptor < 0)
+        {
+            std::cerr << "Cannot open file: " << path << std::endl;
+            return false;
+        }
+        mapped.descriptor = descriptor;
+        mapped.size = size;
+        if (size == 0) return true;
+
+        void* data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, descriptor, 0);
+        if (data == MAP_FAILED)
+        {
+            std::cerr << "Cannot map file: " << path << std::endl;
+            unmapFile(mapped);
+            return false;
+        }
+        mapped.data = (unsigned char*)data;
+        return true;
+    }
+#endif
+}
+
+bool mapFile(MappedFile& mapped, const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size = {};
+    if (file != INVALID_HANDLE_VALUE) GetFileSizeEx(file, &size);
+    return mapHandle(mapped, file, (uint64_t)size.QuadPart, false, path);
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    struct stat info = {};
+    if (descriptor >= 0) fstat(descriptor, &info);
+    return mapDescriptor(mapped, descriptor, (uint64_t)info.st_size, false, path);
+#endif
+}
+
+bool createMappedFile(MappedFile& mapped, const std::string& path, uint64_t size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return mapHandle(mapped, file, size, true, path);
+#else
+    int descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (descriptor >= 0 && ftruncate(descriptor, (off_t)size) != 0)
+    {
+        std::cerr << "Cannot resize file: " << path << std::endl;
+        close(descriptor);
+        return false;
+    }
+    return mapDescriptor(mapped, descriptor, size, true, path);
+#endif
+}
+
+void unmapFile(MappedFile& mapped)
+{
+#ifdef _WIN32
+    if (mapped.data) UnmapViewOfFile(mapped.data);
+    if (mapped.mapping) CloseHandle((HANDLE)mapped.mapping);
+    if (mapped.file) CloseHandle((HANDLE)mapped.file);
+#else
+    if (mapped.data) munmap(mapped.data, mapped.size);
+    if (mapped.descriptor >= 0) close(mapped.descriptor);
+#endif
+    mapped = MappedFile();
+}
+
+void releasePages(MappedFile& mapped, uint64_t offset, uint64_t size)
+{
+    if (!mapped.data || offset >= mapped.size) return;
+    if (size > mapped.size - offset) size = mapped.size - offset;
+
+#ifdef _WIN32
+    // Odblokowanie niezablokowanych stron usuwa je z zestawu roboczego procesu
+    VirtualUnlock(mapped.data + offset, (SIZE_T)size);
+#else
+    // madvise wymaga pocztku wyrwnanego do strony
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t begin = offset / page * page;
+    madvise(mapped.data + begin, size + (offset - begin), MADV_DONTNEED);
+#endif
+}
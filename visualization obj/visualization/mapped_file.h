@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Plik odwzorowany w pami. Strony wczytuje system dopiero przy pierwszym dostpie,
+// wic pliki wiksze od RAM mona czyta fragmentami bez wasnego buforowania.
+struct MappedFile
+{
+    unsigned char* data = nullptr;
+    uint64_t size = 0;
+
+    void* file = nullptr;    // HANDLE pliku (Windows)
+    void* mapping = nullptr; // HANDLE odwzorowania (Windows)
+    int descriptor = -1;     // Deskryptor pliku (POSIX)
+};
+
+// Odwzorowanie istniejcego pliku tylko do odczytu
+bool mapFile(MappedFile& mapped, const std::string& path);
+
+// Utworzenie pliku o podanym rozmiarze i odwzorowanie go do zapisu
+bool createMappedFile(MappedFile& mapped, const std::string& path, uint64_t size);
+
+void unmapFile(MappedFile& mapped);
+
+// Wskazwka dla systemu, e zakres nie bdzie szybko potrzebny i jego strony mona zwolni
+void releasePages(MappedFile& mapped, uint64_t offset, uint64_t size);
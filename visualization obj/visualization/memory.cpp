@@ -0,0 +1,267 @@
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+struct ArenaBlock
+{
+    ArenaBlock* previous;
+    size_t size;   // Bajty danych za nagwkiem
+    size_t offset; // Pierwszy wolny bajt
+};
+
+namespace
+{
+    std::atomic<uint64_t> allocationCount(0);
+    std::atomic<uint64_t> freeCount(0);
+    std::atomic<uint64_t> allocatedBytes(0);
+
+    const size_t blockHeader = (sizeof(ArenaBlock) + 15) & ~(size_t)15;
+
+    ArenaBlock* newBlock(MemoryArena& arena, size_t size, ArenaBlock* previous)
+    {
+        ArenaBlock* block = static_cast<ArenaBlock*>(::operator new(blockHeader + size));
+        block->previous = previous;
+        block->size = size;
+        block->offset = 0;
+        arena.reserved += size;
+        return block;
+    }
+
+    void freeBlocks(ArenaBlock* block)
+    {
+        while (block)
+        {
+            ArenaBlock* previous = block->previous;
+            ::operator delete(block);
+            block = previous;
+        }
+    }
+
+    void* countedAllocate(size_t bytes)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        return std::malloc(bytes ? bytes : 1);
+    }
+
+    void countedFree(void* pointer)
+    {
+        if (!pointer) return;
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+        std::free(pointer);
+    }
+
+    void* countedAlignedAllocate(size_t bytes, size_t alignment)
+    {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+#ifdef _WIN32
+        return _aligned_malloc(bytes ? bytes : 1, alignment);
+#else
+        // aligned_alloc wymaga rozmiaru bdcego wielokrotnoci wyrwnania
+        return std::aligned_alloc(alignment, (std::max(bytes, (size_t)1) + alignment - 1) / alignment * alignment);
+#endif
+    }
+
+    void countedAlignedFree(void* pointer)
+    {
+        if (!pointer) return;
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+        _aligned_free(pointer);
+#else
+        std::free(pointer);
+#endif
+    }
+}
+
+void* arenaAllocate(MemoryArena& arena, size_t bytes, size_t alignment)
+{
+    // Wyrwnanie liczone od adresu, bo pocztek bloku ze sterty ma tylko wyrwnanie malloc
+    ArenaBlock* block = arena.blocks;
+    uintptr_t base = 0, start = 0;
+    if (block)
+    {
+        base = reinterpret_cast<uintptr_t>(block) + blockHeader;
+        start = ((base + block->offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+    if (!block || start + bytes > block->size)
+    {
+        block = newBlock(arena, std::max(arena.blockSize, bytes + alignment), block);
+        arena.blocks = block;
+        base = reinterpret_cast<uintptr_t>(block) + blockHeader;
+        start = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+    }
+    arena.used += start - block->offset + bytes;
+    arena.peak = std::max(arena.peak, arena.used);
+    block->offset = start + bytes;
+    return reinterpret_cast<void*>(base + start);
+}
+
+bool arenaGrow(MemoryArena& arena, void* pointer, size_t bytes, size_t newBytes)
+{
+    ArenaBlock* block = arena.blocks;
+    if (!block || !pointer || newBytes < bytes) return false;
+    uintptr_t base = reinterpret_cast<uintptr_t>(block) + blockHeader;
+    uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+    if (address < base || address - base + bytes != block->offset || address - base + newBytes > block->size) return false;
+    arena.used += newBytes - bytes;
+    arena.peak = std::max(arena.peak, arena.used);
+    block->offset = address - base + newBytes;
+    return true;
+}
+
+void resetArena(MemoryArena& arena)
+{
+    ArenaBlock* block = arena.blocks;
+    if (block && block->previous)
+    {
+        // Kilka blokw zastpuje jeden o cznym rozmiarze, kolejne przejcie zmieci si bez dokadania
+        size_t total = arena.reserved;
+        freeBlocks(block);
+        arena.reserved = 0;
+        block = newBlock(arena, total, nullptr);
+        arena.blocks = block;
+    }
+    if (block) block->offset = 0;
+    arena.used = 0;
+}
+
+void releaseArena(MemoryArena& arena)
+{
+    freeBlocks(arena.blocks);
+    arena.blocks = nullptr;
+    arena.used = 0;
+    arena.reserved = 0;
+}
+
+void beginFrameMemory(FrameAllocator& allocator)
+{
+    allocator.frame++;
+    resetArena(allocator.arenas[allocator.frame & 1]);
+}
+
+void* frameAllocate(FrameAllocator& allocator, size_t bytes, size_t alignment)
+{
+    return arenaAllocate(allocator.arenas[allocator.frame & 1], bytes, alignment);
+}
+
+bool frameGrow(FrameAllocator& allocator, void* pointer, size_t bytes, size_t newBytes)
+{
+    return arenaGrow(allocator.arenas[allocator.frame & 1], pointer, bytes, newBytes);
+}
+
+const char* frameFormat(FrameAllocator& allocator, const char* format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    va_list copy;
+    va_copy(copy, arguments);
+    int length = std::vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    char* text = static_cast<char*>(frameAllocate(allocator, (size_t)std::max(length, 0) + 1, 1));
+    std::vsnprintf(text, (size_t)std::max(length, 0) + 1, format, arguments);
+    va_end(arguments);
+    return text;
+}
+
+void releaseFrameAllocator(FrameAllocator& allocator)
+{
+    releaseArena(allocator.arenas[0]);
+    releaseArena(allocator.arenas[1]);
+}
+
+AllocationStats readAllocationStats()
+{
+    AllocationStats stats;
+    stats.allocations = allocationCount.load(std::memory_order_relaxed);
+    stats.frees = freeCount.load(std::memory_order_relaxed);
+    stats.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return (uint64_t)usage.ru_maxrss * 1024; // Linux podaje kilobajty
+#endif
+}
+
+// Zastpione operatory new i delete: ten sam malloc, tylko z licznikami
+void* operator new(size_t bytes)
+{
+    void* pointer = countedAllocate(bytes);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t bytes)
+{
+    return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept
+{
+    return countedAllocate(bytes);
+}
+
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { countedFree(pointer); }
+
+void* operator new(size_t bytes, std::align_val_t alignment)
+{
+    void* pointer = countedAlignedAllocate(bytes, (size_t)alignment);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment)
+{
+    return operator new(bytes, alignment);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAllocate(bytes, (size_t)alignment);
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAllocate(bytes, (size_t)alignment);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept { countedAlignedFree(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { countedAlignedFree(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { countedAlignedFree(pointer); }
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Pami tymczasowa bez pojedynczych zwolnie. Arena przydziela przesuwajc wskanik w duych
+// blokach i oddaje wszystko naraz, wic dane pomocnicze wczytywania nie przechodz przez stert
+// dla kadego elementu. Alokator klatki to dwie areny na zmian: dane klatki N s wane jeszcze
+// w klatce N+1, a po rozgrzaniu klatka nie dotyka sterty. Liczniki zastpionego operatora new
+// pozwalaj sprawdzi, ile przydziaw na stercie robi dany fragment programu.
+
+struct ArenaBlock;
+
+struct MemoryArena
+{
+    size_t blockSize = 1 << 20;   // Najmniejszy blok, wiksze przydziay dostaj wasny
+    ArenaBlock* blocks = nullptr; // Biecy blok, poprzednie na licie
+    size_t used = 0;              // Bajty przydzielone od ostatniego resetu, z wyrwnaniem
+    size_t reserved = 0;          // Bajty blokw wzitych ze sterty
+    size_t peak = 0;
+};
+
+void* arenaAllocate(MemoryArena& arena, size_t bytes, size_t alignment = 16);
+
+// Tablica bez konstrukcji elementw, dla typw zapisywanych przed odczytem
+template <typename T>
+T* arenaArray(MemoryArena& arena, size_t count)
+{
+    return static_cast<T*>(arenaAllocate(arena, count * sizeof(T), alignof(T)));
+}
+
+// Powikszenie ostatniego przydziau w miejscu, gdy za nim nic nie przydzielono i mieci si w bloku
+bool arenaGrow(MemoryArena& arena, void* pointer, size_t bytes, size_t newBytes);
+
+// Reset zostawia jeden blok o cznym rozmiarze poprzednich, wic kolejne uycie tej samej wielkoci nie przydziela
+void resetArena(MemoryArena& arena);
+void releaseArena(MemoryArena& arena);
+
+struct FrameAllocator
+{
+    MemoryArena arenas[2];
+    unsigned frame = 0;
+};
+
+// Pocztek klatki: druga arena jest czyszczona i staje si biec
+void beginFrameMemory(FrameAllocator& allocator);
+void* frameAllocate(FrameAllocator& allocator, size_t bytes, size_t alignment = 16);
+bool frameGrow(FrameAllocator& allocator, void* pointer, size_t bytes, size_t newBytes);
+
+// Tekst w formacie printf w pamici klatki
+const char* frameFormat(FrameAllocator& allocator, const char* format, ...);
+
+void releaseFrameAllocator(FrameAllocator& allocator);
+
+// Liczniki operatora new i delete od startu programu
+struct AllocationStats
+{
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+};
+
+AllocationStats readAllocationStats();
+
+// Najwiksze zuycie pamici fizycznej przez proces w bajtach
+uint64_t peakResidentBytes();
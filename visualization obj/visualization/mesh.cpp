@@ -0,0 +1,330 @@
+#include "mesh.h"
+#include "lod.h"
+#include "meshlet.h"
+#include "mapped_file.h"
+#include "mesh_codec.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace
+{
+    size_t hashVertex(const Vertex& v)
+    {
+        const unsigned* words = reinterpret_cast<const unsigned*>(&v);
+        size_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(Vertex) / sizeof(unsigned); i++)
+        {
+            h = (h ^ words[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    const char* skipSpaces(const char* p, const char* end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        return p;
+    }
+
+    const char* tokenEnd(const char* p, const char* end)
+    {
+        while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+        return p;
+    }
+
+    // Liczba zmiennoprzecinkowa po spacjach, przesuwa p za ni
+    bool parseFloat(const char*& p, const char* end, float& value)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+') p++;
+        std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc()) return false;
+        p = result.ptr;
+        return true;
+    }
+
+    // Indeks z pola ciany, pusty fragment daje 0 jak brak danej
+    bool parseIndex(const char* begin, const char* end, long& value)
+    {
+        value = 0;
+        if (begin == end) return true;
+        std::from_chars_result result = std::from_chars(begin, end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    bool hasPrefix(const char* p, const char* end, const char* prefix, size_t length)
+    {
+        return (size_t)(end - p) > length && std::memcmp(p, prefix, length) == 0 && (p[length] == ' ' || p[length] == '\t');
+    }
+}
+
+bool loadObj(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MemoryArena* scratch)
+{
+    MappedFile file;
+    if (!mapFile(file, filePath)) return false;
+
+    // Dane pomocnicze w arenie, bez areny z wywoania wasna zwalniana na kocu
+    MemoryArena localArena;
+    MemoryArena& arena = scratch ? *scratch : localArena;
+    const char* text = reinterpret_cast<const char*>(file.data);
+    const char* textEnd = text + file.size;
+
+    // Pierwsze przejcie tylko liczy wiersze, tablice dostaj dokadne rozmiary
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0, faceCount = 0;
+    for (const char* line = text; line < textEnd;)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', textEnd - line));
+        if (!lineEnd) lineEnd = textEnd;
+        const char* p = skipSpaces(line, lineEnd);
+        if (hasPrefix(p, lineEnd, "v", 1)) positionCount++;
+        else if (hasPrefix(p, lineEnd, "vt", 2)) texCoordCount++;
+        else if (hasPrefix(p, lineEnd, "vn", 2)) normalCount++;
+        else if (hasPrefix(p, lineEnd, "f", 1)) faceCount++;
+        line = lineEnd + 1;
+    }
+
+    glm::vec3* positions = arenaArray<glm::vec3>(arena, positionCount);
+    glm::vec3* normals = arenaArray<glm::vec3>(arena, normalCount);
+    glm::vec2* texCoords = arenaArray<glm::vec2>(arena, texCoordCount); // Przechowywanie UV
+    size_t positionsRead = 0, texCoordsRead = 0, normalsRead = 0;
+    vertices.reserve(vertices.size() + faceCount * 3);
+    indices.reserve(indices.size() + faceCount * 3);
+
+    bool ok = true;
+    for (const char* line = text; ok && line < textEnd;)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', textEnd - line));
+        if (!lineEnd) lineEnd = textEnd;
+        const char* p = skipSpaces(line, lineEnd);
+        line = lineEnd + 1;
+
+        // Brakujce skadowe zostaj zerami jak przy odczycie strumieniem
+        if (hasPrefix(p, lineEnd, "v", 1)) {  // Vertex position
+            glm::vec3& position = positions[positionsRead++];
+            position = glm::vec3(0.0f);
+            p++;
+            parseFloat(p, lineEnd, position.x) && parseFloat(p, lineEnd, position.y) && parseFloat(p, lineEnd, position.z);
+        }
+        else if (hasPrefix(p, lineEnd, "vt", 2)) {  // Vertex texture coordinate
+            glm::vec2& texCoord = texCoords[texCoordsRead++];
+            texCoord = glm::vec2(0.0f);
+            p += 2;
+            parseFloat(p, lineEnd, texCoord.x) && parseFloat(p, lineEnd, texCoord.y);
+        }
+        else if (hasPrefix(p, lineEnd, "vn", 2)) {  // Vertex normal
+            glm::vec3& normal = normals[normalsRead++];
+            normal = glm::vec3(0.0f);
+            p += 2;
+            parseFloat(p, lineEnd, normal.x) && parseFloat(p, lineEnd, normal.y) && parseFloat(p, lineEnd, normal.z);
+        }
+        else if (hasPrefix(p, lineEnd, "f", 1)) {  // Face
+            p++;
+            size_t faceStart = vertices.size();
+            bool missingNormal[3] = {};
+            for (int i = 0; i < 3; i++) {
+                const char* vertexBegin = skipSpaces(p, lineEnd);
+                const char* vertexEnd = tokenEnd(vertexBegin, lineEnd);
+                p = vertexEnd;
+                if (vertexBegin == vertexEnd) {
+                    std::cerr << "Error: Not enough vertex data in face" << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                // Formaty v, v/vt, v//vn i v/vt/vn; bez UV wsprzdne (0, 0), bez normalnej normalna ciany
+                const char* firstSlash = std::find(vertexBegin, vertexEnd, '/');
+                const char* secondSlash = firstSlash == vertexEnd ? vertexEnd : std::find(firstSlash + 1, vertexEnd, '/');
+                long posIdx = 0, texIdx = 0, normIdx = 0;
+                if (!parseIndex(vertexBegin, firstSlash, posIdx)
+                    || (firstSlash != vertexEnd && !parseIndex(firstSlash + 1, secondSlash, texIdx))
+                    || (secondSlash != vertexEnd && !parseIndex(secondSlash + 1, vertexEnd, normIdx))) {
+                    std::cerr << "Error: Invalid vertex data in face: " << std::string(vertexBegin, vertexEnd) << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                // Kontrola zakresw indeksw
+                if (posIdx < 1 || (size_t)posIdx > positionsRead) {
+                    std::cerr << "Error: Position index out of range in face: " << posIdx << std::endl;
+                    ok = false;
+                    break;
+                }
+                if (texIdx < 0 || (size_t)texIdx > texCoordsRead) {
+                    std::cerr << "Error: Texture index out of range in face: " << texIdx << std::endl;
+                    ok = false;
+                    break;
+                }
+                if (normIdx < 0 || (size_t)normIdx > normalsRead) {
+                    std::cerr << "Error: Normal index out of range in face: " << normIdx << std::endl;
+                    ok = false;
+                    break;
+                }
+
+                Vertex vertex;
+                vertex.position = positions[posIdx - 1];
+                vertex.normal = normIdx ? normals[normIdx - 1] : glm::vec3(0.0f);
+                vertex.texCoord = texIdx ? texCoords[texIdx - 1] : glm::vec2(0.0f); // Przypisanie UV
+                missingNormal[i] = normIdx == 0;
+
+                vertices.push_back(vertex);
+                indices.push_back((unsigned int)vertices.size() - 1);
+            }
+            if (ok && (missingNormal[0] || missingNormal[1] || missingNormal[2])) {
+                Vertex* face = &vertices[faceStart];
+                glm::vec3 normal = glm::cross(face[1].position - face[0].position, face[2].position - face[0].position);
+                float length = glm::length(normal);
+                normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+                for (int i = 0; i < 3; i++) {
+                    if (missingNormal[i]) face[i].normal = normal;
+                }
+            }
+        }
+    }
+
+    unmapFile(file);
+    if (!scratch) releaseArena(localArena);
+    if (!ok) return false;
+
+    std::cout << "Loaded OBJ: " << filePath << " with "
+        << vertices.size() << " vertices and "
+        << indices.size() << " indices." << std::endl;
+    return true;
+}
+
+void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MemoryArena* scratch)
+{
+    // Tablica z adresowaniem otwartym w arenie zamiast wzw unordered_map dla kadego wierzchoka
+    MemoryArena localArena;
+    MemoryArena& arena = scratch ? *scratch : localArena;
+    size_t capacity = 16;
+    while (capacity < vertices.size() * 2) capacity *= 2;
+    unsigned int* table = arenaArray<unsigned int>(arena, capacity);
+    unsigned int* remap = arenaArray<unsigned int>(arena, vertices.size());
+    std::fill(table, table + capacity, ~0u);
+
+    // Scalone wierzchoki trafiaj na pocztek tej samej tablicy, bo unikalny nigdy nie wyprzedza biecego
+    unsigned int unique = 0;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        size_t slot = hashVertex(vertices[i]) & (capacity - 1);
+        while (table[slot] != ~0u && std::memcmp(&vertices[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+        {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        if (table[slot] == ~0u)
+        {
+            vertices[unique] = vertices[i];
+            table[slot] = unique++;
+        }
+        remap[i] = table[slot];
+    }
+    for (unsigned int& index : indices) index = remap[index];
+    vertices.resize(unique);
+    if (!scratch) releaseArena(localArena);
+}
+
+bool loadMesh(const std::string& filePath, Mesh& mesh)
+{
+    // Scalona siatka z poziomami LOD i klastrami z pliku podrcznego, gdy jest nowszy od obj
+    const std::string cachePath = filePath + ".mesh";
+    bool cached = false;
+    std::error_code objError, cacheError;
+    auto objTime = std::filesystem::last_write_time(filePath, objError);
+    auto cacheTime = std::filesystem::last_write_time(cachePath, cacheError);
+    if (!objError && !cacheError && cacheTime >= objTime)
+    {
+        auto start = std::chrono::steady_clock::now();
+        cached = loadMeshCache(cachePath, mesh) && !mesh.lods.empty();
+        if (cached)
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Loaded " << cachePath << " in " << seconds * 1000.0 << " ms" << std::endl;
+        }
+    }
+    std::vector<unsigned int> indices;
+    if (!cached)
+    {
+        // Jedna arena na dane pomocnicze wczytywania i scalania, zwalniana przed budow LOD
+        MemoryArena scratch;
+        mesh.vertices.clear(); // Plik podrczny bez poziomw LOD mg ju wypeni siatk
+        bool loaded = loadObj(filePath, mesh.vertices, indices, &scratch);
+        if (loaded) weldVertices(mesh.vertices, indices, &scratch);
+        std::cout << "OBJ scratch: arena peak " << scratch.peak / 1024 << " KB in " << scratch.reserved / 1024 << " KB of blocks" << std::endl;
+        releaseArena(scratch);
+        if (!loaded) return false;
+    }
+    if (mesh.vertices.empty()) return false;
+    mesh.vertices.shrink_to_fit();
+
+    // Sfera otaczajca ze rodka prostopadocianu
+    glm::vec3 lo = mesh.vertices[0].position, hi = lo;
+    for (const Vertex& v : mesh.vertices)
+    {
+        lo = glm::min(lo, v.position);
+        hi = glm::max(hi, v.position);
+    }
+    mesh.center = (lo + hi) * 0.5f;
+    mesh.radius = 0.0f;
+    for (const Vertex& v : mesh.vertices)
+    {
+        mesh.radius = std::max(mesh.radius, glm::length(v.position - mesh.center));
+    }
+
+    // Upraszczanie i klastry to najdrosza cz wczytywania, plik podrczny przechowuje ich wynik
+    if (!cached)
+    {
+        buildLods(mesh, indices);
+        buildMeshlets(mesh);
+        saveMeshCache(cachePath, mesh);
+    }
+    std::cout << "Mesh " << filePath << ": " << mesh.vertices.size() << " vertices, " << mesh.meshlets.size() << " clusters, LOD triangles:";
+    for (const MeshLod& lod : mesh.lods) std::cout << " " << lod.indexCount / 3;
+    std::cout << std::endl;
+    return true;
+}
+
+void uploadMesh(Mesh& mesh)
+{
+    glGenVertexArrays(1, &mesh.vao);
+    glGenBuffers(1, &mesh.vbo);
+    glGenBuffers(1, &mesh.ebo);
+
+    glBindVertexArray(mesh.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+
+    // Ustawienia atrybutw
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
+void destroyMesh(Mesh& mesh)
+{
+    glDeleteVertexArrays(1, &mesh.vao);
+    glDeleteBuffers(1, &mesh.vbo);
+    glDeleteBuffers(1, &mesh.ebo);
+    mesh.vao = mesh.vbo = mesh.ebo = 0;
+}
+
+void drawMeshLod(const Mesh& mesh, int lod)
+{
+    const MeshLod& range = mesh.lods[lod];
+    glBindVertexArray(mesh.vao);
+    glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.indexOffset * sizeof(unsigned int)));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "memory.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Struktura wierzchoka
+struct Vertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+};
+
+// Zakres indeksw jednego poziomu szczegowoci we wsplnym buforze indeksw
+struct MeshLod
+{
+    unsigned indexOffset;
+    unsigned indexCount;
+    float error; // Najwiksze odchylenie od penej siatki w jednostkach obiektu
+};
+
+// Klaster penej siatki: cigy zakres indeksw z kul otaczajc i stokiem normalnych
+struct Meshlet
+{
+    unsigned indexOffset;
+    unsigned indexCount;
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff; // Sinus poowy kta stoka, 1 gdy klastra nie da si odrzuci jako tylnego
+};
+
+// Siatka z acuchem LOD: wszystkie poziomy korzystaj z tych samych wierzchokw w jednym VBO
+struct Mesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices; // Poziomy kolejno, lods[0] to pena siatka
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;      // Klastry lods[0], ich kolejno to kolejno trjktw w buforze
+    glm::vec3 center = glm::vec3(0.0f); // Sfera otaczajca
+    float radius = 0.0f;
+
+    GLuint vao = 0, vbo = 0, ebo = 0;
+};
+
+// Wczytywanie obiektw z plikw obj, jeden wierzchoek na naronik ciany.
+// Tablice pozycji, normalnych i UV le w arenie scratch, bez niej w arenie zwalnianej przed powrotem
+bool loadObj(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MemoryArena* scratch = nullptr);
+
+// Scalenie identycznych wierzchokw, indeksy wskazuj na scalone
+void weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MemoryArena* scratch = nullptr);
+
+// Wczytanie pliku obj z wygenerowaniem poziomw LOD
+bool loadMesh(const std::string& filePath, Mesh& mesh);
+
+// VAO z atrybutami 0: pozycja, 1: normalna, 2: UV
+void uploadMesh(Mesh& mesh);
+void destroyMesh(Mesh& mesh);
+void drawMeshLod(const Mesh& mesh, int lod);
@@ -0,0 +1,832 @@
+#include "mesh_codec.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MESH_CODEC_SSE2 1
+#endif
+
+namespace
+{
+    const uint32_t meshCacheVersion = 2;
+    const uint32_t compressedFlag = 1;
+    const int vertexWords = sizeof(Vertex) / sizeof(uint32_t);
+    static_assert(vertexWords == 8, "Transpose in the decoder assumes a 32-byte vertex");
+
+    struct MeshCacheHeader
+    {
+        char magic[4];         // "MESH"
+        uint32_t version;
+        uint32_t flags;
+        uint32_t blockVertices;
+        uint32_t blockIndices;
+        uint32_t lodCount;
+        uint32_t meshletCount;
+        uint32_t reserved;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+    };
+
+    // Za nagwkiem tablica blokw, surowe tablice MeshLod i Meshlet, potem bloki wierzchokw i bloki indeksw
+    struct MeshCacheBlock
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const size_t groupBytes[4] = { 0, 4, 8, 16 };
+
+    uint32_t zigzag(uint32_t delta)
+    {
+        return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+    }
+
+    uint32_t unzigzag(uint32_t value)
+    {
+        return (value >> 1) ^ (0u - (value & 1));
+    }
+
+    size_t paddedCount(size_t count)
+    {
+        return (count + 15) / 16 * 16;
+    }
+
+    size_t blockCount(uint64_t count, uint32_t perBlock)
+    {
+        return (size_t)((count + perBlock - 1) / perBlock);
+    }
+
+    // Paszczyzna bajtw: 2 bity nagwka na grup 16 bajtw, potem grupy upakowane na 0, 2, 4 albo 8 bitach
+    void encodePlane(const unsigned char* bytes, size_t padded, std::vector<unsigned char>& out)
+    {
+        size_t groups = padded / 16;
+        size_t header = out.size();
+        out.resize(header + (groups + 3) / 4, 0);
+        for (size_t g = 0; g < groups; g++)
+        {
+            const unsigned char* v = bytes + g * 16;
+            unsigned char any = 0;
+            for (int i = 0; i < 16; i++) any |= v[i];
+            int code = any == 0 ? 0 : any < 4 ? 1 : any < 16 ? 2 : 3;
+            out[header + g / 4] |= (unsigned char)(code << (2 * (g % 4)));
+            if (code == 1)
+            {
+                for (int j = 0; j < 4; j++) out.push_back((unsigned char)(v[4 * j] | v[4 * j + 1] << 2 | v[4 * j + 2] << 4 | v[4 * j + 3] << 6));
+            }
+            else if (code == 2)
+            {
+                for (int j = 0; j < 8; j++) out.push_back((unsigned char)(v[2 * j] | v[2 * j + 1] << 4));
+            }
+            else if (code == 3)
+            {
+                out.insert(out.end(), v, v + 16);
+            }
+        }
+    }
+
+    // Zwraca wskanik za paszczyzn albo nullptr, gdy dane si skoczyy
+    const unsigned char* decodePlaneScalar(const unsigned char* p, const unsigned char* end, size_t groups, unsigned char* out)
+    {
+        const unsigned char* header = p;
+        if ((size_t)(end - p) < (groups + 3) / 4) return nullptr;
+        p += (groups + 3) / 4;
+        for (size_t g = 0; g < groups; g++, out += 16)
+        {
+            int code = header[g / 4] >> (2 * (g % 4)) & 3;
+            if ((size_t)(end - p) < groupBytes[code]) return nullptr;
+            switch (code)
+            {
+            case 0:
+                std::memset(out, 0, 16);
+                break;
+            case 1:
+                for (int j = 0; j < 16; j++) out[j] = p[j / 4] >> (2 * (j % 4)) & 3;
+                break;
+            case 2:
+                for (int j = 0; j < 16; j++) out[j] = p[j / 2] >> (4 * (j % 2)) & 15;
+                break;
+            default:
+                std::memcpy(out, p, 16);
+                break;
+            }
+            p += groupBytes[code];
+        }
+        return p;
+    }
+
+    // Z bajtw paszczyzn sowa, zigzag i suma prefiksowa rnic, wynik sowami jednej skadowej
+    void combinePlanesScalar(const unsigned char* planes, size_t padded, size_t count, uint32_t* words)
+    {
+        uint32_t previous = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t value = planes[i] | (uint32_t)planes[padded + i] << 8 | (uint32_t)planes[2 * padded + i] << 16 | (uint32_t)planes[3 * padded + i] << 24;
+            previous += unzigzag(value);
+            words[i] = previous;
+        }
+    }
+
+#ifdef MESH_CODEC_SSE2
+    const unsigned char* decodePlaneSse(const unsigned char* p, const unsigned char* end, size_t groups, unsigned char* out)
+    {
+        const unsigned char* header = p;
+        if ((size_t)(end - p) < (groups + 3) / 4) return nullptr;
+        p += (groups + 3) / 4;
+        const __m128i mask2 = _mm_set1_epi8(3), mask4 = _mm_set1_epi8(15);
+        for (size_t g = 0; g < groups; g++, out += 16)
+        {
+            int code = header[g / 4] >> (2 * (g % 4)) & 3;
+            if ((size_t)(end - p) < groupBytes[code]) return nullptr;
+            __m128i result;
+            if (code == 0)
+            {
+                result = _mm_setzero_si128();
+            }
+            else if (code == 1)
+            {
+                // Cztery bajty po cztery wartoci: przesunicia, potem przeplot do kolejnoci wartoci
+                int packed;
+                std::memcpy(&packed, p, 4);
+                __m128i x = _mm_cvtsi32_si128(packed);
+                __m128i a = _mm_unpacklo_epi8(_mm_and_si128(x, mask2), _mm_and_si128(_mm_srli_epi16(x, 2), mask2));
+                __m128i b = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), mask2), _mm_and_si128(_mm_srli_epi16(x, 6), mask2));
+                result = _mm_unpacklo_epi16(a, b);
+            }
+            else if (code == 2)
+            {
+                __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+                result = _mm_unpacklo_epi8(_mm_and_si128(x, mask4), _mm_and_si128(_mm_srli_epi16(x, 4), mask4));
+            }
+            else
+            {
+                result = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+            p += groupBytes[code];
+        }
+        return p;
+    }
+
+    // 16 wierzchokw naraz: przeplot czterech paszczyzn w sowa, zigzag, suma prefiksowa w rejestrze z przeniesieniem
+    void combinePlanesSse(const unsigned char* planes, size_t padded, uint32_t* words)
+    {
+        const __m128i one = _mm_set1_epi32(1);
+        __m128i carry = _mm_setzero_si128();
+        for (size_t i = 0; i < padded; i += 16)
+        {
+            __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + i));
+            __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + padded + i));
+            __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + 2 * padded + i));
+            __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + 3 * padded + i));
+            __m128i low01 = _mm_unpacklo_epi8(p0, p1), high01 = _mm_unpackhi_epi8(p0, p1);
+            __m128i low23 = _mm_unpacklo_epi8(p2, p3), high23 = _mm_unpackhi_epi8(p2, p3);
+            __m128i values[4] = { _mm_unpacklo_epi16(low01, low23), _mm_unpackhi_epi16(low01, low23),
+                _mm_unpacklo_epi16(high01, high23), _mm_unpackhi_epi16(high01, high23) };
+            for (int j = 0; j < 4; j++)
+            {
+                __m128i delta = _mm_xor_si128(_mm_srli_epi32(values[j], 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(values[j], one)));
+                delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+                delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+                delta = _mm_add_epi32(delta, carry);
+                carry = _mm_shuffle_epi32(delta, 0xFF);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(words + i + 4 * j), delta);
+            }
+        }
+    }
+
+    // Sowa skadowych po cztery wierzchoki transponowane do ukadu Vertex
+    void transposeWordsSse(const uint32_t* words, size_t padded, size_t count, uint32_t* out)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            for (int half = 0; half < 2; half++)
+            {
+                __m128 r0 = _mm_loadu_ps(reinterpret_cast<const float*>(words + (4 * half + 0) * padded + i));
+                __m128 r1 = _mm_loadu_ps(reinterpret_cast<const float*>(words + (4 * half + 1) * padded + i));
+                __m128 r2 = _mm_loadu_ps(reinterpret_cast<const float*>(words + (4 * half + 2) * padded + i));
+                __m128 r3 = _mm_loadu_ps(reinterpret_cast<const float*>(words + (4 * half + 3) * padded + i));
+                _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                float* row = reinterpret_cast<float*>(out + i * vertexWords + 4 * half);
+                _mm_storeu_ps(row, r0);
+                _mm_storeu_ps(row + vertexWords, r1);
+                _mm_storeu_ps(row + 2 * vertexWords, r2);
+                _mm_storeu_ps(row + 3 * vertexWords, r3);
+            }
+        }
+        for (; i < count; i++)
+        {
+            for (int k = 0; k < vertexWords; k++) out[i * vertexWords + k] = words[k * padded + i];
+        }
+    }
+#endif
+
+    void encodeVertexBlock(const Vertex* vertices, size_t count, std::vector<unsigned char>& out)
+    {
+        size_t padded = paddedCount(count);
+        std::vector<uint32_t> deltas(padded, 0);
+        std::vector<unsigned char> plane(padded, 0);
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertices);
+        for (int k = 0; k < vertexWords; k++)
+        {
+            uint32_t previous = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                uint32_t word;
+                std::memcpy(&word, bytes + i * sizeof(Vertex) + k * sizeof(uint32_t), sizeof(word));
+                deltas[i] = zigzag(word - previous);
+                previous = word;
+            }
+            for (int b = 0; b < 4; b++)
+            {
+                for (size_t i = 0; i < count; i++) plane[i] = (unsigned char)(deltas[i] >> (8 * b));
+                encodePlane(plane.data(), padded, out);
+            }
+        }
+    }
+
+    struct VertexScratch
+    {
+        std::vector<unsigned char> planes;
+        std::vector<uint32_t> words;
+    };
+
+    bool decodeVertexBlock(const unsigned char* p, const unsigned char* end, size_t count, Vertex* vertices, bool simd, VertexScratch& scratch)
+    {
+        size_t padded = paddedCount(count), groups = padded / 16;
+        scratch.planes.resize(4 * padded);
+        scratch.words.resize(vertexWords * padded);
+        uint32_t* out = reinterpret_cast<uint32_t*>(vertices);
+#ifdef MESH_CODEC_SSE2
+        if (simd)
+        {
+            for (int k = 0; k < vertexWords; k++)
+            {
+                for (int b = 0; b < 4 && p; b++) p = decodePlaneSse(p, end, groups, scratch.planes.data() + b * padded);
+                if (!p) return false;
+                combinePlanesSse(scratch.planes.data(), padded, scratch.words.data() + k * padded);
+            }
+            transposeWordsSse(scratch.words.data(), padded, count, out);
+            return p == end;
+        }
+#else
+        (void)simd;
+#endif
+        for (int k = 0; k < vertexWords; k++)
+        {
+            for (int b = 0; b < 4 && p; b++) p = decodePlaneScalar(p, end, groups, scratch.planes.data() + b * padded);
+            if (!p) return false;
+            combinePlanesScalar(scratch.planes.data(), padded, count, scratch.words.data() + k * padded);
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            for (int k = 0; k < vertexWords; k++) out[i * vertexWords + k] = scratch.words[k * padded + i];
+        }
+        return p == end;
+    }
+
+    void writeVarint(uint64_t value, std::vector<unsigned char>& out)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((unsigned char)value);
+    }
+
+    bool readVarint(const unsigned char*& p, const unsigned char* end, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (p >= end) return false;
+            uint64_t byte = *p++;
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80) return true;
+        }
+        return false;
+    }
+
+    // Kolejki ostatnich krawdzi i wierzchokw bloku indeksw, wsplne dla kodera i dekodera
+    const int edgeFifoSize = 16, vertexFifoSize = 16;
+    const uint32_t explicitVertex = 1 + vertexFifoSize; // Kody od tej wartoci to zigzag odlegoci od next
+
+    struct IndexCoder
+    {
+        uint32_t next = 0; // Nastpny nowy wierzchoek
+        uint32_t edges[edgeFifoSize][2];
+        uint32_t vertices[vertexFifoSize];
+        unsigned edgeOffset = 0, vertexOffset = 0;
+
+        IndexCoder()
+        {
+            std::fill(&edges[0][0], &edges[0][0] + 2 * edgeFifoSize, ~0u);
+            std::fill(vertices, vertices + vertexFifoSize, ~0u);
+        }
+
+        int findEdge(uint32_t a, uint32_t b) const
+        {
+            // Numer krawdzi zajmuje starsze 4 bity bajtu razem z zerem dla braku, wic ostatnie 15
+            for (int e = 0; e < edgeFifoSize - 1; e++)
+            {
+                const uint32_t* edge = edges[(edgeOffset - 1 - e) & (edgeFifoSize - 1)];
+                if (edge[0] == a && edge[1] == b) return e;
+            }
+            return -1;
+        }
+
+        // Krawdzie trjkta odwrcone, bo tak widzi je ssiad o tej samej orientacji
+        void pushTriangle(uint32_t a, uint32_t b, uint32_t c)
+        {
+            const uint32_t reversed[3][2] = { { b, a }, { c, b }, { a, c } };
+            for (const auto& edge : reversed)
+            {
+                edges[edgeOffset & (edgeFifoSize - 1)][0] = edge[0];
+                edges[edgeOffset & (edgeFifoSize - 1)][1] = edge[1];
+                edgeOffset++;
+            }
+        }
+
+        // 0 to nowy wierzchoek, 1..16 pozycja w kolejce, dalej odlego od next
+        uint64_t encodeVertex(uint32_t value)
+        {
+            uint64_t code;
+            if (value == next)
+            {
+                code = 0;
+            }
+            else
+            {
+                int f = 0;
+                while (f < vertexFifoSize && vertices[(vertexOffset - 1 - f) & (vertexFifoSize - 1)] != value) f++;
+                code = f < vertexFifoSize ? 1 + f : explicitVertex + (uint64_t)zigzag(next - value);
+            }
+            updateVertex(value, code);
+            return code;
+        }
+
+        bool decodeVertex(uint64_t code, uint64_t vertexCount, uint32_t& value)
+        {
+            if (code == 0) value = next;
+            else if (code < explicitVertex) value = vertices[(vertexOffset - (uint32_t)code) & (vertexFifoSize - 1)];
+            else if (code - explicitVertex <= 0xFFFFFFFFull) value = next - unzigzag((uint32_t)(code - explicitVertex));
+            else return false;
+            if (value >= vertexCount) return false;
+            updateVertex(value, code);
+            return true;
+        }
+
+        void updateVertex(uint32_t value, uint64_t code)
+        {
+            if (code == 0 || code >= explicitVertex) vertices[vertexOffset++ & (vertexFifoSize - 1)] = value;
+            if (value >= next) next = value + 1;
+        }
+    };
+
+    // Trjkt dzielcy krawd z jednym z ostatnich to jeden bajt: numer krawdzi w kolejce i kod trzeciego
+    // wierzchoka (0 nowy, 1..14 z kolejki, 15 i varint dalej). Pozostae trjkty: bajt 0 i trzy varinty.
+    // eby krawd trafia, trjkt moe zosta obrcony; kolejno obiegu si nie zmienia.
+    void encodeIndexBlock(const unsigned int* indices, size_t count, uint32_t next, std::vector<unsigned char>& out)
+    {
+        unsigned char start[4];
+        std::memcpy(start, &next, 4);
+        out.insert(out.end(), start, start + 4);
+        IndexCoder coder;
+        coder.next = next;
+        size_t triangles = count / 3;
+        for (size_t t = 0; t < triangles; t++)
+        {
+            uint32_t a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+            int edge = coder.findEdge(a, b);
+            for (int rotation = 1; rotation < 3 && edge < 0; rotation++)
+            {
+                uint32_t first = a;
+                a = b;
+                b = c;
+                c = first;
+                edge = coder.findEdge(a, b);
+            }
+            if (edge < 0)
+            {
+                // Bez trafienia z powrotem w kolejnoci wejcia
+                a = indices[3 * t];
+                b = indices[3 * t + 1];
+                c = indices[3 * t + 2];
+            }
+            if (edge >= 0)
+            {
+                uint64_t code = coder.encodeVertex(c);
+                out.push_back((unsigned char)((edge + 1) << 4 | std::min<uint64_t>(code, 15)));
+                if (code >= 15) writeVarint(code - 15, out);
+            }
+            else
+            {
+                out.push_back(0);
+                for (uint32_t value : { a, b, c }) writeVarint(coder.encodeVertex(value), out);
+            }
+            coder.pushTriangle(a, b, c);
+        }
+        for (size_t i = 3 * triangles; i < count; i++) writeVarint(coder.encodeVertex(indices[i]), out);
+    }
+
+    bool decodeIndexBlock(const unsigned char* p, const unsigned char* end, size_t count, uint64_t vertexCount, unsigned int* out)
+    {
+        if (end - p < 4) return false;
+        IndexCoder coder;
+        std::memcpy(&coder.next, p, 4);
+        p += 4;
+        size_t triangles = count / 3;
+        for (size_t t = 0; t < triangles; t++, out += 3)
+        {
+            if (p >= end) return false;
+            unsigned header = *p++;
+            uint64_t code;
+            if (header >> 4)
+            {
+                const uint32_t* edge = coder.edges[(coder.edgeOffset - (header >> 4)) & (edgeFifoSize - 1)];
+                if (edge[0] >= vertexCount || edge[1] >= vertexCount) return false;
+                out[0] = edge[0];
+                out[1] = edge[1];
+                code = header & 15;
+                if (code == 15)
+                {
+                    if (!readVarint(p, end, code)) return false;
+                    code += 15;
+                }
+                if (!coder.decodeVertex(code, vertexCount, out[2])) return false;
+            }
+            else
+            {
+                if (header != 0) return false;
+                for (int k = 0; k < 3; k++)
+                {
+                    if (!readVarint(p, end, code) || !coder.decodeVertex(code, vertexCount, out[k])) return false;
+                }
+            }
+            coder.pushTriangle(out[0], out[1], out[2]);
+        }
+        for (size_t i = 3 * triangles; i < count; i++, out++)
+        {
+            uint64_t code;
+            if (!readVarint(p, end, code) || !coder.decodeVertex(code, vertexCount, *out)) return false;
+        }
+        return p == end;
+    }
+
+    // Te same trjkty w tej samej kolejnoci, kady co najwyej obrcony
+    bool sameTriangles(const std::vector<unsigned int>& decoded, const std::vector<unsigned int>& original)
+    {
+        if (decoded.size() != original.size()) return false;
+        size_t triangles = original.size() / 3;
+        for (size_t t = 0; t < triangles; t++)
+        {
+            const unsigned int* a = &decoded[3 * t];
+            const unsigned int* b = &original[3 * t];
+            bool rotated = false;
+            for (int r = 0; r < 3 && !rotated; r++) rotated = a[0] == b[r] && a[1] == b[(r + 1) % 3] && a[2] == b[(r + 2) % 3];
+            if (!rotated) return false;
+        }
+        return std::equal(decoded.begin() + 3 * triangles, decoded.end(), original.begin() + 3 * triangles);
+    }
+
+    // Syntetyczny skan: pole wysokoci z szumem pomiarowym, normalne z rnic, UV z siatki
+    void generateScan(int side, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        std::mt19937 random(9);
+        std::normal_distribution<float> noise(0.0f, 0.002f);
+        std::vector<float> heights((size_t)side * side);
+        for (int y = 0; y < side; y++)
+        {
+            for (int x = 0; x < side; x++)
+            {
+                float u = (float)x / (side - 1), v = (float)y / (side - 1);
+                heights[(size_t)y * side + x] = 0.2f * std::sin(u * 9.0f) * std::cos(v * 7.0f) + 0.05f * std::sin(u * 40.0f + v * 30.0f) + noise(random);
+            }
+        }
+        vertices.resize(heights.size());
+        float cell = 2.0f / (side - 1);
+        for (int y = 0; y < side; y++)
+        {
+            for (int x = 0; x < side; x++)
+            {
+                auto height = [&](int hx, int hy) { return heights[(size_t)std::min(std::max(hy, 0), side - 1) * side + std::min(std::max(hx, 0), side - 1)]; };
+                Vertex& vertex = vertices[(size_t)y * side + x];
+                vertex.position = glm::vec3(x * cell - 1.0f, height(x, y), y * cell - 1.0f);
+                vertex.normal = glm::normalize(glm::vec3(height(x - 1, y) - height(x + 1, y), 2.0f * cell, height(x, y - 1) - height(x, y + 1)));
+                vertex.texCoord = glm::vec2((float)x / (side - 1), (float)y / (side - 1));
+            }
+        }
+        indices.clear();
+        for (int y = 0; y + 1 < side; y++)
+        {
+            for (int x = 0; x + 1 < side; x++)
+            {
+                unsigned a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+                indices.insert(indices.end(), { a, c, b, b, c, d });
+            }
+        }
+    }
+}
+
+void encodeMesh(const Mesh& mesh, bool compressed, std::vector<unsigned char>& out)
+{
+    const std::vector<Vertex>& vertices = mesh.vertices;
+    const std::vector<unsigned int>& indices = mesh.indices;
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, "MESH", 4);
+    header.version = meshCacheVersion;
+    header.flags = compressed ? compressedFlag : 0;
+    header.blockVertices = meshCodecBlockVertices;
+    header.blockIndices = meshCodecBlockIndices;
+    header.lodCount = (uint32_t)mesh.lods.size();
+    header.meshletCount = (uint32_t)mesh.meshlets.size();
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+
+    // Bez kompresji po jednym bloku surowych tablic
+    size_t vertexBlocks = compressed ? blockCount(vertices.size(), meshCodecBlockVertices) : 1;
+    size_t indexBlocks = compressed ? blockCount(indices.size(), meshCodecBlockIndices) : 1;
+    std::vector<std::vector<unsigned char>> blocks(vertexBlocks + indexBlocks);
+    if (compressed)
+    {
+        // Nastpny nowy wierzchoek na pocztku kadego bloku indeksw, eby bloki byy niezalene
+        std::vector<uint32_t> starts(indexBlocks);
+        uint32_t next = 0;
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            if (i % meshCodecBlockIndices == 0) starts[i / meshCodecBlockIndices] = next;
+            if (indices[i] >= next) next = indices[i] + 1;
+        }
+        parallelFor((unsigned)blocks.size(), [&](unsigned first, unsigned last)
+        {
+            for (unsigned block = first; block < last; block++)
+            {
+                if (block < vertexBlocks)
+                {
+                    size_t begin = (size_t)block * meshCodecBlockVertices;
+                    encodeVertexBlock(vertices.data() + begin, std::min<size_t>(meshCodecBlockVertices, vertices.size() - begin), blocks[block]);
+                }
+                else
+                {
+                    size_t index = block - vertexBlocks, begin = index * meshCodecBlockIndices;
+                    encodeIndexBlock(indices.data() + begin, std::min<size_t>(meshCodecBlockIndices, indices.size() - begin), starts[index], blocks[block]);
+                }
+            }
+        });
+    }
+    else
+    {
+        const unsigned char* vertexBytes = reinterpret_cast<const unsigned char*>(vertices.data());
+        const unsigned char* indexBytes = reinterpret_cast<const unsigned char*>(indices.data());
+        blocks[0].assign(vertexBytes, vertexBytes + vertices.size() * sizeof(Vertex));
+        blocks[1].assign(indexBytes, indexBytes + indices.size() * sizeof(unsigned int));
+    }
+
+    std::vector<MeshCacheBlock> table(blocks.size());
+    size_t lodsOffset = sizeof(header) + table.size() * sizeof(MeshCacheBlock);
+    size_t meshletsOffset = lodsOffset + mesh.lods.size() * sizeof(MeshLod);
+    uint64_t offset = meshletsOffset + mesh.meshlets.size() * sizeof(Meshlet);
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+        table[b].offset = offset;
+        table[b].size = blocks[b].size();
+        offset += blocks[b].size();
+    }
+    out.resize((size_t)offset);
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (!table.empty()) std::memcpy(out.data() + sizeof(header), table.data(), table.size() * sizeof(MeshCacheBlock));
+    if (!mesh.lods.empty()) std::memcpy(out.data() + lodsOffset, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+    if (!mesh.meshlets.empty()) std::memcpy(out.data() + meshletsOffset, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+    for (size_t b = 0; b < blocks.size(); b++)
+    {
+        if (!blocks[b].empty()) std::memcpy(out.data() + table[b].offset, blocks[b].data(), blocks[b].size());
+    }
+}
+
+bool decodeMesh(const unsigned char* data, size_t size, Mesh& mesh, unsigned threads, bool simd)
+{
+    std::vector<Vertex>& vertices = mesh.vertices;
+    std::vector<unsigned int>& indices = mesh.indices;
+    MeshCacheHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "MESH", 4) != 0 || header.version != meshCacheVersion || header.blockVertices == 0 || header.blockIndices == 0 ||
+        header.vertexCount > 0xFFFFFFFFull || header.indexCount > size * 8 || header.lodCount > size || header.meshletCount > size)
+    {
+        return false;
+    }
+    bool compressed = (header.flags & compressedFlag) != 0;
+    size_t vertexBlocks = compressed ? blockCount(header.vertexCount, header.blockVertices) : 1;
+    size_t indexBlocks = compressed ? blockCount(header.indexCount, header.blockIndices) : 1;
+    size_t lodsOffset = sizeof(header) + (vertexBlocks + indexBlocks) * sizeof(MeshCacheBlock);
+    size_t meshletsOffset = lodsOffset + header.lodCount * sizeof(MeshLod);
+    size_t tableEnd = meshletsOffset + header.meshletCount * sizeof(Meshlet);
+    if (size < tableEnd) return false;
+    std::vector<MeshCacheBlock> table(vertexBlocks + indexBlocks);
+    if (!table.empty()) std::memcpy(table.data(), data + sizeof(header), table.size() * sizeof(MeshCacheBlock));
+    for (const MeshCacheBlock& block : table)
+    {
+        if (block.offset < tableEnd || block.offset > size || block.size > size - block.offset) return false;
+    }
+
+    // Poziomy i klastry to cae trjkty w buforze indeksw, klastry w zakresie lods[0]
+    mesh.lods.resize(header.lodCount);
+    mesh.meshlets.resize(header.meshletCount);
+    if (!mesh.lods.empty()) std::memcpy(mesh.lods.data(), data + lodsOffset, mesh.lods.size() * sizeof(MeshLod));
+    if (!mesh.meshlets.empty()) std::memcpy(mesh.meshlets.data(), data + meshletsOffset, mesh.meshlets.size() * sizeof(Meshlet));
+    for (const MeshLod& lod : mesh.lods)
+    {
+        if (lod.indexOffset % 3 != 0 || lod.indexCount % 3 != 0 || lod.indexOffset > header.indexCount || lod.indexCount > header.indexCount - lod.indexOffset) return false;
+    }
+    for (const Meshlet& meshlet : mesh.meshlets)
+    {
+        if (mesh.lods.empty() || meshlet.indexOffset % 3 != 0 || meshlet.indexCount % 3 != 0 || meshlet.indexOffset < mesh.lods[0].indexOffset ||
+            (uint64_t)meshlet.indexOffset + meshlet.indexCount > (uint64_t)mesh.lods[0].indexOffset + mesh.lods[0].indexCount)
+        {
+            return false;
+        }
+    }
+
+    vertices.resize((size_t)header.vertexCount);
+    indices.resize((size_t)header.indexCount);
+    if (!compressed)
+    {
+        if (table[0].size != vertices.size() * sizeof(Vertex) || table[1].size != indices.size() * sizeof(unsigned int)) return false;
+        if (table[0].size) std::memcpy(vertices.data(), data + table[0].offset, (size_t)table[0].size);
+        if (table[1].size) std::memcpy(indices.data(), data + table[1].offset, (size_t)table[1].size);
+        for (unsigned int index : indices)
+        {
+            if (index >= vertices.size()) return false;
+        }
+        return true;
+    }
+
+    std::atomic<bool> valid(true);
+    parallelFor((unsigned)table.size(), [&](unsigned first, unsigned last)
+    {
+        VertexScratch scratch;
+        for (unsigned block = first; block < last && valid; block++)
+        {
+            const unsigned char* begin = data + table[block].offset;
+            const unsigned char* end = begin + table[block].size;
+            bool ok;
+            if (block < vertexBlocks)
+            {
+                size_t start = (size_t)block * header.blockVertices;
+                ok = decodeVertexBlock(begin, end, std::min<size_t>(header.blockVertices, vertices.size() - start), vertices.data() + start, simd, scratch);
+            }
+            else
+            {
+                size_t start = (block - vertexBlocks) * header.blockIndices;
+                ok = decodeIndexBlock(begin, end, std::min<size_t>(header.blockIndices, indices.size() - start), header.vertexCount, indices.data() + start);
+            }
+            if (!ok) valid = false;
+        }
+    }, threads == 1 ? 1 : 0);
+    return valid;
+}
+
+bool saveMeshCache(const std::string& path, const Mesh& mesh, bool compressed)
+{
+    std::vector<unsigned char> encoded;
+    encodeMesh(mesh, compressed, encoded);
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot create file: " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    if (!out.good())
+    {
+        std::cerr << "Error writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool loadMeshCache(const std::string& path, Mesh& mesh)
+{
+    MappedFile file;
+    if (!mapFile(file, path)) return false;
+    bool decoded = decodeMesh(file.data, (size_t)file.size, mesh);
+    unmapFile(file);
+    if (!decoded)
+    {
+        std::cerr << "Not a mesh cache file: " << path << std::endl;
+        mesh.vertices.clear();
+        mesh.indices.clear();
+        mesh.lods.clear();
+        mesh.meshlets.clear();
+    }
+    return decoded;
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<unsigned int> remap(vertices.size(), ~0u);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == ~0u)
+        {
+            remap[index] = (unsigned int)ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+int runMeshCodecBenchmark(const std::vector<std::string>& objPaths)
+{
+    struct MeshCase
+    {
+        std::string name;
+        Mesh mesh; // Same wierzchoki i indeksy, bez poziomw LOD i klastrw
+    };
+    std::vector<MeshCase> cases;
+    for (const std::string& path : objPaths)
+    {
+        MeshCase test;
+        test.name = path;
+        if (!loadObj(path, test.mesh.vertices, test.mesh.indices)) continue;
+        weldVertices(test.mesh.vertices, test.mesh.indices);
+        cases.push_back(std::move(test));
+    }
+    MeshCase scan;
+    scan.name = "synthetic scan";
+    generateScan(1024, scan.mesh.vertices, scan.mesh.indices);
+    optimizeVertexFetch(scan.mesh.vertices, scan.mesh.indices);
+    cases.push_back(std::move(scan));
+
+    const double storageMBs = 100.0; // Przepustowo dysku sieciowego do oszacowania czasu wczytania
+    unsigned cores = jobThreadCount();
+    for (const MeshCase& test : cases)
+    {
+        const Mesh& mesh = test.mesh;
+        uint64_t vertexBytes = mesh.vertices.size() * sizeof(Vertex), indexBytes = mesh.indices.size() * sizeof(unsigned int);
+        std::vector<unsigned char> encoded;
+        auto start = std::chrono::steady_clock::now();
+        encodeMesh(mesh, true, encoded);
+        double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Rozmiary strumieni z tablicy blokw
+        MeshCacheHeader header;
+        std::memcpy(&header, encoded.data(), sizeof(header));
+        size_t vertexBlocks = blockCount(header.vertexCount, header.blockVertices);
+        uint64_t encodedVertices = 0, encodedIndices = 0;
+        for (size_t b = 0; b < vertexBlocks + blockCount(header.indexCount, header.blockIndices); b++)
+        {
+            MeshCacheBlock block;
+            std::memcpy(&block, encoded.data() + sizeof(header) + b * sizeof(block), sizeof(block));
+            (b < vertexBlocks ? encodedVertices : encodedIndices) += block.size;
+        }
+        std::cout << test.name << ": " << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles, "
+            << (vertexBytes + indexBytes) / 1024 << " KB raw -> " << encoded.size() / 1024 << " KB ("
+            << (double)(vertexBytes + indexBytes) / encoded.size() << "x), encoded in " << encodeSeconds * 1000.0 << " ms" << std::endl;
+        std::cout << "  vertices " << (double)vertexBytes / std::max<uint64_t>(encodedVertices, 1) << "x, "
+            << encodedVertices * 8.0 / std::max<size_t>(mesh.vertices.size(), 1) << " bits/vertex; indices "
+            << (double)indexBytes / std::max<uint64_t>(encodedIndices, 1) << "x, "
+            << encodedIndices * 8.0 / std::max<size_t>(mesh.indices.size() / 3, 1) << " bits/triangle" << std::endl;
+
+        Mesh decoded;
+        double bestParallel = 1e30;
+        struct DecodeMode
+        {
+            const char* name;
+            unsigned threads;
+            bool simd;
+        };
+        for (DecodeMode mode : { DecodeMode{ "scalar, 1 thread", 1, false }, DecodeMode{ "SSE2, 1 thread", 1, true }, DecodeMode{ "SSE2, all cores", cores, true } })
+        {
+            double best = 1e30;
+            bool ok = true;
+            for (int repeat = 0; repeat < 5; repeat++)
+            {
+                start = std::chrono::steady_clock::now();
+                ok = decodeMesh(encoded.data(), encoded.size(), decoded, mode.threads, mode.simd) && ok;
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            ok = ok && decoded.vertices.size() == mesh.vertices.size() && sameTriangles(decoded.indices, mesh.indices) &&
+                std::memcmp(decoded.vertices.data(), mesh.vertices.data(), vertexBytes) == 0;
+            bestParallel = best;
+            std::cout << "  decode " << mode.name << ": " << best * 1000.0 << " ms, " << (vertexBytes + indexBytes) / best / 1e9 << " GB/s"
+                << (ok ? "" : " - MISMATCH") << std::endl;
+        }
+        std::cout << "  load at " << storageMBs << " MB/s: raw " << (vertexBytes + indexBytes) / (storageMBs * 1e6) * 1000.0 << " ms, compressed "
+            << encoded.size() / (storageMBs * 1e6) * 1000.0 + bestParallel * 1000.0 << " ms including decode" << std::endl;
+    }
+    return 0;
+}
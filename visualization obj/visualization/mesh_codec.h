@@ -0,0 +1,37 @@
+#pragma once
+#include "mesh.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Skompresowany zapis wierzchokw i indeksw siatki dla pliku podrcznego nazwa.obj.mesh.
+// Wierzchoki: kade sowo Vertex jako rnica wzgldem poprzedniego wierzchoka (bitowo, bez strat),
+// zigzag i rozbicie na paszczyzny bajtw; paszczyzna w grupach po 16 bajtw zapisanych na 0, 2, 4
+// albo 8 bitach, wic puste starsze bajty prawie nic nie kosztuj, a dekodowanie grupy to kilka
+// instrukcji SSE2. Indeksy: trjkt dzielcy krawd z jednym z ostatnich 15 trjktw to zwykle
+// jeden bajt (krawd z kolejki i trzeci wierzchoek nowy albo z kolejki ostatnich wierzchokw),
+// pozostae to odlegoci od nastpnego nowego wierzchoka zapisane jako varint.
+// Trjkt moe wrci obrcony (ta sama orientacja). Strumienie dzielone s na niezalene bloki
+// dekodowane rwnolegle. Plik niesie te zakresy poziomw LOD i tablic klastrw (dla lods[0]
+// w kolejnoci klastrw), wic wczytanie z niego pomija upraszczanie i budow klastrw.
+
+const uint32_t meshCodecBlockVertices = 4096;
+const uint32_t meshCodecBlockIndices = 3 * 16384;
+
+// Cay plik podrczny w pamici: nagwek, tablice blokw, poziomw i klastrw oraz bloki; compressed = false
+// zapisuje surowe tablice. Z siatki brane s wierzchoki, indeksy, lods i meshlets
+void encodeMesh(const Mesh& mesh, bool compressed, std::vector<unsigned char>& out);
+
+// threads = 0 oznacza wszystkie rdzenie, simd = false dekoduje skalarnie (do porwnania)
+bool decodeMesh(const unsigned char* data, size_t size, Mesh& mesh, unsigned threads = 0, bool simd = true);
+
+bool saveMeshCache(const std::string& path, const Mesh& mesh, bool compressed = true);
+bool loadMeshCache(const std::string& path, Mesh& mesh);
+
+// Wierzchoki w kolejnoci pierwszego uycia przez indeksy: lepsza lokalno pobierania na GPU i mae rnice indeksw
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Pomiar: stopie kompresji, kodowanie i dekodowanie (skalarnie, SSE2, wszystkie rdzenie) dla podanych plikw obj
+// i syntetycznego skanu z milionem wierzchokw
+int runMeshCodecBenchmark(const std::vector<std::string>& objPaths);
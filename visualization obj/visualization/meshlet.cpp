@@ -0,0 +1,287 @@
+#include "meshlet.h"
+#include "lod.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Kula i stoek normalnych klastra. Stoek liczony z kierunku nawinicia, a trjkt, ktrego
+    // nawinicie nie zgadza si z normalnymi z pliku, wycza odrzucanie caego klastra.
+    void meshletBounds(const Mesh& mesh, Meshlet& meshlet)
+    {
+        const unsigned* indices = mesh.indices.data() + meshlet.indexOffset;
+        glm::vec3 lo = mesh.vertices[indices[0]].position, hi = lo;
+        for (unsigned i = 0; i < meshlet.indexCount; i++)
+        {
+            lo = glm::min(lo, mesh.vertices[indices[i]].position);
+            hi = glm::max(hi, mesh.vertices[indices[i]].position);
+        }
+        meshlet.center = (lo + hi) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (unsigned i = 0; i < meshlet.indexCount; i++)
+        {
+            meshlet.radius = std::max(meshlet.radius, glm::length(mesh.vertices[indices[i]].position - meshlet.center));
+        }
+
+        meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        meshlet.coneCutoff = 1.0f;
+        glm::vec3 normals[124 * 2];
+        unsigned normalCount = 0;
+        glm::vec3 sum(0.0f);
+        for (unsigned i = 0; i + 2 < meshlet.indexCount && normalCount < sizeof(normals) / sizeof(normals[0]); i += 3)
+        {
+            const Vertex& a = mesh.vertices[indices[i]];
+            const Vertex& b = mesh.vertices[indices[i + 1]];
+            const Vertex& c = mesh.vertices[indices[i + 2]];
+            glm::vec3 face = glm::cross(b.position - a.position, c.position - a.position);
+            float length = glm::length(face);
+            if (length <= 0.0f) continue; // Zdegenerowany nie jest widoczny z adnej strony
+            face /= length;
+            if (glm::dot(face, a.normal + b.normal + c.normal) < 0.0f) return;
+            normals[normalCount++] = face;
+            sum += face;
+        }
+        if (normalCount == 0) return;
+        float sumLength = glm::length(sum);
+        if (sumLength <= 0.0f) return;
+        glm::vec3 axis = sum / sumLength;
+        float minDot = 1.0f;
+        for (unsigned i = 0; i < normalCount; i++) minDot = std::min(minDot, glm::dot(axis, normals[i]));
+
+        // Stoek szerszy ni okoo 84 stopnie od osi jest odwrcony tyem tylko z bardzo wskiego zakresu kierunkw
+        if (minDot <= 0.1f) return;
+        meshlet.coneAxis = axis;
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+void buildMeshlets(Mesh& mesh, unsigned maxVertices, unsigned maxTriangles)
+{
+    mesh.meshlets.clear();
+    if (mesh.lods.empty()) return;
+    maxTriangles = std::min(maxTriangles, 124u);
+    unsigned* indices = mesh.indices.data() + mesh.lods[0].indexOffset;
+    unsigned triangleCount = mesh.lods[0].indexCount / 3;
+    unsigned vertexCount = (unsigned)mesh.vertices.size();
+
+    // Trjkty kadego wierzchoka w ukadzie CSR
+    std::vector<unsigned> triangleStart(vertexCount + 1, 0), vertexTriangles(triangleCount * 3);
+    for (unsigned i = 0; i < triangleCount * 3; i++) triangleStart[indices[i] + 1]++;
+    for (unsigned v = 0; v < vertexCount; v++) triangleStart[v + 1] += triangleStart[v];
+    std::vector<unsigned> fill(triangleStart.begin(), triangleStart.end() - 1);
+    for (unsigned i = 0; i < triangleCount * 3; i++) vertexTriangles[fill[indices[i]]++] = i / 3;
+
+    std::vector<unsigned> ordered;
+    ordered.reserve(triangleCount * 3);
+    std::vector<unsigned char> used(triangleCount, 0);
+    std::vector<unsigned> vertexMeshlet(vertexCount, ~0u); // Numer klastra, do ktrego wierzchoek ju naley
+    std::vector<unsigned> candidates;
+    unsigned scan = 0;
+
+    while (scan < triangleCount)
+    {
+        unsigned id = (unsigned)mesh.meshlets.size();
+        Meshlet meshlet = {};
+        meshlet.indexOffset = mesh.lods[0].indexOffset + (unsigned)ordered.size();
+        unsigned vertices = 0, triangles = 0;
+        candidates.clear();
+
+        auto newVertices = [&](unsigned triangle)
+        {
+            unsigned count = 0;
+            for (int k = 0; k < 3; k++) count += vertexMeshlet[indices[triangle * 3 + k]] != id;
+            return count;
+        };
+
+        while (triangles < maxTriangles)
+        {
+            // Najpierw ssiad dokadajcy najmniej wierzchokw, bez ssiadw kolejny wolny w kolejnoci pliku
+            unsigned best = ~0u, bestCost = 4;
+            for (size_t c = 0; c < candidates.size();)
+            {
+                unsigned triangle = candidates[c];
+                if (used[triangle])
+                {
+                    candidates[c] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                unsigned cost = newVertices(triangle);
+                if (cost < bestCost)
+                {
+                    best = triangle;
+                    bestCost = cost;
+                    if (cost == 0) break;
+                }
+                c++;
+            }
+            if (best == ~0u)
+            {
+                while (scan < triangleCount && used[scan]) scan++;
+                if (scan == triangleCount) break;
+                best = scan;
+                bestCost = newVertices(best);
+            }
+            if (vertices + bestCost > maxVertices) break;
+
+            used[best] = 1;
+            triangles++;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned v = indices[best * 3 + k];
+                ordered.push_back(v);
+                if (vertexMeshlet[v] == id) continue;
+                vertexMeshlet[v] = id;
+                vertices++;
+                for (unsigned t = triangleStart[v]; t < triangleStart[v + 1]; t++)
+                {
+                    if (!used[vertexTriangles[t]]) candidates.push_back(vertexTriangles[t]);
+                }
+            }
+        }
+        if (triangles == 0) break;
+        meshlet.indexCount = triangles * 3;
+        mesh.meshlets.push_back(meshlet);
+        while (scan < triangleCount && used[scan]) scan++;
+    }
+
+    // Te same trjkty w kolejnoci klastrw, pozostae poziomy LOD bez zmian
+    std::copy(ordered.begin(), ordered.end(), indices);
+    for (Meshlet& meshlet : mesh.meshlets) meshletBounds(mesh, meshlet);
+}
+
+void cullMeshlets(const Mesh& mesh, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos,
+    std::vector<IndexRange>& ranges, MeshletCullStats& stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    ranges.clear();
+    stats = MeshletCullStats();
+
+    // Kamera i paszczyzny w przestrzeni obiektu, klastry zostaj nieprzeksztacone
+    glm::vec4 planes[6];
+    frustumPlanes(viewProj * model, planes);
+    glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+    for (const Meshlet& meshlet : mesh.meshlets)
+    {
+        if (!sphereInPlanes(planes, meshlet.center, meshlet.radius))
+        {
+            stats.frustumTriangles += meshlet.indexCount / 3;
+            continue;
+        }
+
+        // Wszystkie trjkty tyem, gdy kierunek od kamery mieci si w stoku zwonym o kul klastra
+        glm::vec3 toMeshlet = meshlet.center - camera;
+        if (glm::dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius)
+        {
+            stats.backfaceTriangles += meshlet.indexCount / 3;
+            continue;
+        }
+
+        stats.visibleClusters++;
+        if (!ranges.empty() && ranges.back().indexOffset + ranges.back().indexCount == meshlet.indexOffset)
+        {
+            ranges.back().indexCount += meshlet.indexCount;
+        }
+        else
+        {
+            ranges.push_back({ meshlet.indexOffset, meshlet.indexCount });
+        }
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+namespace
+{
+    // Kula z rwnolenikw i poudnikw, trjkty nawinite przeciwnie do wskazwek zegara patrzc z zewntrz
+    void buildSphere(Mesh& mesh, unsigned rings, unsigned segments)
+    {
+        const float pi = 3.14159265f;
+        for (unsigned r = 0; r <= rings; r++)
+        {
+            float theta = pi * r / rings;
+            for (unsigned s = 0; s <= segments; s++)
+            {
+                float phi = 2.0f * pi * s / segments;
+                Vertex vertex;
+                vertex.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                vertex.position = vertex.normal;
+                vertex.texCoord = glm::vec2((float)s / segments, (float)r / rings);
+                mesh.vertices.push_back(vertex);
+            }
+        }
+        for (unsigned r = 0; r < rings; r++)
+        {
+            for (unsigned s = 0; s < segments; s++)
+            {
+                unsigned a = r * (segments + 1) + s, b = a + segments + 1;
+                unsigned quad[6] = { a, a + 1, b, a + 1, b + 1, b };
+                for (int t = 0; t < 6; t += 3)
+                {
+                    const glm::vec3& p0 = mesh.vertices[quad[t]].position;
+                    const glm::vec3& p1 = mesh.vertices[quad[t + 1]].position;
+                    const glm::vec3& p2 = mesh.vertices[quad[t + 2]].position;
+                    glm::vec3 face = glm::cross(p1 - p0, p2 - p0);
+                    if (glm::dot(face, face) == 0.0f) continue; // Trjkty przy biegunach
+                    if (glm::dot(face, p0 + p1 + p2) < 0.0f) std::swap(quad[t + 1], quad[t + 2]);
+                    mesh.indices.insert(mesh.indices.end(), { quad[t], quad[t + 1], quad[t + 2] });
+                }
+            }
+        }
+        mesh.lods.push_back({ 0, (unsigned)mesh.indices.size(), 0.0f });
+        mesh.center = glm::vec3(0.0f);
+        mesh.radius = 1.0f;
+    }
+}
+
+int runMeshletBenchmark(const char* objPath)
+{
+    Mesh mesh;
+    auto start = std::chrono::steady_clock::now();
+    if (objPath)
+    {
+        if (!loadMesh(objPath, mesh)) return 1;
+    }
+    else
+    {
+        buildSphere(mesh, 700, 1400);
+        buildMeshlets(mesh);
+    }
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned triangles = mesh.lods[0].indexCount / 3, cullable = 0;
+    for (const Meshlet& meshlet : mesh.meshlets) cullable += meshlet.coneCutoff < 1.0f;
+    std::cout << "Meshlets: " << (objPath ? objPath : "sphere") << ", " << triangles << " triangles in " << mesh.meshlets.size()
+        << " clusters, " << (double)triangles / std::max<size_t>(mesh.meshlets.size(), 1) << " triangles per cluster, "
+        << cullable << " with a usable normal cone, loaded and clustered in " << buildSeconds * 1000.0 << " ms" << std::endl;
+
+    // Kamera kry wok siatki z daleka i z bliska, z bliska cz klastrw wypada poza ostrosup
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, mesh.radius * 0.01f, mesh.radius * 100.0f);
+    std::vector<IndexRange> ranges;
+    const int views = 64;
+    for (float distance : { 3.0f, 1.3f })
+    {
+        double seconds = 0.0;
+        unsigned long long backface = 0, frustum = 0, drawn = 0, rangeCount = 0;
+        for (int i = 0; i < views; i++)
+        {
+            float angle = 6.2831853f * i / views;
+            glm::vec3 eye = mesh.center + mesh.radius * distance * glm::vec3(std::cos(angle), 0.3f, std::sin(angle));
+            glm::mat4 view = glm::lookAt(eye, mesh.center, glm::vec3(0.0f, 1.0f, 0.0f));
+            MeshletCullStats stats;
+            cullMeshlets(mesh, glm::mat4(1.0f), proj * view, eye, ranges, stats);
+            seconds += stats.seconds;
+            backface += stats.backfaceTriangles;
+            frustum += stats.frustumTriangles;
+            rangeCount += ranges.size();
+            for (const IndexRange& range : ranges) drawn += range.indexCount / 3;
+        }
+        double total = (double)triangles * views;
+        std::cout << "  camera at " << distance << " radii: " << drawn / views << " of " << triangles << " triangles submitted in "
+            << rangeCount / views << " ranges, culled " << backface / total * 100.0 << "% backfacing and " << frustum / total * 100.0
+            << "% outside the frustum, culling " << seconds / views * 1e6 << " us per frame" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "mesh.h"
+
+// Podzia penej siatki na mae klastry (do 64 wierzchokw i 124 trjktw) ronite po
+// ssiedztwie trjktw. Kady ma kul otaczajc i stoek normalnych, wic co klatk na CPU
+// mona odrzuci klastry poza ostrosupem widzenia i klastry w caoci odwrcone tyem
+// i wysa tylko zakresy indeksw pozostaych.
+
+struct IndexRange
+{
+    unsigned indexOffset;
+    unsigned indexCount;
+};
+
+struct MeshletCullStats
+{
+    unsigned visibleClusters = 0;
+    unsigned backfaceTriangles = 0; // Trjkty klastrw odwrconych tyem
+    unsigned frustumTriangles = 0;  // Trjkty klastrw poza ostrosupem
+    double seconds = 0.0;
+};
+
+// Klastry dla lods[0], trjkty penej siatki w buforze indeksw s przestawiane w kolejnoci klastrw
+void buildMeshlets(Mesh& mesh, unsigned maxVertices = 64, unsigned maxTriangles = 124);
+
+// Zakresy indeksw widocznych klastrw, ssiednie sklejone w jeden. Test stoka w przestrzeni
+// obiektu zakada macierz modelu bez niejednorodnej skali.
+void cullMeshlets(const Mesh& mesh, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos,
+    std::vector<IndexRange>& ranges, MeshletCullStats& stats);
+
+// Pomiar: budowa klastrw i odrzucanie z kilkudziesiciu punktw widzenia, gsta kula albo podany plik obj
+int runMeshletBenchmark(const char* objPath);
@@ -0,0 +1,303 @@
+#include "point_cloud.h"
+#include "gl_utils.h"
+#include "lod.h"
+#include "simulation.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    // Kopiowanie punktw wza z odwzorowanego pliku do jego miejsca w puli, w wtku ta
+    uint64_t uploadNode(PointCloudStreamer& cloud, uint32_t index, uint32_t slot)
+    {
+        const PointNode& node = cloud.nodes[index];
+        uint64_t bytes = (uint64_t)node.pointCount * sizeof(PointRecord);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, cloud.buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)slot * cloud.header.pointsPerNode * sizeof(PointRecord),
+            (GLsizeiptr)bytes, cloud.file.data + node.offset);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        releasePages(cloud.file, node.offset, bytes);
+        return bytes;
+    }
+
+    // Dane zmienione w innym kontekcie s widoczne po ponownym podpiciu bufora
+    void attachPool(const PointCloudStreamer& cloud)
+    {
+        glBindVertexArray(cloud.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, cloud.buffer);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PointRecord), (void*)offsetof(PointRecord, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PointRecord), (void*)offsetof(PointRecord, color));
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+    }
+
+    glm::vec3 nodeCenter(const PointNode& node) { return node.boundsMin + glm::vec3(node.size * 0.5f); }
+    float nodeRadius(const PointNode& node) { return node.size * 0.8660254f; }
+}
+
+bool openPointCloud(PointCloudStreamer& cloud, const std::string& path, uint64_t pointBudget, uint64_t memoryBudget)
+{
+    if (!mapFile(cloud.file, path)) return false;
+
+    const PointOctreeHeader* header = reinterpret_cast<const PointOctreeHeader*>(cloud.file.data);
+    if (cloud.file.size < sizeof(PointOctreeHeader) || std::memcmp(header->magic, "PCOT", 4) != 0 ||
+        header->version != pointOctreeVersion || header->nodeCount == 0 ||
+        cloud.file.size < sizeof(PointOctreeHeader) + (uint64_t)header->nodeCount * sizeof(PointNode))
+    {
+        std::cerr << "Not a point octree file: " << path << std::endl;
+        unmapFile(cloud.file);
+        return false;
+    }
+    cloud.header = *header;
+    cloud.nodes = reinterpret_cast<const PointNode*>(cloud.file.data + sizeof(PointOctreeHeader));
+    cloud.pointBudget = pointBudget;
+
+    uint64_t slotBytes = (uint64_t)header->pointsPerNode * sizeof(PointRecord);
+    uint64_t slotCount = std::min<uint64_t>(memoryBudget / slotBytes, header->nodeCount);
+    if (slotCount == 0)
+    {
+        std::cerr << "Memory budget of " << memoryBudget << " bytes is smaller than one node (" << slotBytes << " bytes)" << std::endl;
+        unmapFile(cloud.file);
+        return false;
+    }
+    glGenVertexArrays(1, &cloud.vao);
+    glGenBuffers(1, &cloud.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, cloud.buffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(slotCount * slotBytes), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    attachPool(cloud);
+    startSlotStreamer(cloud.pool, (size_t)slotCount, header->nodeCount, 8,
+        [&cloud](uint32_t node, uint32_t slot) { return uploadNode(cloud, node, slot); });
+
+    std::cout << "Point cloud " << path << ": " << header->pointCount << " points in " << header->nodeCount << " nodes, "
+        << slotCount << " resident at most (" << slotCount * slotBytes / (1024 * 1024) << " MB), budget "
+        << pointBudget << " points per frame" << std::endl;
+    return true;
+}
+
+void closePointCloud(PointCloudStreamer& cloud)
+{
+    stopSlotStreamer(cloud.pool);
+    glDeleteVertexArrays(1, &cloud.vao);
+    glDeleteBuffers(1, &cloud.buffer);
+    cloud.vao = cloud.buffer = 0;
+    unmapFile(cloud.file);
+    cloud.nodes = nullptr;
+}
+
+void updatePointCloud(PointCloudStreamer& cloud, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale)
+{
+    if (beginSlotFrame(cloud.pool)) attachPool(cloud);
+
+    // Rozmiar wza na ekranie w pikselach
+    auto projectedSize = [&](const PointNode& node)
+    {
+        float distance = std::max(glm::length(nodeCenter(node) - cameraPos) - nodeRadius(node), 1e-6f);
+        return node.size * pixelScale / distance;
+    };
+
+    cloud.drawList.clear();
+    cloud.drawnPoints = 0;
+    cloud.heap.clear();
+    glm::vec4 planes[6];
+    frustumPlanes(viewProj, planes);
+    const PointNode& root = cloud.nodes[0];
+    if (!sphereInPlanes(planes, nodeCenter(root), nodeRadius(root))) return;
+    requireSlot(cloud.pool, 0);
+    cloud.heap.push_back(std::make_pair(projectedSize(root), 0u));
+
+    // Przekrj drzewa: najwiksze na ekranie wzy s zastpowane dziemi jako pierwsze
+    uint64_t selectedPoints = root.pointCount;
+    while (!cloud.heap.empty())
+    {
+        std::pop_heap(cloud.heap.begin(), cloud.heap.end());
+        float size = cloud.heap.back().first;
+        uint32_t index = cloud.heap.back().second;
+        cloud.heap.pop_back();
+        const PointNode& node = cloud.nodes[index];
+
+        // Odstp punktw na ekranie przy punktach lecych na powierzchniach
+        float spacing = size / std::sqrt((float)std::max(node.pointCount, 1u));
+        if (node.childCount > 0 && spacing > cloud.minPointSpacing)
+        {
+            uint64_t childPoints = 0;
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+            {
+                const PointNode& child = cloud.nodes[c];
+                if (sphereInPlanes(planes, nodeCenter(child), nodeRadius(child))) childPoints += child.pointCount;
+            }
+            if (selectedPoints - node.pointCount + childPoints <= cloud.pointBudget)
+            {
+                bool childrenReady = true;
+                for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+                {
+                    const PointNode& child = cloud.nodes[c];
+                    if (!sphereInPlanes(planes, nodeCenter(child), nodeRadius(child))) continue;
+                    childrenReady = requireSlot(cloud.pool, c) && childrenReady;
+                }
+                if (childrenReady)
+                {
+                    selectedPoints += childPoints - node.pointCount;
+                    for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++)
+                    {
+                        const PointNode& child = cloud.nodes[c];
+                        if (!sphereInPlanes(planes, nodeCenter(child), nodeRadius(child))) continue;
+                        cloud.heap.push_back(std::make_pair(projectedSize(child), c));
+                        std::push_heap(cloud.heap.begin(), cloud.heap.end());
+                    }
+                    continue;
+                }
+            }
+        }
+
+        int slot = cloud.pool.itemSlots[index];
+        if (slot >= 0 && cloud.pool.slots[slot].ready)
+        {
+            cloud.drawList.push_back(index);
+            cloud.drawnPoints += node.pointCount;
+        }
+    }
+
+    cloud.drawFirsts.clear();
+    cloud.drawCounts.clear();
+    for (uint32_t index : cloud.drawList)
+    {
+        cloud.drawFirsts.push_back((GLint)((uint64_t)cloud.pool.itemSlots[index] * cloud.header.pointsPerNode));
+        cloud.drawCounts.push_back((GLsizei)cloud.nodes[index].pointCount);
+    }
+}
+
+void drawPointCloud(const PointCloudStreamer& cloud)
+{
+    if (cloud.drawList.empty()) return;
+    glBindVertexArray(cloud.vao);
+    glMultiDrawArrays(GL_POINTS, cloud.drawFirsts.data(), cloud.drawCounts.data(), (GLsizei)cloud.drawList.size());
+    glBindVertexArray(0);
+}
+
+namespace
+{
+    const GLchar* pointVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        in vec4 color;
+
+        uniform mat4 viewProj;
+        uniform float pointSize;
+
+        out vec4 Color;
+
+        void main()
+        {
+            Color = color;
+            gl_Position = viewProj * vec4(position, 1.0);
+            gl_PointSize = pointSize;
+        }
+    )glsl";
+
+    const GLchar* pointFragmentSource = R"glsl(
+        #version 330 core
+        in vec4 Color;
+        out vec4 outColor;
+
+        void main()
+        {
+            outColor = Color;
+        }
+    )glsl";
+}
+
+int runPointCloudViewer(sf::Window& window, const char* path, uint64_t pointBudget, uint64_t memoryBudget)
+{
+    PointCloudStreamer cloud;
+    if (!openPointCloud(cloud, path, pointBudget, memoryBudget)) return 1;
+
+    GLuint program = createProgram(pointVertexSource, pointFragmentSource, { "position", "color" }, "Point cloud");
+    if (!program)
+    {
+        closePointCloud(cloud);
+        return 1;
+    }
+    GLint uniViewProj = glGetUniformLocation(program, "viewProj");
+
+    // Kamera przed ca chmur, prdko dopasowana do jej rozmiaru
+    glm::vec3 center = (cloud.header.boundsMin + cloud.header.boundsMax) * 0.5f;
+    float radius = std::max(glm::length(cloud.header.boundsMax - cloud.header.boundsMin) * 0.5f, 1e-3f);
+    CameraState camera;
+    camera.position = center + glm::vec3(0.0f, 0.0f, radius * 2.0f);
+
+    Simulation simulation;
+    simulation.moveSpeed = radius * 0.25f;
+    startSimulation(simulation, window, camera);
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    float fov = glm::radians(45.0f);
+    glm::mat4 proj = glm::perspective(fov, (float)width / height, radius * 1e-4f, radius * 8.0f);
+    float pixelScale = pixelsPerUnit(fov, height);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glUseProgram(program);
+    glUniform1f(glGetUniformLocation(program, "pointSize"), 2.0f);
+
+    bool running = true;
+    sf::Clock fpsClock;
+    int frameCount = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            if (windowEvent.type == sf::Event::Closed ||
+                (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Escape))
+            {
+                running = false;
+            }
+            // Klawisze + i - podwajaj i poowi budet punktw
+            if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Add)
+            {
+                cloud.pointBudget *= 2;
+            }
+            if (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Subtract)
+            {
+                cloud.pointBudget = std::max<uint64_t>(cloud.pointBudget / 2, cloud.header.pointsPerNode);
+            }
+        }
+
+        camera = sampleCamera(simulation);
+        glm::mat4 viewProj = proj * cameraView(camera);
+        updatePointCloud(cloud, viewProj, camera.position, pixelScale);
+
+        glClearColor(0.1f, 0.1f, 0.12f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glUniformMatrix4fv(uniViewProj, 1, GL_FALSE, glm::value_ptr(viewProj));
+        drawPointCloud(cloud);
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            window.setTitle("Point cloud - FPS: " + std::to_string(frameCount) + " - points: " + std::to_string(cloud.drawnPoints) +
+                "/" + std::to_string(cloud.pointBudget) + " in " + std::to_string(cloud.drawList.size()) + " nodes, resident: " +
+                std::to_string(readySlotCount(cloud.pool)) + "/" + std::to_string(cloud.pool.slots.size()) +
+                ", uploaded: " + std::to_string(cloud.pool.uploadedBytes / (1024 * 1024)) + " MB");
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    stopSimulation(simulation);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+    glDeleteProgram(program);
+    closePointCloud(cloud);
+    checkGLErrors("After point cloud viewer");
+    return 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "point_octree.h"
+#include "slot_streamer.h"
+
+namespace sf
+{
+    class Window;
+}
+
+// Rysowanie chmury punktw z pliku drzewa oktalnego w staym budecie punktw na klatk.
+// Drzewo jest przechodzone od korzenia w kolejnoci rozmiaru wzw na ekranie, wze jest
+// zastpowany dziemi, dopki jego punkty s na ekranie rzadsze ni minimalny odstp i budet
+// na to pozwala. Dzieci zastpuj rodzica dopiero, gdy wszystkie s na GPU, do tego czasu
+// rysowany jest rodzic. Wzy wczytuje wtek ta do puli o staej liczbie miejsc (slot_streamer.h).
+
+struct PointCloudStreamer
+{
+    MappedFile file;
+    PointOctreeHeader header = {};
+    const PointNode* nodes = nullptr;
+
+    uint64_t pointBudget = 0;        // Najwicej punktw rysowanych w klatce
+    float minPointSpacing = 1.5f;    // Odstp punktw na ekranie w pikselach, poniej ktrego wze nie jest dzielony
+    std::vector<std::pair<float, uint32_t>> heap;
+    std::vector<uint32_t> drawList;
+    std::vector<GLint> drawFirsts;
+    std::vector<GLsizei> drawCounts;
+    uint64_t drawnPoints = 0;
+
+    GLuint vao = 0, buffer = 0;
+    SlotStreamer pool; // Elementy puli to numery wzw
+};
+
+// Otwarcie pliku drzewa i utworzenie puli mieszczcej si w memoryBudget bajtach
+bool openPointCloud(PointCloudStreamer& cloud, const std::string& path, uint64_t pointBudget, uint64_t memoryBudget);
+void closePointCloud(PointCloudStreamer& cloud);
+
+// Wybr wzw dla kamery w budecie punktw, zlecenie brakujcych i odbir wczytanych, raz na klatk
+void updatePointCloud(PointCloudStreamer& cloud, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale);
+
+// Wszystkie wybrane wzy jednym glMultiDrawArrays, atrybuty 0: pozycja, 1: kolor
+void drawPointCloud(const PointCloudStreamer& cloud);
+
+// Przegldarka chmury punktw z kamer sterowan mysz i klawiatur
+int runPointCloudViewer(sf::Window& window, const char* path, uint64_t pointBudget, uint64_t memoryBudget);
@@ -0,0 +1,260 @@
+#include "point_octree.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Sortowanie przez zliczanie do komrek poziomu sortLevel (128^3), gbiej podzia w miejscu
+    const int sortLevel = 7;
+    const uint32_t maxLevel = 20;
+
+    struct NodeRange
+    {
+        uint64_t begin;
+        uint64_t end;
+        uint32_t code; // Pierwsza komrka poziomu sortLevel w wle, tylko powyej sortLevel
+    };
+
+    // Kod Mortona komrki, na kadym poziomie cyfra semkowa x | y << 1 | z << 2 jak numer dziecka
+    uint32_t cellCode(const glm::vec3& position, const glm::vec3& boundsMin, float size)
+    {
+        const int cells = 1 << sortLevel;
+        int index[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            index[axis] = std::min(std::max((int)((position[axis] - boundsMin[axis]) / size * cells), 0), cells - 1);
+        }
+        uint32_t code = 0;
+        for (int level = sortLevel - 1; level >= 0; level--)
+        {
+            code = code << 3 | (uint32_t)(((index[0] >> level) & 1) | ((index[1] >> level) & 1) << 1 | ((index[2] >> level) & 1) << 2);
+        }
+        return code;
+    }
+
+    PointRecord readPoint(const unsigned char* data, bool hasColor)
+    {
+        PointRecord point;
+        std::memcpy(&point.position, data, sizeof(glm::vec3));
+        point.color[0] = hasColor ? data[12] : 255;
+        point.color[1] = hasColor ? data[13] : 255;
+        point.color[2] = hasColor ? data[14] : 255;
+        point.color[3] = 255;
+        return point;
+    }
+
+    bool validPoint(const glm::vec3& position)
+    {
+        return std::isfinite(position.x) && std::isfinite(position.y) && std::isfinite(position.z);
+    }
+
+    template <typename T>
+    void writeValue(std::ofstream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+bool buildPointOctree(const std::string& inputPath, const std::string& octreePath, bool hasColor, uint32_t pointsPerNode)
+{
+    MappedFile input;
+    if (!mapFile(input, inputPath)) return false;
+    const uint64_t recordSize = hasColor ? 15 : 12;
+    const uint64_t inputCount = input.size / recordSize;
+    if (inputCount == 0)
+    {
+        std::cerr << "Error: No points in " << inputPath << std::endl;
+        unmapFile(input);
+        return false;
+    }
+    if (input.size % recordSize != 0)
+    {
+        std::cerr << "Warning: " << input.size % recordSize << " trailing bytes in " << inputPath << " ignored" << std::endl;
+    }
+    pointsPerNode = std::max(pointsPerNode, 1u);
+
+    // Przebieg 1: granice, korze to szecian na najduszym boku. Punkty z NaN lub
+    // nieskoczonoci s pomijane we wszystkich przebiegach
+    glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+    uint64_t validCount = 0;
+    for (uint64_t i = 0; i < inputCount; i++)
+    {
+        glm::vec3 position = readPoint(input.data + i * recordSize, false).position;
+        if (!validPoint(position)) continue;
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+        validCount++;
+    }
+    if (validCount == 0)
+    {
+        std::cerr << "Error: No valid points in " << inputPath << std::endl;
+        unmapFile(input);
+        return false;
+    }
+    const uint64_t pointCount = validCount;
+    glm::vec3 extent = boundsMax - boundsMin;
+    float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) * 1.0001f;
+    std::cout << "Building octree from " << inputPath << ": " << pointCount << " points";
+    if (inputCount > pointCount) std::cout << ", " << inputCount - pointCount << " invalid points skipped";
+    std::cout << std::endl;
+
+    // Przebieg 2: zliczanie punktw w komrkach i rozoenie ich w pliku tymczasowym wedug kodu Mortona,
+    // dziki temu kady wze do poziomu sortLevel to cigy zakres
+    const uint32_t cellCount = 1u << (3 * sortLevel);
+    std::vector<uint64_t> cellStart(cellCount + 1, 0);
+    for (uint64_t i = 0; i < inputCount; i++)
+    {
+        glm::vec3 position = readPoint(input.data + i * recordSize, false).position;
+        if (validPoint(position)) cellStart[cellCode(position, boundsMin, size) + 1]++;
+    }
+    for (uint32_t c = 1; c <= cellCount; c++) cellStart[c] += cellStart[c - 1];
+
+    const std::string sortedPath = octreePath + ".sorted.tmp";
+    MappedFile sorted;
+    if (!createMappedFile(sorted, sortedPath, pointCount * sizeof(PointRecord)))
+    {
+        unmapFile(input);
+        return false;
+    }
+    PointRecord* points = reinterpret_cast<PointRecord*>(sorted.data);
+    {
+        std::vector<uint64_t> cursor(cellStart.begin(), cellStart.end() - 1);
+        for (uint64_t i = 0; i < inputCount; i++)
+        {
+            PointRecord point = readPoint(input.data + i * recordSize, hasColor);
+            if (!validPoint(point.position)) continue;
+            points[cursor[cellCode(point.position, boundsMin, size)]++] = point;
+        }
+    }
+    unmapFile(input);
+
+    // Przebieg 3: podzia wzw, ktre nie mieszcz si w pointsPerNode. Dzieci wza s dopisywane
+    // razem, a dopiero potem dzielone, wic w tablicy le obok siebie
+    std::vector<PointNode> nodes;
+    std::vector<NodeRange> ranges;
+    nodes.push_back(PointNode{ boundsMin, size, 0, 0, 0, 0, 0 });
+    ranges.push_back(NodeRange{ 0, pointCount, 0 });
+    uint64_t droppedPoints = 0;
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        PointNode node = nodes[index];
+        NodeRange range = ranges[index];
+        uint64_t count = range.end - range.begin;
+        nodes[index].pointCount = (uint32_t)std::min<uint64_t>(count, pointsPerNode);
+        if (count <= pointsPerNode) continue;
+        if (node.level == maxLevel)
+        {
+            // Powtrzone punkty nie daj si podzieli, zostaje z nich prbka
+            droppedPoints += count - pointsPerNode;
+            continue;
+        }
+        // Prbka nie wiksza ni wier poddrzewa, inaczej wzy tu nad limi podwajayby ich punkty
+        nodes[index].pointCount = (uint32_t)std::min<uint64_t>(count / 4, pointsPerNode);
+
+        NodeRange children[8];
+        if ((int)node.level < sortLevel)
+        {
+            uint32_t block = 1u << (3 * (sortLevel - node.level - 1));
+            for (uint32_t c = 0; c < 8; c++)
+            {
+                uint32_t code = range.code + c * block;
+                children[c] = NodeRange{ cellStart[code], cellStart[code + block], code };
+            }
+        }
+        else
+        {
+            // Poniej siatki sortowania: podzia zakresu w miejscu wzdu z, potem y, potem x
+            glm::vec3 center = node.boundsMin + glm::vec3(node.size * 0.5f);
+            uint64_t bounds[9] = { range.begin, 0, 0, 0, 0, 0, 0, 0, range.end };
+            for (int axis = 2, step = 8; axis >= 0; axis--, step /= 2)
+            {
+                for (int first = 0; first < 8; first += step)
+                {
+                    PointRecord* split = std::partition(points + bounds[first], points + bounds[first + step],
+                        [&](const PointRecord& point) { return point.position[axis] < center[axis]; });
+                    bounds[first + step / 2] = (uint64_t)(split - points);
+                }
+            }
+            for (int c = 0; c < 8; c++) children[c] = NodeRange{ bounds[c], bounds[c + 1], 0 };
+        }
+
+        nodes[index].firstChild = (uint32_t)nodes.size();
+        for (uint32_t c = 0; c < 8; c++)
+        {
+            if (children[c].begin == children[c].end) continue;
+            float childSize = node.size * 0.5f;
+            glm::vec3 childMin = node.boundsMin + glm::vec3((c & 1) ? childSize : 0.0f, (c & 2) ? childSize : 0.0f, (c & 4) ? childSize : 0.0f);
+            nodes.push_back(PointNode{ childMin, childSize, 0, 0, 0, 0, node.level + 1 });
+            ranges.push_back(children[c]);
+            nodes[index].childCount++;
+        }
+    }
+
+    // Przebieg 4: punkty wzw po kolei. Zakres jest uporzdkowany przestrzennie, wic punkty
+    // wybierane co stay krok daj prbk rwnomiernie pokrywajc cay wze
+    PointOctreeHeader header = {};
+    std::memcpy(header.magic, "PCOT", 4);
+    header.version = pointOctreeVersion;
+    header.nodeCount = (uint32_t)nodes.size();
+    header.pointsPerNode = pointsPerNode;
+    header.pointCount = pointCount;
+    header.boundsMin = boundsMin;
+    header.boundsMax = boundsMin + glm::vec3(size);
+
+    uint64_t offset = sizeof(PointOctreeHeader) + nodes.size() * sizeof(PointNode);
+    uint64_t storedPoints = 0;
+    for (PointNode& node : nodes)
+    {
+        node.offset = offset;
+        offset += (uint64_t)node.pointCount * sizeof(PointRecord);
+        storedPoints += node.pointCount;
+    }
+
+    std::ofstream out(octreePath, std::ios::binary);
+    if (!out)
+    {
+        std::cerr << "Cannot create file: " << octreePath << std::endl;
+        unmapFile(sorted);
+        std::remove(sortedPath.c_str());
+        return false;
+    }
+    writeValue(out, header);
+    out.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(PointNode));
+
+    std::vector<PointRecord> sample;
+    for (size_t index = 0; index < nodes.size(); index++)
+    {
+        const NodeRange& range = ranges[index];
+        uint64_t count = range.end - range.begin;
+        uint32_t taken = nodes[index].pointCount;
+        if (taken == count)
+        {
+            out.write(reinterpret_cast<const char*>(points + range.begin), (std::streamsize)(count * sizeof(PointRecord)));
+            continue;
+        }
+        sample.resize(taken);
+        for (uint32_t i = 0; i < taken; i++) sample[i] = points[range.begin + (uint64_t)((i + 0.5) * count / taken)];
+        out.write(reinterpret_cast<const char*>(sample.data()), (std::streamsize)(taken * sizeof(PointRecord)));
+    }
+    bool ok = out.good();
+    out.close();
+    unmapFile(sorted);
+    std::remove(sortedPath.c_str());
+
+    if (!ok)
+    {
+        std::cerr << "Error writing " << octreePath << std::endl;
+        return false;
+    }
+    std::cout << "Point octree " << octreePath << ": " << nodes.size() << " nodes, " << storedPoints << " points stored ("
+        << storedPoints - (pointCount - droppedPoints) << " in coarse levels)";
+    if (droppedPoints) std::cout << ", " << droppedPoints << " duplicate points dropped";
+    std::cout << std::endl;
+    return true;
+}
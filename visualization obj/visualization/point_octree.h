@@ -0,0 +1,45 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+
+// Plik oktalnego drzewa chmury punktw do strumieniowania. Kady wze ma co najwyej
+// pointsPerNode punktw: licie przechowuj swoje punkty, wzy wewntrzne rwnomiern
+// prbk punktw caego poddrzewa jako zgrubny poziom szczegowoci. Dzieci wza le
+// w tablicy obok siebie. Na pocztku pliku nagwek i tablica wzw, dalej punkty wzw.
+
+const uint32_t pointOctreeVersion = 1;
+
+struct PointOctreeHeader
+{
+    char magic[4];          // "PCOT"
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t pointsPerNode; // Najwikszy wze, wyznacza rozmiar miejsca w puli GPU
+    uint64_t pointCount;    // Poprawne punkty pliku wejciowego
+    glm::vec3 boundsMin;    // Szecian korzenia
+    glm::vec3 boundsMax;
+};
+
+struct PointNode
+{
+    glm::vec3 boundsMin;    // Szecian wza
+    float size;
+    uint64_t offset;        // Pooenie punktw wza w pliku
+    uint32_t pointCount;
+    uint32_t firstChild;    // 0 dla licia, korze nie jest niczyim dzieckiem
+    uint32_t childCount;
+    uint32_t level;
+};
+
+// Punkt w pliku i w buforze GPU
+struct PointRecord
+{
+    glm::vec3 position;
+    unsigned char color[4];
+};
+
+// Przetworzenie binarnego pliku punktw (float x, y, z i opcjonalnie bajty r, g, b na punkt,
+// bez nagwka) na plik drzewa. Punkty s sortowane wedug komrek siatki przez plik
+// tymczasowy odwzorowany w pami, wic wejcie moe by wiksze od RAM.
+bool buildPointOctree(const std::string& inputPath, const std::string& octreePath, bool hasColor, uint32_t pointsPerNode = 20000);
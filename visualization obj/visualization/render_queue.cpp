@@ -0,0 +1,394 @@
+#include "render_queue.h"
+#include "gl_utils.h"
+#include "mesh.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    const uint64_t depthMax = (1u << 24) - 1;
+
+    // Kolejny identyfikator dla nowej nazwy GL, 0 zarezerwowane dla braku obiektu
+    uint64_t internId(std::unordered_map<GLuint, uint32_t>& ids, GLuint name)
+    {
+        if (name == 0) return 0;
+        auto found = ids.find(name);
+        if (found != ids.end()) return found->second;
+        uint32_t id = (uint32_t)ids.size() + 1;
+        ids.emplace(name, id);
+        return id;
+    }
+}
+
+uint32_t addQueueProgram(RenderQueue& queue, GLuint program)
+{
+    QueueProgram entry;
+    entry.program = program;
+    entry.uniModel = glGetUniformLocation(program, "model");
+    entry.uniObjectColor = glGetUniformLocation(program, "objectColor");
+    entry.uniUseTexture = glGetUniformLocation(program, "useTexture");
+    entry.uniTextureLayer = glGetUniformLocation(program, "textureLayer");
+    queue.programs.push_back(entry);
+    return (uint32_t)queue.programs.size() - 1;
+}
+
+void beginQueue(RenderQueue& queue)
+{
+    queue.items.clear();
+    queue.stats = RenderStats();
+}
+
+void submitDraw(RenderQueue& queue, uint32_t program, GLuint texture, GLuint vao, GLsizei indexCount, GLuint indexOffset,
+    const glm::mat4& model, const glm::vec4& color, float viewDepth, int layer)
+{
+    // Zbyt wiele tekstur lub VAO skleja grupy w kluczu, ale nie psuje rysowania,
+    // bo pomijanie zmian porwnuje prawdziwe nazwy
+    uint64_t programId = program & 0x7F;
+    uint64_t textureId = internId(queue.textureIds, texture) & 0xFFF;
+    uint64_t vaoId = internId(queue.vaoIds, vao) & 0xFFF;
+    uint64_t depth = (uint64_t)(glm::clamp(viewDepth / queue.farPlane, 0.0f, 1.0f) * depthMax);
+
+    uint64_t key;
+    if (color.a < 1.0f)
+    {
+        // Przezroczyste: od najdalszych, stan dopiero przy rwnej gbokoci
+        key = (1ull << 63) | ((depthMax - depth) << 39) | (programId << 32) | (textureId << 20) | (vaoId << 8);
+    }
+    else
+    {
+        // Nieprzezroczyste: grupy stanu, w grupie od najbliszych
+        key = (programId << 56) | (textureId << 44) | (vaoId << 32) | (depth << 8);
+    }
+
+    queue.items.push_back(RenderItem{ key, program, texture, vao, indexCount, indexOffset, model, color, layer });
+}
+
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order,
+    std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& orderScratch)
+{
+    size_t n = keys.size();
+    keyScratch.resize(n);
+    orderScratch.resize(n);
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[257] = {};
+        for (size_t i = 0; i < n; i++) counts[((keys[i] >> shift) & 0xFF) + 1]++;
+
+        // Wszystkie klucze z tym samym bajtem, przebieg niczego nie zmieni
+        if (counts[((keys[0] >> shift) & 0xFF) + 1] == n) continue;
+
+        for (int b = 0; b < 256; b++) counts[b + 1] += counts[b];
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t slot = counts[(keys[i] >> shift) & 0xFF]++;
+            keyScratch[slot] = keys[i];
+            orderScratch[slot] = order[i];
+        }
+        keys.swap(keyScratch);
+        order.swap(orderScratch);
+    }
+}
+
+void executeQueue(RenderQueue& queue)
+{
+    size_t n = queue.items.size();
+    queue.order.resize(n);
+    for (size_t i = 0; i < n; i++) queue.order[i] = (uint32_t)i;
+    if (queue.sorting && n > 1)
+    {
+        queue.keys.resize(n);
+        for (size_t i = 0; i < n; i++) queue.keys[i] = queue.items[i].key;
+        radixSort(queue.keys, queue.order, queue.keyScratch, queue.orderScratch);
+    }
+
+    // Biecy stan, -1 oznacza nieznany
+    RenderStats& stats = queue.stats;
+    int64_t currentProgram = -1, currentTexture = -1, currentVao = -1;
+    int currentBlend = -1, currentUseTexture = -1, currentLayer = -1;
+    glm::vec4 currentColor(-1.0f);
+    glActiveTexture(GL_TEXTURE0);
+
+    for (uint32_t index : queue.order)
+    {
+        const RenderItem& item = queue.items[index];
+        const QueueProgram& program = queue.programs[item.program];
+        bool elide = queue.elision;
+
+        int blend = item.color.a < 1.0f ? 1 : 0;
+        if (!elide || blend != currentBlend)
+        {
+            if (blend)
+            {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDepthMask(GL_FALSE);
+            }
+            else
+            {
+                glDisable(GL_BLEND);
+                glDepthMask(GL_TRUE);
+            }
+            currentBlend = blend;
+            stats.blendChanges++;
+        }
+        if (!elide || (int64_t)program.program != currentProgram)
+        {
+            glUseProgram(program.program);
+            currentProgram = program.program;
+            // Uniformy nale do programu, po zmianie ich wartoci s nieznane
+            currentUseTexture = -1;
+            currentLayer = -1;
+            currentColor = glm::vec4(-1.0f);
+            stats.programChanges++;
+        }
+        if (!elide || (int64_t)item.texture != currentTexture)
+        {
+            glBindTexture(queue.textureTarget, item.texture);
+            currentTexture = item.texture;
+            stats.textureChanges++;
+        }
+        if (!elide || (int64_t)item.vao != currentVao)
+        {
+            glBindVertexArray(item.vao);
+            currentVao = item.vao;
+            stats.vaoChanges++;
+        }
+
+        int useTexture = item.texture != 0 ? 1 : 0;
+        if (!elide || useTexture != currentUseTexture)
+        {
+            glUniform1i(program.uniUseTexture, useTexture);
+            currentUseTexture = useTexture;
+            stats.uniformUpdates++;
+        }
+        if (program.uniTextureLayer != -1 && (!elide || item.layer != currentLayer))
+        {
+            glUniform1i(program.uniTextureLayer, item.layer);
+            currentLayer = item.layer;
+            stats.uniformUpdates++;
+        }
+        if (!elide || item.color != currentColor)
+        {
+            glUniform4fv(program.uniObjectColor, 1, glm::value_ptr(item.color));
+            currentColor = item.color;
+            stats.uniformUpdates++;
+        }
+        glUniformMatrix4fv(program.uniModel, 1, GL_FALSE, glm::value_ptr(item.model));
+        stats.uniformUpdates++;
+
+        glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, (void*)(item.indexOffset * sizeof(unsigned int)));
+        stats.drawCalls++;
+    }
+
+    if (currentBlend == 1)
+    {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+    }
+    glBindVertexArray(0);
+}
+
+namespace
+{
+    const GLchar* queueVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        in vec3 normal;
+        in vec2 texCoord;
+
+        uniform mat4 model;
+        uniform mat4 viewProj;
+
+        out vec3 Normal;
+        out vec2 TexCoord;
+
+        void main()
+        {
+            Normal = mat3(model) * normal;
+            TexCoord = texCoord;
+            gl_Position = viewProj * model * vec4(position, 1.0);
+        }
+    )glsl";
+
+    // Dwa materiay: owietlony i paski, oba z tekstur albo kolorem
+    const GLchar* litFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        out vec4 outColor;
+
+        uniform sampler2D texture1;
+        uniform vec4 objectColor;
+        uniform bool useTexture;
+
+        void main()
+        {
+            vec4 base = useTexture ? texture(texture1, TexCoord) * objectColor : objectColor;
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            outColor = vec4(base.rgb * light, base.a);
+        }
+    )glsl";
+
+    const GLchar* flatFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        out vec4 outColor;
+
+        uniform sampler2D texture1;
+        uniform vec4 objectColor;
+        uniform bool useTexture;
+
+        void main()
+        {
+            outColor = useTexture ? texture(texture1, TexCoord) * objectColor : objectColor;
+        }
+    )glsl";
+
+    // Maa tekstura w kratk w podanym kolorze
+    GLuint createCheckerTexture(unsigned char r, unsigned char g, unsigned char b)
+    {
+        const int size = 32;
+        std::vector<unsigned char> pixels(size * size * 3);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                bool dark = ((x / 4) + (y / 4)) % 2 == 0;
+                unsigned char* p = &pixels[(y * size + x) * 3];
+                p[0] = dark ? r / 2 : r;
+                p[1] = dark ? g / 2 : g;
+                p[2] = dark ? b / 2 : b;
+            }
+        }
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+}
+
+int runRenderQueueBenchmark(sf::Window& window, int objectCount)
+{
+    Mesh meshes[2];
+    if (!loadMesh("chair.obj", meshes[0]) || !loadMesh("table.obj", meshes[1])) return 1;
+    for (Mesh& mesh : meshes) uploadMesh(mesh);
+
+    GLuint programs[2] = {
+        createProgram(queueVertexSource, litFragmentSource, { "position", "normal", "texCoord" }, "Queue lit"),
+        createProgram(queueVertexSource, flatFragmentSource, { "position", "normal", "texCoord" }, "Queue flat") };
+    if (!programs[0] || !programs[1]) return 1;
+
+    const int textureCount = 8;
+    GLuint textures[textureCount];
+    for (int i = 0; i < textureCount; i++)
+    {
+        textures[i] = createCheckerTexture((unsigned char)(80 + 20 * i), (unsigned char)(200 - 15 * i), (unsigned char)(60 + 25 * (i % 4)));
+    }
+
+    RenderQueue queue;
+    uint32_t queuePrograms[2] = { addQueueProgram(queue, programs[0]), addQueueProgram(queue, programs[1]) };
+
+    // Materiay przemieszane tak, by ssiednie obiekty miay rny stan
+    struct BenchObject
+    {
+        int mesh, program;
+        GLuint texture;
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+    std::vector<BenchObject> objects;
+    int side = std::max(1, (int)std::ceil(std::sqrt((double)objectCount)));
+    float spacing = std::max(meshes[0].radius, meshes[1].radius) * 2.5f;
+    for (int i = 0; i < objectCount; i++)
+    {
+        BenchObject object;
+        object.mesh = (i * 5 / 3) % 2;
+        object.program = (i * 7 / 5) % 2;
+        int texture = (i * 13) % (textureCount + 1);
+        object.texture = texture < textureCount ? textures[texture] : 0;
+        object.model = glm::translate(glm::mat4(1.0f), glm::vec3((i % side) * spacing, 0.0f, (i / side) * spacing));
+        float alpha = (i % 7 == 0) ? 0.5f : 1.0f;
+        object.color = glm::vec4(0.6f + 0.4f * (i % 3) / 2.0f, 0.8f, 0.6f + 0.4f * (i % 5) / 4.0f, alpha);
+        objects.push_back(object);
+    }
+
+    float extent = side * spacing;
+    glm::vec3 cameraPos(-spacing, spacing * 3.0f, -spacing);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    queue.farPlane = extent * 2.0f;
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)width / height, spacing * 0.05f, queue.farPlane);
+    glm::mat4 viewProj = proj * view;
+    for (GLuint program : programs)
+    {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "viewProj"), 1, GL_FALSE, glm::value_ptr(viewProj));
+        glUniform1i(glGetUniformLocation(program, "texture1"), 0);
+    }
+
+    window.setVerticalSyncEnabled(false);
+    glEnable(GL_DEPTH_TEST);
+    std::cout << "Render queue: " << objectCount << " objects, 2 programs, " << textureCount << " textures, 2 meshes" << std::endl;
+
+    const char* names[3] = { "submission order, no elision", "submission order, elision", "sorted, elision" };
+    const int frames = 100;
+    for (int mode = 0; mode < 3; mode++)
+    {
+        queue.sorting = mode == 2;
+        queue.elision = mode >= 1;
+
+        double cpuSeconds = 0.0;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            auto cpuStart = std::chrono::steady_clock::now();
+            beginQueue(queue);
+            for (const BenchObject& object : objects)
+            {
+                const Mesh& mesh = meshes[object.mesh];
+                glm::vec3 center = glm::vec3(object.model * glm::vec4(mesh.center, 1.0f));
+                float depth = -(view * glm::vec4(center, 1.0f)).z;
+                submitDraw(queue, queuePrograms[object.program], object.texture, mesh.vao,
+                    mesh.lods[0].indexCount, mesh.lods[0].indexOffset, object.model, object.color, depth);
+            }
+            executeQueue(queue);
+            cpuSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - cpuStart).count();
+
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const RenderStats& stats = queue.stats;
+        std::cout << "  " << names[mode] << ": " << stats.drawCalls << " draws, " << stats.programChanges << " program, "
+            << stats.textureChanges << " texture, " << stats.vaoChanges << " VAO, " << stats.blendChanges << " blend changes, "
+            << stats.uniformUpdates << " uniform updates; CPU " << cpuSeconds / frames * 1000.0 << " ms, frame "
+            << seconds / frames * 1000.0 << " ms" << std::endl;
+    }
+
+    glDeleteTextures(textureCount, textures);
+    for (GLuint program : programs) glDeleteProgram(program);
+    for (Mesh& mesh : meshes) destroyMesh(mesh);
+    checkGLErrors("After render queue benchmark");
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Kolejka rysowania sortowana 64-bitowym kluczem stanu. Klucz nieprzezroczystych: program,
+// tekstura, VAO, potem gboko od najbliszych; przezroczyste po nich, od najdalszych.
+// Klucze sortowane pozycyjnie (radix) co klatk, a wykonanie pomija zmiany stanu, ktre
+// niczego nie zmieniaj. Numery w kluczu to kolejne identyfikatory nadawane przez kolejk,
+// nie nazwy obiektw GL.
+
+// Program z lokalizacjami uniformw uywanych przez kolejk
+struct QueueProgram
+{
+    GLuint program;
+    GLint uniModel;
+    GLint uniObjectColor;
+    GLint uniUseTexture;
+    GLint uniTextureLayer; // -1 dla programw bez tablicy tekstur
+};
+
+struct RenderItem
+{
+    uint64_t key;
+    uint32_t program;  // Indeks w RenderQueue::programs
+    GLuint texture;    // 0: kolor obiektu zamiast tekstury
+    GLuint vao;
+    GLsizei indexCount;
+    GLuint indexOffset;
+    glm::mat4 model;
+    glm::vec4 color;   // Alfa poniej 1 oznacza obiekt przezroczysty
+    int layer;         // Warstwa tablicy tekstur
+};
+
+// Liczniki jednej klatki
+struct RenderStats
+{
+    unsigned drawCalls = 0;
+    unsigned programChanges = 0;
+    unsigned textureChanges = 0;
+    unsigned vaoChanges = 0;
+    unsigned blendChanges = 0;
+    unsigned uniformUpdates = 0;
+
+    unsigned stateChanges() const { return programChanges + textureChanges + vaoChanges + blendChanges; }
+};
+
+struct RenderQueue
+{
+    std::vector<QueueProgram> programs;
+    std::unordered_map<GLuint, uint32_t> textureIds;
+    std::unordered_map<GLuint, uint32_t> vaoIds;
+
+    bool sorting = true; // Wyczane w pomiarze: kolejno zgosze
+    bool elision = true; // Wyczane w pomiarze: kady stan ustawiany przy kadym rysowaniu
+    float farPlane = 100.0f;
+    GLenum textureTarget = GL_TEXTURE_2D; // GL_TEXTURE_2D_ARRAY: warstwa w uniformie zamiast wizania tekstury
+
+    std::vector<RenderItem> items;
+    std::vector<uint64_t> keys, keyScratch;
+    std::vector<uint32_t> order, orderScratch;
+    RenderStats stats;
+};
+
+// Rejestracja programu z uniformami model, objectColor, useTexture i opcjonalnie textureLayer, zwraca jego indeks
+uint32_t addQueueProgram(RenderQueue& queue, GLuint program);
+
+void beginQueue(RenderQueue& queue);
+
+// Zgoszenie rysowania, viewDepth to odlego od kamery wzdu osi widzenia
+void submitDraw(RenderQueue& queue, uint32_t program, GLuint texture, GLuint vao, GLsizei indexCount, GLuint indexOffset,
+    const glm::mat4& model, const glm::vec4& color, float viewDepth, int layer = 0);
+
+// Sortowanie i wykonanie zgoszonych rysowa, liczniki w queue.stats
+void executeQueue(RenderQueue& queue);
+
+// Pozycyjne sortowanie kluczy razem z indeksami, po 8 bitw na przebieg
+void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& order,
+    std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& orderScratch);
+
+// Pomiar: zmiany stanu i czas CPU dla sceny z mieszanymi materiaami
+int runRenderQueueBenchmark(sf::Window& window, int objectCount);
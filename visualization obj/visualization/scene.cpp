@@ -0,0 +1,277 @@
+#include "scene.h"
+#include "job_system.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SCENE_SIMD_SSE 1
+#endif
+
+namespace
+{
+    const uint32_t updateBatch = 4096;   // Wzy jednego zadania w obrbie poziomu
+
+    // Macierz lokalna T * R * S zapisana kolumnami, ostatni wiersz zawsze (0, 0, 0, 1)
+    void localMatrix(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale, float* out)
+    {
+        float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+        float xx = x * x, yy = y * y, zz = z * z, xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+        out[0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+        out[1] = 2.0f * (xy + wz) * scale.x;
+        out[2] = 2.0f * (xz - wy) * scale.x;
+        out[3] = 0.0f;
+        out[4] = 2.0f * (xy - wz) * scale.y;
+        out[5] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+        out[6] = 2.0f * (yz + wx) * scale.y;
+        out[7] = 0.0f;
+        out[8] = 2.0f * (xz + wy) * scale.z;
+        out[9] = 2.0f * (yz - wx) * scale.z;
+        out[10] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+        out[11] = 0.0f;
+        out[12] = position.x;
+        out[13] = position.y;
+        out[14] = position.z;
+        out[15] = 1.0f;
+    }
+
+#ifdef SCENE_SIMD_SSE
+    // parent * local dla macierzy afinicznej local: kada kolumna wyniku to kombinacja kolumn rodzica
+    void multiplyAffine(const float* parent, const float* local, float* world)
+    {
+        __m128 p0 = _mm_loadu_ps(parent), p1 = _mm_loadu_ps(parent + 4), p2 = _mm_loadu_ps(parent + 8), p3 = _mm_loadu_ps(parent + 12);
+        for (int c = 0; c < 4; c++)
+        {
+            const float* column = local + c * 4;
+            __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(column[0])), _mm_mul_ps(p1, _mm_set1_ps(column[1]))),
+                _mm_mul_ps(p2, _mm_set1_ps(column[2])));
+            if (c == 3) result = _mm_add_ps(result, p3);
+            _mm_storeu_ps(world + c * 4, result);
+        }
+    }
+#endif
+
+    // Przeliczenie wzw [begin, end) jednego poziomu, zwraca liczb przeliczonych
+    uint32_t updateRange(SceneGraph& scene, uint32_t begin, uint32_t end)
+    {
+        uint32_t updated = 0;
+        float local[16];
+        for (uint32_t i = begin; i < end; i++)
+        {
+            // Zmieniony rodzic oznacza zmienione cae poddrzewo, flaga przechodzi na dziecko
+            int32_t parent = scene.parents[i];
+            if (!scene.dirty[i] && (parent < 0 || !scene.dirty[parent])) continue;
+            scene.dirty[i] = 1;
+            updated++;
+
+            localMatrix(scene.positions[i], scene.rotations[i], scene.scales[i], local);
+            float* world = glm::value_ptr(scene.worlds[i]);
+            if (parent < 0)
+            {
+                std::memcpy(world, local, sizeof(local));
+                continue;
+            }
+#ifdef SCENE_SIMD_SSE
+            if (scene.simd)
+            {
+                multiplyAffine(glm::value_ptr(scene.worlds[parent]), local, world);
+                continue;
+            }
+#endif
+            glm::mat4 localMat;
+            std::memcpy(glm::value_ptr(localMat), local, sizeof(local));
+            scene.worlds[i] = scene.worlds[parent] * localMat;
+        }
+        return updated;
+    }
+
+    template <typename T>
+    void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> sorted(values.size());
+        for (size_t i = 0; i < order.size(); i++) sorted[i] = values[order[i]];
+        values.swap(sorted);
+    }
+
+    // Stabilne uoenie wzw poziomami gbokoci
+    void sortScene(SceneGraph& scene)
+    {
+        uint32_t count = (uint32_t)scene.parents.size();
+        uint16_t maxDepth = 0;
+        for (uint16_t depth : scene.depths) maxDepth = std::max(maxDepth, depth);
+        scene.levelStart.assign((size_t)maxDepth + 2, 0);
+        for (uint16_t depth : scene.depths) scene.levelStart[(size_t)depth + 1]++;
+        for (size_t level = 1; level < scene.levelStart.size(); level++) scene.levelStart[level] += scene.levelStart[level - 1];
+
+        std::vector<uint32_t> order(count), next(scene.levelStart.begin(), scene.levelStart.end() - 1);
+        std::vector<uint32_t> newIndex(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t target = next[scene.depths[i]]++;
+            order[target] = i;
+            newIndex[i] = target;
+        }
+
+        permute(scene.positions, order);
+        permute(scene.rotations, order);
+        permute(scene.scales, order);
+        permute(scene.parents, order);
+        permute(scene.depths, order);
+        permute(scene.dirty, order);
+        permute(scene.worlds, order);
+        permute(scene.handles, order);
+        for (int32_t& parent : scene.parents)
+        {
+            if (parent >= 0) parent = (int32_t)newIndex[parent];
+        }
+        for (uint32_t i = 0; i < count; i++) scene.slots[scene.handles[i]] = i;
+        scene.sorted = true;
+    }
+
+    void markDirty(SceneGraph& scene, uint32_t slot)
+    {
+        if (!scene.dirty[slot]) scene.dirtyCount++;
+        scene.dirty[slot] = 1;
+    }
+}
+
+SceneNode addSceneNode(SceneGraph& scene, SceneNode parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+    SceneNode node = (SceneNode)scene.slots.size();
+    uint32_t slot = (uint32_t)scene.parents.size();
+    int32_t parentSlot = parent == noSceneNode ? -1 : (int32_t)scene.slots[parent];
+
+    scene.positions.push_back(position);
+    scene.rotations.push_back(rotation);
+    scene.scales.push_back(scale);
+    scene.parents.push_back(parentSlot);
+    scene.depths.push_back(parentSlot < 0 ? 0 : (uint16_t)(scene.depths[parentSlot] + 1));
+    scene.dirty.push_back(0);
+    scene.worlds.push_back(glm::mat4(1.0f));
+    scene.slots.push_back(slot);
+    scene.handles.push_back(node);
+    markDirty(scene, slot);
+
+    // Dziecko dopisane na kocu jest ju za rodzicem, ale poziomy trzeba uoy od nowa
+    scene.sorted = false;
+    return node;
+}
+
+void setNodePosition(SceneGraph& scene, SceneNode node, const glm::vec3& position)
+{
+    uint32_t slot = scene.slots[node];
+    scene.positions[slot] = position;
+    markDirty(scene, slot);
+}
+
+void setNodeRotation(SceneGraph& scene, SceneNode node, const glm::quat& rotation)
+{
+    uint32_t slot = scene.slots[node];
+    scene.rotations[slot] = rotation;
+    markDirty(scene, slot);
+}
+
+void setNodeScale(SceneGraph& scene, SceneNode node, const glm::vec3& scale)
+{
+    uint32_t slot = scene.slots[node];
+    scene.scales[slot] = scale;
+    markDirty(scene, slot);
+}
+
+const glm::mat4& nodeWorld(const SceneGraph& scene, SceneNode node)
+{
+    return scene.worlds[scene.slots[node]];
+}
+
+void updateScene(SceneGraph& scene)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!scene.sorted) sortScene(scene);
+    scene.updatedNodes = 0;
+    if (scene.dirtyCount == 0)
+    {
+        scene.updateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+
+    // Poziomy kolejno, bo dziecko potrzebuje gotowej macierzy rodzica, w obrbie poziomu paczki niezalene
+    unsigned threads = scene.threads ? scene.threads : jobThreadCount();
+    std::atomic<uint32_t> updated(0);
+    for (size_t level = 0; level + 1 < scene.levelStart.size(); level++)
+    {
+        uint32_t begin = scene.levelStart[level], end = scene.levelStart[level + 1];
+        unsigned batches = (end - begin + updateBatch - 1) / updateBatch;
+        parallelFor(batches, [&](unsigned first, unsigned last)
+        {
+            uint32_t count = 0;
+            for (unsigned batch = first; batch < last; batch++)
+            {
+                count += updateRange(scene, begin + batch * updateBatch, std::min(end, begin + (batch + 1) * updateBatch));
+            }
+            updated += count;
+        }, threads > 1 ? batches : 1);
+    }
+
+    std::fill(scene.dirty.begin(), scene.dirty.end(), (unsigned char)0);
+    scene.dirtyCount = 0;
+    scene.updatedNodes = updated;
+    scene.updateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runSceneBenchmark(uint32_t nodes)
+{
+    // Las drzew: tysic korzeni, kady kolejny wze pod losowym wczeniejszym, wic gboko ronie logarytmicznie
+    SceneGraph scene;
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::vector<SceneNode> all;
+    all.reserve(nodes);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        SceneNode parent = i < 1000 ? noSceneNode : all[random() % i];
+        float angle = offset(random);
+        all.push_back(addSceneNode(scene, parent, glm::vec3(offset(random), offset(random), offset(random)),
+            glm::quat(std::cos(angle), 0.0f, std::sin(angle), 0.0f), glm::vec3(0.99f)));
+    }
+    updateScene(scene);
+    std::cout << "Scene: " << nodes << " nodes, " << scene.levelStart.size() - 1 << " levels, built and sorted in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+
+    unsigned cores = jobThreadCount();
+    const int repeats = 5;
+    for (double fraction : { 0.01, 1.0 })
+    {
+        uint32_t step = (uint32_t)std::max(1.0, std::round(1.0 / fraction));
+        for (bool simd : { false, true })
+        {
+            for (unsigned threads : { 1u, cores })
+            {
+                scene.simd = simd;
+                scene.threads = threads;
+                double best = 1e30;
+                for (int repeat = 0; repeat < repeats; repeat++)
+                {
+                    // Co step-ty wze obrcony, przesunicie zmienia wybr midzy powtrzeniami
+                    float angle = 0.01f * (repeat + 1);
+                    for (uint32_t i = repeat % step; i < nodes; i += step)
+                    {
+                        setNodeRotation(scene, all[i], glm::quat(std::cos(angle), 0.0f, std::sin(angle), 0.0f));
+                    }
+                    updateScene(scene);
+                    best = std::min(best, scene.updateSeconds);
+                }
+                std::cout << "  " << fraction * 100.0 << "% dirty, " << (simd ? "SSE" : "scalar") << ", " << threads << " threads: "
+                    << best * 1000.0 << " ms, " << scene.updatedNodes << " nodes updated with subtrees, "
+                    << scene.updatedNodes / best / 1e6 << " M nodes/s" << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+// Scena jako struktura tablic: pooenia, obroty, skale, rodzice i macierze wiata w osobnych
+// cigych tablicach, wzy uoone poziomami gbokoci, wic rodzic zawsze jest przed dziemi.
+// Zmiana wza ustawia flag, aktualizacja przechodzi poziomy po kolei i liczy macierze tylko
+// zmienionych wzw i ich poddrzew, kady poziom paczkami na kilku wtkach z mnoeniem SSE.
+
+typedef uint32_t SceneNode;           // Uchwyt wza, nie zmienia si przy przestawianiu tablic
+const SceneNode noSceneNode = 0xffffffffu;
+
+struct SceneGraph
+{
+    // Tablice indeksowane pooeniem wza, kolejno poziomami gbokoci
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<int32_t> parents;          // Indeks rodzica, -1 dla korzenia
+    std::vector<uint16_t> depths;
+    std::vector<unsigned char> dirty;      // Zmieniony od ostatniej aktualizacji
+    std::vector<glm::mat4> worlds;
+    std::vector<uint32_t> levelStart;      // Pierwszy wze kadego poziomu, na kocu liczba wzw
+
+    std::vector<uint32_t> slots;           // Uchwyt -> indeks w tablicach
+    std::vector<SceneNode> handles;        // Indeks -> uchwyt
+    bool sorted = true;                    // false po dodaniu wza, kolejno poprawia updateScene
+    uint32_t dirtyCount = 0;
+    unsigned threads = 0;                  // 0 oznacza wszystkie rdzenie
+    bool simd = true;
+
+    // Ostatnia aktualizacja
+    uint32_t updatedNodes = 0;
+    double updateSeconds = 0.0;
+};
+
+// Nowy wze pod rodzicem parent (noSceneNode dla korzenia), rodzic musi ju istnie
+SceneNode addSceneNode(SceneGraph& scene, SceneNode parent, const glm::vec3& position = glm::vec3(0.0f),
+    const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+void setNodePosition(SceneGraph& scene, SceneNode node, const glm::vec3& position);
+void setNodeRotation(SceneGraph& scene, SceneNode node, const glm::quat& rotation);
+void setNodeScale(SceneGraph& scene, SceneNode node, const glm::vec3& scale);
+
+// Macierz wiata z ostatniej aktualizacji
+const glm::mat4& nodeWorld(const SceneGraph& scene, SceneNode node);
+
+// Przeliczenie macierzy zmienionych poddrzew, poziom po poziomie
+void updateScene(SceneGraph& scene);
+
+// Pomiar: aktualizacja sceny z nodes wzami przy 1% i 100% zmienionych, skalarnie i SSE, jeden i wszystkie rdzenie
+int runSceneBenchmark(uint32_t nodes);
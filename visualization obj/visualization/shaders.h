@@ -32,15 +32,16 @@ const GLchar* fragmentSource = R"glsl(
     in vec3 Normal;
     in vec2 TexCoord;
 
-    uniform sampler2D texture1; // Sampler tekstury
-    uniform vec4 objectColor;    // Kolor obiektu
-    uniform bool useTexture;     // Flaga uycia tekstury
+    uniform sampler2DArray texture1; // Tablica tekstur
+    uniform int textureLayer;        // Warstwa tekstury obiektu
+    uniform vec4 objectColor;        // Kolor obiektu
+    uniform bool useTexture;         // Flaga uycia tekstury
 
     void main()
     {
         if (useTexture)
         {
-            outColor = texture(texture1, TexCoord);
+            outColor = texture(texture1, vec3(TexCoord, textureLayer));
         }
         else
         {
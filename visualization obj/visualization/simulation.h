@@ -0,0 +1,100 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "triple_buffer.h"
+
+// Wejcie i kamera aktualizowane ze staym krokiem na osobnym wtku. Wtek renderujcy
+// dostaje niezmienne migawki przez bufor potrjny i interpoluje midzy dwoma ostatnimi krokami,
+// wic duga klatka nie gubi ruchw myszy, a aktualizacja nie spowalnia rysowania.
+
+struct CameraState
+{
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 3.0f);
+    glm::vec3 front = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+};
+
+// Stan sceny po jednym kroku symulacji
+struct SceneSnapshot
+{
+    CameraState previous;  // Stan z poprzedniego kroku
+    CameraState current;
+    double tickTime = 0.0; // Czas kroku w sekundach zegara symulacji
+    unsigned tick = 0;
+    unsigned quietTicks = 0; // Kolejne kroki bez zmiany kamery, cznie z tym
+};
+
+struct Simulation
+{
+    double tickSeconds = 1.0 / 120.0;
+    float moveSpeed = 5.0f;   // Jednostki na sekund
+    float sensitivity = 0.1f; // Stopnie na piksel
+
+    TripleBuffer<SceneSnapshot> snapshots;
+    std::thread thread;
+    std::atomic<bool> running{ false };
+    sf::Window* window = nullptr;
+    sf::Clock clock;          // Wsplny zegar obu wtkw, sf::Clock jest tylko do odczytu
+
+    // Wstrzymanie na czas bezczynnoci renderera, wtek pi zamiast budzi si co krok
+    std::mutex pauseMutex;
+    std::condition_variable pauseWake;
+    bool paused = false;
+
+    // Stan nalecy do wtku symulacji
+    CameraState camera;
+    sf::Vector2i lastMouse;
+    bool firstMouse = true;
+};
+
+// Start wtku symulacji z pocztkowym stanem kamery
+void startSimulation(Simulation& sim, sf::Window& window, const CameraState& initial);
+void stopSimulation(Simulation& sim);
+
+// Wtek renderujcy: kamera z najnowszej migawki interpolowana do biecej chwili
+CameraState sampleCamera(Simulation& sim);
+
+glm::mat4 cameraView(const CameraState& camera);
+
+void pauseSimulation(Simulation& sim);
+void resumeSimulation(Simulation& sim);
+
+// Rysowanie na danie: gdy kamera stoi, a od ostatniej klatki nic si nie zmienio, ptla
+// czeka w waitEvent zamiast rysowa t sam klatk, a wtek symulacji jest wstrzymany.
+struct FramePacing
+{
+    bool onDemand = true;
+    bool dirty = true;        // Zmiana spoza kamery: zdarzenie, uniform, animacja, dane sceny
+    unsigned wakeTick = 0;    // Krok symulacji przy ostatnim wybudzeniu
+
+    // Liczniki od ostatniego raportu
+    unsigned frames = 0;
+    unsigned wakeups = 0;
+    double idleSeconds = 0.0;
+    double reportCpu = 0.0;
+    double reportTime = 0.0;
+};
+
+// Czeka na zdarzenie, jeli klatka nie jest potrzebna. true oznacza, e event zawiera zdarzenie do obsuenia.
+bool waitForFrame(FramePacing& pacing, Simulation& sim, sf::Window& window, sf::Event& event);
+
+// Raport od poprzedniego wywoania: klatki na sekund, zuycie procesora w procentach jednego rdzenia,
+// wybudzenia i udzia czasu bezczynnoci
+struct PacingReport
+{
+    double fps = 0.0;
+    double cpuPercent = 0.0;
+    unsigned wakeups = 0;
+    double idlePercent = 0.0;
+};
+
+PacingReport readPacingReport(FramePacing& pacing, Simulation& sim);
+
+// Czas procesora zuyty przez proces, wszystkie wtki, w sekundach
+double processCpuSeconds();
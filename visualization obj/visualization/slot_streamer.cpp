@@ -0,0 +1,163 @@
+#include "slot_streamer.h"
+#include <SFML/Window.hpp>
+
+namespace
+{
+    void uploadLoop(SlotStreamer* streamer)
+    {
+        sf::Context context; // Kontekst wspdzielcy obiekty z kontekstem okna
+
+        while (true)
+        {
+            SlotRequest request;
+            {
+                std::unique_lock<std::mutex> lock(streamer->mutex);
+                streamer->wake.wait(lock, [&]() { return !streamer->running || !streamer->requests.empty(); });
+                if (!streamer->running) break;
+                request = streamer->requests.front();
+                streamer->requests.pop_front();
+            }
+
+            // Poprzednia zawarto miejsca moga by jeszcze rysowana
+            if (request.released)
+            {
+                glWaitSync(request.released, 0, GL_TIMEOUT_IGNORED);
+                glDeleteSync(request.released);
+            }
+
+            // Odczyt stron z dysku odbywa si tutaj, poza wtkiem renderujcym
+            uint64_t bytes = streamer->upload(request.item, request.slot);
+            GLsync uploaded = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            streamer->uploadedBytes += bytes;
+
+            std::lock_guard<std::mutex> lock(streamer->mutex);
+            streamer->results.push_back(SlotResult{ request.item, request.slot, uploaded });
+        }
+    }
+}
+
+void startSlotStreamer(SlotStreamer& streamer, size_t slotCount, size_t itemCount, int maxInFlight, SlotUpload upload)
+{
+    streamer.slots.assign(slotCount, PoolSlot());
+    streamer.itemSlots.assign(itemCount, -1);
+    streamer.wantedFrame.assign(itemCount, 0);
+    streamer.frame = 0;
+    streamer.maxInFlight = maxInFlight;
+    streamer.inFlight = 0;
+    streamer.upload = std::move(upload);
+    streamer.uploadedBytes = 0;
+
+    glFinish(); // Pula musi istnie, zanim uyje jej wtek ta
+    streamer.running = true;
+    streamer.thread = std::thread(uploadLoop, &streamer);
+}
+
+void stopSlotStreamer(SlotStreamer& streamer)
+{
+    if (streamer.thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(streamer.mutex);
+            streamer.running = false;
+        }
+        streamer.wake.notify_all();
+        streamer.thread.join();
+    }
+
+    for (const SlotRequest& request : streamer.requests)
+    {
+        if (request.released) glDeleteSync(request.released);
+    }
+    for (const SlotResult& result : streamer.results) glDeleteSync(result.uploaded);
+    for (const SlotResult& result : streamer.pending) glDeleteSync(result.uploaded);
+    streamer.requests.clear();
+    streamer.results.clear();
+    streamer.pending.clear();
+    streamer.slots.clear();
+    streamer.itemSlots.clear();
+    streamer.wantedFrame.clear();
+    streamer.inFlight = 0;
+}
+
+bool beginSlotFrame(SlotStreamer& streamer)
+{
+    // Wczytane elementy s rysowane dopiero po sygnale potu
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.pending.insert(streamer.pending.end(), streamer.results.begin(), streamer.results.end());
+        streamer.results.clear();
+    }
+    bool arrived = false;
+    for (size_t i = 0; i < streamer.pending.size();)
+    {
+        const SlotResult& result = streamer.pending[i];
+        if (glClientWaitSync(result.uploaded, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            i++;
+            continue;
+        }
+        glDeleteSync(result.uploaded);
+        streamer.slots[result.slot].ready = true;
+        streamer.inFlight--;
+        arrived = true;
+        streamer.pending[i] = streamer.pending.back();
+        streamer.pending.pop_back();
+    }
+    streamer.frame++;
+    return arrived;
+}
+
+bool requireSlot(SlotStreamer& streamer, uint32_t item)
+{
+    streamer.wantedFrame[item] = streamer.frame;
+    int slot = streamer.itemSlots[item];
+    if (slot >= 0)
+    {
+        streamer.slots[slot].lastUsed = streamer.frame;
+        return streamer.slots[slot].ready;
+    }
+    if (streamer.inFlight >= streamer.maxInFlight) return false;
+
+    // Wolne miejsce albo najdawniej uywane z elementem niepotrzebnym w tej klatce
+    int victim = -1;
+    for (size_t s = 0; s < streamer.slots.size(); s++)
+    {
+        const PoolSlot& candidate = streamer.slots[s];
+        if (candidate.item < 0)
+        {
+            victim = (int)s;
+            break;
+        }
+        if (!candidate.ready || streamer.wantedFrame[candidate.item] == streamer.frame) continue;
+        if (victim < 0 || candidate.lastUsed < streamer.slots[victim].lastUsed) victim = (int)s;
+    }
+    if (victim < 0) return false;
+
+    PoolSlot& target = streamer.slots[victim];
+    GLsync released = 0;
+    if (target.item >= 0)
+    {
+        streamer.itemSlots[target.item] = -1;
+        released = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+    }
+    target.item = (int)item;
+    target.ready = false;
+    target.lastUsed = streamer.frame;
+    streamer.itemSlots[item] = victim;
+    streamer.inFlight++;
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        streamer.requests.push_back(SlotRequest{ item, (uint32_t)victim, released });
+    }
+    streamer.wake.notify_one();
+    return false;
+}
+
+size_t readySlotCount(const SlotStreamer& streamer)
+{
+    size_t ready = 0;
+    for (const PoolSlot& slot : streamer.slots) ready += slot.ready ? 1 : 0;
+    return ready;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pula GPU o staej liczbie miejsc zapeniana przez wtek ta z wasnym kontekstem GL.
+// Wsplna dla strumieniowania kawakw siatki i wzw chmury punktw: elementy to numery
+// z pliku, miejsca to fragmenty buforw waciciela. Przed nadpisaniem miejsca wtek czeka
+// na pot koca rysowania poprzedniej zawartoci, nowa jest rysowana po pocie wysania.
+// Przy braku miejsca wypada najdawniej uywany element niepotrzebny w biecej klatce (LRU).
+
+struct SlotRequest
+{
+    uint32_t item;
+    uint32_t slot;
+    GLsync released; // Koniec rysowania poprzedniej zawartoci miejsca, 0 dla wolnego
+};
+
+struct SlotResult
+{
+    uint32_t item;
+    uint32_t slot;
+    GLsync uploaded;
+};
+
+struct PoolSlot
+{
+    int item = -1;
+    bool ready = false;    // Dane na GPU, mona rysowa
+    unsigned lastUsed = 0; // Ostatnia klatka, w ktrej element by potrzebny
+};
+
+// Wysanie elementu do miejsca w puli, wywoywane w kontekcie wtku ta; zwraca liczb bajtw
+using SlotUpload = std::function<uint64_t(uint32_t item, uint32_t slot)>;
+
+struct SlotStreamer
+{
+    std::vector<PoolSlot> slots;
+    std::vector<int> itemSlots;        // Miejsce kadego elementu, -1 gdy nie ma go na GPU
+    std::vector<unsigned> wantedFrame; // Klatka, w ktrej element by ostatnio potrzebny
+    unsigned frame = 0;
+    SlotUpload upload;
+
+    // Wtek wczytujcy
+    int maxInFlight = 4;
+    int inFlight = 0;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<SlotRequest> requests;
+    std::vector<SlotResult> results; // Gotowe po stronie wtku, odbierane przez wtek renderujcy
+    std::vector<SlotResult> pending; // Odebrane, czekajce na pot GPU
+    std::atomic<bool> running{ false };
+    std::atomic<uint64_t> uploadedBytes{ 0 };
+};
+
+// Bufory puli musz ju istnie w kontekcie okna
+void startSlotStreamer(SlotStreamer& streamer, size_t slotCount, size_t itemCount, int maxInFlight, SlotUpload upload);
+void stopSlotStreamer(SlotStreamer& streamer);
+
+// Odbir wczytanych elementw i pocztek klatki. true, gdy co doszo: dane zmienione w innym
+// kontekcie s widoczne po ponownym podpiciu buforw puli.
+bool beginSlotFrame(SlotStreamer& streamer);
+
+// Element potrzebny w tej klatce: ochrona przed usuniciem i zlecenie wczytania, true gdy jest na GPU
+bool requireSlot(SlotStreamer& streamer, uint32_t item);
+
+size_t readySlotCount(const SlotStreamer& streamer);
@@ -0,0 +1,259 @@
+#include "streaming.h"
+#include "gl_utils.h"
+#include "lod.h"
+#include "mesh.h"
+#include "simulation.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const float minChunkPixels = 2.0f; // Mniejsze kawaki nie s wczytywane
+
+    // Kopiowanie kawaka z odwzorowanego pliku do jego miejsca w puli, w wtku ta
+    uint64_t uploadChunk(ChunkStreamer& streamer, uint32_t chunk, uint32_t slot)
+    {
+        const ChunkInfo& info = streamer.chunks[chunk];
+        uint64_t vertexBytes = (uint64_t)info.vertexCount * sizeof(Vertex);
+        uint64_t indexBytes = (uint64_t)info.indexCount * sizeof(uint32_t);
+        const unsigned char* source = streamer.file.data + info.offset;
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, streamer.vertexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)slot * streamer.slotVertices * sizeof(Vertex), (GLsizeiptr)vertexBytes, source);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, streamer.indexBuffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)slot * streamer.slotIndices * sizeof(uint32_t), (GLsizeiptr)indexBytes, source + vertexBytes);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        releasePages(streamer.file, info.offset, vertexBytes + indexBytes);
+        return vertexBytes + indexBytes;
+    }
+
+    // Dane zmienione w innym kontekcie s widoczne po ponownym podpiciu bufora
+    void attachPool(const ChunkStreamer& streamer)
+    {
+        glBindVertexArray(streamer.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, streamer.vertexBuffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streamer.indexBuffer);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord));
+        glEnableVertexAttribArray(2);
+
+        glBindVertexArray(0);
+    }
+}
+
+bool openChunkStreamer(ChunkStreamer& streamer, const std::string& path, uint64_t memoryBudget)
+{
+    if (!mapFile(streamer.file, path)) return false;
+
+    const ChunkFileHeader* header = reinterpret_cast<const ChunkFileHeader*>(streamer.file.data);
+    if (streamer.file.size < sizeof(ChunkFileHeader) || std::memcmp(header->magic, "OBJC", 4) != 0 ||
+        header->version != chunkFileVersion ||
+        streamer.file.size < sizeof(ChunkFileHeader) + (uint64_t)header->chunkCount * sizeof(ChunkInfo))
+    {
+        std::cerr << "Not a chunk file: " << path << std::endl;
+        unmapFile(streamer.file);
+        return false;
+    }
+    streamer.header = *header;
+    streamer.chunks = reinterpret_cast<const ChunkInfo*>(streamer.file.data + sizeof(ChunkFileHeader));
+
+    // Limit pamici wyznacza liczb miejsc, kade na najwikszy kawaek z pliku
+    streamer.memoryBudget = memoryBudget;
+    streamer.slotVertices = header->maxVertices;
+    streamer.slotIndices = header->maxIndices;
+    uint64_t slotBytes = (uint64_t)streamer.slotVertices * sizeof(Vertex) + (uint64_t)streamer.slotIndices * sizeof(uint32_t);
+    uint64_t slotCount = std::min<uint64_t>(memoryBudget / slotBytes, header->chunkCount);
+    if (slotCount == 0)
+    {
+        std::cerr << "Memory budget of " << memoryBudget << " bytes is smaller than one chunk (" << slotBytes << " bytes)" << std::endl;
+        unmapFile(streamer.file);
+        return false;
+    }
+
+    glGenVertexArrays(1, &streamer.vao);
+    glGenBuffers(1, &streamer.vertexBuffer);
+    glGenBuffers(1, &streamer.indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, streamer.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(slotCount * streamer.slotVertices * sizeof(Vertex)), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, streamer.indexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(slotCount * streamer.slotIndices * sizeof(uint32_t)), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    attachPool(streamer);
+    startSlotStreamer(streamer.pool, (size_t)slotCount, header->chunkCount, 4,
+        [&streamer](uint32_t chunk, uint32_t slot) { return uploadChunk(streamer, chunk, slot); });
+
+    std::cout << "Streaming " << path << ": " << header->chunkCount << " chunks, " << slotCount << " resident at most ("
+        << slotCount * slotBytes / (1024 * 1024) << " MB of " << memoryBudget / (1024 * 1024) << " MB)" << std::endl;
+    return true;
+}
+
+void closeChunkStreamer(ChunkStreamer& streamer)
+{
+    stopSlotStreamer(streamer.pool);
+    glDeleteVertexArrays(1, &streamer.vao);
+    glDeleteBuffers(1, &streamer.vertexBuffer);
+    glDeleteBuffers(1, &streamer.indexBuffer);
+    streamer.vao = streamer.vertexBuffer = streamer.indexBuffer = 0;
+    unmapFile(streamer.file);
+    streamer.chunks = nullptr;
+}
+
+void updateChunkStreamer(ChunkStreamer& streamer, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale)
+{
+    if (beginSlotFrame(streamer.pool)) attachPool(streamer);
+
+    // Kawaki wedug rozmiaru na ekranie, widoczne przed lecymi obok ostrosupa,
+    // te drugie zostaj w puli, eby obrt kamery nie wymaga wczytywania
+    streamer.candidates.clear();
+    glm::vec4 planes[6];
+    frustumPlanes(viewProj, planes);
+    for (uint32_t c = 0; c < streamer.header.chunkCount; c++)
+    {
+        const ChunkInfo& info = streamer.chunks[c];
+        float distance = std::max(glm::length(info.center - cameraPos) - info.radius, 1e-6f);
+        float pixels = info.radius * pixelScale / distance;
+        if (pixels < minChunkPixels) continue;
+        float priority = sphereInPlanes(planes, info.center, info.radius) ? pixels : -1.0f / pixels;
+        streamer.candidates.push_back(std::make_pair(priority, c));
+    }
+    size_t wantedCount = std::min(streamer.candidates.size(), streamer.pool.slots.size());
+    std::partial_sort(streamer.candidates.begin(), streamer.candidates.begin() + wantedCount, streamer.candidates.end(),
+        [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+    for (size_t i = 0; i < wantedCount; i++) streamer.pool.wantedFrame[streamer.candidates[i].second] = streamer.pool.frame;
+
+    streamer.drawList.clear();
+    for (size_t i = 0; i < wantedCount; i++)
+    {
+        uint32_t chunk = streamer.candidates[i].second;
+        bool visible = streamer.candidates[i].first > 0.0f;
+        if (requireSlot(streamer.pool, chunk) && visible) streamer.drawList.push_back(chunk);
+    }
+}
+
+void drawChunks(const ChunkStreamer& streamer)
+{
+    glBindVertexArray(streamer.vao);
+    for (uint32_t chunk : streamer.drawList)
+    {
+        int slot = streamer.pool.itemSlots[chunk];
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)streamer.chunks[chunk].indexCount, GL_UNSIGNED_INT,
+            (void*)((size_t)slot * streamer.slotIndices * sizeof(uint32_t)), (GLint)(slot * streamer.slotVertices));
+    }
+    glBindVertexArray(0);
+}
+
+namespace
+{
+    const GLchar* streamVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        in vec3 normal;
+        in vec2 texCoord;
+
+        uniform mat4 viewProj;
+
+        out vec3 Normal;
+
+        void main()
+        {
+            Normal = normal;
+            gl_Position = viewProj * vec4(position, 1.0);
+        }
+    )glsl";
+
+    const GLchar* streamFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        out vec4 outColor;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * abs(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))));
+            outColor = vec4(vec3(light), 1.0);
+        }
+    )glsl";
+}
+
+int runStreamViewer(sf::Window& window, const char* path, uint64_t memoryBudget)
+{
+    ChunkStreamer streamer;
+    if (!openChunkStreamer(streamer, path, memoryBudget)) return 1;
+
+    GLuint program = createProgram(streamVertexSource, streamFragmentSource, { "position", "normal", "texCoord" }, "Streaming");
+    if (!program)
+    {
+        closeChunkStreamer(streamer);
+        return 1;
+    }
+    GLint uniViewProj = glGetUniformLocation(program, "viewProj");
+
+    // Kamera przed caym modelem, prdko dopasowana do jego rozmiaru
+    glm::vec3 center = (streamer.header.boundsMin + streamer.header.boundsMax) * 0.5f;
+    float radius = std::max(glm::length(streamer.header.boundsMax - streamer.header.boundsMin) * 0.5f, 1e-3f);
+    CameraState camera;
+    camera.position = center + glm::vec3(0.0f, 0.0f, radius * 2.0f);
+
+    Simulation simulation;
+    simulation.moveSpeed = radius * 0.25f;
+    startSimulation(simulation, window, camera);
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    float fov = glm::radians(45.0f);
+    glm::mat4 proj = glm::perspective(fov, (float)width / height, radius * 1e-4f, radius * 8.0f);
+    float pixelScale = pixelsPerUnit(fov, height);
+
+    glEnable(GL_DEPTH_TEST);
+    glUseProgram(program);
+
+    bool running = true;
+    sf::Clock fpsClock;
+    int frameCount = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            if (windowEvent.type == sf::Event::Closed ||
+                (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Escape))
+            {
+                running = false;
+            }
+        }
+
+        camera = sampleCamera(simulation);
+        glm::mat4 viewProj = proj * cameraView(camera);
+        updateChunkStreamer(streamer, viewProj, camera.position, pixelScale);
+
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glUniformMatrix4fv(uniViewProj, 1, GL_FALSE, glm::value_ptr(viewProj));
+        drawChunks(streamer);
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            window.setTitle("Streaming - FPS: " + std::to_string(frameCount) + " - chunks drawn: " + std::to_string(streamer.drawList.size()) +
+                ", resident: " + std::to_string(readySlotCount(streamer.pool)) + "/" + std::to_string(streamer.pool.slots.size()) +
+                ", uploaded: " + std::to_string(streamer.pool.uploadedBytes / (1024 * 1024)) + " MB");
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    stopSimulation(simulation);
+    glDeleteProgram(program);
+    closeChunkStreamer(streamer);
+    checkGLErrors("After streaming viewer");
+    return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "chunk_file.h"
+#include "mapped_file.h"
+#include "slot_streamer.h"
+
+namespace sf
+{
+    class Window;
+}
+
+// Strumieniowanie kawakw siatki z pliku odwzorowanego w pami. Pula GPU ma sta liczb
+// miejsc wyznaczon przez limit pamici, kade mieci najwikszy kawaek. Co klatk wybierane s
+// kawaki bliskie kamerze, brakujce wczytuje wtek ta puli (slot_streamer.h), a przy braku
+// miejsca wypadaj najdawniej uywane (LRU).
+
+struct ChunkStreamer
+{
+    MappedFile file;
+    ChunkFileHeader header = {};
+    const ChunkInfo* chunks = nullptr;
+
+    uint64_t memoryBudget = 0;  // Limit pamici puli GPU w bajtach
+    uint32_t slotVertices = 0;
+    uint32_t slotIndices = 0;
+    std::vector<uint32_t> drawList;
+    std::vector<std::pair<float, uint32_t>> candidates;
+
+    GLuint vao = 0, vertexBuffer = 0, indexBuffer = 0;
+    SlotStreamer pool; // Elementy puli to numery kawakw
+};
+
+// Otwarcie pliku kawakw i utworzenie puli mieszczcej si w memoryBudget bajtach
+bool openChunkStreamer(ChunkStreamer& streamer, const std::string& path, uint64_t memoryBudget);
+void closeChunkStreamer(ChunkStreamer& streamer);
+
+// Wybr kawakw dla kamery, zlecenie brakujcych i odbir wczytanych, raz na klatk
+void updateChunkStreamer(ChunkStreamer& streamer, const glm::mat4& viewProj, const glm::vec3& cameraPos, float pixelScale);
+
+// Rysowanie wczytanych kawakw z listy ostatniej aktualizacji, atrybuty 0: pozycja, 1: normalna, 2: UV
+void drawChunks(const ChunkStreamer& streamer);
+
+// Przegldarka pliku kawakw z kamer sterowan mysz i klawiatur
+int runStreamViewer(sf::Window& window, const char* path, uint64_t memoryBudget);
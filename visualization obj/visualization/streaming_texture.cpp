@@ -0,0 +1,328 @@
+#include "streaming_texture.h"
+#include "gl_utils.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    // Wtek roboczy: wypenianie odwzorowanych buforw bez adnych wywoa GL
+    void fillLoop(StreamingTexture* stream)
+    {
+        while (true)
+        {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(stream->mutex);
+                stream->wake.wait(lock, [&]() { return !stream->running || !stream->fillQueue.empty(); });
+                if (!stream->running) break;
+                index = stream->fillQueue.front();
+                stream->fillQueue.pop_front();
+            }
+
+            PixelBuffer& buffer = stream->buffers[index];
+            stream->producer(buffer.mapped, stream->width, stream->height, buffer.frame);
+
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            stream->filled.push_back(index);
+        }
+    }
+
+    unsigned char* mapPixelBuffer(const StreamingTexture& stream, PixelBuffer& buffer)
+    {
+        // Bufor nie jest ju czytany przez GPU (pot), wic bez synchronizacji i z porzuceniem zawartoci
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+        return static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)stream.frameBytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    }
+}
+
+bool createStreamingTexture(StreamingTexture& stream, int width, int height, FrameProducer producer, int ringSize, int workerCount)
+{
+    stream.width = width;
+    stream.height = height;
+    stream.frameBytes = (size_t)width * height * 4;
+    stream.producer = producer;
+    stream.persistent = GLEW_ARB_buffer_storage != 0;
+
+    glGenTextures(1, &stream.texture);
+    glBindTexture(GL_TEXTURE_2D, stream.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    stream.buffers.assign((size_t)std::max(2, ringSize), PixelBuffer());
+    for (PixelBuffer& buffer : stream.buffers)
+    {
+        glGenBuffers(1, &buffer.buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+        if (stream.persistent)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)stream.frameBytes, nullptr, flags);
+            buffer.mapped = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)stream.frameBytes, flags));
+        }
+        else
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)stream.frameBytes, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    checkGLErrors("After creating streaming texture");
+
+    stream.running = true;
+    for (int i = 0; i < std::max(1, workerCount); i++) stream.workers.emplace_back(fillLoop, &stream);
+    return true;
+}
+
+void destroyStreamingTexture(StreamingTexture& stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.running = false;
+    }
+    stream.wake.notify_all();
+    for (std::thread& worker : stream.workers) worker.join();
+    stream.workers.clear();
+    stream.fillQueue.clear();
+    stream.filled.clear();
+
+    for (PixelBuffer& buffer : stream.buffers)
+    {
+        if (buffer.fence) glDeleteSync(buffer.fence);
+        if (buffer.mapped)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer.buffer);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stream.buffers.clear();
+    glDeleteTextures(1, &stream.texture);
+    stream.texture = 0;
+}
+
+bool updateStreamingTexture(StreamingTexture& stream)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<size_t> ready;
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        ready.swap(stream.filled);
+    }
+    for (size_t index : ready) stream.buffers[index].state = PboState::Filled;
+
+    // Tylko najnowsza wypeniona klatka trafia do tekstury, starsze wracaj do piercienia
+    int newest = -1;
+    for (size_t i = 0; i < stream.buffers.size(); i++)
+    {
+        const PixelBuffer& buffer = stream.buffers[i];
+        if (buffer.state == PboState::Filled && (newest < 0 || buffer.frame > stream.buffers[newest].frame)) newest = (int)i;
+    }
+    bool updated = false;
+    for (size_t i = 0; i < stream.buffers.size(); i++)
+    {
+        PixelBuffer& buffer = stream.buffers[i];
+        if (buffer.state != PboState::Filled) continue;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.buffer);
+        if (!stream.persistent)
+        {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            buffer.mapped = nullptr;
+        }
+        if ((int)i != newest || buffer.frame < stream.shownFrame)
+        {
+            buffer.state = PboState::Free;
+            stream.skippedFrames++;
+            continue;
+        }
+
+        // rdem jest przesunicie w buforze, wywoanie wraca bez czekania na kopiowanie
+        glBindTexture(GL_TEXTURE_2D, stream.texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, stream.width, stream.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        buffer.state = PboState::Uploading;
+        stream.shownFrame = buffer.frame;
+        stream.uploadedBytes += stream.frameBytes;
+        stream.uploadedFrames++;
+        updated = true;
+    }
+
+    // Bufory, z ktrych GPU skoczyo czyta, i oddanie wolnych wtkom roboczym
+    size_t queued = 0;
+    for (PixelBuffer& buffer : stream.buffers)
+    {
+        if (buffer.state == PboState::Uploading)
+        {
+            if (glClientWaitSync(buffer.fence, 0, 0) == GL_TIMEOUT_EXPIRED) continue;
+            glDeleteSync(buffer.fence);
+            buffer.fence = 0;
+            buffer.state = PboState::Free;
+        }
+        if (buffer.state != PboState::Free) continue;
+
+        if (!stream.persistent) buffer.mapped = mapPixelBuffer(stream, buffer);
+        if (!buffer.mapped) continue;
+        buffer.frame = stream.nextFrame++;
+        buffer.state = PboState::Filling;
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.fillQueue.push_back((size_t)(&buffer - stream.buffers.data()));
+        queued++;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (queued) stream.wake.notify_all();
+
+    stream.stallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return updated;
+}
+
+// Prostokt na cay ekran z gl_VertexID, bez bufora wierzchokw
+const GLchar* screenQuadVertexSource = R"glsl(
+    #version 330 core
+    out vec2 TexCoord;
+
+    void main()
+    {
+        vec2 corner = vec2((gl_VertexID & 1) * 2.0, (gl_VertexID & 2) * 1.0);
+        TexCoord = corner;
+        gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+    }
+)glsl";
+
+const GLchar* screenQuadFragmentSource = R"glsl(
+    #version 330 core
+    in vec2 TexCoord;
+    out vec4 outColor;
+
+    uniform sampler2D frame;
+
+    void main()
+    {
+        outColor = texture(frame, TexCoord);
+    }
+)glsl";
+
+namespace
+{
+    // Ruchomy wzr jako zastpstwo klatki wideo albo mapy ciepa
+    void fillPattern(unsigned char* pixels, int width, int height, uint64_t frame)
+    {
+        unsigned shift = (unsigned)(frame * 4);
+        for (int y = 0; y < height; y++)
+        {
+            unsigned char* row = pixels + (size_t)y * width * 4;
+            for (int x = 0; x < width; x++)
+            {
+                row[x * 4 + 0] = (unsigned char)(x + shift);
+                row[x * 4 + 1] = (unsigned char)(y + shift / 2);
+                row[x * 4 + 2] = (unsigned char)((x ^ y) + shift);
+                row[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
+
+int runStreamingTextureBenchmark(sf::Window& window, int frames)
+{
+    GLuint program = createProgram(screenQuadVertexSource, screenQuadFragmentSource, {}, "Streaming texture");
+    if (!program) return 1;
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "frame"), 0);
+    glDisable(GL_DEPTH_TEST);
+
+    // Klatki pokazywane z synchronizacj pionow, jak przy odtwarzaniu 60 Hz
+    window.setVerticalSyncEnabled(true);
+    frames = std::max(1, frames);
+    const int sizes[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    std::cout << "Streaming texture: " << frames << " frames with vertical sync, RGBA8" << std::endl;
+
+    for (const int* size : sizes)
+    {
+        int width = size[0], height = size[1];
+        double megabytes = (double)width * height * 4 / (1024.0 * 1024.0);
+
+        // Synchronicznie: wypenienie i glTexSubImage2D z pamici programu na wtku renderujcym
+        std::vector<unsigned char> pixels((size_t)width * height * 4);
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        double stall = 0.0, worstStall = 0.0;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            auto stallStart = std::chrono::steady_clock::now();
+            fillPattern(pixels.data(), width, height, (uint64_t)frame + 1);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            double frameStall = std::chrono::duration<double>(std::chrono::steady_clock::now() - stallStart).count();
+            stall += frameStall;
+            worstStall = std::max(worstStall, frameStall);
+
+            glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        glDeleteTextures(1, &texture);
+        std::cout << "  " << width << "x" << height << " synchronous: " << frames / seconds << " frames/s, "
+            << megabytes * frames / seconds << " MB/s, render thread stall " << stall / frames * 1000.0
+            << " ms/frame (worst " << worstStall * 1000.0 << " ms)" << std::endl;
+
+        // Piercie PBO: wypenianie na wtkach roboczych, wtek renderujcy tylko przecza bufory
+        StreamingTexture stream;
+        createStreamingTexture(stream, width, height, fillPattern);
+        worstStall = 0.0;
+        glFinish();
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            double before = stream.stallSeconds;
+            updateStreamingTexture(stream);
+            worstStall = std::max(worstStall, stream.stallSeconds - before);
+
+            glBindTexture(GL_TEXTURE_2D, stream.texture);
+            glBindVertexArray(vao);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            window.display();
+        }
+        glFinish();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  " << width << "x" << height << " PBO ring (" << stream.buffers.size() << " buffers"
+            << (stream.persistent ? ", persistent mapping" : "") << "): " << frames / seconds << " frames/s, "
+            << stream.uploadedFrames << " new frames shown, " << stream.skippedFrames << " skipped, "
+            << stream.uploadedBytes / (1024.0 * 1024.0) / seconds << " MB/s, render thread stall "
+            << stream.stallSeconds / frames * 1000.0 << " ms/frame (worst " << worstStall * 1000.0 << " ms)" << std::endl;
+        destroyStreamingTexture(stream);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+    checkGLErrors("After streaming texture benchmark");
+    return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Tekstura zmieniana co klatk (wideo, dane na ywo) wysyana przez piercie buforw PBO.
+// Wtek renderujcy odwzorowuje wolny bufor i oddaje wskanik wtkom roboczym, ktre wypeniaj
+// go pikselami. Wypeniony bufor trafia do tekstury przez glTexSubImage2D z GL_PIXEL_UNPACK_BUFFER,
+// wic kopiowanie odbywa si w sterowniku rwnolegle z rysowaniem, a bufor wraca do piercienia
+// po sygnale potu. Z ARB_buffer_storage bufory s odwzorowane na stae.
+
+// Wypenienie klatki RGBA8 o podanym numerze, wiersze od dou, wywoywane na wtku roboczym
+using FrameProducer = std::function<void(unsigned char* pixels, int width, int height, uint64_t frame)>;
+
+enum class PboState
+{
+    Free,      // Mona odwzorowa i odda do wypenienia
+    Filling,   // Odwzorowany, u wtku roboczego
+    Filled,    // Czeka na wysanie do tekstury
+    Uploading  // Kopiowany do tekstury, wolny po sygnale potu
+};
+
+struct PixelBuffer
+{
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr;
+    PboState state = PboState::Free;
+    GLsync fence = 0;
+    uint64_t frame = 0;
+};
+
+struct StreamingTexture
+{
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    size_t frameBytes = 0;
+    bool persistent = false;  // Bufory odwzorowane raz na cay czas ycia
+    uint64_t shownFrame = 0;  // Numer klatki ostatnio wysanej do tekstury, 0 przed pierwsz
+
+    std::vector<PixelBuffer> buffers;
+    uint64_t nextFrame = 1;
+
+    // Wtki robocze
+    FrameProducer producer;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<size_t> fillQueue;      // Bufory do wypenienia
+    std::vector<size_t> filled;        // Wypenione, odbierane przez wtek renderujcy
+    std::atomic<bool> running{ false };
+
+    // Statystyki
+    uint64_t uploadedBytes = 0;
+    uint64_t uploadedFrames = 0;
+    uint64_t skippedFrames = 0;   // Wypenione, ale zastpione nowsz przed wysaniem
+    double stallSeconds = 0.0;    // Czas wtku renderujcego spdzony w updateStreamingTexture
+};
+
+// Tekstura RGBA8 z piercieniem ringSize buforw i workerCount wtkami wypeniajcymi
+bool createStreamingTexture(StreamingTexture& stream, int width, int height, FrameProducer producer, int ringSize = 3, int workerCount = 2);
+void destroyStreamingTexture(StreamingTexture& stream);
+
+// Raz na klatk na wtku renderujcym: wysanie najnowszej wypenionej klatki, zwolnienie buforw
+// po potach i oddanie wolnych do wypenienia. Zwraca true, gdy tekstura dostaa now klatk.
+bool updateStreamingTexture(StreamingTexture& stream);
+
+// Shadery tekstury na cay ekran (sampler frame), rysowanej jako GL_TRIANGLE_STRIP z 4 wierzchokw bez atrybutw
+extern const GLchar* screenQuadVertexSource;
+extern const GLchar* screenQuadFragmentSource;
+
+// Pomiar: przepustowo wysyania i czas blokowania wtku renderujcego dla 1080p i 4K
+// przy 60 Hz, synchronicznie glTexSubImage2D z pamici programu i przez piercie PBO
+int runStreamingTextureBenchmark(sf::Window& window, int frames);
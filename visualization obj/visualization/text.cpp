@@ -0,0 +1,499 @@
+#include "text.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "mapped_file.h"
+#include "memory.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+namespace
+{
+    const uint32_t atlasCacheVersion = 1;
+
+    struct AtlasCacheHeader
+    {
+        char magic[4];         // "SDFA"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        float pixelSize;
+        int32_t padding;
+        float ascent;
+        float descent;
+        float lineGap;
+        uint32_t glyphCount;
+    };
+
+    const GLchar* textVertexSource = R"glsl(
+        #version 330 core
+        in vec4 rect;
+        in vec4 uv;
+        in vec4 color;
+        out vec2 TexCoord;
+        out vec4 Color;
+
+        uniform vec2 viewport;
+
+        void main()
+        {
+            vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+            TexCoord = mix(uv.xy, uv.zw, corner);
+            Color = color;
+            gl_Position = vec4((rect.xy + rect.zw * corner) / viewport * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )glsl";
+
+    // Kontur na wartoci 0.5, szeroko przejcia z pochodnej, wic krawd ma okoo piksela przy kadym rozmiarze
+    const GLchar* textFragmentSource = R"glsl(
+        #version 330 core
+        in vec2 TexCoord;
+        in vec4 Color;
+        out vec4 outColor;
+
+        uniform sampler2D atlas;
+
+        void main()
+        {
+            float distance = texture(atlas, TexCoord).r;
+            float edge = max(fwidth(distance) * 0.75, 1e-3);
+            float alpha = smoothstep(0.5 - edge, 0.5 + edge, distance);
+            if (alpha <= 0.0) discard;
+            outColor = vec4(Color.rgb, Color.a * alpha);
+        }
+    )glsl";
+
+    std::string atlasCachePath(const std::string& fontPath)
+    {
+        return std::filesystem::path(fontPath).filename().string() + ".sdf";
+    }
+
+    bool saveFontAtlas(const std::string& path, const FontAtlas& font)
+    {
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+        {
+            std::cerr << "Cannot create file: " << path << std::endl;
+            return false;
+        }
+        AtlasCacheHeader header = {};
+        std::memcpy(header.magic, "SDFA", 4);
+        header.version = atlasCacheVersion;
+        header.width = (uint32_t)font.width;
+        header.height = (uint32_t)font.height;
+        header.pixelSize = font.pixelSize;
+        header.padding = font.padding;
+        header.ascent = font.ascent;
+        header.descent = font.descent;
+        header.lineGap = font.lineGap;
+        header.glyphCount = glyphCount;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(font.glyphs), sizeof(font.glyphs));
+        out.write(reinterpret_cast<const char*>(font.pixels.data()), font.pixels.size());
+        if (!out.good())
+        {
+            std::cerr << "Error writing " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool loadFontCache(const std::string& path, FontAtlas& font)
+    {
+        std::ifstream in(path, std::ios::binary);
+        AtlasCacheHeader header = {};
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!in || std::memcmp(header.magic, "SDFA", 4) != 0 || header.version != atlasCacheVersion || header.glyphCount != glyphCount ||
+            header.pixelSize != font.pixelSize || header.padding != font.padding)
+        {
+            return false;
+        }
+        font.width = (int)header.width;
+        font.height = (int)header.height;
+        font.ascent = header.ascent;
+        font.descent = header.descent;
+        font.lineGap = header.lineGap;
+        font.pixels.resize((size_t)font.width * font.height);
+        in.read(reinterpret_cast<char*>(font.glyphs), sizeof(font.glyphs));
+        in.read(reinterpret_cast<char*>(font.pixels.data()), font.pixels.size());
+        if (!in)
+        {
+            std::cerr << "Truncated font atlas file: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Pola odlegoci znakw liczone rwnolegle, potem uoone pkami w atlasie o staej szerokoci
+    bool buildFontAtlas(FontAtlas& font, const std::string& fontPath)
+    {
+        MappedFile file;
+        if (!mapFile(file, fontPath)) return false;
+        stbtt_fontinfo info;
+        if (!stbtt_InitFont(&info, file.data, stbtt_GetFontOffsetForIndex(file.data, 0)))
+        {
+            std::cerr << "Not a TrueType font: " << fontPath << std::endl;
+            unmapFile(file);
+            return false;
+        }
+        float scale = stbtt_ScaleForPixelHeight(&info, font.pixelSize);
+        int ascent, descent, lineGap;
+        stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+        font.ascent = ascent * scale / font.pixelSize;
+        font.descent = descent * scale / font.pixelSize;
+        font.lineGap = lineGap * scale / font.pixelSize;
+
+        struct GlyphBitmap
+        {
+            unsigned char* data;
+            int width, height, xOffset, yOffset;
+        };
+        GlyphBitmap bitmaps[glyphCount] = {};
+        parallelFor(glyphCount, [&](unsigned first, unsigned last)
+        {
+            for (unsigned i = first; i < last; i++)
+            {
+                GlyphBitmap& bitmap = bitmaps[i];
+                bitmap.data = stbtt_GetCodepointSDF(&info, scale, firstGlyph + (int)i, font.padding, 128, 128.0f / font.padding,
+                    &bitmap.width, &bitmap.height, &bitmap.xOffset, &bitmap.yOffset);
+                if (!bitmap.data) bitmap.width = bitmap.height = 0;
+            }
+        });
+
+        int x = 1, y = 1, rowHeight = 0;
+        int positions[glyphCount][2];
+        for (int i = 0; i < glyphCount; i++)
+        {
+            if (x + bitmaps[i].width + 1 > font.width)
+            {
+                x = 1;
+                y += rowHeight + 1;
+                rowHeight = 0;
+            }
+            positions[i][0] = x;
+            positions[i][1] = y;
+            x += bitmaps[i].width + 1;
+            rowHeight = std::max(rowHeight, bitmaps[i].height);
+        }
+        font.height = (y + rowHeight + 1 + 3) / 4 * 4;
+        font.pixels.assign((size_t)font.width * font.height, 0);
+
+        for (int i = 0; i < glyphCount; i++)
+        {
+            const GlyphBitmap& bitmap = bitmaps[i];
+            int px = positions[i][0], py = positions[i][1];
+            for (int row = 0; row < bitmap.height; row++)
+            {
+                std::memcpy(&font.pixels[(size_t)(py + row) * font.width + px], bitmap.data + (size_t)row * bitmap.width, bitmap.width);
+            }
+            // Wiersz 0 bitmapy to gra znaku, w atlasie ley przy mniejszym v
+            int advance, leftBearing;
+            stbtt_GetCodepointHMetrics(&info, firstGlyph + i, &advance, &leftBearing);
+            Glyph& glyph = font.glyphs[i];
+            glyph.x0 = bitmap.xOffset / font.pixelSize;
+            glyph.x1 = (bitmap.xOffset + bitmap.width) / font.pixelSize;
+            glyph.y0 = -(bitmap.yOffset + bitmap.height) / font.pixelSize;
+            glyph.y1 = -bitmap.yOffset / font.pixelSize;
+            glyph.u0 = (float)px / font.width;
+            glyph.u1 = (float)(px + bitmap.width) / font.width;
+            glyph.v0 = (float)(py + bitmap.height) / font.height;
+            glyph.v1 = (float)py / font.height;
+            glyph.advance = advance * scale / font.pixelSize;
+            if (bitmap.data) stbtt_FreeSDF(bitmap.data, nullptr);
+        }
+        unmapFile(file);
+        return true;
+    }
+
+    uint32_t packColor(const glm::vec4& color)
+    {
+        auto channel = [](float value) { return (uint32_t)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+        return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | channel(color.a) << 24;
+    }
+
+    const Glyph& glyphFor(const FontAtlas& font, char c)
+    {
+        int index = (unsigned char)c - firstGlyph;
+        return font.glyphs[index >= 0 && index < glyphCount ? index : '?' - firstGlyph];
+    }
+
+    // Miejsce na kolejne znaki: tablica ronie w miejscu, gdy jest ostatnim przydziaem klatki,
+    // inaczej nowa tablica w pamici klatki, a stara zostaje do koca klatki
+    void reserveGlyphs(TextBatch& batch, size_t extra)
+    {
+        if (batch.count + extra <= batch.capacity) return;
+        size_t capacity = std::max(std::max(batch.capacity * 2, batch.count + extra), (size_t)1024);
+        if (frameGrow(*batch.frame, batch.glyphs, batch.capacity * sizeof(TextGlyph), capacity * sizeof(TextGlyph)))
+        {
+            batch.capacity = capacity;
+            return;
+        }
+        TextGlyph* glyphs = static_cast<TextGlyph*>(frameAllocate(*batch.frame, capacity * sizeof(TextGlyph), alignof(TextGlyph)));
+        if (batch.count) std::memcpy(glyphs, batch.glyphs, batch.count * sizeof(TextGlyph));
+        batch.glyphs = glyphs;
+        batch.capacity = capacity;
+    }
+}
+
+const char* defaultFontPath()
+{
+#ifdef _WIN32
+    return "C:/Windows/Fonts/arial.ttf";
+#else
+    return "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf";
+#endif
+}
+
+bool loadFontAtlas(FontAtlas& font, const std::string& fontPath)
+{
+    const std::string cachePath = atlasCachePath(fontPath);
+    std::error_code error;
+    auto fontTime = std::filesystem::last_write_time(fontPath, error);
+    if (error)
+    {
+        std::cerr << "Cannot open file: " << fontPath << std::endl;
+        return false;
+    }
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (!error && cacheTime >= fontTime && loadFontCache(cachePath, font)) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!buildFontAtlas(font, fontPath)) return false;
+    std::cout << "Built font atlas " << cachePath << ": " << font.width << "x" << font.height << " in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+    saveFontAtlas(cachePath, font);
+    return true;
+}
+
+bool createTextRenderer(TextBatch& batch, const std::string& fontPath)
+{
+    if (!loadFontAtlas(batch.font, fontPath)) return false;
+
+    glGenTextures(1, &batch.font.texture);
+    glBindTexture(GL_TEXTURE_2D, batch.font.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, batch.font.width, batch.font.height, 0, GL_RED, GL_UNSIGNED_BYTE, batch.font.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    batch.program = createProgram(textVertexSource, textFragmentSource, { "rect", "uv", "color" }, "Text");
+    if (!batch.program) return false;
+    batch.uniViewport = glGetUniformLocation(batch.program, "viewport");
+    glUseProgram(batch.program);
+    glUniform1i(glGetUniformLocation(batch.program, "atlas"), 0);
+
+    glGenVertexArrays(1, &batch.vao);
+    glGenBuffers(1, &batch.buffer);
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextGlyph), (void*)offsetof(TextGlyph, rect));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(TextGlyph), (void*)offsetof(TextGlyph, uv));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(TextGlyph), (void*)offsetof(TextGlyph, color));
+    for (GLuint attribute = 0; attribute < 3; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    glBindVertexArray(0);
+    checkGLErrors("After text renderer setup");
+    return true;
+}
+
+void destroyTextRenderer(TextBatch& batch)
+{
+    glDeleteTextures(1, &batch.font.texture);
+    glDeleteProgram(batch.program);
+    glDeleteVertexArrays(1, &batch.vao);
+    glDeleteBuffers(1, &batch.buffer);
+    batch = TextBatch();
+}
+
+void beginText(TextBatch& batch, FrameAllocator& allocator)
+{
+    batch.frame = &allocator;
+    batch.glyphs = nullptr;
+    batch.count = batch.capacity = 0;
+}
+
+float textWidth(const FontAtlas& font, const char* text, float size)
+{
+    float width = 0.0f, line = 0.0f;
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '\n')
+        {
+            width = std::max(width, line);
+            line = 0.0f;
+            continue;
+        }
+        line += glyphFor(font, *c).advance * size;
+    }
+    return std::max(width, line);
+}
+
+float addText(TextBatch& batch, const char* text, const glm::vec2& position, float size, const glm::vec4& color, TextAlign align)
+{
+    size_t length = std::strlen(text);
+    reserveGlyphs(batch, length);
+    float width = textWidth(batch.font, text, size);
+    float left = position.x - (align == TextAlign::Center ? width * 0.5f : align == TextAlign::Right ? width : 0.0f);
+    float lineHeight = (batch.font.ascent - batch.font.descent + batch.font.lineGap) * size;
+    uint32_t packed = packColor(color);
+
+    glm::vec2 pen(left, position.y);
+    for (size_t i = 0; i < length; i++)
+    {
+        if (text[i] == '\n')
+        {
+            pen = glm::vec2(left, pen.y - lineHeight);
+            continue;
+        }
+        const Glyph& glyph = glyphFor(batch.font, text[i]);
+        if (glyph.x1 > glyph.x0)
+        {
+            TextGlyph& out = batch.glyphs[batch.count++];
+            out.rect = glm::vec4(pen.x + glyph.x0 * size, pen.y + glyph.y0 * size, (glyph.x1 - glyph.x0) * size, (glyph.y1 - glyph.y0) * size);
+            out.uv = glm::vec4(glyph.u0, glyph.v0, glyph.u1, glyph.v1);
+            out.color = packed;
+        }
+        pen.x += glyph.advance * size;
+    }
+    return width;
+}
+
+void drawText(TextBatch& batch, int viewportWidth, int viewportHeight)
+{
+    batch.drawnGlyphs = batch.count;
+    if (batch.count == 0) return;
+
+    // Porzucenie poprzedniej zawartoci bufora, jak przy liniach wykresu
+    glBindVertexArray(batch.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, batch.buffer);
+    batch.bufferCapacity = std::max(batch.bufferCapacity, batch.count);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(batch.bufferCapacity * sizeof(TextGlyph)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(batch.count * sizeof(TextGlyph)), batch.glyphs);
+
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(batch.program);
+    glUniform2f(batch.uniViewport, (float)viewportWidth, (float)viewportHeight);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, batch.font.texture);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)batch.count);
+    glBindVertexArray(0);
+    if (!blend) glDisable(GL_BLEND);
+    batch.count = 0;
+}
+
+double niceTickStep(double span, int ticks)
+{
+    double raw = span / std::max(ticks, 1);
+    if (!(raw > 0.0)) return 1.0;
+    double power = std::pow(10.0, std::floor(std::log10(raw)));
+    double fraction = raw / power;
+    return (fraction <= 1.0 ? 1.0 : fraction <= 2.0 ? 2.0 : fraction <= 5.0 ? 5.0 : 10.0) * power;
+}
+
+int runTextBenchmark(sf::Window& window, int labels)
+{
+    // Atlas budowany od nowa i wczytywany z pliku
+    const std::string fontPath = defaultFontPath();
+    std::remove(atlasCachePath(fontPath).c_str());
+    FontAtlas built, cached;
+    if (!loadFontAtlas(built, fontPath)) return 1;
+    auto start = std::chrono::steady_clock::now();
+    if (!loadFontAtlas(cached, fontPath)) return 1;
+    std::cout << "  atlas loaded from " << atlasCachePath(fontPath) << " in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+
+    TextBatch batch;
+    if (!createTextRenderer(batch, fontPath)) return 1;
+    window.setVerticalSyncEnabled(false);
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+
+    // Etykiety liczb w losowych miejscach, jak wartoci punktw wykresu
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<glm::vec3> points(std::max(labels, 1));
+    for (glm::vec3& point : points) point = glm::vec3(unit(random) * width, unit(random) * height, unit(random) * 1000.0f - 500.0f);
+
+    FrameAllocator frameMemory;
+    const int frames = 30;
+    std::vector<int> counts;
+    for (int count : { 1000, 10000 })
+    {
+        if (count < labels) counts.push_back(count);
+    }
+    counts.push_back(labels);
+    for (int count : counts)
+    {
+        double layoutSeconds = 0.0;
+        size_t glyphs = 0;
+        glFinish();
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            beginFrameMemory(frameMemory);
+            auto layoutStart = std::chrono::steady_clock::now();
+            beginText(batch, frameMemory);
+            for (int i = 0; i < count; i++)
+            {
+                const glm::vec3& point = points[i];
+                addText(batch, frameFormat(frameMemory, "%.4g", point.z + frame), glm::vec2(point.x, point.y), 12.0f,
+                    glm::vec4(0.9f, 0.9f, 0.9f, 1.0f), TextAlign::Center);
+            }
+            layoutSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - layoutStart).count();
+            glClear(GL_COLOR_BUFFER_BIT);
+            drawText(batch, width, height);
+            glyphs = batch.drawnGlyphs;
+            window.display();
+        }
+        glFinish();
+        double frameMs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / frames;
+        std::cout << "  " << count << " labels, " << glyphs << " glyphs/frame: layout " << layoutSeconds * 1000.0 / frames << " ms ("
+            << glyphs * frames / layoutSeconds / 1e6 << " M glyphs/s), frame " << frameMs << " ms, 1 draw call" << std::endl;
+    }
+
+    // Dla porwnania jedno wywoanie na etykiet
+    int separate = std::min(labels, 2000);
+    glFinish();
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        beginFrameMemory(frameMemory);
+        beginText(batch, frameMemory);
+        glClear(GL_COLOR_BUFFER_BIT);
+        for (int i = 0; i < separate; i++)
+        {
+            const glm::vec3& point = points[i];
+            addText(batch, frameFormat(frameMemory, "%.4g", point.z + frame), glm::vec2(point.x, point.y), 12.0f,
+                glm::vec4(0.9f, 0.9f, 0.9f, 1.0f), TextAlign::Center);
+            drawText(batch, width, height);
+        }
+        window.display();
+    }
+    glFinish();
+    std::cout << "  " << separate << " labels, one draw call each: frame "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / frames << " ms" << std::endl;
+
+    releaseFrameAllocator(frameMemory);
+    destroyTextRenderer(batch);
+    checkGLErrors("After text benchmark");
+    return 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+struct FrameAllocator;
+
+// Tekst z atlasu pl odlegoci (SDF): kady znak ASCII raz zamieniony na odlego od konturu
+// w pikselach atlasu, wic jedna tekstura wystarcza na kady rozmiar, a krawd wycina shader.
+// Atlas jest budowany z pliku TTF przy pierwszym uyciu i zapisywany obok programu. Etykiety
+// dopisywane w klatce trafiaj do tablicy instancji w pamici klatki, cao to jedno wysanie
+// bufora i jedno wywoanie rysowania.
+
+const int firstGlyph = 32;
+const int glyphCount = 95; // Znaki ASCII od spacji do tyldy
+
+// Prostokt znaku wzgldem pira na linii bazowej i jego miejsce w atlasie, w jednostkach wysokoci czcionki
+struct Glyph
+{
+    float x0, y0, x1, y1; // y w gr
+    float u0, v0, u1, v1;
+    float advance;
+};
+
+struct FontAtlas
+{
+    float pixelSize = 48.0f; // Wysoko czcionki w atlasie
+    int padding = 6;         // Zasig pola odlegoci w pikselach atlasu
+    int width = 512, height = 0;
+    float ascent = 0.0f, descent = 0.0f, lineGap = 0.0f;
+    Glyph glyphs[glyphCount] = {};
+    std::vector<unsigned char> pixels;
+    GLuint texture = 0;
+};
+
+// Jedna instancja to prostokt znaku w pikselach okna (left, bottom, width, height)
+struct TextGlyph
+{
+    glm::vec4 rect;
+    glm::vec4 uv;
+    uint32_t color;
+};
+
+enum class TextAlign
+{
+    Left,
+    Center,
+    Right
+};
+
+struct TextBatch
+{
+    FontAtlas font;
+    GLuint program = 0, vao = 0, buffer = 0;
+    GLint uniViewport = -1;
+    size_t bufferCapacity = 0; // Instancje w buforze GPU
+
+    FrameAllocator* frame = nullptr;
+    TextGlyph* glyphs = nullptr; // Tablica w pamici klatki
+    size_t count = 0, capacity = 0;
+    size_t drawnGlyphs = 0;      // Znaki ostatniego rysowania
+};
+
+// Czcionka systemowa, gdy nie podano innej
+const char* defaultFontPath();
+
+// Atlas z pliku nazwa.ttf.sdf w katalogu roboczym albo zbudowany od nowa, gdy pliku nie ma lub czcionka jest nowsza
+bool loadFontAtlas(FontAtlas& font, const std::string& fontPath);
+bool createTextRenderer(TextBatch& batch, const std::string& fontPath);
+void destroyTextRenderer(TextBatch& batch);
+
+// Pocztek etykiet klatki, tablica instancji ronie w pamici allocator
+void beginText(TextBatch& batch, FrameAllocator& allocator);
+
+// Etykieta z lini bazow w position (piksele od lewego dolnego rogu), size to wysoko czcionki w pikselach.
+// Zwraca szeroko w pikselach.
+float addText(TextBatch& batch, const char* text, const glm::vec2& position, float size, const glm::vec4& color,
+    TextAlign align = TextAlign::Left);
+float textWidth(const FontAtlas& font, const char* text, float size);
+
+// Wszystkie etykiety od beginText jednym wywoaniem
+void drawText(TextBatch& batch, int viewportWidth, int viewportHeight);
+
+// Krok podziaki 1, 2 albo 5 razy potga dziesiciu, dajcy najwyej okoo ticks kresek na span
+double niceTickStep(double span, int ticks);
+
+// Pomiar: budowa i wczytanie atlasu, czas ukadania i klatki dla rosncej liczby etykiet
+int runTextBenchmark(sf::Window& window, int labels);
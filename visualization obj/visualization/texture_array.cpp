@@ -0,0 +1,286 @@
+#include "texture_array.h"
+#include "gl_utils.h"
+#include "indirect_draw.h"
+#include "lod.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+bool createTextureArray(TextureArray& array, const std::vector<TextureImage>& images, const std::vector<std::string>& names)
+{
+    if (images.empty()) return false;
+
+    array.width = images[0].width;
+    array.height = images[0].height;
+    array.names = names;
+    array.names.resize(images.size());
+
+    glGenTextures(1, &array.texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    // Wszystkie poziomy od razu, bez glGenerateMipmap po wysaniu
+    int levelCount = mipLevelCount(array.width, array.height);
+    for (int level = 0, width = array.width, height = array.height; level < levelCount; level++)
+    {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, (GLsizei)images.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    TextureImage resized;
+    std::vector<TextureImage> levels;
+    for (size_t layer = 0; layer < images.size(); layer++)
+    {
+        const TextureImage* image = &images[layer];
+        if (image->width != array.width || image->height != array.height)
+        {
+            resampleImage(*image, array.width, array.height, resized);
+            image = &resized;
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, array.width, array.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels.data());
+
+        generateMipChain(*image, levels);
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level + 1, 0, 0, (GLint)layer, levels[level].width, levels[level].height, 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, levels[level].pixels.data());
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    checkGLErrors("After creating texture array");
+    return true;
+}
+
+bool loadTextureArray(TextureArray& array, const std::vector<std::string>& paths)
+{
+    std::vector<TextureImage> images;
+    std::vector<std::string> names;
+    for (const std::string& path : paths)
+    {
+        TextureImage image;
+        if (!loadTextureImage(path, image)) continue;
+        images.push_back(std::move(image));
+        names.push_back(path);
+    }
+    return createTextureArray(array, images, names);
+}
+
+int textureLayer(const TextureArray& array, const std::string& name)
+{
+    auto found = std::find(array.names.begin(), array.names.end(), name);
+    return found != array.names.end() ? (int)(found - array.names.begin()) : -1;
+}
+
+void destroyTextureArray(TextureArray& array)
+{
+    if (array.texture) glDeleteTextures(1, &array.texture);
+    array = TextureArray();
+}
+
+namespace
+{
+    // Shadery obu wariantw pomiaru, kolor obiektu mnoony przez tekstur
+    const GLchar* arrayFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        in vec4 Color;
+        flat in float Layer;
+        out vec4 outColor;
+
+        uniform sampler2DArray textures;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            outColor = vec4(texture(textures, vec3(TexCoord, Layer)).rgb * Color.rgb * light, Color.a);
+        }
+    )glsl";
+
+    const GLchar* separateFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 Normal;
+        in vec2 TexCoord;
+        in vec4 Color;
+        out vec4 outColor;
+
+        uniform sampler2D texture1;
+
+        void main()
+        {
+            float light = 0.2 + 0.8 * max(dot(normalize(Normal), normalize(vec3(0.3, 1.0, 0.5))), 0.0);
+            outColor = vec4(texture(texture1, TexCoord).rgb * Color.rgb * light, Color.a);
+        }
+    )glsl";
+
+    // Obraz w paski o rnej szerokoci i kolorze dla kadej warstwy
+    TextureImage stripeImage(int index, int size)
+    {
+        TextureImage image;
+        image.width = image.height = size;
+        image.pixels.resize((size_t)size * size * 4);
+        int period = 4 + 2 * (index % 8);
+        for (int y = 0; y < size; y++)
+        {
+            for (int x = 0; x < size; x++)
+            {
+                bool stripe = ((x + y * (index % 3)) / period) % 2 == 0;
+                unsigned char* p = &image.pixels[((size_t)y * size + x) * 4];
+                p[0] = (unsigned char)(stripe ? 60 + 37 * index % 196 : 230);
+                p[1] = (unsigned char)(stripe ? 90 + 53 * index % 166 : 230);
+                p[2] = (unsigned char)(stripe ? 120 + 71 * index % 136 : 230);
+                p[3] = 255;
+            }
+        }
+        return image;
+    }
+}
+
+int runTextureArrayBenchmark(sf::Window& window, int objectCount, int textureCount)
+{
+    Mesh meshes[2];
+    if (!loadMesh("chair.obj", meshes[0]) || !loadMesh("table.obj", meshes[1])) return 1;
+    textureCount = std::max(1, textureCount);
+
+    std::vector<TextureImage> images;
+    std::vector<std::string> names;
+    for (int i = 0; i < textureCount; i++)
+    {
+        images.push_back(stripeImage(i, 256));
+        names.push_back("stripes" + std::to_string(i));
+    }
+
+    // Wczytywanie: osobne tekstury 2D kontra jedna tablica z tych samych obrazw
+    glFinish();
+    auto loadStart = std::chrono::steady_clock::now();
+    std::vector<GLuint> separate(textureCount);
+    glGenTextures(textureCount, separate.data());
+    for (int i = 0; i < textureCount; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, separate[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, images[i].width, images[i].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, images[i].pixels.data());
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glFinish();
+    double separateLoad = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    loadStart = std::chrono::steady_clock::now();
+    TextureArray array;
+    createTextureArray(array, images, names);
+    glFinish();
+    double arrayLoad = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    // Obiekty z losowo przypisanymi teksturami, materia odpowiada teksturze dla wariantu osobnych tekstur
+    IndirectRenderer renderer;
+    for (const Mesh& mesh : meshes) addPooledMesh(renderer, mesh);
+    int side = std::max(1, (int)std::ceil(std::sqrt((double)objectCount)));
+    float spacing = std::max(meshes[0].radius, meshes[1].radius) * 2.5f;
+    for (int i = 0; i < objectCount; i++)
+    {
+        DrawObject object;
+        object.mesh = (uint32_t)(i % 2);
+        object.layer = (i * 7919) % textureCount;
+        object.material = (uint32_t)object.layer;
+        object.model = glm::translate(glm::mat4(1.0f), glm::vec3((i % side) * spacing, 0.0f, (i / side) * spacing));
+        object.color = glm::vec4(1.0f);
+        renderer.objects.push_back(object);
+    }
+    renderer.materialCount = (uint32_t)textureCount;
+    createIndirectRenderer(renderer);
+
+    GLuint separateProgram = createProgram(indirectVertexSource, separateFragmentSource, { "position", "normal", "texCoord", "drawId" }, "Separate textures");
+    GLuint arrayProgram = createProgram(indirectVertexSource, arrayFragmentSource, { "position", "normal", "texCoord", "drawId" }, "Texture array");
+    if (!separateProgram || !arrayProgram) return 1;
+
+    float extent = side * spacing;
+    glm::vec3 cameraPos(-spacing, spacing * 3.0f, -spacing);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(extent * 0.5f, 0.0f, extent * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    float fov = glm::radians(45.0f);
+    glm::mat4 viewProj = glm::perspective(fov, (float)width / height, spacing * 0.05f, extent * 2.0f) * view;
+    float pixelScale = pixelsPerUnit(fov, height);
+    for (GLuint program : { separateProgram, arrayProgram })
+    {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "viewProj"), 1, GL_FALSE, glm::value_ptr(viewProj));
+        glUniform1i(glGetUniformLocation(program, "drawData"), 0);
+        glUniform1i(glGetUniformLocation(program, "texture1"), 1);
+        glUniform1i(glGetUniformLocation(program, "textures"), 1);
+    }
+
+    window.setVerticalSyncEnabled(false);
+    glEnable(GL_DEPTH_TEST);
+    std::cout << "Texture array: " << objectCount << " objects, " << textureCount << " textures of 256x256" << std::endl;
+    std::cout << "  loading: separate textures " << separateLoad * 1000.0 << " ms, texture array " << arrayLoad * 1000.0 << " ms" << std::endl;
+
+    const int frames = 100;
+    for (int useArray = 0; useArray < 2; useArray++)
+    {
+        // Osobne tekstury: jedno wywoanie na tekstur, tablica: jedno na wszystko
+        renderer.materialCount = useArray ? 1 : (uint32_t)textureCount;
+        for (size_t i = 0; i < renderer.objects.size(); i++)
+        {
+            renderer.objects[i].material = useArray ? 0 : (uint32_t)renderer.objects[i].layer;
+        }
+
+        unsigned drawCalls = 0;
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            cullIndirect(renderer, viewProj, cameraPos, pixelScale, 1.0f);
+            glUseProgram(useArray ? arrayProgram : separateProgram);
+            glActiveTexture(GL_TEXTURE1);
+            if (useArray) glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            for (uint32_t material = 0; material < renderer.materialCount; material++)
+            {
+                if (!useArray)
+                {
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, separate[material]);
+                }
+                drawIndirect(renderer, material);
+            }
+            drawCalls = renderer.drawCalls;
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << (useArray ? "  texture array: " : "  separate textures: ") << drawCalls << " draw calls, frame "
+            << seconds / frames * 1000.0 << " ms" << std::endl;
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glDeleteProgram(separateProgram);
+    glDeleteProgram(arrayProgram);
+    glDeleteTextures(textureCount, separate.data());
+    destroyTextureArray(array);
+    destroyIndirectRenderer(renderer);
+    for (Mesh& mesh : meshes) destroyMesh(mesh);
+    checkGLErrors("After texture array benchmark");
+    return 0;
+}
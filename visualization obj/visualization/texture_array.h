@@ -0,0 +1,37 @@
+#pragma once
+#include <GL/glew.h>
+#include "image_pipeline.h"
+#include <string>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Tekstury jednego rozmiaru i formatu jako warstwy GL_TEXTURE_2D_ARRAY. Obiekt niesie numer
+// warstwy zamiast wasnej tekstury, wic obiekty z rnymi teksturami mieszcz si w jednym
+// wywoaniu rysowania. Obrazy innego rozmiaru s przeskalowywane przy wczytywaniu.
+
+struct TextureArray
+{
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<std::string> names; // Nazwa kadej warstwy
+};
+
+// Tablica z podanych obrazw, rozmiar warstw wedug pierwszego obrazu, mipmapy liczone
+// na CPU (generateMipChain) i wysyane poziom po poziomie
+bool createTextureArray(TextureArray& array, const std::vector<TextureImage>& images, const std::vector<std::string>& names);
+
+// Wczytanie plikw do tablicy, pliki, ktrych nie udao si wczyta, nie dostaj warstwy
+bool loadTextureArray(TextureArray& array, const std::vector<std::string>& paths);
+
+// Warstwa o podanej nazwie, -1 gdy jej brak
+int textureLayer(const TextureArray& array, const std::string& name);
+
+void destroyTextureArray(TextureArray& array);
+
+// Pomiar: czas wczytywania i klatki dla osobnych tekstur i dla tablicy tekstur
+int runTextureArrayBenchmark(sf::Window& window, int objectCount, int textureCount);
@@ -0,0 +1,555 @@
+#include "time_series.h"
+#include "gl_utils.h"
+#include "memory.h"
+#include "text.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+    void merge(MinMax& range, float value)
+    {
+        range.min = std::min(range.min, value);
+        range.max = std::max(range.max, value);
+    }
+
+    void merge(MinMax& range, const MinMax& other)
+    {
+        range.min = std::min(range.min, other.min);
+        range.max = std::max(range.max, other.max);
+    }
+
+    MinMax emptyRange()
+    {
+        return MinMax{ std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+    }
+
+    // Element poziomu level, -1 to same prbki
+    MinMax levelEntry(const TimeSeries& series, int level, uint64_t index)
+    {
+        if (level < 0)
+        {
+            float value = series.samples[index];
+            return MinMax{ value, value };
+        }
+        return series.levels[level][index];
+    }
+}
+
+void appendSamples(TimeSeries& series, const float* values, size_t count)
+{
+    uint64_t begin = series.samples.size;
+    for (size_t i = 0; i < count; i++) series.samples.push_back(values[i]);
+    uint64_t end = series.samples.size;
+
+    // Na kadym poziomie przeliczane s tylko bloki nad zmienionym zakresem poziomu niszego
+    for (size_t level = 0;; level++)
+    {
+        uint64_t belowSize = level == 0 ? series.samples.size : series.levels[level - 1].size;
+        if (level == series.levels.size())
+        {
+            // Nowy poziom dopiero, gdy niszy ma wicej ni jeden blok
+            if (belowSize <= (uint64_t)pyramidFanout) break;
+            series.levels.emplace_back();
+            begin = 0;
+            end = belowSize;
+        }
+
+        ChunkedColumn<MinMax>& blocks = series.levels[level];
+        uint64_t blockBegin = begin / pyramidFanout;
+        uint64_t blockEnd = (end + pyramidFanout - 1) / pyramidFanout;
+        for (uint64_t block = blockBegin; block < blockEnd; block++)
+        {
+            MinMax range = emptyRange();
+            uint64_t childEnd = std::min(belowSize, (block + 1) * pyramidFanout);
+            for (uint64_t child = block * pyramidFanout; child < childEnd; child++)
+            {
+                merge(range, levelEntry(series, (int)level - 1, child));
+            }
+            if (block < blocks.size) blocks[block] = range;
+            else blocks.push_back(range);
+        }
+        begin = blockBegin;
+        end = blockEnd;
+    }
+}
+
+MinMax seriesRange(const TimeSeries& series, uint64_t begin, uint64_t end)
+{
+    MinMax range = emptyRange();
+    end = std::min(end, series.samples.size);
+
+    // Niewyrwnane brzegi na biecym poziomie, rodek poziom wyej
+    int level = -1;
+    while (begin < end)
+    {
+        if (level + 1 < (int)series.levels.size() && end - begin > (uint64_t)(2 * pyramidFanout))
+        {
+            while (begin % pyramidFanout) merge(range, levelEntry(series, level, begin++));
+            while (end % pyramidFanout) merge(range, levelEntry(series, level, --end));
+            begin /= pyramidFanout;
+            end /= pyramidFanout;
+            level++;
+            continue;
+        }
+        while (begin < end) merge(range, levelEntry(series, level, begin++));
+    }
+    return range;
+}
+
+MinMax decimateSeries(const TimeSeries& series, double first, double last, int columns, std::vector<glm::vec2>& points)
+{
+    points.clear();
+    MinMax range = emptyRange();
+    uint64_t size = series.samples.size;
+    if (columns <= 0 || last <= first || size == 0 || last <= 0.0 || first >= (double)size) return MinMax{ 0.0f, 0.0f };
+    // Skala z caego widoku, take gdy wychodzi poza prbki: dane zajmuj tylko swoje kolumny
+    double perColumn = (last - first) / columns;
+
+    // Przy duym przyblieniu same prbki, z jedn za kad krawdzi, eby linia dochodzia do brzegw
+    if (perColumn <= 2.0)
+    {
+        uint64_t begin = (uint64_t)std::max(std::floor(first), 0.0);
+        if (begin > 0) begin--;
+        uint64_t end = (uint64_t)std::min((double)size, std::ceil(last) + 1.0);
+        for (uint64_t i = begin; i < end; i++)
+        {
+            float value = series.samples[i];
+            points.push_back(glm::vec2((float)((i - first) / perColumn), value));
+            merge(range, value);
+        }
+        return range;
+    }
+
+    // Tylko kolumny nachodzce na prbki [0, size)
+    int firstColumn = (int)std::max(std::floor(-first / perColumn), 0.0);
+    int lastColumn = (int)std::min(std::ceil(((double)size - first) / perColumn), (double)columns);
+    for (int column = firstColumn; column < lastColumn; column++)
+    {
+        uint64_t begin = (uint64_t)std::max(first + column * perColumn, 0.0);
+        uint64_t end = (uint64_t)std::min(first + (column + 1) * perColumn, (double)size);
+        if (end <= begin) continue;
+        MinMax columnRange = seriesRange(series, begin, end);
+        merge(range, columnRange);
+
+        // Najpierw koniec bliszy poprzedniemu punktowi, eby linia nie przeskakiwaa przez ca kolumn
+        float x = column + 0.5f;
+        if (!points.empty() && std::fabs(points.back().y - columnRange.max) < std::fabs(points.back().y - columnRange.min))
+        {
+            points.push_back(glm::vec2(x, columnRange.max));
+            points.push_back(glm::vec2(x, columnRange.min));
+        }
+        else
+        {
+            points.push_back(glm::vec2(x, columnRange.min));
+            points.push_back(glm::vec2(x, columnRange.max));
+        }
+    }
+    return range;
+}
+
+namespace
+{
+    // Kada instancja to prostokt wzdu jednego odcinka, przeduony o p gruboci na zczach
+    const GLchar* lineVertexSource = R"glsl(
+        #version 330 core
+        in vec2 pointA;
+        in vec2 pointB;
+
+        uniform vec2 viewport;
+        uniform vec4 area;
+        uniform vec2 valueRange;
+        uniform float thickness;
+
+        vec2 toPixels(vec2 point)
+        {
+            return vec2(area.x + point.x, area.y + (point.y - valueRange.x) / (valueRange.y - valueRange.x) * area.w);
+        }
+
+        void main()
+        {
+            vec2 a = toPixels(pointA);
+            vec2 b = toPixels(pointB);
+            vec2 direction = b - a;
+            float len = length(direction);
+            direction = len > 1e-4 ? direction / len : vec2(1.0, 0.0);
+            vec2 along = direction * thickness * 0.5;
+            vec2 across = vec2(-direction.y, direction.x) * thickness * 0.5;
+
+            vec2 position = (gl_VertexID < 2 ? a - along : b + along) + ((gl_VertexID & 1) == 0 ? -across : across);
+            gl_Position = vec4(position / viewport * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )glsl";
+
+    const GLchar* lineFragmentSource = R"glsl(
+        #version 330 core
+        out vec4 outColor;
+
+        uniform vec4 color;
+
+        void main()
+        {
+            outColor = color;
+        }
+    )glsl";
+}
+
+bool createLinePlot(LinePlot& plot)
+{
+    plot.program = createProgram(lineVertexSource, lineFragmentSource, { "pointA", "pointB" }, "Line plot");
+    if (!plot.program) return false;
+    plot.uniViewport = glGetUniformLocation(plot.program, "viewport");
+    plot.uniArea = glGetUniformLocation(plot.program, "area");
+    plot.uniValueRange = glGetUniformLocation(plot.program, "valueRange");
+    plot.uniThickness = glGetUniformLocation(plot.program, "thickness");
+    plot.uniColor = glGetUniformLocation(plot.program, "color");
+
+    glGenVertexArrays(1, &plot.vao);
+    glGenBuffers(1, &plot.buffer);
+    glBindVertexArray(plot.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, plot.buffer);
+    for (GLuint attribute = 0; attribute < 2; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+    glBindVertexArray(0);
+    return true;
+}
+
+void destroyLinePlot(LinePlot& plot)
+{
+    glDeleteProgram(plot.program);
+    glDeleteVertexArrays(1, &plot.vao);
+    glDeleteBuffers(1, &plot.buffer);
+    plot = LinePlot();
+}
+
+void drawLine(LinePlot& plot, const std::vector<glm::vec2>& points, const glm::vec4& area, MinMax valueRange,
+    float thickness, const glm::vec4& color, int viewportWidth, int viewportHeight)
+{
+    if (points.size() < 2) return;
+    if (valueRange.max - valueRange.min < 1e-12f)
+    {
+        valueRange.min -= 0.5f;
+        valueRange.max += 0.5f;
+    }
+
+    // Porzucenie poprzedniej zawartoci, eby nie czeka na rysowanie poprzedniego kanau
+    glBindVertexArray(plot.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, plot.buffer);
+    plot.capacity = std::max(plot.capacity, points.size());
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(plot.capacity * sizeof(glm::vec2)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(points.size() * sizeof(glm::vec2)), points.data());
+    // Pocztek i koniec odcinka i to punkty i oraz i + 1 z tego samego bufora
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)sizeof(glm::vec2));
+
+    glUseProgram(plot.program);
+    glUniform2f(plot.uniViewport, (float)viewportWidth, (float)viewportHeight);
+    glUniform4f(plot.uniArea, area.x, area.y, area.z, area.w);
+    glUniform2f(plot.uniValueRange, valueRange.min, valueRange.max);
+    glUniform1f(plot.uniThickness, thickness);
+    glUniform4f(plot.uniColor, color.r, color.g, color.b, color.a);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)(points.size() - 1));
+    glBindVertexArray(0);
+}
+
+namespace
+{
+    // Sygna zastpczy: wolna i szybka sinusoida, szum i rzadkie szpilki, inne dla kadego kanau
+    struct SignalGenerator
+    {
+        uint32_t state = 1;
+        uint64_t index = 0;
+        double slow = 1e-6;
+        double fast = 1e-3;
+
+        void generate(float* values, size_t count)
+        {
+            for (size_t i = 0; i < count; i++, index++)
+            {
+                state = state * 1664525u + 1013904223u;
+                float noise = (float)(state >> 8) / 16777216.0f - 0.5f;
+                float value = (float)(std::sin(index * slow) + 0.3 * std::sin(index * fast)) + 0.1f * noise;
+                if ((state >> 4) % 1000003u == 0) value += 3.0f;
+                values[i] = value;
+            }
+        }
+    };
+
+    SignalGenerator channelGenerator(int channel)
+    {
+        SignalGenerator generator;
+        generator.state = 12345u + 7919u * channel;
+        generator.slow = 1e-6 * (1 + channel);
+        generator.fast = 1e-3 / (1 + channel);
+        return generator;
+    }
+
+    const glm::vec4 channelColors[4] = {
+        glm::vec4(0.95f, 0.75f, 0.3f, 1.0f), glm::vec4(0.4f, 0.8f, 0.95f, 1.0f),
+        glm::vec4(0.6f, 0.95f, 0.5f, 1.0f), glm::vec4(0.95f, 0.5f, 0.6f, 1.0f) };
+
+    // Pas kanau: left, bottom, width, height z marginesem
+    glm::vec4 channelArea(int channel, int channels, int width, int height)
+    {
+        float band = (float)height / channels;
+        return glm::vec4(10.0f, height - band * (channel + 1) + 10.0f, width - 20.0f, std::max(band - 20.0f, 1.0f));
+    }
+
+    void fillSeries(std::vector<TimeSeries>& series, std::vector<SignalGenerator>& generators, uint64_t samples, double& appendSeconds)
+    {
+        std::vector<float> batch(seriesChunkSize);
+        appendSeconds = 0.0;
+        for (size_t c = 0; c < series.size(); c++)
+        {
+            for (uint64_t done = 0; done < samples;)
+            {
+                size_t count = (size_t)std::min<uint64_t>(batch.size(), samples - done);
+                generators[c].generate(batch.data(), count);
+                auto start = std::chrono::steady_clock::now();
+                appendSamples(series[c], batch.data(), count);
+                appendSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                done += count;
+            }
+        }
+    }
+}
+
+int runPlotViewer(sf::Window& window, int channels, uint64_t samples)
+{
+    channels = std::max(1, channels);
+    std::vector<TimeSeries> series(channels);
+    std::vector<SignalGenerator> generators;
+    for (int c = 0; c < channels; c++) generators.push_back(channelGenerator(c));
+    double appendSeconds;
+    fillSeries(series, generators, samples, appendSeconds);
+
+    LinePlot plot;
+    if (!createLinePlot(plot)) return 1;
+    // Bez czcionki wykres dziaa dalej, tylko bez opisw osi
+    TextBatch text;
+    bool labels = createTextRenderer(text, defaultFontPath());
+    FrameAllocator frameMemory;
+    const glm::vec4 labelColor(0.7f, 0.7f, 0.75f, 1.0f);
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    double first = 0.0, last = (double)std::max<uint64_t>(samples, 2);
+    bool follow = false;
+    bool dragging = false;
+    int dragX = 0;
+    const double liveRate = 200000.0; // Prbki na sekund na kana przy ledzeniu
+    std::vector<float> batch;
+    std::vector<glm::vec2> points;
+
+    glDisable(GL_DEPTH_TEST);
+    bool running = true;
+    sf::Clock frameClock, fpsClock;
+    int frameCount = 0;
+    size_t drawnPoints = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            switch (windowEvent.type)
+            {
+            case sf::Event::Closed:
+                running = false;
+                break;
+            case sf::Event::KeyPressed:
+                if (windowEvent.key.code == sf::Keyboard::Escape) running = false;
+                if (windowEvent.key.code == sf::Keyboard::F) follow = !follow;
+                if (windowEvent.key.code == sf::Keyboard::T && text.program) labels = !labels;
+                break;
+            case sf::Event::MouseWheelScrolled:
+            {
+                // Przyblianie wok prbki pod kursorem, najwyej do 8 prbek na szeroko
+                double anchor = first + (last - first) * (windowEvent.mouseWheelScroll.x - 10.0) / std::max(width - 20, 1);
+                double scale = std::pow(0.8, windowEvent.mouseWheelScroll.delta);
+                double span = std::min(std::max((last - first) * scale, 8.0), (double)series[0].samples.size * 1.1);
+                first = anchor - (anchor - first) / (last - first) * span;
+                last = first + span;
+                break;
+            }
+            case sf::Event::MouseButtonPressed:
+                dragging = windowEvent.mouseButton.button == sf::Mouse::Left;
+                dragX = windowEvent.mouseButton.x;
+                break;
+            case sf::Event::MouseButtonReleased:
+                dragging = false;
+                break;
+            case sf::Event::MouseMoved:
+                if (dragging)
+                {
+                    double shift = (dragX - windowEvent.mouseMove.x) * (last - first) / std::max(width - 20, 1);
+                    first += shift;
+                    last += shift;
+                    dragX = windowEvent.mouseMove.x;
+                    follow = false;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        // Dopisywanie na ywo z szybkoci liveRate, widok przesuwa si za kocem danych
+        float elapsed = frameClock.restart().asSeconds();
+        if (follow)
+        {
+            batch.resize((size_t)(liveRate * std::min(elapsed, 0.1f)));
+            for (int c = 0; c < channels; c++)
+            {
+                generators[c].generate(batch.data(), batch.size());
+                appendSamples(series[c], batch.data(), batch.size());
+            }
+            double span = last - first;
+            last = (double)series[0].samples.size;
+            first = last - span;
+        }
+
+        beginFrameMemory(frameMemory);
+        beginText(text, frameMemory);
+        glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        drawnPoints = 0;
+        for (int c = 0; c < channels; c++)
+        {
+            glm::vec4 area = channelArea(c, channels, width, height);
+            MinMax range = decimateSeries(series[c], first, last, (int)area.z, points);
+            drawLine(plot, points, area, range, 1.5f, channelColors[c % 4], width, height);
+            drawnPoints += points.size();
+            if (!labels) continue;
+
+            // Podziaka wartoci przy lewej krawdzi pasa, podziaka numerw prbek pod ostatnim kanaem
+            if (range.max - range.min > 1e-12f)
+            {
+                double step = niceTickStep(range.max - range.min, std::max((int)(area.w / 40.0f), 2));
+                for (double value = std::ceil(range.min / step) * step; value <= range.max; value += step)
+                {
+                    float y = area.y + (float)((value - range.min) / (range.max - range.min)) * area.w;
+                    addText(text, frameFormat(frameMemory, "%g", std::abs(value) < step * 1e-6 ? 0.0 : value), glm::vec2(area.x + 4.0f, y + 3.0f),
+                        13.0f, labelColor);
+                }
+            }
+            if (c == channels - 1)
+            {
+                double step = niceTickStep(last - first, std::max((int)(area.z / 120.0f), 2));
+                for (double sample = std::ceil(std::max(first, 0.0) / step) * step; sample <= last; sample += step)
+                {
+                    float x = area.x + (float)((sample - first) / (last - first)) * area.z;
+                    addText(text, frameFormat(frameMemory, "%.0f", sample), glm::vec2(x, area.y + 4.0f), 13.0f, labelColor, TextAlign::Center);
+                }
+            }
+        }
+        if (labels) drawText(text, width, height);
+        else text.drawnGlyphs = 0;
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            double perPixel = (last - first) / std::max(width - 20, 1);
+            window.setTitle("Plot - FPS: " + std::to_string(frameCount) + " - samples: " + std::to_string(series[0].samples.size) +
+                " x " + std::to_string(channels) + ", " + std::to_string(perPixel) + " per pixel, points drawn: " +
+                std::to_string(drawnPoints) + ", glyphs: " + std::to_string(text.drawnGlyphs) + (follow ? " (live)" : ""));
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    releaseFrameAllocator(frameMemory);
+    if (text.program) destroyTextRenderer(text);
+    destroyLinePlot(plot);
+    checkGLErrors("After plot viewer");
+    return 0;
+}
+
+int runTimeSeriesBenchmark(sf::Window& window, int channels, uint64_t samples)
+{
+    channels = std::max(1, channels);
+    samples = std::max<uint64_t>(samples, 1024);
+    std::vector<TimeSeries> series(channels);
+    std::vector<SignalGenerator> generators;
+    for (int c = 0; c < channels; c++) generators.push_back(channelGenerator(c));
+
+    // Dopisywanie w porcjach po seriesChunkSize, mierzone bez generowania sygnau
+    double appendSeconds;
+    fillSeries(series, generators, samples, appendSeconds);
+    uint64_t pyramidBytes = 0;
+    for (const ChunkedColumn<MinMax>& level : series[0].levels) pyramidBytes += level.size * sizeof(MinMax);
+    std::cout << "Time series: " << channels << " channels x " << samples << " samples, "
+        << samples * sizeof(float) / (1024 * 1024) << " MB of samples and " << pyramidBytes / (1024 * 1024)
+        << " MB of min/max pyramid per channel, " << series[0].levels.size() << " levels" << std::endl;
+    std::cout << "  bulk append: " << channels * samples / appendSeconds / 1e6 << " M samples/s" << std::endl;
+
+    // Dopisywanie na ywo maymi porcjami do penej serii, koszt nie zaley od jej dugoci
+    std::vector<float> batch(1024);
+    const int liveBatches = 1000;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < liveBatches; i++)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            generators[c].generate(batch.data(), batch.size());
+            appendSamples(series[c], batch.data(), batch.size());
+        }
+    }
+    double liveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  live append of " << batch.size() << " samples: " << liveSeconds / liveBatches / channels * 1e6
+        << " us per batch and channel, including signal generation" << std::endl;
+
+    LinePlot plot;
+    if (!createLinePlot(plot)) return 1;
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    window.setVerticalSyncEnabled(false);
+    glDisable(GL_DEPTH_TEST);
+
+    uint64_t total = series[0].samples.size;
+    std::vector<glm::vec2> points;
+    const int frames = 100;
+    for (double zoom : { 1.0, 1e-2, 1e-4, 1e-6, 1e-8 })
+    {
+        double span = std::max(total * zoom, 8.0);
+        double first = total * 0.5 - span * 0.5, last = first + span;
+        double decimateSeconds = 0.0;
+        size_t drawnPoints = 0;
+
+        glFinish();
+        auto frameStart = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            sf::Event windowEvent;
+            while (window.pollEvent(windowEvent)) {}
+
+            glClearColor(0.08f, 0.08f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            drawnPoints = 0;
+            for (int c = 0; c < channels; c++)
+            {
+                glm::vec4 area = channelArea(c, channels, width, height);
+                auto decimateStart = std::chrono::steady_clock::now();
+                MinMax range = decimateSeries(series[c], first, last, (int)area.z, points);
+                decimateSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - decimateStart).count();
+                drawLine(plot, points, area, range, 1.5f, channelColors[c % 4], width, height);
+                drawnPoints += points.size();
+            }
+            window.display();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+        std::cout << "  " << span << " samples visible (" << span / (width - 20) << " per pixel): " << drawnPoints
+            << " points, decimation " << decimateSeconds / frames * 1000.0 << " ms, frame " << seconds / frames * 1000.0 << " ms" << std::endl;
+    }
+
+    destroyLinePlot(plot);
+    checkGLErrors("After time series benchmark");
+    return 0;
+}
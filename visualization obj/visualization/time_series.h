@@ -0,0 +1,88 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Wykresy liniowe dugich serii pomiarowych. Prbki (rwne odstpy w czasie) le w kawakach
+// staej wielkoci, obok piramida minimw i maksimw: poziom k ma blok na 8^(k+1) prbek.
+// Dopisywanie uzupenia tylko ostatnie bloki kadego poziomu. Przy rysowaniu kada kolumna
+// pikseli dostaje minimum i maksimum swojego zakresu zoone z kilku blokw na poziom (cae
+// grube bloki w rodku, drobne na brzegach), wic punktw jest najwyej dwa na kolumn przy
+// kadym powikszeniu, a szpilki nie gin. Linie o zadanej gruboci rysuje jedno wywoanie na kana.
+
+const uint32_t seriesChunkSize = 1u << 16;
+const int pyramidFanout = 8;
+
+struct MinMax
+{
+    float min;
+    float max;
+};
+
+// Kolumna w kawakach po seriesChunkSize, dopisywanie nie przenosi istniejcych elementw
+template <typename T>
+struct ChunkedColumn
+{
+    std::vector<std::unique_ptr<T[]>> chunks;
+    uint64_t size = 0;
+
+    T& operator[](uint64_t index) { return chunks[(size_t)(index / seriesChunkSize)][index % seriesChunkSize]; }
+    const T& operator[](uint64_t index) const { return chunks[(size_t)(index / seriesChunkSize)][index % seriesChunkSize]; }
+
+    void push_back(const T& value)
+    {
+        if (size % seriesChunkSize == 0) chunks.emplace_back(new T[seriesChunkSize]);
+        chunks.back()[size % seriesChunkSize] = value;
+        size++;
+    }
+};
+
+struct TimeSeries
+{
+    double startTime = 0.0;
+    double sampleInterval = 1.0;
+    ChunkedColumn<float> samples;
+    std::vector<ChunkedColumn<MinMax>> levels;
+};
+
+// Dopisanie prbek na kocu serii z uzupenieniem piramidy
+void appendSamples(TimeSeries& series, const float* values, size_t count);
+
+// Minimum i maksimum prbek [begin, end) z piramidy
+MinMax seriesRange(const TimeSeries& series, uint64_t begin, uint64_t end);
+
+// Punkty linii dla widoku od prbki first do last (uamkowo) na columns kolumnach pikseli.
+// x w pikselach od lewej krawdzi widoku, y to warto prbki. Widok moe wychodzi poza prbki,
+// wtedy punkty s tylko w kolumnach, ktre na nie nachodz. Zwraca zakres wartoci punktw.
+MinMax decimateSeries(const TimeSeries& series, double first, double last, int columns, std::vector<glm::vec2>& points);
+
+// Rysowanie linii amanych o gruboci w pikselach, jedna instancja na odcinek
+struct LinePlot
+{
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLuint buffer = 0;
+    size_t capacity = 0; // Pojemno bufora w punktach
+    GLint uniViewport = -1, uniArea = -1, uniValueRange = -1, uniThickness = -1, uniColor = -1;
+};
+
+bool createLinePlot(LinePlot& plot);
+void destroyLinePlot(LinePlot& plot);
+
+// Linia przez punkty w prostokcie area (left, bottom, width, height w pikselach okna),
+// wartoci z valueRange rozcignite na jego wysoko
+void drawLine(LinePlot& plot, const std::vector<glm::vec2>& points, const glm::vec4& area, MinMax valueRange,
+    float thickness, const glm::vec4& color, int viewportWidth, int viewportHeight);
+
+// Przegldarka: kko myszy przyblia, przeciganie przesuwa, F wcza ledzenie dopisywanych danych
+int runPlotViewer(sf::Window& window, int channels, uint64_t samples);
+
+// Pomiar: przepustowo dopisywania i czas klatki przy kilku powikszeniach
+int runTimeSeriesBenchmark(sf::Window& window, int channels, uint64_t samples);
@@ -10,294 +10,101 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <cstdlib>
+#include <cstring>
 #include "shaders.h"
+#include "gl_utils.h"
+#include "batch2d.h"
+#include "simulation.h"
+#include "mesh.h"
+#include "lod.h"
+#include "meshlet.h"
+#include "mesh_codec.h"
+#include "chunk_file.h"
+#include "streaming.h"
+#include "point_octree.h"
+#include "point_cloud.h"
+#include "time_series.h"
+#include "data_table.h"
+#include "indirect_draw.h"
+#include "render_queue.h"
+#include "texture_array.h"
+#include "image_pipeline.h"
+#include "streaming_texture.h"
+#include "heatmap.h"
+#include "scene.h"
+#include "text.h"
+#include "volume.h"
+#include "job_system.h"
+#include "memory.h"
 #include "stb_image.h"
 
-// Utworzenie zmiennych do ustawienia kamery
-glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
-glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-float yaw = -90.0f;
-float pitch = 0.0f;
-float sensitivity = 0.1f;
-float lastX = 400, lastY = 300;
-bool firstMouse = true;
-
-// Sprawdzanie bdw shaderw
-bool checkShaders(GLuint shader, const std::string& type)
+// Ustawianie koloru obj
+void setObjectColor(GLuint shaderProgram, GLint uniObjectColor, float r, float g, float b, float a) 
 {
-    GLint status;
-    GLchar log[512];
-
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status); // GL_COMPILE_STATUS - to chcemy pobra
-
-    if (!status) // 0 - bd
-    {
-        glGetShaderInfoLog(shader, 512, nullptr, log);
-        std::cerr << "Error: Compilation of " << type << " failed\n" << log << std::endl;
-        return false;
-    }
-    else
+    if (uniObjectColor != -1) 
     {
-        std::cout << "Compilation of " << type << " OK" << std::endl;
-        return true;
+        glUniform4f(uniObjectColor, r, g, b, a);
     }
-}
-
-// Sprawdzanie bdw OpenGL
-void checkGLErrors(const std::string& context) 
-{
-    GLenum err;
-    while ((err = glGetError()) != GL_NO_ERROR)
+    else 
     {
-        std::cerr << "OpenGL error in " << context << ": " << err << std::endl;
+        std::cerr << "Warning: 'objectColor' uniform not found." << std::endl;
     }
 }
 
-// Ustawianie kamery/myszki
-void setCameraMouse(GLint uniView, float deltaTime, sf::Window& window)
+int main(int argc, char** argv)
 {
-    sf::Vector2i localPosition = sf::Mouse::getPosition(window);
+    // System zada startuje na wtku gwnym, ktry dostaje wasn kolejk i czekajc wykonuje zadania
+    sharedJobSystem();
 
-    if (firstMouse)
+    // Przygotowanie pliku kawakw nie potrzebuje okna: --chunk plik.obj plik.chunks [trjkty na kawaek]
+    if (argc > 3 && std::strcmp(argv[1], "--chunk") == 0)
     {
-        lastX = localPosition.x;
-        lastY = localPosition.y;
-        firstMouse = false;
+        return buildChunkFile(argv[2], argv[3], argc > 4 ? (uint32_t)std::atoi(argv[4]) : 16384) ? 0 : 1;
     }
-
-    // Obliczenie przesunicia myszy
-    float xoffset = localPosition.x - lastX;
-    float yoffset = lastY - localPosition.y; // odwrotnie, aby poruszanie w gr byo dodatnie
-    lastX = localPosition.x;
-    lastY = localPosition.y;
-
-    xoffset *= sensitivity;
-    yoffset *= sensitivity;
-
-    // Aktualizacja kta obrotu kamery
-    yaw += xoffset;
-    pitch += yoffset;
-
-    // Ograniczenie kta nachylenia w pionie
-    if (pitch > 89.0f) pitch = 89.0f;
-    if (pitch < -89.0f) pitch = -89.0f;
-
-    // Obliczanie nowego kierunku patrzenia
-    glm::vec3 front;
-    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    front.y = sin(glm::radians(pitch));
-    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraFront = glm::normalize(front);
-}
-
-void setCameraKeys(float deltaTime)
-{
-    float cameraSpeed = 5.0f * deltaTime; // Zwikszono prdko kamery
-
-    // Poruszanie w przd i w ty
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        cameraPos += cameraSpeed * cameraFront;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        cameraPos -= cameraSpeed * cameraFront;
-
-    // Poruszanie w lewo i w prawo
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-
-    // Poruszanie w gr i w d
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        cameraPos += cameraSpeed * cameraUp;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        cameraPos -= cameraSpeed * cameraUp;
-}
-
-// Struktura wierzchoka
-struct Vertex 
-{
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoord;
-};
-
-// Wczytywanie obiektw z plikw obj
-bool loadObj(const std::string& filePath, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
-{
-    std::ifstream file(filePath);
-    if (!file.is_open())
+    // Pomiar wczytywania CSV: --bench-csv [miliony wierszy]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-csv") == 0)
     {
-        std::cerr << "Cannot open file: " << filePath << std::endl;
-        return false;
+        return runCsvBenchmark((uint64_t)((argc > 2 ? std::atof(argv[2]) : 10.0) * 1e6));
     }
-
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::vec2> texCoords; // Przechowywanie UV
-
-    std::string line;
-    while (std::getline(file, line))
+    // Pomiar systemu zada: --bench-jobs [liczba zada]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-jobs") == 0)
     {
-        if (line.empty()) continue;
-        std::istringstream iss(line);
-        std::string prefix;
-        iss >> prefix;
-
-        if (prefix == "v") {  // Vertex position
-            glm::vec3 position;
-            iss >> position.x >> position.y >> position.z;
-            positions.push_back(position);
-        }
-        else if (prefix == "vt") {  // Vertex texture coordinate
-            glm::vec2 texCoord;
-            iss >> texCoord.x >> texCoord.y;
-            texCoords.push_back(texCoord);
-        }
-        else if (prefix == "vn") {  // Vertex normal
-            glm::vec3 normal;
-            iss >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        }
-        else if (prefix == "f") {  // Face
-            std::string vertexStr;
-            for (int i = 0; i < 3; i++) {
-                if (!(iss >> vertexStr)) {
-                    std::cerr << "Error: Not enough vertex data in face" << std::endl;
-                    return false;
-                }
-
-                std::istringstream viss(vertexStr);
-                std::string posStr, texStr, normStr;
-                size_t firstSlash = vertexStr.find('/');
-                size_t lastSlash = vertexStr.rfind('/');
-
-                unsigned int posIdx = 0;
-                unsigned int texIdx = 0;
-                unsigned int normIdx = 0;
-
-                if (firstSlash == std::string::npos) {
-                    // Only position
-                    posIdx = std::stoi(vertexStr);
-                }
-                else if (firstSlash == lastSlash) {
-                    // Format: v/vt
-                    posIdx = std::stoi(vertexStr.substr(0, firstSlash));
-                    texIdx = std::stoi(vertexStr.substr(firstSlash + 1));
-                }
-                else {
-                    // Format: v/vt/vn or v//vn
-                    posIdx = std::stoi(vertexStr.substr(0, firstSlash));
-                    if (lastSlash > firstSlash + 1) {
-                        // v/vt/vn
-                        texIdx = std::stoi(vertexStr.substr(firstSlash + 1, lastSlash - firstSlash - 1));
-                        normIdx = std::stoi(vertexStr.substr(lastSlash + 1));
-                    }
-                    else {
-                        // v//vn
-                        normIdx = std::stoi(vertexStr.substr(lastSlash + 1));
-                    }
-                }
-
-                // Kontrola zakresw indeksw
-                if (posIdx < 1 || posIdx > positions.size()) {
-                    std::cerr << "Error: Position index out of range in face: " << posIdx << std::endl;
-                    return false;
-                }
-                if (texIdx < 1 || texIdx > texCoords.size()) {
-                    std::cerr << "Error: Texture index out of range in face: " << texIdx << std::endl;
-                    return false;
-                }
-                if (normIdx < 1 || normIdx > normals.size()) {
-                    std::cerr << "Error: Normal index out of range in face: " << normIdx << std::endl;
-                    return false;
-                }
-
-                Vertex vertex;
-                vertex.position = positions[posIdx - 1];
-                vertex.normal = normals[normIdx - 1];
-                vertex.texCoord = texCoords[texIdx - 1]; // Przypisanie UV
-
-                vertices.push_back(vertex);
-                indices.push_back(vertices.size() - 1);
-            }
-        }
+        return runJobBenchmark(argc > 2 ? (unsigned)std::atoi(argv[2]) : 20000);
     }
-
-    std::cout << "Loaded OBJ: " << filePath << " with "
-        << vertices.size() << " vertices and "
-        << indices.size() << " indices." << std::endl;
-    return true;
-}
-
-// Ustawianie koloru obj
-void setObjectColor(GLuint shaderProgram, GLint uniObjectColor, float r, float g, float b, float a) 
-{
-    if (uniObjectColor != -1) 
+    // Pomiar aktualizacji hierarchii sceny: --bench-scene [liczba wzw]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-scene") == 0)
     {
-        glUniform4f(uniObjectColor, r, g, b, a);
+        return runSceneBenchmark(argc > 2 ? (uint32_t)std::atoi(argv[2]) : 1000000);
     }
-    else 
+    // Pomiar klastrw siatki i ich odrzucania: --bench-meshlets [plik obj]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-meshlets") == 0)
     {
-        std::cerr << "Warning: 'objectColor' uniform not found." << std::endl;
+        return runMeshletBenchmark(argc > 2 ? argv[2] : nullptr);
     }
-}
-
-// Wczytywanie tekstury
-GLuint loadTexture(const char* filepath)
-{
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrChannels;
-    // Wczytaj obraz w pionowej orientacji
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filepath, &width, &height, &nrChannels, 0);
-    if (data)
+    // Pomiar kodeka pliku podrcznego siatki: --bench-mesh-codec [pliki obj]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-mesh-codec") == 0)
     {
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // Ustawienia tekstury
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
+        std::vector<std::string> paths(argv + 2, argv + argc);
+        if (paths.empty()) paths = { "chair.obj", "table.obj" };
+        return runMeshCodecBenchmark(paths);
     }
-    else
+    // Drzewo chmury punktw z binarnego pliku xyz: --octree punkty.xyz punkty.pco [rgb]
+    if (argc > 3 && std::strcmp(argv[1], "--octree") == 0)
     {
-        std::cerr << "Failed to load texture: " << filepath << std::endl;
-        stbi_image_free(data);
-        return 0; // Zwrot 0 w przypadku niepowodzenia
+        return buildPointOctree(argv[2], argv[3], argc > 4 && std::strcmp(argv[4], "rgb") == 0) ? 0 : 1;
     }
 
-    return textureID;
-}
-
-int main()
-{
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
     settings.majorVersion = 3;
-    settings.minorVersion = 2;
+    settings.minorVersion = 3;
     settings.attributeFlags = sf::ContextSettings::Core;
 
 
     // Okno renderingu
     sf::Window window(sf::VideoMode(800, 600, 32), "OpenGL", sf::Style::Titlebar | sf::Style::Close, settings);
-    window.setFramerateLimit(60);
     window.setVerticalSyncEnabled(true);
 
     // Inicjalizacja GLEW
@@ -314,6 +121,94 @@ int main()
 
     checkGLErrors("After GLEW Init");
 
+    // Tryby pomiarowe: --bench-2d [liczba ksztatw], --bench-lod [plik obj] [bok siatki], --bench-indirect [liczba obiektw],
+    // --bench-queue [liczba obiektw], --bench-textures [liczba obiektw] [liczba tekstur], --bench-mipmaps [bok obrazu],
+    // --bench-stream-texture [liczba klatek], --bench-plot [kanay] [miliony prbek], --bench-heatmap [miliony punktw],
+    // --bench-volume [najwikszy bok wolumenu], --bench-text [liczba etykiet],
+    // przegldanie pliku kawakw: --stream plik.chunks [limit pamici GPU w MB],
+    // chmura punktw: --points plik.pco [budet w milionach punktw] [limit pamici GPU w MB],
+    // wykres serii pomiarowych: --plot [kanay] [miliony prbek], wykres punktowy z CSV: --scatter plik.csv kolumna_x kolumna_y,
+    // mapa gstoci z CSV: --heatmap plik.csv kolumna_x kolumna_y,
+    // wolumen z surowego pliku: --volume plik.raw x y z [u8|u16|f32] [limit pamici GPU w MB]
+    if (argc > 1 && std::strcmp(argv[1], "--bench-2d") == 0)
+    {
+        return runBatch2DBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 100000);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-lod") == 0)
+    {
+        return runLodBenchmark(window, argc > 2 ? argv[2] : "chair.obj", argc > 3 ? std::atoi(argv[3]) : 64);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-indirect") == 0)
+    {
+        return runIndirectBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 16384);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-queue") == 0)
+    {
+        return runRenderQueueBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 20000);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-textures") == 0)
+    {
+        return runTextureArrayBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 16384, argc > 3 ? std::atoi(argv[3]) : 32);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-mipmaps") == 0)
+    {
+        return runMipmapBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 2048);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-stream-texture") == 0)
+    {
+        return runStreamingTextureBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 300);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-plot") == 0)
+    {
+        uint64_t samples = (uint64_t)((argc > 3 ? std::atof(argv[3]) : 100.0) * 1e6);
+        return runTimeSeriesBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 1, samples);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-heatmap") == 0)
+    {
+        uint64_t points = (uint64_t)((argc > 2 ? std::atof(argv[2]) : 50.0) * 1e6);
+        return runHeatmapBenchmark(window, points);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-volume") == 0)
+    {
+        return runVolumeBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 512);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--bench-text") == 0)
+    {
+        return runTextBenchmark(window, argc > 2 ? std::atoi(argv[2]) : 50000);
+    }
+    if (argc > 1 && std::strcmp(argv[1], "--plot") == 0)
+    {
+        uint64_t samples = (uint64_t)((argc > 3 ? std::atof(argv[3]) : 10.0) * 1e6);
+        return runPlotViewer(window, argc > 2 ? std::atoi(argv[2]) : 4, samples);
+    }
+    if (argc > 4 && std::strcmp(argv[1], "--scatter") == 0)
+    {
+        return runScatterViewer(window, argv[2], argv[3], argv[4]);
+    }
+    if (argc > 4 && std::strcmp(argv[1], "--heatmap") == 0)
+    {
+        return runHeatmapViewer(window, argv[2], argv[3], argv[4]);
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--stream") == 0)
+    {
+        uint64_t budgetMB = argc > 3 ? (uint64_t)std::atoll(argv[3]) : 512;
+        return runStreamViewer(window, argv[2], budgetMB * 1024 * 1024);
+    }
+    if (argc > 2 && std::strcmp(argv[1], "--points") == 0)
+    {
+        uint64_t pointBudget = (uint64_t)((argc > 3 ? std::atof(argv[3]) : 5.0) * 1e6);
+        uint64_t budgetMB = argc > 4 ? (uint64_t)std::atoll(argv[4]) : 1024;
+        return runPointCloudViewer(window, argv[2], pointBudget, budgetMB * 1024 * 1024);
+    }
+    if (argc > 5 && std::strcmp(argv[1], "--volume") == 0)
+    {
+        VoxelFormat format = VoxelFormat::UInt8;
+        if (argc > 6 && std::strcmp(argv[6], "u16") == 0) format = VoxelFormat::UInt16;
+        if (argc > 6 && std::strcmp(argv[6], "f32") == 0) format = VoxelFormat::Float32;
+        uint64_t budgetMB = argc > 7 ? (uint64_t)std::atoll(argv[7]) : 512;
+        return runVolumeViewer(window, argv[2], glm::ivec3(std::atoi(argv[3]), std::atoi(argv[4]), std::atoi(argv[5])), format, budgetMB * 1024 * 1024);
+    }
+
     // Wczenie z-bufora
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -355,11 +250,14 @@ int main()
     std::cout << "Shader program linked successfully." << std::endl;
 
 
-    GLuint chairTexture = loadTexture("wood.png");
-    GLuint tableTexture = loadTexture("wood.png");
+    // Tekstury modeli jako warstwy jednej tablicy, obiekt wybiera warstw uniformem
+    TextureArray textures;
+    loadTextureArray(textures, { "wood.png" });
+    int chairLayer = textureLayer(textures, "wood.png");
+    int tableLayer = textureLayer(textures, "wood.png");
 
-    bool hasChairTexture = (chairTexture != 0);
-    bool hasTableTexture = (tableTexture != 0);
+    bool hasChairTexture = (chairLayer >= 0);
+    bool hasTableTexture = (tableLayer >= 0);
 
     if (!hasChairTexture || !hasTableTexture)
     {
@@ -372,124 +270,163 @@ int main()
     glUseProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
 
-    // Lokalizacja uniformw
-    GLint uniModel = glGetUniformLocation(shaderProgram, "model");
+    // Lokalizacja uniformw, model, objectColor i useTexture ustawia kolejka rysowania
     GLint uniView = glGetUniformLocation(shaderProgram, "view");
     GLint uniProj = glGetUniformLocation(shaderProgram, "proj");
     GLint uniObjectColor = glGetUniformLocation(shaderProgram, "objectColor");
-    GLint uniUseTexture = glGetUniformLocation(shaderProgram, "useTexture");
 
     if (uniObjectColor == -1) 
     {
         std::cerr << "Warning: 'objectColor' uniform not found." << std::endl;
     }
 
-    // Wczytywanie modeli
-    std::vector<Vertex> chairVertices;
-    std::vector<unsigned int> chairIndices;
-
-    std::vector<Vertex> tableVertices;
-    std::vector<unsigned int> tableIndices;
-
-    if (!loadObj("chair.obj", chairVertices, chairIndices)) 
+    // Wczytywanie modeli razem z poziomami LOD, oba pliki rwnolegle jako zadania
+    AllocationStats loadStart = readAllocationStats();
+    Mesh chair, table;
+    bool chairLoaded = false, tableLoaded = false;
+    JobGraph loading;
+    addJob(loading, [&] { chairLoaded = loadMesh("chair.obj", chair); });
+    addJob(loading, [&] { tableLoaded = loadMesh("table.obj", table); });
+    runJobGraph(sharedJobSystem(), loading);
+    if (!chairLoaded) 
     {
         std::cerr << "Error loading chair.obj" << std::endl;
         return -1;
     }
 
-    if (!loadObj("table.obj", tableVertices, tableIndices)) 
+    if (!tableLoaded) 
     {
         std::cerr << "Error loading table.obj" << std::endl;
         return -1;
     }
 
-    // VAO i VBO dla krzesa
-    GLuint vaoChair, vboChair, eboChair;
-    glGenVertexArrays(1, &vaoChair);
-    glGenBuffers(1, &vboChair);
-    glGenBuffers(1, &eboChair);
-
-    glBindVertexArray(vaoChair);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vboChair);
-    glBufferData(GL_ARRAY_BUFFER, chairVertices.size() * sizeof(Vertex), &chairVertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboChair);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, chairIndices.size() * sizeof(unsigned int), &chairIndices[0], GL_STATIC_DRAW);
-
-    // Ustawienia atrybutw
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord)); // Dodane UV
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
-
+    uploadMesh(chair);
     checkGLErrors("After setting up VAO Chair");
-
-    // VAO i VBO dla stou
-    GLuint vaoTable, vboTable, eboTable;
-    glGenVertexArrays(1, &vaoTable);
-    glGenBuffers(1, &vboTable);
-    glGenBuffers(1, &eboTable);
-
-    glBindVertexArray(vaoTable);
-
-    glBindBuffer(GL_ARRAY_BUFFER, vboTable);
-    glBufferData(GL_ARRAY_BUFFER, tableVertices.size() * sizeof(Vertex), &tableVertices[0], GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eboTable);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, tableIndices.size() * sizeof(unsigned int), &tableIndices[0], GL_STATIC_DRAW);
-
-    // Ustawienia atrybutw
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texCoord)); // Dodane UV
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0);
+    uploadMesh(table);
     checkGLErrors("After setting up VAO Table");
+    AllocationStats loadEnd = readAllocationStats();
+    std::cout << "Loading: " << loadEnd.allocations - loadStart.allocations << " heap allocations, "
+        << (loadEnd.bytes - loadStart.bytes) / (1024 * 1024) << " MB allocated, peak RSS " << peakResidentBytes() / (1024 * 1024) << " MB" << std::endl;
+
+    // Dopuszczalny bd LOD w pikselach, przeczany klawiszem L (0 = zawsze pena siatka)
+    const float pixelScale = pixelsPerUnit(glm::radians(45.0f), 600);
+    float maxPixelError = 1.0f;
 
     // Macierz projekcji
     glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
     glUniformMatrix4fv(uniProj, 1, GL_FALSE, glm::value_ptr(proj));
 
     // Pocztkowa macierz widoku
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    CameraState camera;
+    glm::mat4 view = cameraView(camera);
     glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
 
     checkGLErrors("After setting uniforms");
 
+    // Nakadka 2D z ksztatami dema GDI, przeczana klawiszem O
+    Batch2D overlay;
+    bool showOverlay = false;
+    if (!createBatch2D(overlay))
+    {
+        std::cerr << "2D overlay disabled." << std::endl;
+    }
+
     bool running = true;
 
 
-    sf::Clock clock;
-    float deltaTime; // Przechowuje czas w sekundach jaki upyn od ostatniego odwieenia klatki
+    // Wejcie i kamera na osobnym wtku, renderowanie tylko czyta migawki
+    Simulation simulation;
+    startSimulation(simulation, window, camera);
+
+    unsigned drawnTriangles = 0;
+    unsigned long long clusterCulledTriangles = 0;
+    double clusterCullSeconds = 0.0;
+
+    // Hierarchia sceny: krzeso i st w jednym pokoju, ich macierze wiata liczy updateScene
+    SceneGraph scene;
+    SceneNode room = addSceneNode(scene, noSceneNode, glm::vec3(-2.0f, 0.0f, -5.0f));
+    SceneNode chairNode = addSceneNode(scene, room);
+    SceneNode tableNode = addSceneNode(scene, room);
+
+    // Kolejka rysowania sceny
+    RenderQueue queue;
+    queue.textureTarget = GL_TEXTURE_2D_ARRAY;
+    uint32_t sceneProgram = addQueueProgram(queue, shaderProgram);
+
+    // Etapy klatki jako graf zada: najpierw hierarchia sceny, potem niezalenie poziomy LOD obu modeli
+    // i odrzucanie klastrw penej siatki (klawisz C). Rysowanie zostaje na wtku gwnym, bo tylko on ma kontekst OpenGL.
+    glm::vec3 chairCenter, tableCenter;
+    int chairLevel = 0, tableLevel = 0;
+    bool clusterCulling = true;
+    std::vector<IndexRange> chairRanges, tableRanges;
+    MeshletCullStats chairCull, tableCull;
+    auto selectRanges = [&](const Mesh& mesh, const glm::mat4& model, int level, std::vector<IndexRange>& ranges, MeshletCullStats& stats)
+    {
+        ranges.clear();
+        stats = MeshletCullStats();
+        if (level == 0 && clusterCulling && !mesh.meshlets.empty())
+        {
+            cullMeshlets(mesh, model, proj * view, camera.position, ranges, stats);
+            return;
+        }
+        ranges.push_back({ mesh.lods[level].indexOffset, mesh.lods[level].indexCount });
+    };
+    JobGraph frameJobs;
+    uint32_t sceneJob = addJob(frameJobs, [&] { updateScene(scene); });
+    uint32_t chairJob = addJob(frameJobs, [&]
+    {
+        chairCenter = glm::vec3(nodeWorld(scene, chairNode) * glm::vec4(chair.center, 1.0f));
+        chairLevel = selectLod(chair, chairCenter, camera.position, pixelScale, maxPixelError);
+        selectRanges(chair, nodeWorld(scene, chairNode), chairLevel, chairRanges, chairCull);
+    });
+    uint32_t tableJob = addJob(frameJobs, [&]
+    {
+        tableCenter = glm::vec3(nodeWorld(scene, tableNode) * glm::vec4(table.center, 1.0f));
+        tableLevel = selectLod(table, tableCenter, camera.position, pixelScale, maxPixelError);
+        selectRanges(table, nodeWorld(scene, tableNode), tableLevel, tableRanges, tableCull);
+    });
+    addDependency(frameJobs, sceneJob, chairJob);
+    addDependency(frameJobs, sceneJob, tableJob);
+
+    // Dane tymczasowe klatki w dwch arenach na zmian. Klatka bez adnego new jest liczona osobno,
+    // wyjtkiem jest ta, w ktrej zmienia si tytu, bo SFML kopiuje go do wasnego napisu.
+    FrameAllocator frameMemory;
+    int zeroAllocationFrames = 0;
+
+    // Rysowanie na danie, klawisz R przecza na cige. W bezczynnoci tytu zmienia si dopiero po wybudzeniu.
+    FramePacing pacing;
 
     while (running)
     {
-        deltaTime = clock.restart().asSeconds(); // reset zegara i zwracanie czasu od ostatniego resetu
-        static int frameCount = 0;
+        uint64_t frameAllocations = readAllocationStats().allocations;
+        beginFrameMemory(frameMemory);
+
         static sf::Clock fpsClock;
-        frameCount++;
         if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
         {
-            window.setTitle("OpenGL - FPS: " + std::to_string(frameCount));
-            frameCount = 0;
+            JobStats jobStats = readJobStats(sharedJobSystem());
+            unsigned frameCount = pacing.frames;
+            PacingReport report = readPacingReport(pacing, simulation);
+            window.setTitle(frameFormat(frameMemory, "OpenGL - FPS: %d - Triangles: %u - State changes: %u - Jobs: %llu, steals: %llu, busy: %d%%"
+                " - Frames without allocations: %d/%u - %s, CPU: %d%%, wake-ups: %u, idle: %d%% - Clusters %s: %llu triangles culled, %d us per frame",
+                (int)std::round(report.fps), drawnTriangles,
+                queue.stats.stateChanges(), (unsigned long long)jobStats.executed, (unsigned long long)jobStats.steals,
+                (int)(jobStats.utilization * 100.0), zeroAllocationFrames, frameCount, pacing.onDemand ? "on demand" : "continuous",
+                (int)report.cpuPercent, report.wakeups, (int)report.idlePercent, clusterCulling ? "on" : "off",
+                frameCount ? clusterCulledTriangles / frameCount : 0ull, frameCount ? (int)(clusterCullSeconds / frameCount * 1e6) : 0));
+            clusterCulledTriangles = 0;
+            clusterCullSeconds = 0.0;
+            zeroAllocationFrames = 0;
             fpsClock.restart();
         }
 
+        // Zdarzenie, na ktre czekaa bezczynna ptla, jest obsugiwane jak pierwsze z kolejki
         sf::Event windowEvent;
-        while (window.pollEvent(windowEvent))
+        bool waited = waitForFrame(pacing, simulation, window, windowEvent);
+        while (waited || window.pollEvent(windowEvent))
         {
+            waited = false;
+            pacing.dirty = true;
             if (windowEvent.type == sf::Event::Closed)
             {
                 running = false;
@@ -500,6 +437,22 @@ int main()
                 {
                     running = false;
                 }
+                else if (windowEvent.key.code == sf::Keyboard::O)
+                {
+                    showOverlay = overlay.program != 0 && !showOverlay;
+                }
+                else if (windowEvent.key.code == sf::Keyboard::L)
+                {
+                    maxPixelError = maxPixelError > 0.0f ? 0.0f : 1.0f;
+                }
+                else if (windowEvent.key.code == sf::Keyboard::R)
+                {
+                    pacing.onDemand = !pacing.onDemand;
+                }
+                else if (windowEvent.key.code == sf::Keyboard::C)
+                {
+                    clusterCulling = !clusterCulling;
+                }
             }
         }
 
@@ -507,79 +460,64 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Aktualizacja kamery
-        setCameraMouse(uniView, deltaTime, window);
-        setCameraKeys(deltaTime);
+        glUseProgram(shaderProgram);
 
-        // Aktualizacja macierzy widoku po zmianie kamery
-        view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        // Kamera z ostatniego kroku symulacji
+        camera = sampleCamera(simulation);
+        view = cameraView(camera);
         glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
+        drawnTriangles = 0;
 
-        // Renderowanie krzesa
-        glActiveTexture(GL_TEXTURE0);
-        if (hasChairTexture)
+        // Rysowania trafiaj do kolejki, ktra sortuje je wedug stanu i pomija powtrzone wizania
+        beginQueue(queue);
+        runJobGraph(sharedJobSystem(), frameJobs);
+
+        // Krzeso na poziomie dobranym do odlegoci od kamery, pena siatka tylko w zakresach widocznych klastrw
+        const glm::mat4& chairModel = nodeWorld(scene, chairNode);
+        for (const IndexRange& range : chairRanges)
         {
-            glBindTexture(GL_TEXTURE_2D, chairTexture);
-            glUniform1i(uniUseTexture, GL_TRUE);
+            submitDraw(queue, sceneProgram, hasChairTexture ? textures.texture : 0, chair.vao, range.indexCount, range.indexOffset,
+                chairModel, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), -(view * glm::vec4(chairCenter, 1.0f)).z, chairLayer); // Czerwony bez tekstury
+            drawnTriangles += range.indexCount / 3;
         }
-        else
+
+        // St
+        const glm::mat4& tableModel = nodeWorld(scene, tableNode);
+        for (const IndexRange& range : tableRanges)
         {
-            glBindTexture(GL_TEXTURE_2D, 0); // Odwizanie tekstury
-            glUniform1i(uniUseTexture, GL_FALSE);
-            glUniform4f(uniObjectColor, 1.0f, 0.0f, 0.0f, 1.0f); // Czerwony
+            submitDraw(queue, sceneProgram, hasTableTexture ? textures.texture : 0, table.vao, range.indexCount, range.indexOffset,
+                tableModel, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f), -(view * glm::vec4(tableCenter, 1.0f)).z, tableLayer); // ty bez tekstury
+            drawnTriangles += range.indexCount / 3;
         }
+        clusterCulledTriangles += chairCull.backfaceTriangles + chairCull.frustumTriangles + tableCull.backfaceTriangles + tableCull.frustumTriangles;
+        clusterCullSeconds += chairCull.seconds + tableCull.seconds;
 
-        // Macierz modelu dla krzesa
-        glm::mat4 chairModel = glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, 0.0f, -5.0f));
-        glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(chairModel));
-
-        // Rysowanie krzesa
-        glBindVertexArray(vaoChair);
-        glDrawElements(GL_TRIANGLES, chairIndices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-        checkGLErrors("After drawing Chair");
+        executeQueue(queue);
+        checkGLErrors("After drawing scene");
 
-        // Renderowanie stou
-        glActiveTexture(GL_TEXTURE0);
-        if (hasTableTexture)
-        {
-            glBindTexture(GL_TEXTURE_2D, tableTexture);
-            glUniform1i(uniUseTexture, GL_TRUE);
-        }
-        else
+        if (showOverlay)
         {
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glUniform1i(uniUseTexture, GL_FALSE);
-            glUniform4f(uniObjectColor, 1.0f, 1.0f, 0.0f, 1.0f); // ty
+            batchDemoShapes(overlay);
+            flushBatch2D(overlay, (int)window.getSize().x, (int)window.getSize().y);
         }
 
-        // Ustaw macierz modelu dla stou
-        glm::mat4 tableModel = glm::translate(glm::mat4(1.0f), glm::vec3(-2.0f, 0.0f, -5.0f));
-        glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(tableModel));
-
-        // Rysowanie stou
-        glBindVertexArray(vaoTable);
-        glDrawElements(GL_TRIANGLES, tableIndices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-        checkGLErrors("After drawing Table");
-
         window.display();
+        pacing.frames++;
+        pacing.dirty = false;
+        if (readAllocationStats().allocations == frameAllocations) zeroAllocationFrames++;
     }
 
+    stopSimulation(simulation);
+    releaseFrameAllocator(frameMemory);
+
     glDeleteProgram(shaderProgram);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-    glDeleteVertexArrays(1, &vaoChair);
-    glDeleteBuffers(1, &vboChair);
-    glDeleteBuffers(1, &eboChair);
-    glDeleteVertexArrays(1, &vaoTable);
-    glDeleteBuffers(1, &vboTable);
-    glDeleteBuffers(1, &eboTable);
-
-    if (hasChairTexture)
-        glDeleteTextures(1, &chairTexture);
-    if (hasTableTexture)
-        glDeleteTextures(1, &tableTexture);
+    destroyMesh(chair);
+    destroyMesh(table);
+    destroyBatch2D(overlay);
+
+    destroyTextureArray(textures);
 
     window.close();
     return 0;
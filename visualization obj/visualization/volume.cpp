@@ -0,0 +1,784 @@
+#include "volume.h"
+#include "gl_utils.h"
+#include "job_system.h"
+#include "lod.h"
+#include "simulation.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const GLchar* volumeVertexSource = R"glsl(
+        #version 330 core
+        in vec3 position;
+        out vec3 VolumePos;
+        uniform mat4 model;
+        uniform mat4 viewProj;
+
+        void main()
+        {
+            VolumePos = position;
+            gl_Position = viewProj * model * vec4(position, 1.0);
+        }
+    )glsl";
+
+    // Rysowane s tylne ciany prostopadocianu, promie od kamery (albo od wejcia do wolumenu)
+    // do ciany idzie w przestrzeni wokseli. Po wejciu do nowego bloku odczyt tablicy stron
+    // i zakresu, pusty albo niewczytany blok jest przeskakiwany do punktu wyjcia.
+    const GLchar* volumeFragmentSource = R"glsl(
+        #version 330 core
+        in vec3 VolumePos;
+        out vec4 outColor;
+        uniform sampler3D pool;
+        uniform usampler3D pages;
+        uniform sampler3D ranges;
+        uniform sampler1D transfer;
+        uniform sampler2D rangeOpacity;
+        uniform vec3 cameraVolume;
+        uniform vec3 volumeSize;
+        uniform vec3 poolScale;
+        uniform float stepSize;
+        uniform bool skipping;
+        uniform int maxSteps;
+
+        const float brickSize = 32.0;
+        const float paddedBrick = 34.0;
+
+        void main()
+        {
+            vec3 origin = cameraVolume * volumeSize;
+            vec3 dir = VolumePos * volumeSize - origin;
+            float tExit = length(dir);
+            dir /= tExit;
+            vec3 safeDir = mix(dir, vec3(1e-6), lessThan(abs(dir), vec3(1e-6)));
+            vec3 invDir = 1.0 / safeDir;
+            vec3 tEnter = min(-origin * invDir, (volumeSize - origin) * invDir);
+            float tStart = max(max(max(tEnter.x, tEnter.y), tEnter.z), 0.0);
+            float t = tStart;
+
+            ivec3 brickCount = textureSize(pages, 0);
+            ivec3 currentBrick = ivec3(-1);
+            bool skipBrick = true;
+            float brickExit = 0.0;
+            vec3 slotOffset = vec3(0.0);
+            vec4 color = vec4(0.0);
+            for (int i = 0; i < maxSteps && t < tExit; i++)
+            {
+                vec3 p = origin + dir * t;
+                ivec3 brick = clamp(ivec3(floor(p / brickSize)), ivec3(0), brickCount - 1);
+                if (brick != currentBrick)
+                {
+                    currentBrick = brick;
+                    vec3 low = vec3(brick) * brickSize;
+                    vec3 tBrick = max((low - origin) * invDir, (low + brickSize - origin) * invDir);
+                    brickExit = min(min(tBrick.x, tBrick.y), tBrick.z);
+                    uvec4 page = texelFetch(pages, brick, 0);
+                    skipBrick = page.w == 0u;
+                    if (skipping && !skipBrick)
+                    {
+                        vec2 range = texelFetch(ranges, brick, 0).xy;
+                        skipBrick = texelFetch(rangeOpacity, ivec2(floor(range.x * 255.0), ceil(range.y * 255.0)), 0).r == 0.0;
+                    }
+                    slotOffset = vec3(page.xyz) * paddedBrick + 1.0 - low;
+                }
+                if (skipBrick)
+                {
+                    // Nastpna prbka za blokiem w tej samej siatce krokw, jak bez przeskakiwania
+                    t = tStart + ceil((max(brickExit, t) + 0.001 - tStart) / stepSize) * stepSize;
+                    continue;
+                }
+
+                float value = texture(pool, (p + slotOffset) * poolScale).r;
+                vec4 mapped = texture(transfer, value * (255.0 / 256.0) + 0.5 / 256.0);
+                float alpha = 1.0 - pow(1.0 - mapped.a, stepSize); // Nieprzezroczysto dana na jeden woksel
+                color.rgb += (1.0 - color.a) * alpha * mapped.rgb;
+                color.a += (1.0 - color.a) * alpha;
+                if (color.a > 0.99) break;
+                t += stepSize;
+            }
+            outColor = color;
+        }
+    )glsl";
+
+    size_t voxelBytes(VoxelFormat format)
+    {
+        return format == VoxelFormat::UInt8 ? 1 : format == VoxelFormat::UInt16 ? 2 : 4;
+    }
+
+    // W puli UInt8 zostaje, UInt16 i Float32 trafiaj do 16-bitowych wartoci znormalizowanych
+    size_t poolBytes(VoxelFormat format)
+    {
+        return format == VoxelFormat::UInt8 ? 1 : 2;
+    }
+
+    float rawFloat(const Volume& volume, size_t index)
+    {
+        float value;
+        std::memcpy(&value, volume.voxels + index * 4, sizeof(value));
+        return value;
+    }
+
+    float voxelValue(const Volume& volume, size_t index)
+    {
+        switch (volume.format)
+        {
+        case VoxelFormat::UInt8:
+            return volume.voxels[index] * (1.0f / 255.0f);
+        case VoxelFormat::UInt16:
+        {
+            uint16_t value;
+            std::memcpy(&value, volume.voxels + index * 2, sizeof(value));
+            return value * (1.0f / 65535.0f);
+        }
+        default:
+            return std::min(std::max((rawFloat(volume, index) - volume.valueMin) / (volume.valueMax - volume.valueMin), 0.0f), 1.0f);
+        }
+    }
+
+    size_t voxelIndex(const Volume& volume, int x, int y, int z)
+    {
+        return ((size_t)z * volume.size.y + y) * volume.size.x + x;
+    }
+
+    glm::ivec3 brickCoords(const Volume& volume, int brick)
+    {
+        return glm::ivec3(brick % volume.bricks.x, (brick / volume.bricks.x) % volume.bricks.y, brick / (volume.bricks.x * volume.bricks.y));
+    }
+
+    glm::ivec3 slotCoords(const Volume& volume, int slot)
+    {
+        return glm::ivec3(slot % volume.poolSlots.x, (slot / volume.poolSlots.x) % volume.poolSlots.y, slot / (volume.poolSlots.x * volume.poolSlots.y));
+    }
+
+    // Czy w zakresie wartoci bloku funkcja przejcia daje cokolwiek widocznego
+    bool brickVisible(const Volume& volume, int brick)
+    {
+        glm::vec2 range = volume.brickRanges[brick];
+        int low = (int)std::floor(range.x * 255.0f), high = (int)std::ceil(range.y * 255.0f);
+        return volume.rangeOpacity[(size_t)high * 256 + low] != 0;
+    }
+
+    // Min i max kadego bloku razem z ramk, ktr czyta filtrowanie na jego granicy
+    void computeBrickRanges(Volume& volume)
+    {
+        if (volume.format == VoxelFormat::Float32)
+        {
+            std::vector<glm::vec2> slices(volume.size.z, glm::vec2(INFINITY, -INFINITY));
+            size_t slice = (size_t)volume.size.x * volume.size.y;
+            parallelFor((unsigned)volume.size.z, [&](unsigned first, unsigned last)
+            {
+                for (unsigned z = first; z < last; z++)
+                {
+                    for (size_t i = z * slice; i < (z + 1) * slice; i++)
+                    {
+                        float value = rawFloat(volume, i);
+                        slices[z].x = std::min(slices[z].x, value);
+                        slices[z].y = std::max(slices[z].y, value);
+                    }
+                }
+            });
+            volume.valueMin = INFINITY;
+            volume.valueMax = -INFINITY;
+            for (const glm::vec2& range : slices)
+            {
+                volume.valueMin = std::min(volume.valueMin, range.x);
+                volume.valueMax = std::max(volume.valueMax, range.y);
+            }
+            if (!(volume.valueMax > volume.valueMin)) volume.valueMax = volume.valueMin + 1.0f;
+        }
+
+        int count = volume.bricks.x * volume.bricks.y * volume.bricks.z;
+        volume.brickRanges.assign(count, glm::vec2(0.0f));
+        parallelFor((unsigned)count, [&](unsigned first, unsigned last)
+        {
+            for (unsigned brick = first; brick < last; brick++)
+            {
+                glm::ivec3 low = glm::max(brickCoords(volume, brick) * Volume::brickSize - 1, glm::ivec3(0));
+                glm::ivec3 high = glm::min(brickCoords(volume, brick) * Volume::brickSize + Volume::brickSize, volume.size - 1);
+                float minValue = 1.0f, maxValue = 0.0f;
+                for (int z = low.z; z <= high.z; z++)
+                {
+                    for (int y = low.y; y <= high.y; y++)
+                    {
+                        size_t row = voxelIndex(volume, 0, y, z);
+                        for (int x = low.x; x <= high.x; x++)
+                        {
+                            float value = voxelValue(volume, row + x);
+                            minValue = std::min(minValue, value);
+                            maxValue = std::max(maxValue, value);
+                        }
+                    }
+                }
+                volume.brickRanges[brick] = glm::vec2(minValue, maxValue);
+            }
+        });
+    }
+
+    // Blok z ramk do bufora 34^3, poza wolumenem powtrzony brzegowy woksel
+    void gatherBrick(const Volume& volume, int brick, unsigned char* out)
+    {
+        glm::ivec3 origin = brickCoords(volume, brick) * Volume::brickSize - 1;
+        const int padded = Volume::paddedBrick;
+        int xs[padded];
+        for (int x = 0; x < padded; x++) xs[x] = std::min(std::max(origin.x + x, 0), volume.size.x - 1);
+
+        uint16_t* out16 = reinterpret_cast<uint16_t*>(out);
+        size_t written = 0;
+        for (int z = 0; z < padded; z++)
+        {
+            int sz = std::min(std::max(origin.z + z, 0), volume.size.z - 1);
+            for (int y = 0; y < padded; y++)
+            {
+                int sy = std::min(std::max(origin.y + y, 0), volume.size.y - 1);
+                size_t row = voxelIndex(volume, 0, sy, sz);
+                switch (volume.format)
+                {
+                case VoxelFormat::UInt8:
+                    for (int x = 0; x < padded; x++) out[written + x] = volume.voxels[row + xs[x]];
+                    break;
+                case VoxelFormat::UInt16:
+                    for (int x = 0; x < padded; x++) std::memcpy(out16 + written + x, volume.voxels + (row + xs[x]) * 2, 2);
+                    break;
+                default:
+                    for (int x = 0; x < padded; x++) out16[written + x] = (uint16_t)(voxelValue(volume, row + xs[x]) * 65535.0f + 0.5f);
+                    break;
+                }
+                written += padded;
+            }
+        }
+    }
+
+    void setPage(const Volume& volume, int brick, const unsigned char entry[4])
+    {
+        glm::ivec3 coords = brickCoords(volume, brick);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, coords.x, coords.y, coords.z, 1, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entry);
+    }
+
+    void uploadTransfer(const Volume& volume)
+    {
+        glBindTexture(GL_TEXTURE_1D, volume.transferTexture);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA16F, 256, 0, GL_RGBA, GL_FLOAT, volume.transfer.data());
+        glBindTexture(GL_TEXTURE_2D, volume.rangeOpacityTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, 256, 256, 0, GL_RED, GL_UNSIGNED_BYTE, volume.rangeOpacity.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    GLuint createTexture(GLenum target, GLint filter)
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(target, texture);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        return texture;
+    }
+
+    // Prostopadocian [0, 1]^3 wolumenu o proporcjach jego rozmiaru, wyrodkowany w zerze
+    glm::mat4 volumeModel(const Volume& volume)
+    {
+        glm::vec3 extent = glm::vec3(volume.size) / (float)std::max(volume.size.x, std::max(volume.size.y, volume.size.z));
+        return glm::scale(glm::translate(glm::mat4(1.0f), -extent * 0.5f), extent);
+    }
+}
+
+bool openVolume(Volume& volume, const std::string& path, const glm::ivec3& size, VoxelFormat format)
+{
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0)
+    {
+        std::cerr << "Invalid volume size " << size.x << "x" << size.y << "x" << size.z << std::endl;
+        return false;
+    }
+    if (!mapFile(volume.file, path)) return false;
+    uint64_t expected = (uint64_t)size.x * size.y * size.z * voxelBytes(format);
+    if (volume.file.size != expected)
+    {
+        std::cerr << "Volume file " << path << " has " << volume.file.size << " bytes, expected " << expected << std::endl;
+        unmapFile(volume.file);
+        return false;
+    }
+    volume.size = size;
+    volume.format = format;
+    volume.voxels = volume.file.data;
+    return true;
+}
+
+void generateVolume(Volume& volume, int size)
+{
+    struct Blob
+    {
+        glm::vec3 center;
+        float radius;
+        float peak;
+    };
+    const Blob blobs[] = {
+        { glm::vec3(0.3f, 0.3f, 0.3f), 0.10f, 0.9f },
+        { glm::vec3(0.7f, 0.35f, 0.6f), 0.07f, 0.7f },
+        { glm::vec3(0.4f, 0.7f, 0.7f), 0.12f, 1.0f },
+        { glm::vec3(0.65f, 0.7f, 0.25f), 0.05f, 0.6f },
+        { glm::vec3(0.2f, 0.6f, 0.45f), 0.06f, 0.8f },
+    };
+    const glm::vec3 shellCenter(0.5f);
+    const float shellRadius = 0.42f, shellWidth = 0.015f;
+
+    volume.size = glm::ivec3(size);
+    volume.format = VoxelFormat::UInt8;
+    volume.owned.assign((size_t)size * size * size, 0);
+    volume.voxels = volume.owned.data();
+    parallelFor((unsigned)size, [&](unsigned first, unsigned last)
+    {
+        for (unsigned z = first; z < last; z++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                unsigned char* row = volume.owned.data() + voxelIndex(volume, 0, y, z);
+                for (int x = 0; x < size; x++)
+                {
+                    glm::vec3 p = (glm::vec3((float)x, (float)y, (float)z) + 0.5f) / (float)size;
+                    float shell = (glm::length(p - shellCenter) - shellRadius) / shellWidth;
+                    float value = shell * shell < 9.0f ? 0.35f * std::exp(-shell * shell) : 0.0f;
+                    for (const Blob& blob : blobs)
+                    {
+                        float d2 = glm::dot(p - blob.center, p - blob.center) / (blob.radius * blob.radius);
+                        if (d2 < 9.0f) value = std::max(value, blob.peak * std::exp(-d2));
+                    }
+                    // Poniej progu zero, eby otoczenie byo naprawd puste
+                    row[x] = value < 0.02f ? 0 : (unsigned char)(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    });
+}
+
+void setTransferWindow(Volume& volume, float center, float width)
+{
+    volume.transferCenter = std::min(std::max(center, 0.0f), 1.0f);
+    volume.transferWidth = std::min(std::max(width, 1.0f / 255.0f), 2.0f);
+    float low = volume.transferCenter - volume.transferWidth * 0.5f;
+
+    // Poniej okna przezroczyste, w oknie kolor od niebieskiego przez pomaraczowy do biaego
+    const glm::vec3 blue(0.1f, 0.3f, 0.9f), orange(1.0f, 0.55f, 0.1f), white(1.0f);
+    volume.transfer.resize(256);
+    for (int i = 0; i < 256; i++)
+    {
+        float t = (i / 255.0f - low) / volume.transferWidth;
+        if (t <= 0.0f)
+        {
+            volume.transfer[i] = glm::vec4(0.0f);
+            continue;
+        }
+        t = std::min(t, 1.0f);
+        glm::vec3 color = t < 0.5f ? glm::mix(blue, orange, t * 2.0f) : glm::mix(orange, white, t * 2.0f - 1.0f);
+        volume.transfer[i] = glm::vec4(color, 0.02f + 0.3f * t * t);
+    }
+
+    // Najwiksza nieprzezroczysto w przedziale [low, high], wiersz high, kolumna low
+    volume.rangeOpacity.assign(256 * 256, 0);
+    for (int low = 0; low < 256; low++)
+    {
+        float maxAlpha = 0.0f;
+        for (int high = low; high < 256; high++)
+        {
+            maxAlpha = std::max(maxAlpha, volume.transfer[high].a);
+            volume.rangeOpacity[(size_t)high * 256 + low] = maxAlpha > 0.0f ? (unsigned char)std::max(1.0f, std::ceil(maxAlpha * 255.0f)) : 0;
+        }
+    }
+    volume.transferVersion++;
+    if (volume.transferTexture) uploadTransfer(volume);
+}
+
+bool createVolumeRenderer(Volume& volume, uint64_t memoryBudget)
+{
+    volume.bricks = (volume.size + Volume::brickSize - 1) / Volume::brickSize;
+    int count = volume.bricks.x * volume.bricks.y * volume.bricks.z;
+    auto start = std::chrono::steady_clock::now();
+    computeBrickRanges(volume);
+    std::cout << "Volume " << volume.size.x << "x" << volume.size.y << "x" << volume.size.z << ": " << count << " bricks, ranges in "
+        << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+
+    // Pula mieszczca si w budecie i w najwikszej teksturze 3D, pooenie w tablicy stron na bajt
+    uint64_t slotBytes = (uint64_t)Volume::paddedBrick * Volume::paddedBrick * Volume::paddedBrick * poolBytes(volume.format);
+    int wantedSlots = (int)std::min<uint64_t>(memoryBudget / slotBytes, (uint64_t)count);
+    if (wantedSlots < 1)
+    {
+        std::cerr << "Memory budget of " << memoryBudget << " bytes is smaller than one brick (" << slotBytes << " bytes)" << std::endl;
+        return false;
+    }
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+    int perAxis = std::min(std::max(maxSize / Volume::paddedBrick, 1), 255);
+    int side = std::min((int)std::ceil(std::cbrt((double)wantedSlots)), perAxis);
+    int layers = std::min((wantedSlots + side * side - 1) / (side * side), perAxis);
+    if (layers > 1 && (uint64_t)side * side * layers * slotBytes > memoryBudget) layers--;
+    volume.poolSlots = glm::ivec3(side, side, layers);
+    volume.slots.assign((size_t)side * side * layers, VolumeBrickSlot());
+    volume.brickSlots.assign(count, -1);
+
+    volume.poolTexture = createTexture(GL_TEXTURE_3D, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_3D, 0, volume.format == VoxelFormat::UInt8 ? GL_R8 : GL_R16, side * Volume::paddedBrick, side * Volume::paddedBrick,
+        layers * Volume::paddedBrick, 0, GL_RED, volume.format == VoxelFormat::UInt8 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT, nullptr);
+
+    std::vector<unsigned char> emptyPages((size_t)count * 4, 0);
+    volume.pageTexture = createTexture(GL_TEXTURE_3D, GL_NEAREST);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8UI, volume.bricks.x, volume.bricks.y, volume.bricks.z, 0, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, emptyPages.data());
+
+    std::vector<uint16_t> ranges((size_t)count * 2);
+    for (int brick = 0; brick < count; brick++)
+    {
+        ranges[(size_t)brick * 2] = (uint16_t)(volume.brickRanges[brick].x * 65535.0f);
+        ranges[(size_t)brick * 2 + 1] = (uint16_t)std::ceil(volume.brickRanges[brick].y * 65535.0f);
+    }
+    volume.rangeTexture = createTexture(GL_TEXTURE_3D, GL_NEAREST);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RG16, volume.bricks.x, volume.bricks.y, volume.bricks.z, 0, GL_RG, GL_UNSIGNED_SHORT, ranges.data());
+
+    volume.transferTexture = createTexture(GL_TEXTURE_1D, GL_LINEAR);
+    volume.rangeOpacityTexture = createTexture(GL_TEXTURE_2D, GL_NEAREST);
+    setTransferWindow(volume, volume.transferCenter, volume.transferWidth);
+
+    volume.program = createProgram(volumeVertexSource, volumeFragmentSource, { "position" }, "Volume");
+    if (!volume.program) return false;
+    glUseProgram(volume.program);
+    glUniform1i(glGetUniformLocation(volume.program, "pool"), 0);
+    glUniform1i(glGetUniformLocation(volume.program, "pages"), 1);
+    glUniform1i(glGetUniformLocation(volume.program, "ranges"), 2);
+    glUniform1i(glGetUniformLocation(volume.program, "transfer"), 3);
+    glUniform1i(glGetUniformLocation(volume.program, "rangeOpacity"), 4);
+    glUniform3fv(glGetUniformLocation(volume.program, "volumeSize"), 1, glm::value_ptr(glm::vec3(volume.size)));
+    glUniform3fv(glGetUniformLocation(volume.program, "poolScale"), 1,
+        glm::value_ptr(1.0f / (glm::vec3(volume.poolSlots) * (float)Volume::paddedBrick)));
+    volume.uniModel = glGetUniformLocation(volume.program, "model");
+    volume.uniViewProj = glGetUniformLocation(volume.program, "viewProj");
+    volume.uniCameraVolume = glGetUniformLocation(volume.program, "cameraVolume");
+    volume.uniStepSize = glGetUniformLocation(volume.program, "stepSize");
+    volume.uniSkipping = glGetUniformLocation(volume.program, "skipping");
+    volume.uniMaxSteps = glGetUniformLocation(volume.program, "maxSteps");
+
+    // 36 wierzchokw szecianu [0, 1]^3, ciany zewntrzne przeciwnie do ruchu wskazwek zegara
+    std::vector<float> cube;
+    const int faces[6][4][3] = {
+        { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 } }, { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } },
+        { { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 } }, { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } },
+        { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }, { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } },
+    };
+    for (const auto& face : faces)
+    {
+        for (int corner : { 0, 1, 2, 0, 2, 3 })
+        {
+            for (int axis = 0; axis < 3; axis++) cube.push_back((float)face[corner][axis]);
+        }
+    }
+    glGenVertexArrays(1, &volume.vao);
+    glBindVertexArray(volume.vao);
+    glGenBuffers(1, &volume.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, volume.vbo);
+    glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(float), cube.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    std::cout << "Brick pool: " << volume.slots.size() << " slots (" << volume.poolSlots.x << "x" << volume.poolSlots.y << "x" << volume.poolSlots.z
+        << "), " << volume.slots.size() * slotBytes / (1024 * 1024) << " MB" << std::endl;
+    checkGLErrors("After volume setup");
+    return true;
+}
+
+void destroyVolume(Volume& volume)
+{
+    GLuint textures[] = { volume.poolTexture, volume.pageTexture, volume.rangeTexture, volume.transferTexture, volume.rangeOpacityTexture };
+    glDeleteTextures(5, textures);
+    glDeleteProgram(volume.program);
+    glDeleteBuffers(1, &volume.vbo);
+    glDeleteVertexArrays(1, &volume.vao);
+    volume.poolTexture = volume.pageTexture = volume.rangeTexture = volume.transferTexture = volume.rangeOpacityTexture = 0;
+    volume.program = volume.vao = volume.vbo = 0;
+    if (volume.file.data) unmapFile(volume.file);
+    std::vector<unsigned char>().swap(volume.owned);
+    volume.voxels = nullptr;
+}
+
+void updateVolume(Volume& volume, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos)
+{
+    volume.frame++;
+
+    // Lista niepustych blokw zmienia si tylko razem z funkcj przejcia
+    if (volume.visibleVersion != volume.transferVersion)
+    {
+        volume.visibleBricks.clear();
+        for (int brick = 0; brick < (int)volume.brickRanges.size(); brick++)
+        {
+            if (volume.loadEmpty || brickVisible(volume, brick)) volume.visibleBricks.push_back(brick);
+        }
+        volume.visibleVersion = volume.transferVersion;
+    }
+
+    glm::vec4 planes[6];
+    frustumPlanes(viewProj, planes);
+    glm::vec3 brickExtent = glm::vec3((float)Volume::brickSize) / glm::vec3(volume.size);
+    float radius = glm::length(glm::vec3(model * glm::vec4(brickExtent * 0.5f, 0.0f)));
+    auto brickCenter = [&](uint32_t brick)
+    {
+        return glm::vec3(model * glm::vec4((glm::vec3(brickCoords(volume, brick)) + 0.5f) * brickExtent, 1.0f));
+    };
+    volume.wanted.clear();
+    for (uint32_t brick : volume.visibleBricks)
+    {
+        if (sphereInPlanes(planes, brickCenter(brick), radius)) volume.wanted.push_back(brick);
+    }
+
+    // Gdy pula nie mieci wszystkich, zostaj najblisze kamerze
+    auto closer = [&](uint32_t a, uint32_t b)
+    {
+        glm::vec3 da = brickCenter(a) - cameraPos, db = brickCenter(b) - cameraPos;
+        return glm::dot(da, da) < glm::dot(db, db);
+    };
+    size_t keep = std::min(volume.wanted.size(), volume.slots.size());
+    if (keep < volume.wanted.size())
+    {
+        std::nth_element(volume.wanted.begin(), volume.wanted.begin() + keep, volume.wanted.end(), closer);
+        volume.wanted.resize(keep);
+    }
+    std::sort(volume.wanted.begin(), volume.wanted.end(), closer);
+
+    volume.uploads.clear();
+    for (uint32_t brick : volume.wanted)
+    {
+        int slot = volume.brickSlots[brick];
+        if (slot >= 0) volume.slots[slot].lastUsed = volume.frame;
+        else if ((int)volume.uploads.size() < volume.uploadsPerFrame) volume.uploads.push_back(glm::ivec2(brick, -1));
+    }
+    if (volume.uploads.empty()) return;
+
+    // Miejsca nieuyte w tej klatce od najstarszych, wolne maj lastUsed 0
+    volume.victims.clear();
+    for (uint32_t slot = 0; slot < volume.slots.size(); slot++)
+    {
+        if (volume.slots[slot].lastUsed != volume.frame) volume.victims.push_back(slot);
+    }
+    size_t uploads = std::min(volume.uploads.size(), volume.victims.size());
+    auto older = [&](uint32_t a, uint32_t b) { return volume.slots[a].lastUsed < volume.slots[b].lastUsed; };
+    if (uploads < volume.victims.size()) std::nth_element(volume.victims.begin(), volume.victims.begin() + uploads, volume.victims.end(), older);
+    volume.uploads.resize(uploads);
+    for (size_t i = 0; i < uploads; i++) volume.uploads[i].y = (int)volume.victims[i];
+
+    // Kopiowanie z ramk na wtkach, wysyanie na wtku kontekstu
+    size_t slotBytes = (size_t)Volume::paddedBrick * Volume::paddedBrick * Volume::paddedBrick * poolBytes(volume.format);
+    if (volume.staging.size() < uploads * slotBytes) volume.staging.resize(uploads * slotBytes);
+    parallelFor((unsigned)uploads, [&](unsigned first, unsigned last)
+    {
+        for (unsigned i = first; i < last; i++) gatherBrick(volume, volume.uploads[i].x, volume.staging.data() + i * slotBytes);
+    });
+
+    const unsigned char emptyPage[4] = { 0, 0, 0, 0 };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < uploads; i++)
+    {
+        int brick = volume.uploads[i].x, slot = volume.uploads[i].y;
+        glm::ivec3 coords = slotCoords(volume, slot);
+        glBindTexture(GL_TEXTURE_3D, volume.poolTexture);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, coords.x * Volume::paddedBrick, coords.y * Volume::paddedBrick, coords.z * Volume::paddedBrick,
+            Volume::paddedBrick, Volume::paddedBrick, Volume::paddedBrick, GL_RED,
+            volume.format == VoxelFormat::UInt8 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT, volume.staging.data() + i * slotBytes);
+
+        glBindTexture(GL_TEXTURE_3D, volume.pageTexture);
+        VolumeBrickSlot& entry = volume.slots[slot];
+        if (entry.brick >= 0)
+        {
+            volume.brickSlots[entry.brick] = -1;
+            setPage(volume, entry.brick, emptyPage);
+        }
+        const unsigned char page[4] = { (unsigned char)coords.x, (unsigned char)coords.y, (unsigned char)coords.z, 255 };
+        setPage(volume, brick, page);
+        entry.brick = brick;
+        entry.lastUsed = volume.frame;
+        volume.brickSlots[brick] = slot;
+        volume.uploadedBytes += slotBytes;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void drawVolume(const Volume& volume, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos)
+{
+    glUseProgram(volume.program);
+    glUniformMatrix4fv(volume.uniModel, 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(volume.uniViewProj, 1, GL_FALSE, glm::value_ptr(viewProj));
+    glUniform3fv(volume.uniCameraVolume, 1, glm::value_ptr(glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f))));
+    glUniform1f(volume.uniStepSize, volume.stepSize);
+    glUniform1i(volume.uniSkipping, volume.skipping ? 1 : 0);
+    // Przektna krokami plus jedno przeskoczenie na kady przecity blok
+    glUniform1i(volume.uniMaxSteps, (int)(glm::length(glm::vec3(volume.size)) / volume.stepSize) + 2 * (volume.bricks.x + volume.bricks.y + volume.bricks.z) + 16);
+
+    const GLenum targets[] = { GL_TEXTURE_3D, GL_TEXTURE_3D, GL_TEXTURE_3D, GL_TEXTURE_1D, GL_TEXTURE_2D };
+    const GLuint textures[] = { volume.poolTexture, volume.pageTexture, volume.rangeTexture, volume.transferTexture, volume.rangeOpacityTexture };
+    for (int unit = 0; unit < 5; unit++)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(targets[unit], textures[unit]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // Tylne ciany, wic promie dziaa take z kamer wewntrz wolumenu; kolor z alf przemnoon
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(volume.vao);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+    glDisable(GL_BLEND);
+    glCullFace(GL_BACK);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_DEPTH_TEST);
+}
+
+int runVolumeViewer(sf::Window& window, const char* path, const glm::ivec3& size, VoxelFormat format, uint64_t memoryBudget)
+{
+    Volume volume;
+    if (!openVolume(volume, path, size, format)) return 1;
+    if (!createVolumeRenderer(volume, memoryBudget))
+    {
+        destroyVolume(volume);
+        return 1;
+    }
+    glm::mat4 model = volumeModel(volume);
+
+    CameraState camera;
+    camera.position = glm::vec3(0.0f, 0.0f, 2.0f);
+    Simulation simulation;
+    simulation.moveSpeed = 0.5f;
+    startSimulation(simulation, window, camera);
+
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)width / height, 0.01f, 20.0f);
+
+    bool running = true;
+    sf::Clock fpsClock;
+    int frameCount = 0, transferEdits = 0;
+    while (running)
+    {
+        sf::Event windowEvent;
+        while (window.pollEvent(windowEvent))
+        {
+            if (windowEvent.type == sf::Event::Closed ||
+                (windowEvent.type == sf::Event::KeyPressed && windowEvent.key.code == sf::Keyboard::Escape))
+            {
+                running = false;
+            }
+            if (windowEvent.type != sf::Event::KeyPressed) continue;
+            // + i - zmieniaj krok marszu, K przeskakiwanie pustych blokw
+            if (windowEvent.key.code == sf::Keyboard::Add) volume.stepSize = std::max(volume.stepSize * 0.5f, 0.125f);
+            if (windowEvent.key.code == sf::Keyboard::Subtract) volume.stepSize = std::min(volume.stepSize * 2.0f, 8.0f);
+            if (windowEvent.key.code == sf::Keyboard::K) volume.skipping = !volume.skipping;
+            // Strzaki przesuwaj okno funkcji przejcia (lewo, prawo) i zmieniaj jego szeroko (gra, d)
+            float center = volume.transferCenter, transferWidth = volume.transferWidth;
+            if (windowEvent.key.code == sf::Keyboard::Left) center -= 0.02f;
+            if (windowEvent.key.code == sf::Keyboard::Right) center += 0.02f;
+            if (windowEvent.key.code == sf::Keyboard::Up) transferWidth *= 1.25f;
+            if (windowEvent.key.code == sf::Keyboard::Down) transferWidth *= 0.8f;
+            if (center != volume.transferCenter || transferWidth != volume.transferWidth)
+            {
+                setTransferWindow(volume, center, transferWidth);
+                transferEdits++;
+            }
+        }
+
+        camera = sampleCamera(simulation);
+        glm::mat4 viewProj = proj * cameraView(camera);
+        updateVolume(volume, model, viewProj, camera.position);
+
+        glClearColor(0.05f, 0.05f, 0.07f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        drawVolume(volume, model, viewProj, camera.position);
+        window.display();
+
+        frameCount++;
+        if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
+        {
+            size_t resident = 0;
+            for (const VolumeBrickSlot& slot : volume.slots) resident += slot.brick >= 0 ? 1 : 0;
+            window.setTitle("Volume - FPS: " + std::to_string(frameCount) + " - step: " + std::to_string(volume.stepSize) +
+                (volume.skipping ? ", skipping" : ", no skipping") + " - bricks: " + std::to_string(volume.wanted.size()) + " wanted, " +
+                std::to_string(resident) + "/" + std::to_string(volume.slots.size()) + " resident, uploaded: " +
+                std::to_string(volume.uploadedBytes / (1024 * 1024)) + " MB - transfer edits: " + std::to_string(transferEdits));
+            frameCount = 0;
+            fpsClock.restart();
+        }
+    }
+
+    stopSimulation(simulation);
+    destroyVolume(volume);
+    checkGLErrors("After volume viewer");
+    return 0;
+}
+
+int runVolumeBenchmark(sf::Window& window, int maxSize)
+{
+    window.setVerticalSyncEnabled(false);
+    int width = (int)window.getSize().x, height = (int)window.getSize().y;
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), (float)width / height, 0.01f, 20.0f);
+    glm::vec3 cameraPos(0.6f, 0.4f, 1.9f);
+    glm::mat4 viewProj = proj * glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const int frames = 20;
+
+    for (int size = 128; size <= maxSize; size *= 2)
+    {
+        Volume volume;
+        auto start = std::chrono::steady_clock::now();
+        generateVolume(volume, size);
+        std::cout << "Generated " << size << "^3 volume in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0
+            << " ms" << std::endl;
+
+        // Pula na wszystkie bloki, take puste, eby bez przeskakiwania marsz szed przez cay wolumen
+        uint64_t slotBytes = (uint64_t)Volume::paddedBrick * Volume::paddedBrick * Volume::paddedBrick;
+        uint64_t side = (size + Volume::brickSize - 1) / Volume::brickSize;
+        if (!createVolumeRenderer(volume, side * side * side * slotBytes))
+        {
+            destroyVolume(volume);
+            return 1;
+        }
+        size_t nonEmpty = 0;
+        for (int brick = 0; brick < (int)volume.brickRanges.size(); brick++) nonEmpty += brickVisible(volume, brick) ? 1 : 0;
+        volume.loadEmpty = true;
+        volume.uploadsPerFrame = (int)volume.brickRanges.size();
+        glm::mat4 model = volumeModel(volume);
+        start = std::chrono::steady_clock::now();
+        updateVolume(volume, model, viewProj, cameraPos);
+        glFinish();
+        std::cout << "  " << nonEmpty << "/" << volume.brickRanges.size() << " bricks non-empty, " << volume.wanted.size() << " uploaded in "
+            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 << " ms" << std::endl;
+
+        for (bool skipping : { false, true })
+        {
+            for (float step : { 0.5f, 1.0f, 2.0f })
+            {
+                volume.skipping = skipping;
+                volume.stepSize = step;
+                drawVolume(volume, model, viewProj, cameraPos);
+                glFinish();
+                start = std::chrono::steady_clock::now();
+                for (int frame = 0; frame < frames; frame++)
+                {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    drawVolume(volume, model, viewProj, cameraPos);
+                }
+                glFinish();
+                window.display();
+                double ms = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0 / frames;
+                std::cout << "  step " << step << (skipping ? ", skipping: " : ", no skipping: ") << ms << " ms/frame" << std::endl;
+            }
+        }
+        destroyVolume(volume);
+    }
+    checkGLErrors("After volume benchmark");
+    return 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+namespace sf
+{
+    class Window;
+}
+
+// Wolumen skalarny rysowany marszem promieni w shaderze fragmentw. Surowy plik jest odwzorowany
+// w pami i dzielony na bloki 32^3 wokseli, ktre trafiaj do puli w jednej teksturze 3D
+// (z ramk jednego woksela dla filtrowania na granicach blokw). Tablica stron mwi, gdzie
+// ley kady blok, a siatka min/max blokw razem z tabel najwikszej nieprzezroczystoci
+// w przedziale wartoci pozwala przeskakiwa puste bloki. Funkcja przejcia to osobna tekstura 1D,
+// wic jej zmiana nie wysya ponownie danych wolumenu.
+
+enum class VoxelFormat
+{
+    UInt8,
+    UInt16,
+    Float32
+};
+
+struct VolumeBrickSlot
+{
+    int brick = -1;
+    unsigned lastUsed = 0;
+};
+
+struct Volume
+{
+    static const int brickSize = 32;
+    static const int paddedBrick = brickSize + 2;
+
+    glm::ivec3 size = glm::ivec3(0);    // Woksele
+    glm::ivec3 bricks = glm::ivec3(0);  // Bloki w kadej osi
+    VoxelFormat format = VoxelFormat::UInt8;
+    MappedFile file;
+    std::vector<unsigned char> owned;   // Wolumen wygenerowany w pamici zamiast pliku
+    const unsigned char* voxels = nullptr;
+    float valueMin = 0.0f, valueMax = 1.0f; // Zakres Float32 sprowadzany do [0, 1]
+
+    std::vector<glm::vec2> brickRanges; // Min i max bloku cznie z ramk, po sprowadzeniu do [0, 1]
+
+    // Funkcja przejcia i najwiksza nieprzezroczysto w kadym przedziale jej 256 wartoci
+    std::vector<glm::vec4> transfer;
+    std::vector<unsigned char> rangeOpacity;
+    float transferCenter = 0.35f, transferWidth = 0.5f;
+    unsigned transferVersion = 0;
+
+    // Pula blokw na GPU i stan wczytywania
+    glm::ivec3 poolSlots = glm::ivec3(0);
+    std::vector<VolumeBrickSlot> slots;
+    std::vector<int> brickSlots;        // Miejsce bloku w puli, -1 gdy go nie ma
+    std::vector<uint32_t> wanted;       // Niepuste bloki w ostrosupie, od najbliszych
+    std::vector<uint32_t> visibleBricks; // Niepuste bloki dla biecej funkcji przejcia
+    unsigned visibleVersion = ~0u;
+    std::vector<glm::ivec2> uploads;    // Blok i miejsce w puli wczytywane w tej klatce
+    std::vector<uint32_t> victims;      // Miejsca do zwolnienia, od najdawniej uywanych
+    std::vector<unsigned char> staging;
+    int uploadsPerFrame = 128;
+    bool loadEmpty = false;             // Wczytywanie take pustych blokw, do pomiaru bez przeskakiwania
+    unsigned frame = 0;
+    uint64_t uploadedBytes = 0;
+
+    GLuint poolTexture = 0, pageTexture = 0, rangeTexture = 0, transferTexture = 0, rangeOpacityTexture = 0;
+    GLuint program = 0, vao = 0, vbo = 0;
+    GLint uniModel = -1, uniViewProj = -1, uniCameraVolume = -1, uniStepSize = -1, uniSkipping = -1, uniMaxSteps = -1;
+    float stepSize = 1.0f; // Krok marszu w wokselach
+    bool skipping = true;
+};
+
+// Surowy plik x * y * z wokseli bez nagwka, x zmienia si najszybciej
+bool openVolume(Volume& volume, const std::string& path, const glm::ivec3& size, VoxelFormat format);
+
+// Wolumen testowy: kilka rozmytych kul i powok w pustym otoczeniu, wartoci UInt8
+void generateVolume(Volume& volume, int size);
+
+// Siatka min/max blokw, program, tekstury i pula mieszczca si w memoryBudget bajtach
+bool createVolumeRenderer(Volume& volume, uint64_t memoryBudget);
+void destroyVolume(Volume& volume);
+
+// Nowa funkcja przejcia: okno wartoci [center - width / 2, center + width / 2] z map kolorw
+void setTransferWindow(Volume& volume, float center, float width);
+
+// Wybr i wczytanie brakujcych blokw dla kamery, raz na klatk
+void updateVolume(Volume& volume, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos);
+
+// Marsz promieni przez prostopadocian wolumenu, model przeksztaca [0, 1]^3 na wiat
+void drawVolume(const Volume& volume, const glm::mat4& model, const glm::mat4& viewProj, const glm::vec3& cameraPos);
+
+// Przegldarka wolumenu z kamer sterowan mysz i klawiatur
+int runVolumeViewer(sf::Window& window, const char* path, const glm::ivec3& size, VoxelFormat format, uint64_t memoryBudget);
+
+// Pomiar: czas klatki dla kilku rozmiarw wolumenu i krokw, z przeskakiwaniem pustych blokw i bez
+int runVolumeBenchmark(sf::Window& window, int maxSize);
@@ -0,0 +1,254 @@
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    // Trjkt pokrywajcy ekran z gl_VertexID, bez bufora wierzchokw
+    const GLchar* upscaleVertexSource = R"glsl(
+#version 150 core
+out vec2 uv;
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)glsl";
+
+    // Prbkowanie dwuliniowe czci celu, opcjonalnie wyostrzenie krzyem ssiadw
+    // ograniczone do ich zakresu, eby nie tworzyo obwdek
+    const GLchar* upscaleFragmentSource = R"glsl(
+#version 150 core
+in vec2 uv;
+out vec4 outColor;
+uniform sampler2D source;
+uniform vec2 sourceScale; // Cz tekstury zajta przez klatk
+uniform vec2 texelSize;
+uniform float sharpness;
+void main()
+{
+    vec2 limit = sourceScale - texelSize * 0.5;
+    vec2 at = min(uv * sourceScale, limit);
+    vec3 center = texture(source, at).rgb;
+    if (sharpness <= 0.0)
+    {
+        outColor = vec4(center, 1.0);
+        return;
+    }
+    vec3 left = texture(source, clamp(at - vec2(texelSize.x, 0.0), texelSize * 0.5, limit)).rgb;
+    vec3 right = texture(source, clamp(at + vec2(texelSize.x, 0.0), texelSize * 0.5, limit)).rgb;
+    vec3 down = texture(source, clamp(at - vec2(0.0, texelSize.y), texelSize * 0.5, limit)).rgb;
+    vec3 up = texture(source, clamp(at + vec2(0.0, texelSize.y), texelSize * 0.5, limit)).rgb;
+    vec3 low = min(center, min(min(left, right), min(down, up)));
+    vec3 high = max(center, max(max(left, right), max(down, up)));
+    vec3 sharpened = center + (center * 4.0 - left - right - down - up) * 0.25 * sharpness;
+    outColor = vec4(clamp(sharpened, low, high), 1.0);
+}
+)glsl";
+
+    GLuint compileShader(GLenum type, const GLchar* source, const char* name)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        GLint status;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (!status)
+        {
+            GLchar log[512];
+            glGetShaderInfoLog(shader, 512, nullptr, log);
+            std::cerr << "Error: Compilation of " << name << " failed\n" << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    // Regulator: pole klatki proporcjonalne do stosunku celu do pomiaru, z zapasem i tumieniem,
+    // eby opnione o kilka klatek wyniki GPU nie rozhutay skali
+    void adjustScale(DynamicResolution& resolution)
+    {
+        double measured = std::max(resolution.cpuMs, resolution.gpuMs);
+        if (measured <= 0.0) return;
+        double wanted = resolution.scale * std::sqrt(resolution.targetMs * 0.9 / measured);
+        wanted = std::min(std::max(wanted, (double)resolution.minScale), 1.0);
+        float next = resolution.scale + (float)(wanted - resolution.scale) * 0.3f;
+        if (std::abs(next - resolution.scale) > 0.01f || wanted == 1.0) resolution.scale = next;
+        resolution.scale = std::min(std::max(resolution.scale, resolution.minScale), 1.0f);
+    }
+
+    // Wymiary w wielokrotnociach 8 pikseli, drobne zmiany skali nie zmieniaj celu co klatk
+    int scaledSize(int size, float scale)
+    {
+        int scaled = ((int)std::lround(size * scale) + 7) / 8 * 8;
+        return std::min(std::max(scaled, 8), size);
+    }
+}
+
+bool createDynamicResolution(DynamicResolution& resolution, int width, int height)
+{
+    resolution.width = width;
+    resolution.height = height;
+    resolution.renderWidth = width;
+    resolution.renderHeight = height;
+
+    glGenTextures(1, &resolution.colorTexture);
+    glBindTexture(GL_TEXTURE_2D, resolution.colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenRenderbuffers(1, &resolution.depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolution.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    // Cel ma rozmiar okna, mniejsza skala to tylko mniejszy viewport, bez ponownego przydziau
+    glGenFramebuffers(1, &resolution.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolution.colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, resolution.depthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Error: Dynamic resolution framebuffer incomplete: " << status << std::endl;
+        destroyDynamicResolution(resolution);
+        return false;
+    }
+
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, upscaleVertexSource, "upscale vertex shader");
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, upscaleFragmentSource, "upscale fragment shader");
+    if (!vertexShader || !fragmentShader)
+    {
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        destroyDynamicResolution(resolution);
+        return false;
+    }
+    resolution.upscaleProgram = glCreateProgram();
+    glAttachShader(resolution.upscaleProgram, vertexShader);
+    glAttachShader(resolution.upscaleProgram, fragmentShader);
+    glBindFragDataLocation(resolution.upscaleProgram, 0, "outColor");
+    glLinkProgram(resolution.upscaleProgram);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    GLint linked;
+    glGetProgramiv(resolution.upscaleProgram, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        std::cerr << "Error: Linking of upscale program failed" << std::endl;
+        destroyDynamicResolution(resolution);
+        return false;
+    }
+    resolution.uniSourceScale = glGetUniformLocation(resolution.upscaleProgram, "sourceScale");
+    resolution.uniTexelSize = glGetUniformLocation(resolution.upscaleProgram, "texelSize");
+    resolution.uniSharpness = glGetUniformLocation(resolution.upscaleProgram, "sharpness");
+    glUseProgram(resolution.upscaleProgram);
+    glUniform1i(glGetUniformLocation(resolution.upscaleProgram, "source"), 0);
+    glUniform2f(resolution.uniTexelSize, 1.0f / width, 1.0f / height);
+    glGenVertexArrays(1, &resolution.vao);
+
+    // Bez zapyta o czas regulator patrzy tylko na CPU, co przy programowym GL i tak obejmuje rysowanie
+    resolution.timerQueries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (resolution.timerQueries) glGenQueries(DynamicResolution::queryCount, resolution.queries);
+    return true;
+}
+
+void destroyDynamicResolution(DynamicResolution& resolution)
+{
+    glDeleteFramebuffers(1, &resolution.framebuffer);
+    glDeleteTextures(1, &resolution.colorTexture);
+    glDeleteRenderbuffers(1, &resolution.depthBuffer);
+    glDeleteProgram(resolution.upscaleProgram);
+    glDeleteVertexArrays(1, &resolution.vao);
+    if (resolution.timerQueries) glDeleteQueries(DynamicResolution::queryCount, resolution.queries);
+    resolution.framebuffer = resolution.colorTexture = resolution.depthBuffer = 0;
+    resolution.upscaleProgram = resolution.vao = 0;
+    resolution.timerQueries = false;
+    if (resolution.trace.is_open()) resolution.trace.close();
+}
+
+bool openResolutionTrace(DynamicResolution& resolution, const std::string& path)
+{
+    resolution.trace.open(path);
+    if (!resolution.trace.is_open())
+    {
+        std::cerr << "Cannot open file: " << path << std::endl;
+        return false;
+    }
+    resolution.trace << "frame,cpu_ms,gpu_ms,scale,width,height\n";
+    return true;
+}
+
+void beginDynamicFrame(DynamicResolution& resolution)
+{
+    // Najstarsze zapytanie piercienia, jeli GPU ju je zakoczyo
+    if (resolution.timerQueries && resolution.queryFrame >= (unsigned)DynamicResolution::queryCount)
+    {
+        GLuint query = resolution.queries[resolution.queryFrame % DynamicResolution::queryCount];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            resolution.gpuMs = nanoseconds * 1e-6;
+        }
+    }
+
+    if (resolution.enabled)
+    {
+        adjustScale(resolution);
+        resolution.renderWidth = scaledSize(resolution.width, resolution.scale);
+        resolution.renderHeight = scaledSize(resolution.height, resolution.scale);
+        glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    }
+    else
+    {
+        resolution.renderWidth = resolution.width;
+        resolution.renderHeight = resolution.height;
+    }
+    glViewport(0, 0, resolution.renderWidth, resolution.renderHeight);
+
+    if (resolution.timerQueries) glBeginQuery(GL_TIME_ELAPSED, resolution.queries[resolution.queryFrame % DynamicResolution::queryCount]);
+}
+
+void endDynamicFrame(DynamicResolution& resolution, double cpuMs)
+{
+    if (resolution.enabled)
+    {
+        // Rozcignicie zajtej czci celu na cae okno
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, resolution.width, resolution.height);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        glDisable(GL_DEPTH_TEST);
+        GLint program;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glUseProgram(resolution.upscaleProgram);
+        glUniform2f(resolution.uniSourceScale, (float)resolution.renderWidth / resolution.width, (float)resolution.renderHeight / resolution.height);
+        glUniform1f(resolution.uniSharpness, resolution.sharpen && resolution.renderWidth < resolution.width ? 0.5f : 0.0f);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, resolution.colorTexture);
+        glBindVertexArray(resolution.vao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        if (depthTest) glEnable(GL_DEPTH_TEST);
+        glUseProgram(program);
+    }
+
+    if (resolution.timerQueries)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        resolution.queryFrame++;
+    }
+    resolution.cpuMs = cpuMs;
+    resolution.frame++;
+    if (resolution.trace.is_open())
+    {
+        resolution.trace << resolution.frame << ',' << cpuMs << ',' << resolution.gpuMs << ',' << resolution.scale << ','
+            << resolution.renderWidth << ',' << resolution.renderHeight << '\n';
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <GL/glew.h>
+#include <fstream>
+#include <string>
+
+// Dynamiczna rozdzielczo: scena rysowana do celu poza ekranem w czci jego rozmiaru,
+// a potem skalowana do okna. Regulator co klatk zmienia skal tak, eby czas klatki
+// (wikszy z czasu GPU z zapyta i czasu CPU) trzyma si zadanego celu. Koszt owietlenia
+// na fragment ronie z liczb pikseli, wic skala dziaa na pole, nie na bok.
+
+struct DynamicResolution
+{
+    float targetMs = 16.6f;
+    float minScale = 0.35f;   // Skala boku, 1 to pena rozdzielczo okna
+    float scale = 1.0f;
+    bool enabled = true;      // false: rysowanie prosto do okna, bez celu i skalowania
+    bool sharpen = true;      // false: samo filtrowanie dwuliniowe
+
+    int width = 0, height = 0;             // Rozmiar okna i celu
+    int renderWidth = 0, renderHeight = 0; // Cz celu, do ktrej rysuje bieca klatka
+
+    GLuint framebuffer = 0, colorTexture = 0, depthBuffer = 0;
+    GLuint upscaleProgram = 0, vao = 0;
+    GLint uniSourceScale = -1, uniTexelSize = -1, uniSharpness = -1;
+
+    // Zapytania o czas GPU w piercieniu, wynik czytany kilka klatek pniej bez czekania
+    static const int queryCount = 4;
+    GLuint queries[queryCount] = {};
+    unsigned queryFrame = 0;
+    bool timerQueries = false;
+
+    double cpuMs = 0.0, gpuMs = 0.0; // Ostatnie pomiary
+    unsigned frame = 0;
+    std::ofstream trace;             // Jeden wiersz na klatk, gdy plik jest otwarty
+};
+
+bool createDynamicResolution(DynamicResolution& resolution, int width, int height);
+void destroyDynamicResolution(DynamicResolution& resolution);
+
+// Zapis przebiegu: frame, cpu_ms, gpu_ms, scale, width, height
+bool openResolutionTrace(DynamicResolution& resolution, const std::string& path);
+
+// Pocztek klatki: regulacja skali z ostatnich pomiarw, wizanie celu i viewportu renderWidth x renderHeight
+void beginDynamicFrame(DynamicResolution& resolution);
+
+// Koniec sceny: skalowanie do okna, cpuMs to czas pracy CPU w klatce bez czekania na synchronizacj pionow
+void endDynamicFrame(DynamicResolution& resolution, double cpuMs);
@@ -0,0 +1,460 @@
+#include "job_system.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <queue>
+
+namespace
+{
+    const int idleSpins = 64;   // Nieudane szukania zadania przed upieniem wtku
+
+    thread_local JobSystem* currentSystem = nullptr;
+    thread_local unsigned currentWorker = 0;
+
+    // Waciciel wkada na d, zwraca false gdy kolejka jest pena
+    bool pushJob(JobDeque& deque, Job* job)
+    {
+        int64_t bottom = deque.bottom.load(std::memory_order_relaxed);
+        int64_t top = deque.top.load(std::memory_order_acquire);
+        if (bottom - top >= JobDeque::capacity) return false;
+        deque.jobs[bottom & (JobDeque::capacity - 1)].store(job, std::memory_order_relaxed);
+        deque.bottom.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waciciel bierze z dou, o ostatnie zadanie ciga si ze zodziejami przez CAS na top
+    Job* popJob(JobDeque& deque)
+    {
+        int64_t bottom = deque.bottom.load(std::memory_order_relaxed) - 1;
+        deque.bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = deque.top.load(std::memory_order_relaxed);
+        if (top > bottom)
+        {
+            deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = deque.jobs[bottom & (JobDeque::capacity - 1)].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            if (!deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+            deque.bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // Dowolny wtek bierze z gry
+    Job* stealJob(JobDeque& deque)
+    {
+        int64_t top = deque.top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = deque.bottom.load(std::memory_order_acquire);
+        if (top >= bottom) return nullptr;
+        Job* job = deque.jobs[top & (JobDeque::capacity - 1)].load(std::memory_order_relaxed);
+        if (!deque.top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+        return job;
+    }
+
+    // Wtek systemu do wasnej kolejki, pozostae i przepenienie do wsplnej
+    void enqueue(JobSystem& system, Job* job)
+    {
+        if (currentSystem != &system || !pushJob(system.deques[currentWorker], job))
+        {
+            std::lock_guard<std::mutex> lock(system.injectedMutex);
+            system.injected.push_back(job);
+            system.injectedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        system.queued.fetch_add(1);
+        if (system.sleeping.load() > 0)
+        {
+            // Pusta sekcja krytyczna: picy albo ju widzi queued, albo czeka i dostanie sygna
+            { std::lock_guard<std::mutex> lock(system.sleepMutex); }
+            system.wake.notify_one();
+        }
+    }
+
+    // Wasna kolejka, wsplna, potem kradzie od losowej ofiary; worker < 0 dla wtkw spoza systemu
+    Job* findJob(JobSystem& system, int worker, uint32_t& random)
+    {
+        Job* job = worker >= 0 ? popJob(system.deques[worker]) : nullptr;
+        if (!job && system.injectedCount.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(system.injectedMutex);
+            if (!system.injected.empty())
+            {
+                job = system.injected.front();
+                system.injected.pop_front();
+                system.injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        if (!job && system.threadCount > 1)
+        {
+            random = random * 1664525u + 1013904223u;
+            unsigned first = (random >> 8) % system.threadCount;
+            for (unsigned i = 0; i < system.threadCount && !job; i++)
+            {
+                unsigned victim = (first + i) % system.threadCount;
+                if ((int)victim == worker) continue;
+                job = stealJob(system.deques[victim]);
+                if (worker >= 0) (job ? system.stats[worker].steals : system.stats[worker].failedSteals).fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (job) system.queued.fetch_sub(1);
+        return job;
+    }
+
+    void executeJob(JobSystem& system, Job* job, int worker)
+    {
+        auto start = std::chrono::steady_clock::now();
+        job->function(job->data, job->begin, job->end);
+        if (worker >= 0)
+        {
+            JobWorkerStats& stats = system.stats[worker];
+            stats.executed.fetch_add(1, std::memory_order_relaxed);
+            stats.busyNanoseconds.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+                std::memory_order_relaxed);
+        }
+
+        // Nastpniki przed licznikiem: po zejciu licznika do zera czekajcy moe zwolni zadania
+        for (Job* successor : job->successors)
+        {
+            if (successor->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) enqueue(system, successor);
+        }
+        if (job->counter) job->counter->fetch_sub(1, std::memory_order_release);
+    }
+
+    void workerLoop(JobSystem& system, unsigned worker)
+    {
+        currentSystem = &system;
+        currentWorker = worker;
+        uint32_t random = worker * 2654435761u + 1;
+        int idle = 0;
+        while (system.running.load(std::memory_order_relaxed))
+        {
+            if (Job* job = findJob(system, (int)worker, random))
+            {
+                executeJob(system, job, (int)worker);
+                idle = 0;
+                continue;
+            }
+            if (++idle < idleSpins)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            system.sleeping.fetch_add(1);
+            {
+                std::unique_lock<std::mutex> lock(system.sleepMutex);
+                system.wake.wait(lock, [&] { return system.queued.load() > 0 || !system.running.load(); });
+            }
+            system.sleeping.fetch_sub(1);
+            idle = 0;
+        }
+        currentSystem = nullptr;
+    }
+
+    int workerIndex(const JobSystem& system)
+    {
+        return currentSystem == &system ? (int)currentWorker : -1;
+    }
+
+    // Wsplny stan jednego parallelFor, zadania czci le w parts pod indeksem begin / grain
+    struct ParallelRange
+    {
+        JobSystem* system;
+        Job* parts;
+        unsigned grain;
+        std::atomic<int>* counter;
+        void (*function)(void*, unsigned, unsigned);
+        void* data;
+    };
+
+    // Druga poowa zakresu do kolejki, a zostanie jedna cz
+    void splitRange(void* data, unsigned begin, unsigned end)
+    {
+        ParallelRange& range = *static_cast<ParallelRange*>(data);
+        while (end - begin > range.grain)
+        {
+            unsigned pieces = (end - begin + range.grain - 1) / range.grain;
+            unsigned middle = begin + (pieces + 1) / 2 * range.grain;
+            Job& half = range.parts[middle / range.grain];
+            half.function = splitRange;
+            half.data = data;
+            half.begin = middle;
+            half.end = end;
+            submitJob(*range.system, half, range.counter);
+            end = middle;
+        }
+        range.function(range.data, begin, end);
+    }
+
+    void runGraphTask(void* data, unsigned, unsigned)
+    {
+        (*static_cast<std::function<void()>*>(data))();
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    if (running) stopJobSystem(*this);
+}
+
+void startJobSystem(JobSystem& system, unsigned threads)
+{
+    system.threadCount = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    system.deques.reset(new JobDeque[system.threadCount]);
+    system.stats.reset(new JobWorkerStats[system.threadCount]);
+    system.owner = std::this_thread::get_id();
+    system.running = true;
+    system.statsStart = std::chrono::steady_clock::now();
+    currentSystem = &system;
+    currentWorker = 0;
+    for (unsigned worker = 1; worker < system.threadCount; worker++)
+    {
+        system.workers.emplace_back(workerLoop, std::ref(system), worker);
+    }
+}
+
+void stopJobSystem(JobSystem& system)
+{
+    system.running = false;
+    {
+        std::lock_guard<std::mutex> lock(system.sleepMutex);
+    }
+    system.wake.notify_all();
+    for (std::thread& worker : system.workers) worker.join();
+    system.workers.clear();
+    if (currentSystem == &system) currentSystem = nullptr;
+}
+
+JobSystem& sharedJobSystem()
+{
+    static JobSystem system;
+    static std::once_flag started;
+    std::call_once(started, [] { startJobSystem(system); });
+    return system;
+}
+
+unsigned jobThreadCount()
+{
+    return sharedJobSystem().threadCount;
+}
+
+void submitJob(JobSystem& system, Job& job, std::atomic<int>* counter)
+{
+    job.counter = counter;
+    if (counter) counter->fetch_add(1, std::memory_order_relaxed);
+    enqueue(system, &job);
+}
+
+void waitJobs(JobSystem& system, std::atomic<int>& counter)
+{
+    int worker = workerIndex(system);
+    uint32_t random = (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1u;
+    while (counter.load(std::memory_order_acquire) > 0)
+    {
+        if (Job* job = findJob(system, worker, random)) executeJob(system, job, worker);
+        else std::this_thread::yield();
+    }
+}
+
+uint32_t addJob(JobGraph& graph, std::function<void()> task)
+{
+    graph.tasks.push_back(std::move(task));
+    graph.jobs.emplace_back();
+    Job& job = graph.jobs.back();
+    job.function = runGraphTask;
+    job.data = &graph.tasks.back();
+    return (uint32_t)graph.jobs.size() - 1;
+}
+
+void addDependency(JobGraph& graph, uint32_t before, uint32_t after)
+{
+    graph.jobs[before].successors.push_back(&graph.jobs[after]);
+    graph.jobs[after].dependencyCount++;
+}
+
+void runJobGraph(JobSystem& system, JobGraph& graph)
+{
+    // Liczniki ustawione przed woeniem czegokolwiek, bo zadania mog koczy si od razu
+    std::atomic<int> counter((int)graph.jobs.size());
+    for (Job& job : graph.jobs)
+    {
+        job.dependencies.store(job.dependencyCount, std::memory_order_relaxed);
+        job.counter = &counter;
+    }
+    for (Job& job : graph.jobs)
+    {
+        if (job.dependencyCount == 0) enqueue(system, &job);
+    }
+    waitJobs(system, counter);
+}
+
+void runParallel(JobSystem& system, unsigned count, unsigned jobs, void (*function)(void*, unsigned, unsigned), void* data)
+{
+    if (count == 0) return;
+    if (jobs == 0) jobs = system.threadCount * 4;
+    jobs = std::min(jobs, count);
+    if (jobs <= 1 || system.threadCount <= 1)
+    {
+        function(data, 0, count);
+        return;
+    }
+
+    // Czci jak w zwykym podziale na jobs kawakw, rni si tylko kto je wykonuje
+    unsigned grain = (count + jobs - 1) / jobs;
+    // Zwykle czci mieszcz si na stosie, ptla co klatk nie przydziela wtedy pamici
+    unsigned partCount = (count + grain - 1) / grain;
+    Job localParts[64];
+    std::vector<Job> heapParts(partCount > 64 ? partCount : 0);
+    Job* parts = partCount > 64 ? heapParts.data() : localParts;
+    std::atomic<int> counter(0);
+    ParallelRange range = { &system, parts, grain, &counter, function, data };
+    parts[0].function = splitRange;
+    parts[0].data = &range;
+    parts[0].begin = 0;
+    parts[0].end = count;
+    submitJob(system, parts[0], &counter);
+    waitJobs(system, counter);
+}
+
+JobStats readJobStats(JobSystem& system, bool reset)
+{
+    JobStats result;
+    uint64_t busy = 0;
+    for (unsigned worker = 0; worker < system.threadCount; worker++)
+    {
+        JobWorkerStats& stats = system.stats[worker];
+        result.executed += reset ? stats.executed.exchange(0) : stats.executed.load();
+        result.steals += reset ? stats.steals.exchange(0) : stats.steals.load();
+        result.failedSteals += reset ? stats.failedSteals.exchange(0) : stats.failedSteals.load();
+        busy += reset ? stats.busyNanoseconds.exchange(0) : stats.busyNanoseconds.load();
+    }
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - system.statsStart).count();
+    if (elapsed > 0.0 && system.threadCount > 0) result.utilization = busy * 1e-9 / (elapsed * system.threadCount);
+    if (reset) system.statsStart = now;
+    return result;
+}
+
+namespace
+{
+    // Zadanie testowe: co sme sto razy drosze, eby cz wtkw skoczya wczeniej i krada
+    double benchmarkTask(unsigned index, unsigned baseCost)
+    {
+        unsigned cost = (index * 2654435761u >> 29) == 0 ? baseCost * 100 : baseCost;
+        double sum = 0.0;
+        for (unsigned i = 0; i < cost; i++) sum += std::sqrt((double)(i + index));
+        return sum;
+    }
+
+    // Najprostsza pula: jedna kolejka std::function pod jednym mutexem
+    struct MutexQueue
+    {
+        std::mutex mutex;
+        std::condition_variable ready, done;
+        std::queue<std::function<void()>> tasks;
+        std::vector<std::thread> threads;
+        unsigned pending = 0;
+        bool stop = false;
+    };
+
+    void startMutexQueue(MutexQueue& queue, unsigned threads)
+    {
+        for (unsigned i = 0; i < threads; i++)
+        {
+            queue.threads.emplace_back([&queue]
+            {
+                std::unique_lock<std::mutex> lock(queue.mutex);
+                while (true)
+                {
+                    queue.ready.wait(lock, [&] { return queue.stop || !queue.tasks.empty(); });
+                    if (queue.tasks.empty()) return;
+                    std::function<void()> task = std::move(queue.tasks.front());
+                    queue.tasks.pop();
+                    lock.unlock();
+                    task();
+                    lock.lock();
+                    if (--queue.pending == 0) queue.done.notify_all();
+                }
+            });
+        }
+    }
+
+    void stopMutexQueue(MutexQueue& queue)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.stop = true;
+        }
+        queue.ready.notify_all();
+        for (std::thread& thread : queue.threads) thread.join();
+    }
+}
+
+int runJobBenchmark(unsigned tasks)
+{
+    JobSystem& system = sharedJobSystem();
+    tasks = std::max(tasks, 1u);
+    std::vector<double> results(tasks);
+    std::cout << "Jobs: " << tasks << " tasks on " << system.threadCount << " threads, every 8th task 100x longer" << std::endl;
+
+    MutexQueue queue;
+    startMutexQueue(queue, system.threadCount);
+    for (unsigned baseCost : { 0u, 200u })
+    {
+        std::cout << "  " << (baseCost ? "uneven tasks" : "empty tasks") << ":" << std::endl;
+        auto report = [&](const char* name, double seconds)
+        {
+            std::cout << "    " << name << ": " << seconds * 1000.0 << " ms, " << seconds * 1e9 / tasks << " ns per task" << std::endl;
+        };
+
+        // System zada, jedno zadanie na element i automatyczny podzia
+        for (unsigned jobs : { tasks, 0u })
+        {
+            readJobStats(system);
+            auto start = std::chrono::steady_clock::now();
+            parallelFor(tasks, [&](unsigned begin, unsigned end)
+            {
+                for (unsigned i = begin; i < end; i++) results[i] = benchmarkTask(i, baseCost);
+            }, jobs);
+            report(jobs ? "work stealing, task per item" : "work stealing, 4 parts per thread", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            JobStats stats = readJobStats(system);
+            std::cout << "      " << stats.executed << " jobs, " << stats.steals << " steals, " << stats.failedSteals << " failed steals, utilization "
+                << stats.utilization * 100.0 << "%" << std::endl;
+        }
+
+        // Wtki z std::async, po jednym na wtek systemu zada, biorce kolejne zadania ze wsplnego licznika.
+        // Wtek na kade zadanie przy dziesitkach tysicy zada mierzyby tworzenie wtkw i ich limit.
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<unsigned> next{ 0 };
+        std::vector<std::future<void>> futures;
+        for (unsigned t = 0; t < system.threadCount; t++)
+        {
+            futures.push_back(std::async(std::launch::async, [&]
+            {
+                for (unsigned i = next++; i < tasks; i = next++) results[i] = benchmarkTask(i, baseCost);
+            }));
+        }
+        for (std::future<void>& future : futures) future.get();
+        report("std::async, shared counter", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        // Wsplna kolejka z mutexem
+        start = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.pending += tasks;
+            for (unsigned i = 0; i < tasks; i++) queue.tasks.push([&results, i, baseCost] { results[i] = benchmarkTask(i, baseCost); });
+        }
+        queue.ready.notify_all();
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.done.wait(lock, [&] { return queue.pending == 0; });
+        }
+        report("mutex queue", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    stopMutexQueue(queue);
+    return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// System zada z kradzie pracy: staa liczba wtkw roboczych, kady z wasn kolejk
+// Chase-Lev, do ktrej sam wkada i z ktrej sam bierze od koca, a bezczynni kradn od pocztku.
+// Wtek czekajcy na zadania nie pi, tylko wykonuje cudze, wic parallelFor mona zagnieda.
+// Zalenoci bez fiberw: zadanie po zakoczeniu zmniejsza licznik nastpnikw i wkada te,
+// ktrych licznik doszed do zera. Zadania z wtkw spoza systemu trafiaj do wsplnej kolejki.
+
+struct Job
+{
+    void (*function)(void* data, unsigned begin, unsigned end) = nullptr;
+    void* data = nullptr;
+    unsigned begin = 0, end = 0;
+    std::atomic<int>* counter = nullptr;  // Zmniejszany po wykonaniu, na nim czeka waitJobs
+    std::atomic<int> dependencies{ 0 };   // Niezakoczeni poprzednicy
+    int dependencyCount = 0;              // Liczba poprzednikw, dependencies wraca do niej przy kadym uruchomieniu grafu
+    std::vector<Job*> successors;
+};
+
+// Kolejka Chase-Lev o staej pojemnoci: push i pop tylko waciciel, steal dowolny wtek
+struct JobDeque
+{
+    static const int64_t capacity = 4096;
+    std::atomic<int64_t> top{ 0 };
+    std::atomic<int64_t> bottom{ 0 };
+    std::atomic<Job*> jobs[capacity];
+};
+
+// Liczniki wtku, kady na osobnej linii pamici podrcznej
+struct alignas(64) JobWorkerStats
+{
+    std::atomic<uint64_t> executed{ 0 };
+    std::atomic<uint64_t> steals{ 0 };
+    std::atomic<uint64_t> failedSteals{ 0 };
+    std::atomic<uint64_t> busyNanoseconds{ 0 };
+};
+
+struct JobSystem
+{
+    // Kolejka 0 naley do wtku, ktry uruchomi system, pozostae do wtkw roboczych
+    std::unique_ptr<JobDeque[]> deques;
+    std::unique_ptr<JobWorkerStats[]> stats;
+    std::vector<std::thread> workers;
+    unsigned threadCount = 0;             // Wtki robocze razem z wtkiem uruchamiajcym
+    std::thread::id owner;
+
+    // Zadania z wtkw spoza systemu
+    std::mutex injectedMutex;
+    std::deque<Job*> injected;
+    std::atomic<int> injectedCount{ 0 };
+
+    // Usypianie bezczynnych wtkw
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };         // Zadania woone, jeszcze nie wzite
+    std::atomic<int> sleeping{ 0 };
+    std::atomic<bool> running{ false };
+    std::chrono::steady_clock::time_point statsStart;
+
+    ~JobSystem();
+};
+
+// Start systemu z threads wtkami razem z biecym (0 oznacza wszystkie rdzenie)
+void startJobSystem(JobSystem& system, unsigned threads = 0);
+void stopJobSystem(JobSystem& system);
+
+// Wsplny system programu uruchamiany przy pierwszym uyciu z wtku gwnego
+JobSystem& sharedJobSystem();
+unsigned jobThreadCount();
+
+// Woenie zadania, counter zwikszany od razu, zmniejszany po wykonaniu
+void submitJob(JobSystem& system, Job& job, std::atomic<int>* counter);
+// Wykonywanie zada, a counter dojdzie do zera
+void waitJobs(JobSystem& system, std::atomic<int>& counter);
+
+// Graf zada: zadanie uruchamia si, gdy skocz si wszystkie jego poprzedniki
+struct JobGraph
+{
+    std::deque<Job> jobs;
+    std::deque<std::function<void()>> tasks;
+};
+
+uint32_t addJob(JobGraph& graph, std::function<void()> task);
+void addDependency(JobGraph& graph, uint32_t before, uint32_t after);
+void runJobGraph(JobSystem& system, JobGraph& graph);
+
+// Podzia [0, count) na jobs rwnych czci wykonywanych rwnolegle, task(begin, end). Zakres jest
+// dzielony na p, a zostanie jedna cz, wic zodziej od razu dostaje poow pracy.
+// jobs = 0 oznacza cztery czci na wtek, jobs = 1 wykonuje wszystko na biecym wtku
+void runParallel(JobSystem& system, unsigned count, unsigned jobs, void (*function)(void*, unsigned, unsigned), void* data);
+
+template <typename Task>
+void parallelFor(unsigned count, const Task& task, unsigned jobs = 0)
+{
+    runParallel(sharedJobSystem(), count, jobs, [](void* data, unsigned begin, unsigned end)
+    {
+        (*static_cast<const Task*>(data))(begin, end);
+    }, const_cast<Task*>(&task));
+}
+
+// Suma licznikw od ostatniego odczytu, utilization to redni odsetek czasu spdzonego w zadaniach
+struct JobStats
+{
+    uint64_t executed = 0;
+    uint64_t steals = 0;
+    uint64_t failedSteals = 0;
+    double utilization = 0.0;
+};
+
+JobStats readJobStats(JobSystem& system, bool reset = true);
+
+// Pomiar: drobne zadania o nierwnym koszcie przez system zada, std::async i prost kolejk z mutexem
+int runJobBenchmark(unsigned tasks);
@@ -0,0 +1,280 @@
+#include "lights.h"
+#include "job_system.h"
+#include <SFML/Window.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    // Zakres kafelkw pokrytych przez kul zasigu wiata, false gdy wiato jest poza ekranem.
+    // Prostokt jest zachowawczy: brzegi kuli rzutowane z gbokoci najbardziej rozszerzajc obraz.
+    bool lightTiles(const Light& light, const glm::mat4& view, const glm::mat4& proj, int width, int height,
+        int tileSize, int tilesX, int tilesY, glm::ivec4& rect)
+    {
+        glm::vec3 c = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        float r = light.radius;
+        float nearPlane = proj[3][2] / (proj[2][2] - 1.0f);
+
+        if (c.z - r >= -nearPlane) return false; // Caa kula za paszczyzn blisk
+
+        float x0 = -1.0f, x1 = 1.0f, y0 = -1.0f, y1 = 1.0f;
+        if (c.z + r < -nearPlane)
+        {
+            float nearDepth = -(c.z + r), farDepth = -(c.z - r);
+            auto projectMax = [&](float v, float scale)
+            {
+                return scale * v / (v > 0.0f ? nearDepth : farDepth);
+            };
+            auto projectMin = [&](float v, float scale)
+            {
+                return scale * v / (v < 0.0f ? nearDepth : farDepth);
+            };
+            x1 = projectMax(c.x + r, proj[0][0]);
+            x0 = projectMin(c.x - r, proj[0][0]);
+            y1 = projectMax(c.y + r, proj[1][1]);
+            y0 = projectMin(c.y - r, proj[1][1]);
+            if (x0 > 1.0f || x1 < -1.0f || y0 > 1.0f || y1 < -1.0f) return false;
+        }
+
+        // Wsprzdne okna jak gl_FragCoord, y ronie w gr
+        auto tile = [&](float ndc, int size, int tiles)
+        {
+            int t = (int)std::floor((ndc * 0.5f + 0.5f) * size / tileSize);
+            return std::min(std::max(t, 0), tiles - 1);
+        };
+        rect = glm::ivec4(tile(x0, width, tilesX), tile(y0, height, tilesY), tile(x1, width, tilesX), tile(y1, height, tilesY));
+        return true;
+    }
+
+    void attachBuffer(GLuint& buffer, GLuint& texture, GLenum format)
+    {
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    }
+
+    template <typename T>
+    void uploadBuffer(GLuint buffer, const std::vector<T>& data)
+    {
+        // Nowy magazyn co klatk, sterownik nie czeka na klatk, ktra jeszcze czyta stary
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(data.size() * sizeof(T), 16), NULL, GL_STREAM_DRAW);
+        if (!data.empty()) glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(T), data.data());
+    }
+}
+
+Light pointLight(const glm::vec3& position, float radius, const glm::vec3& color)
+{
+    return Light{ position, radius, color, -1.0f, glm::vec3(0.0f, -1.0f, 0.0f), -2.0f };
+}
+
+Light spotLight(const glm::vec3& position, const glm::vec3& direction, float radius, const glm::vec3& color, float innerDegrees, float outerDegrees)
+{
+    return Light{ position, radius, color, std::cos(glm::radians(innerDegrees)), glm::normalize(direction), std::cos(glm::radians(outerDegrees)) };
+}
+
+void createLightGrid(LightGrid& grid)
+{
+    attachBuffer(grid.lightBuffer, grid.lightTexture, GL_RGBA32F);
+    attachBuffer(grid.rangeBuffer, grid.rangeTexture, GL_RG32UI);
+    attachBuffer(grid.indexBuffer, grid.indexTexture, GL_R32UI);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void destroyLightGrid(LightGrid& grid)
+{
+    GLuint buffers[] = { grid.lightBuffer, grid.rangeBuffer, grid.indexBuffer };
+    GLuint textures[] = { grid.lightTexture, grid.rangeTexture, grid.indexTexture };
+    glDeleteBuffers(3, buffers);
+    glDeleteTextures(3, textures);
+    grid.lightBuffer = grid.rangeBuffer = grid.indexBuffer = 0;
+    grid.lightTexture = grid.rangeTexture = grid.indexTexture = 0;
+}
+
+void cullLights(LightGrid& grid, const glm::mat4& view, const glm::mat4& proj, int width, int height, unsigned threads)
+{
+    if (threads == 0) threads = jobThreadCount();
+    grid.tilesX = (width + grid.tileSize - 1) / grid.tileSize;
+    grid.tilesY = (height + grid.tileSize - 1) / grid.tileSize;
+    unsigned tileCount = (unsigned)(grid.tilesX * grid.tilesY);
+    unsigned lightCount = (unsigned)grid.lights.size();
+    grid.tileRanges.assign(tileCount * 2, 0);
+
+    if (!grid.culling)
+    {
+        grid.tileLights.resize(lightCount);
+        for (unsigned i = 0; i < lightCount; i++) grid.tileLights[i] = i;
+        for (unsigned t = 0; t < tileCount; t++) grid.tileRanges[t * 2 + 1] = lightCount;
+        return;
+    }
+
+    // Prostokty wiate, kade wiato niezalenie; pusty prostokt dla niewidocznych
+    grid.rects.resize(lightCount);
+    parallelFor(lightCount, [&](unsigned begin, unsigned end)
+    {
+        for (unsigned i = begin; i < end; i++)
+        {
+            if (!lightTiles(grid.lights[i], view, proj, width, height, grid.tileSize, grid.tilesX, grid.tilesY, grid.rects[i]))
+            {
+                grid.rects[i] = glm::ivec4(0, 0, -1, -1);
+            }
+        }
+    }, threads);
+
+    // Kady wtek dostaje pas wierszy kafelkw, wic liczniki i listy si nie nakadaj
+    unsigned bands = std::min(threads, (unsigned)grid.tilesY);
+    unsigned rowsPerBand = (grid.tilesY + bands - 1) / bands;
+    grid.tileCounts.assign(tileCount, 0);
+    auto forEachBand = [&](unsigned begin, unsigned end, bool fill)
+    {
+        for (unsigned band = begin; band < end; band++)
+        {
+            int row0 = band * rowsPerBand;
+            int row1 = std::min<int>(grid.tilesY, row0 + rowsPerBand) - 1;
+            for (unsigned i = 0; i < lightCount; i++)
+            {
+                const glm::ivec4& r = grid.rects[i];
+                int y0 = std::max(r.y, row0), y1 = std::min(r.w, row1);
+                for (int y = y0; y <= y1; y++)
+                {
+                    for (int x = r.x; x <= r.z; x++)
+                    {
+                        GLuint& counter = grid.tileCounts[y * grid.tilesX + x];
+                        if (fill) grid.tileLights[counter] = i;
+                        counter++;
+                    }
+                }
+            }
+        }
+    };
+
+    parallelFor(bands, [&](unsigned begin, unsigned end) { forEachBand(begin, end, false); }, bands);
+
+    // Pocztki list kafelkw, liczniki staj si kursorami zapisu
+    GLuint offset = 0;
+    for (unsigned t = 0; t < tileCount; t++)
+    {
+        grid.tileRanges[t * 2] = offset;
+        grid.tileRanges[t * 2 + 1] = grid.tileCounts[t];
+        grid.tileCounts[t] = offset;
+        offset += grid.tileRanges[t * 2 + 1];
+    }
+    grid.tileLights.resize(offset);
+
+    parallelFor(bands, [&](unsigned begin, unsigned end) { forEachBand(begin, end, true); }, bands);
+}
+
+void uploadLightGrid(LightGrid& grid)
+{
+    uploadBuffer(grid.lightBuffer, grid.lights);
+    uploadBuffer(grid.rangeBuffer, grid.tileRanges);
+    uploadBuffer(grid.indexBuffer, grid.tileLights);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void bindLightGrid(const LightGrid& grid, GLuint program, int firstUnit)
+{
+    GLuint textures[] = { grid.lightTexture, grid.rangeTexture, grid.indexTexture };
+    const char* samplers[] = { "lightData", "tileRanges", "tileLights" };
+    for (int i = 0; i < 3; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        glUniform1i(glGetUniformLocation(program, samplers[i]), firstUnit + i);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, "tileSize"), grid.tileSize);
+    glUniform1i(glGetUniformLocation(program, "tilesX"), grid.tilesX);
+}
+
+int runLightBenchmark(sf::Window& window, LightGrid& grid, GLuint program, const glm::mat4& proj,
+    const std::function<void(const glm::mat4& view)>& drawScene)
+{
+    window.setVerticalSyncEnabled(false);
+    int width = (int)window.getSize().x;
+    int height = (int)window.getSize().y;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, 12.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "lightingEnabled"), GL_TRUE);
+    glUniform1i(glGetUniformLocation(program, "lightingType"), 3);
+    glUniform3f(glGetUniformLocation(program, "viewPos"), 0.0f, 10.0f, 12.0f);
+
+    std::cout << "Lights: " << width << "x" << height << ", tiles " << grid.tileSize << "x" << grid.tileSize
+        << ", " << jobThreadCount() << " threads" << std::endl;
+
+    const int frames = 30;
+    const unsigned counts[] = { 64, 256, 1024, 4096, 16384 };
+    for (unsigned count : counts)
+    {
+        std::mt19937 rng(count);
+        std::uniform_real_distribution<float> pos(-16.0f, 16.0f);
+        std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+        grid.lights.clear();
+        for (unsigned i = 0; i < count; i++)
+        {
+            glm::vec3 p(pos(rng), 0.5f, pos(rng));
+            glm::vec3 color(channel(rng), channel(rng), channel(rng));
+            if (i % 4 == 0) grid.lights.push_back(spotLight(p + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 2.5f, color, 20.0f, 30.0f));
+            else grid.lights.push_back(pointLight(p, 1.5f, color));
+        }
+
+        std::cout << "  " << count << " lights:";
+        for (int culling = 1; culling >= 0; culling--)
+        {
+            // Bez kafelkw kady fragment liczy wszystkie wiata, przy tysicach to sekundy na klatk
+            if (!culling && count > 1024)
+            {
+                std::cout << "  all lights per pixel: skipped";
+                continue;
+            }
+            grid.culling = culling != 0;
+            double cullSeconds = 0.0;
+            size_t assigned = 0;
+            glFinish();
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                sf::Event windowEvent;
+                while (window.pollEvent(windowEvent)) {}
+
+                auto cullStart = std::chrono::steady_clock::now();
+                cullLights(grid, view, proj, width, height);
+                cullSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - cullStart).count();
+                assigned = grid.tileLights.size();
+
+                uploadLightGrid(grid);
+                glUseProgram(program);
+                bindLightGrid(grid, program, 1);
+                glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                drawScene(view);
+                window.display();
+            }
+            glFinish();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (culling)
+            {
+                std::cout << "  tiled: cull " << cullSeconds / frames * 1000.0 << " ms, "
+                    << (double)assigned / (grid.tilesX * grid.tilesY) << " lights/tile, frame ";
+            }
+            else
+            {
+                std::cout << "  all lights per pixel: frame ";
+            }
+            std::cout << seconds / frames * 1000.0 << " ms";
+        }
+        std::cout << std::endl;
+    }
+    grid.culling = true;
+    return 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+namespace sf
+{
+    class Window;
+}
+
+// Owietlenie forward+: wiata punktowe i reflektory w buforze tekstury, ekran podzielony na kafelki,
+// dla kadego kafelka lista wiate, ktrych kula zasigu go pokrywa. Przydzia liczony na CPU
+// na kilku wtkach, shader fragmentw przechodzi tylko po wiatach swojego kafelka (lightingType 3).
+
+// Jedno wiato, trzy teksele RGBA32F w buforze
+struct Light
+{
+    glm::vec3 position;
+    float radius;        // Zasig, poza nim wiato nie dziaa
+    glm::vec3 color;
+    float cosInner;      // Cosinus wewntrznego stoka reflektora
+    glm::vec3 direction; // Kierunek reflektora
+    float cosOuter;      // Cosinus zewntrznego stoka, -2 dla wiata punktowego
+};
+
+struct LightGrid
+{
+    int tileSize = 16;
+    int tilesX = 0;
+    int tilesY = 0;
+    bool culling = true; // false: kade wiato w kadym kafelku, do porwnania
+
+    std::vector<Light> lights;
+    std::vector<glm::ivec4> rects;     // Zakres kafelkw kadego wiata, x0, y0, x1, y1 wcznie
+    std::vector<GLuint> tileRanges;    // Pocztek i liczba wiate dla kadego kafelka
+    std::vector<GLuint> tileLights;    // Indeksy wiate kolejnych kafelkw
+    std::vector<GLuint> tileCounts;    // Bufor roboczy do liczenia
+
+    GLuint lightBuffer = 0, lightTexture = 0;
+    GLuint rangeBuffer = 0, rangeTexture = 0;
+    GLuint indexBuffer = 0, indexTexture = 0;
+};
+
+Light pointLight(const glm::vec3& position, float radius, const glm::vec3& color);
+Light spotLight(const glm::vec3& position, const glm::vec3& direction, float radius, const glm::vec3& color, float innerDegrees, float outerDegrees);
+
+void createLightGrid(LightGrid& grid);
+void destroyLightGrid(LightGrid& grid);
+
+// Przydzia wiate do kafelkw dla biecej kamery, threads = 0 oznacza wszystkie rdzenie
+void cullLights(LightGrid& grid, const glm::mat4& view, const glm::mat4& proj, int width, int height, unsigned threads = 0);
+
+// Wysanie wiate i list kafelkw do GPU i podpicie ich do programu od podanej jednostki tekstury
+void uploadLightGrid(LightGrid& grid);
+void bindLightGrid(const LightGrid& grid, GLuint program, int firstUnit);
+
+// Pomiar: czas przydziau i czas klatki dla rosncej liczby wiate, z kafelkami i bez
+int runLightBenchmark(sf::Window& window, LightGrid& grid, GLuint program, const glm::mat4& proj,
+    const std::function<void(const glm::mat4& view)>& drawScene);
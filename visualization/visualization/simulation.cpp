@@ -0,0 +1,243 @@
+#include "simulation.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+    // Obrt kamery o przesunicie myszy od poprzedniego kroku, true gdy kamera si obrcia
+    bool updateCameraMouse(Simulation& sim)
+    {
+        sf::Vector2i position = sf::Mouse::getPosition(*sim.window);
+        if (sim.firstMouse)
+        {
+            sim.lastMouse = position;
+            sim.firstMouse = false;
+        }
+
+        float xoffset = (position.x - sim.lastMouse.x) * sim.sensitivity;
+        float yoffset = (sim.lastMouse.y - position.y) * sim.sensitivity; // odwrotnie, aby poruszanie w gr byo dodatnie
+        sim.lastMouse = position;
+        if (xoffset == 0.0f && yoffset == 0.0f) return false;
+
+        CameraState& camera = sim.camera;
+        camera.yaw += xoffset;
+        camera.pitch = std::min(std::max(camera.pitch + yoffset, -89.0f), 89.0f);
+
+        // Kierunek liczony raz na krok i tylko gdy kty si zmieniy
+        glm::vec3 front;
+        front.x = cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+        front.y = sin(glm::radians(camera.pitch));
+        front.z = sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+        camera.front = glm::normalize(front);
+        return true;
+    }
+
+    bool updateCameraKeys(Simulation& sim)
+    {
+        CameraState& camera = sim.camera;
+        glm::vec3 start = camera.position;
+        float cameraSpeed = sim.moveSpeed * (float)sim.tickSeconds;
+        glm::vec3 right = glm::normalize(glm::cross(camera.front, camera.up));
+
+        // Poruszanie w przd i w ty
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
+            camera.position += cameraSpeed * camera.front;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
+            camera.position -= cameraSpeed * camera.front;
+
+        // Poruszanie w lewo i w prawo
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
+            camera.position -= right * cameraSpeed;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
+            camera.position += right * cameraSpeed;
+
+        // Poruszanie w gr i w d
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
+            camera.position += cameraSpeed * camera.up;
+        if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
+            camera.position -= cameraSpeed * camera.up;
+        return camera.position != start;
+    }
+
+    void simulationLoop(Simulation& sim)
+    {
+        auto tick = std::chrono::duration<double>(sim.tickSeconds);
+        auto next = std::chrono::steady_clock::now();
+        unsigned tickIndex = 0, quietTicks = 1;
+        CameraState previous = sim.camera;
+
+        while (sim.running.load(std::memory_order_relaxed))
+        {
+            {
+                std::unique_lock<std::mutex> lock(sim.pauseMutex);
+                sim.pauseWake.wait(lock, [&] { return !sim.paused; });
+            }
+
+            // Wejcie czytane tylko gdy okno ma fokus, tak jak zdarzenia. Ruch myszy z czasu
+            // wstrzymania trafia do pierwszego kroku po wznowieniu.
+            bool changed = false;
+            if (sim.window->hasFocus())
+            {
+                changed = updateCameraMouse(sim);
+                changed = updateCameraKeys(sim) || changed;
+            }
+            quietTicks = changed ? 0 : quietTicks + 1;
+
+            SceneSnapshot& snapshot = sim.snapshots.writeSlot();
+            snapshot.previous = previous;
+            snapshot.current = sim.camera;
+            snapshot.tickTime = sim.clock.getElapsedTime().asSeconds();
+            snapshot.tick = ++tickIndex;
+            snapshot.quietTicks = quietTicks;
+            sim.snapshots.publish();
+            previous = sim.camera;
+
+            // Po dugim przestoju kolejne kroki nie s nadrabiane seriami
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(tick);
+            auto now = std::chrono::steady_clock::now();
+            if (next < now) next = now;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    glm::vec3 mixDirection(const glm::vec3& a, const glm::vec3& b, float t)
+    {
+        glm::vec3 d = a + (b - a) * t;
+        float length = glm::length(d);
+        return length > 0.0f ? d / length : b;
+    }
+}
+
+void startSimulation(Simulation& sim, sf::Window& window, const CameraState& initial)
+{
+    sim.window = &window;
+    sim.camera = initial;
+    sim.firstMouse = true;
+
+    // Pierwsza migawka przed startem wtku, eby renderer nigdy nie czyta pustej
+    SceneSnapshot& snapshot = sim.snapshots.writeSlot();
+    snapshot.previous = initial;
+    snapshot.current = initial;
+    snapshot.tickTime = sim.clock.getElapsedTime().asSeconds();
+    snapshot.tick = 0;
+    snapshot.quietTicks = 1;
+    sim.snapshots.publish();
+
+    sim.running = true;
+    sim.thread = std::thread(simulationLoop, std::ref(sim));
+}
+
+void stopSimulation(Simulation& sim)
+{
+    sim.running = false;
+    resumeSimulation(sim);
+    if (sim.thread.joinable()) sim.thread.join();
+}
+
+CameraState sampleCamera(Simulation& sim)
+{
+    sim.snapshots.update();
+    const SceneSnapshot& snapshot = sim.snapshots.read();
+
+    // Renderer jest co najwyej jeden krok za symulacj, przejcie midzy krokami jest pynne
+    double elapsed = sim.clock.getElapsedTime().asSeconds() - snapshot.tickTime;
+    float t = (float)std::min(std::max(elapsed / sim.tickSeconds, 0.0), 1.0);
+
+    CameraState camera = snapshot.current;
+    camera.position = snapshot.previous.position + (snapshot.current.position - snapshot.previous.position) * t;
+    camera.front = mixDirection(snapshot.previous.front, snapshot.current.front, t);
+    return camera;
+}
+
+glm::mat4 cameraView(const CameraState& camera)
+{
+    return glm::lookAt(camera.position, camera.position + camera.front, camera.up);
+}
+
+void pauseSimulation(Simulation& sim)
+{
+    std::lock_guard<std::mutex> lock(sim.pauseMutex);
+    sim.paused = true;
+}
+
+void resumeSimulation(Simulation& sim)
+{
+    {
+        std::lock_guard<std::mutex> lock(sim.pauseMutex);
+        sim.paused = false;
+    }
+    sim.pauseWake.notify_one();
+}
+
+bool waitForFrame(FramePacing& pacing, Simulation& sim, sf::Window& window, sf::Event& event)
+{
+    if (!pacing.onDemand || pacing.dirty) return false;
+
+    // Ostatnia klatka pokazuje stan spoczynku, jeli od jej migawki do najnowszej kamera
+    // si nie ruszya, rwnie w kroku tamtej migawki (czyli bez interpolacji w toku)
+    unsigned drawnTick = sim.snapshots.read().tick;
+    sim.snapshots.update();
+    const SceneSnapshot& latest = sim.snapshots.read();
+    if (latest.quietTicks <= latest.tick - drawnTick) return false;
+
+    // Po wybudzeniu symulacja musi zrobi peny krok, zanim spoczynek znowu co znaczy
+    if (latest.tick <= pacing.wakeTick + 1) return false;
+
+    double start = sim.clock.getElapsedTime().asSeconds();
+    pauseSimulation(sim);
+    bool received = window.waitEvent(event);
+    resumeSimulation(sim);
+    pacing.idleSeconds += sim.clock.getElapsedTime().asSeconds() - start;
+    pacing.wakeups++;
+    pacing.wakeTick = sim.snapshots.read().tick;
+    pacing.dirty = true;
+    return received;
+}
+
+PacingReport readPacingReport(FramePacing& pacing, Simulation& sim)
+{
+    PacingReport report;
+    double now = sim.clock.getElapsedTime().asSeconds(), cpu = processCpuSeconds();
+    double elapsed = now - pacing.reportTime;
+    if (elapsed > 0.0)
+    {
+        report.fps = pacing.frames / elapsed;
+        report.cpuPercent = (cpu - pacing.reportCpu) / elapsed * 100.0;
+        report.idlePercent = pacing.idleSeconds / elapsed * 100.0;
+    }
+    report.wakeups = pacing.wakeups;
+    pacing.frames = 0;
+    pacing.wakeups = 0;
+    pacing.idleSeconds = 0.0;
+    pacing.reportCpu = cpu;
+    pacing.reportTime = now;
+    return report;
+}
+
+double processCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0.0;
+    ULARGE_INTEGER kernelTime, userTime;
+    kernelTime.LowPart = kernel.dwLowDateTime;
+    kernelTime.HighPart = kernel.dwHighDateTime;
+    userTime.LowPart = user.dwLowDateTime;
+    userTime.HighPart = user.dwHighDateTime;
+    return (kernelTime.QuadPart + userTime.QuadPart) * 1e-7; // Jednostki po 100 ns
+#else
+    rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <atomic>
+
+// Bufor potrjny bez blokad dla jednego piszcego i jednego czytajcego.
+// Piszcy zawsze ma wolny slot, czytajcy dostaje najnowsz kompletn warto,
+// aden z wtkw nie czeka na drugi. Wartoci porednie mog zosta pominite.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : middle(1), front(0), back(2) {}
+
+    // Wtek piszcy: slot do wypenienia, potem publish()
+    T& writeSlot()
+    {
+        return slots[back];
+    }
+
+    void publish()
+    {
+        // Wypeniony slot trafia do rodka z flag nowej wartoci, poprzedni rodek staje si wolny
+        back = middle.exchange(back | freshFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Wtek czytajcy: true jeli od ostatniego wywoania pojawia si nowa warto
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & freshFlag)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& read() const
+    {
+        return slots[front];
+    }
+
+private:
+    static const unsigned indexMask = 3;
+    static const unsigned freshFlag = 4;
+
+    T slots[3];
+    std::atomic<unsigned> middle; // Indeks slotu wymiany i flaga nowej wartoci
+    unsigned front;               // Naley do czytajcego
+    unsigned back;                // Naley do piszcego
+};
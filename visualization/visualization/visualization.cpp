@@ -9,6 +9,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "stb_image.h"
+#include "simulation.h"
+#include "lights.h"
+#include "job_system.h"
+#include "dynamic_resolution.h"
+#include <cstring>
 
 // Kody shaderw
 const GLchar* vertexSource = R"glsl(
@@ -49,7 +54,7 @@ in vec3 FragPos;
 out vec4 outColor;
 
 uniform sampler2D texture1;
-uniform int lightingType; // 0: Directional, 1: Point, 2: Spotlight
+uniform int lightingType; // 0: Directional, 1: Point, 2: Spotlight, 3: Wiele wiate w kafelkach
 uniform bool lightingEnabled;
 
 // Wsplne zmienne dla wiate
@@ -73,6 +78,44 @@ uniform float diffuseStrength = 1.0;
 uniform float specularStrength = 0.5;
 uniform float shininess = 32.0;
 
+// wiata w kafelkach ekranu (forward+)
+uniform samplerBuffer lightData;   // Trzy teksele na wiato: pozycja i zasig, kolor, kierunek
+uniform usamplerBuffer tileRanges; // Pocztek i liczba wiate kafelka
+uniform usamplerBuffer tileLights; // Indeksy wiate
+uniform int tileSize = 16;
+uniform int tilesX = 1;
+
+vec3 tiledLighting(vec3 norm, vec3 viewDir)
+{
+    ivec2 tile = ivec2(gl_FragCoord.xy) / tileSize;
+    uvec2 range = texelFetch(tileRanges, tile.y * tilesX + tile.x).xy;
+    vec3 result = vec3(0.0);
+
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int light = int(texelFetch(tileLights, int(range.x + i)).x) * 3;
+        vec4 positionRadius = texelFetch(lightData, light);
+        vec4 colorInner = texelFetch(lightData, light + 1);
+        vec4 directionOuter = texelFetch(lightData, light + 2);
+
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w) continue;
+        vec3 lightDirection = toLight / distance;
+
+        // Tumienie spadajce do zera na granicy zasigu, inaczej kafelki byyby widoczne
+        float falloff = 1.0 - (distance * distance) / (positionRadius.w * positionRadius.w);
+        float attenuation = falloff * falloff;
+        float theta = dot(-lightDirection, directionOuter.xyz);
+        attenuation *= clamp((theta - directionOuter.w) / max(colorInner.w - directionOuter.w, 0.0001), 0.0, 1.0);
+
+        float diff = max(dot(norm, lightDirection), 0.0);
+        float spec = pow(max(dot(viewDir, reflect(-lightDirection, norm)), 0.0), shininess);
+        result += attenuation * (diffuseStrength * diff + specularStrength * spec) * colorInner.rgb;
+    }
+    return result;
+}
+
 void main()
 {
     if (!lightingEnabled) 
@@ -84,6 +127,14 @@ void main()
     vec3 ambient = ambientStrength * lightColor; // Ambient - wsplne dla wszystkich
 
     vec3 norm = normalize(Normal); // Normalizacja normalnej
+
+    if (lightingType == 3) // Wiele wiate
+    {
+        vec3 lighting = ambient + tiledLighting(norm, normalize(viewPos - FragPos));
+        outColor = vec4(lighting, 1.0) * texture(texture1, TexCoord);
+        return;
+    }
+
     vec3 lightDirection;
     float attenuation = 1.0;      // Tumienie, domylnie brak
     float spotlightEffect = 1.0;  // Efekt stoka reflektora, domylnie brak
@@ -134,16 +185,6 @@ void main()
 
 )glsl";
 
-// Utworzenie zmiennych do ustawienia kamery
-glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
-glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
-glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-float yaw = -90.0f;
-float pitch = 0.0f;
-float sensitivity = 0.1f;
-float lastX = 400, lastY = 300;
-bool firstMouse = true;
-
 bool checkShaders(GLuint shader, const std::string& type)
 {
     GLint status;
@@ -164,83 +205,11 @@ bool checkShaders(GLuint shader, const std::string& type)
     }
 }
 
-void ustawKamereMysz(GLint uniView, float deltaTime, sf::Window& window) 
+int main(int argc, char** argv)
 {
-    sf::Vector2i localPosition = sf::Mouse::getPosition(window);
-
-    if (firstMouse)
-    {
-        lastX = localPosition.x;
-        lastY = localPosition.y;
-        firstMouse = false;
-    }
-
-    // Obliczenie przesunicia myszy
-    float xoffset = localPosition.x - lastX;
-    float yoffset = lastY - localPosition.y; // odwrotnie, aby poruszanie w gr byo dodatnie
-    lastX = localPosition.x;
-    lastY = localPosition.y;
-
-    xoffset *= sensitivity;
-    yoffset *= sensitivity;
-
-    // Aktualizacja ktw obrotu kamery
-    yaw += xoffset;
-    pitch += yoffset;
+    // System zada startuje na wtku gwnym, ktry dostaje wasn kolejk i czekajc wykonuje zadania
+    sharedJobSystem();
 
-    // Ograniczenie kta nachylenia w pionie
-    if (pitch > 89.0f) pitch = 89.0f;
-    if (pitch < -89.0f) pitch = -89.0f;
-
-    // Obliczanie nowego kierunku patrzenia
-    glm::vec3 front;
-    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    front.y = sin(glm::radians(pitch));
-    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraFront = glm::normalize(front);
-
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-    glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
-}
-
-
-void ustawKamereKlawisze(GLint uniView, float deltaTime) 
-{
-    float cameraSpeed = 0.5f * deltaTime;
-
-    // Poruszanie w przd i w ty
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-        cameraPos += cameraSpeed * cameraFront;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-        cameraPos -= cameraSpeed * cameraFront;
-
-    // Poruszanie w lewo i w prawo
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-
-    // Poruszanie w gr i w d
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        cameraPos += cameraSpeed * cameraUp;
-    if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        cameraPos -= cameraSpeed * cameraUp;
-
-    // Aktualizacja kierunku frontu patrzenia
-    glm::vec3 front;
-    front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-    front.y = sin(glm::radians(pitch));
-    front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-    cameraFront = glm::normalize(front);
-
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-    glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
-}
-
-
-
-int main()
-{
     sf::ContextSettings settings;
     settings.depthBits = 24;
     settings.stencilBits = 8;
@@ -252,7 +221,7 @@ int main()
 
     // Okno renderingu
     sf::Window window(sf::VideoMode(800, 600, 32), "OpenGL", sf::Style::Titlebar | sf::Style::Close, settings);
-    window.setFramerateLimit(360);
+    window.setVerticalSyncEnabled(true);
     window.setMouseCursorGrabbed(true);
     window.setMouseCursorVisible(false);
     //window.setKeyRepeatEnabled(false);
@@ -374,6 +343,17 @@ int main()
     glEnableVertexAttribArray(NorAttrib);
     glVertexAttribPointer(NorAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
 
+    // Atrybuty pozycji, koloru i tekstury zapisane w VAO raz, nie co klatk
+    glEnableVertexAttribArray(posAttrib);
+    glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), 0);
+
+    glEnableVertexAttribArray(colAttrib);
+    glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
+
+    GLint texAttrib = glGetAttribLocation(shaderProgram, "aTexCoord");
+    glEnableVertexAttribArray(texAttrib);
+    glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
+
     // Pozycja wiata
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
     GLint uniLightPos = glGetUniformLocation(shaderProgram, "lightPos");
@@ -388,8 +368,9 @@ int main()
     glUniform1f(glGetUniformLocation(shaderProgram, "quadratic"), 0.032f);
 
     glUniform1i(glGetUniformLocation(shaderProgram, "lightingType"), 2);
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), cameraPos.x, cameraPos.y, cameraPos.z); // Reflektor w kamerze
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightDir"), cameraFront.x, cameraFront.y, cameraFront.z);
+    CameraState camera;
+    glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), camera.position.x, camera.position.y, camera.position.z); // Reflektor w kamerze
+    glUniform3f(glGetUniformLocation(shaderProgram, "lightDir"), camera.front.x, camera.front.y, camera.front.z);
     glUniform1f(glGetUniformLocation(shaderProgram, "cutoff"), 12.5f);
     glUniform1f(glGetUniformLocation(shaderProgram, "outerCutoff"), 15.0f);
 
@@ -414,8 +395,65 @@ int main()
 
     GLint uniView = glGetUniformLocation(shaderProgram, "view");
 
-    sf::Clock clock;
-    float deltaTime; // przechowuje czas w sekundach jaki upyn od ostatniego odwieenia klatki
+    // wiata forward+: kilkaset wiate krcych wok szecianu, klawisz 4
+    LightGrid lightGrid;
+    createLightGrid(lightGrid);
+    std::vector<float> lightOrbits;
+    sf::Clock lightClock;
+    for (int i = 0; i < 512; i++)
+    {
+        float hue = i / 512.0f * 6.28318531f;
+        glm::vec3 color(0.5f + 0.5f * cos(hue), 0.5f + 0.5f * cos(hue + 2.094f), 0.5f + 0.5f * cos(hue + 4.189f));
+        lightGrid.lights.push_back(i % 8 == 0
+            ? spotLight(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), 1.5f, color * 2.0f, 15.0f, 25.0f)
+            : pointLight(glm::vec3(0.0f), 0.4f, color));
+        lightOrbits.push_back(0.6f + 0.8f * ((i * 37) % 101) / 100.0f);
+    }
+
+    // Tryb pomiarowy: --bench-lights
+    if (argc > 1 && std::strcmp(argv[1], "--bench-lights") == 0)
+    {
+        int result = runLightBenchmark(window, lightGrid, shaderProgram, proj, [&](const glm::mat4& view)
+        {
+            // Podoga z 32x32 szecianw
+            glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
+            glBindTexture(GL_TEXTURE_2D, texture1);
+            glBindVertexArray(vaoCube);
+            GLint uniTrans = glGetUniformLocation(shaderProgram, "model");
+            for (int z = -16; z < 16; z++)
+            {
+                for (int x = -16; x < 16; x++)
+                {
+                    glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x + 0.5f, -0.5f, z + 0.5f));
+                    glUniformMatrix4fv(uniTrans, 1, GL_FALSE, glm::value_ptr(model));
+                    glDrawArrays(GL_TRIANGLES, 0, 36);
+                }
+            }
+        });
+        destroyLightGrid(lightGrid);
+        return result;
+    }
+
+    // Dynamiczna rozdzielczo z celem czasu klatki: --target-ms [ms], przebieg skali do pliku: --resolution-trace plik.csv
+    DynamicResolution resolution;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--target-ms") == 0) resolution.targetMs = (float)std::atof(argv[i + 1]);
+    }
+    if (!createDynamicResolution(resolution, (int)window.getSize().x, (int)window.getSize().y))
+    {
+        std::cerr << "Dynamic resolution disabled." << std::endl;
+    }
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--resolution-trace") == 0) openResolutionTrace(resolution, argv[i + 1]);
+    }
+    resolution.enabled = resolution.framebuffer != 0;
+
+    // Wejcie i kamera na osobnym wtku ze staym krokiem, renderowanie tylko czyta migawki
+    Simulation simulation;
+    simulation.moveSpeed = 0.5f;
+    startSimulation(simulation, window, camera);
 
     GLint uniLightingType = glGetUniformLocation(shaderProgram, "lightingType");
     glUniform1i(uniLightingType, lightingType);
@@ -429,23 +467,31 @@ int main()
     GLint uniLightingEnabled = glGetUniformLocation(shaderProgram, "lightingEnabled");
 
 
+    // Rysowanie na danie, klawisz R przecza na cige. W bezczynnoci tytu zmienia si dopiero po wybudzeniu.
+    FramePacing pacing;
     while (running)
     {
-        deltaTime = clock.restart().asSeconds(); // reset zegara i zwracanie czasu od ostatniego resetu
-
-        static int frameCount = 0;
         static sf::Clock fpsClock;
-        frameCount++;
         if (fpsClock.getElapsedTime().asSeconds() >= 1.0f)
         {
-            window.setTitle("OpenGL - FPS: " + std::to_string(frameCount));
-            frameCount = 0;
+            JobStats jobStats = readJobStats(sharedJobSystem());
+            PacingReport report = readPacingReport(pacing, simulation);
+            window.setTitle("OpenGL - FPS: " + std::to_string((int)std::round(report.fps)) + " - Jobs: " + std::to_string(jobStats.executed) +
+                ", steals: " + std::to_string(jobStats.steals) + ", busy: " + std::to_string((int)(jobStats.utilization * 100.0)) + "%" +
+                " - " + (pacing.onDemand ? "on demand" : "continuous") + ", CPU: " + std::to_string((int)report.cpuPercent) +
+                "%, wake-ups: " + std::to_string(report.wakeups) + ", idle: " + std::to_string((int)report.idlePercent) + "%" +
+                " - " + std::to_string(resolution.renderWidth) + "x" + std::to_string(resolution.renderHeight) +
+                ", CPU " + std::to_string((int)std::round(resolution.cpuMs)) + " ms, GPU " + std::to_string((int)std::round(resolution.gpuMs)) + " ms");
             fpsClock.restart();
         }
 
+        // Zdarzenie, na ktre czekaa bezczynna ptla, jest obsugiwane jak pierwsze z kolejki
         sf::Event windowEvent;
-        while (window.pollEvent(windowEvent))
+        bool waited = waitForFrame(pacing, simulation, window, windowEvent);
+        while (waited || window.pollEvent(windowEvent))
         {
+            waited = false;
+            pacing.dirty = true;
             if (windowEvent.type == sf::Event::Closed)
             {
                 running = false;
@@ -494,35 +540,81 @@ int main()
                     GLint uniDiffuseStrength = glGetUniformLocation(shaderProgram, "diffuseStrength");
                     glUniform1f(uniDiffuseStrength, diffuseStrength);
                 }
+                // Dynamiczna rozdzielczo i filtr skalowania
+                else if (windowEvent.key.code == sf::Keyboard::G)
+                {
+                    resolution.enabled = resolution.framebuffer != 0 && !resolution.enabled;
+                    std::cout << (resolution.enabled ? "DYNAMIC RESOLUTION ON\n" : "DYNAMIC RESOLUTION OFF\n");
+                }
+                else if (windowEvent.key.code == sf::Keyboard::F)
+                {
+                    resolution.sharpen = !resolution.sharpen;
+                    std::cout << (resolution.sharpen ? "UPSCALE: SHARPEN\n" : "UPSCALE: BILINEAR\n");
+                }
+                else if (windowEvent.key.code == sf::Keyboard::R)
+                {
+                    pacing.onDemand = !pacing.onDemand;
+                    std::cout << (pacing.onDemand ? "RENDER ON DEMAND\n" : "RENDER CONTINUOUSLY\n");
+                }
                 if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num1)) 
                 {
                     std::cout << "LIGHTING TYPE: DIRECTIONAL\n";
+                    lightingType = 0;
                     glUniform1i(glGetUniformLocation(shaderProgram, "lightingType"), 0); // Directional
                 }
                 if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num2)) 
                 {
                     std::cout << "LIGHTING TYPE: POINT\n";
+                    lightingType = 1;
                     glUniform1i(glGetUniformLocation(shaderProgram, "lightingType"), 1); // Point
                 }
                 if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num3)) 
                 {
                     std::cout << "LIGHTING TYPE: SPOTLIGHT\n";
+                    lightingType = 2;
                     glUniform1i(glGetUniformLocation(shaderProgram, "lightingType"), 2); // Spotlight
                 }
+                if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num4))
+                {
+                    std::cout << "LIGHTING TYPE: TILED (" << lightGrid.lights.size() << " LIGHTS)\n";
+                    lightingType = 3;
+                    glUniform1i(glGetUniformLocation(shaderProgram, "lightingType"), 3); // Wiele wiate
+                }
 
             }
         }
 
+        // Scena do celu w rozdzielczoci dobranej przez regulator
+        sf::Clock frameClock;
+        beginDynamicFrame(resolution);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Macierz widoku
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        GLint uniView = glGetUniformLocation(shaderProgram, "view");
+        camera = sampleCamera(simulation); // Kamera z ostatniego kroku symulacji
+        glm::mat4 view = cameraView(camera);
         glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
+        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(camera.position));
 
-        ustawKamereMysz(uniView, deltaTime, window); // Ustawienie widoku kamery na podstawie ruchu myszy
-        ustawKamereKlawisze(uniView, deltaTime);     // Obsuga klawiszy do poruszania si
+        // Ruch wiate i przydzia do kafelkw dla biecej kamery
+        if (lightingType == 3)
+        {
+            float time = lightClock.getElapsedTime().asSeconds();
+            parallelFor((unsigned)lightGrid.lights.size(), [&](unsigned begin, unsigned end)
+            {
+                for (unsigned i = begin; i < end; i++)
+                {
+                    float angle = time * (0.2f + 0.05f * (i % 7)) + i * 2.39996f;
+                    float height = 0.8f * sin(time * 0.3f + i * 0.7f);
+                    Light& light = lightGrid.lights[i];
+                    light.position = glm::vec3(cos(angle), height, sin(angle)) * lightOrbits[i];
+                    light.direction = glm::normalize(-light.position);
+                }
+            });
+            cullLights(lightGrid, view, proj, resolution.renderWidth, resolution.renderHeight);
+            uploadLightGrid(lightGrid);
+            bindLightGrid(lightGrid, shaderProgram, 1);
+        }
 
             // Macierz modelu                                                              x     y     z
             glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(obrot), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -533,26 +625,22 @@ int main()
 
             glBindVertexArray(vaoCube);
 
-            // Wczenie atrybutu pozycji wierzchoka
-            glEnableVertexAttribArray(posAttrib);
-            glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), 0);
-
-            // Wczenie atrybutu koloru
-            glEnableVertexAttribArray(colAttrib);
-            glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-
-            // Wczenie wsprzdnych tekstury
-            GLint texAttrib = glGetAttribLocation(shaderProgram, "aTexCoord");
-            glEnableVertexAttribArray(texAttrib);
-            glVertexAttribPointer(texAttrib, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
-
             // Renderowanie szecianu jako zbir trjktw
             glBindTexture(GL_TEXTURE_2D, texture1);
             glDrawArrays(GL_TRIANGLES, 0, 36);
 
+        endDynamicFrame(resolution, frameClock.getElapsedTime().asMicroseconds() / 1000.0);
         window.display();
+        pacing.frames++;
+
+        // Krce wiata zmieniaj kad klatk, pozostae tryby czekaj na zmian
+        pacing.dirty = lightingType == 3;
     }
 
+    stopSimulation(simulation);
+    destroyLightGrid(lightGrid);
+    destroyDynamicResolution(resolution);
+
     glDeleteProgram(shaderProgram);
     glDeleteShader(fragmentShader);
     glDeleteShader(vertexShader);